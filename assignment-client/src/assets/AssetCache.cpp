@@ -0,0 +1,108 @@
+//
+//  AssetCache.cpp
+//  assignment-client/src/assets
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "AssetCache.h"
+
+#include <algorithm>
+
+static const qint64 BYTES_PER_MEGABYTE = 1024 * 1024;
+
+const qint64 AssetCache::DEFAULT_MAX_SIZE = 512 * BYTES_PER_MEGABYTE;
+const qint64 AssetCache::DEFAULT_MAX_ENTRY_SIZE = 64 * BYTES_PER_MEGABYTE;
+
+AssetCache::AssetCache(qint64 maxSize, qint64 maxEntrySize) :
+    _maxSize(maxSize),
+    _maxEntrySize(maxEntrySize)
+{
+}
+
+void AssetCache::setMaxSize(qint64 maxSize) {
+    _maxSize = std::max(maxSize, (qint64)0);
+
+    auto maxShardSize = _maxSize / NUM_SHARDS;
+    for (auto& shard : _shards) {
+        Lock lock(shard.mutex);
+        trimShard(shard, maxShardSize);
+    }
+}
+
+bool AssetCache::isCacheable(qint64 size) const {
+    // each shard has its share of the budget
+    qint64 maxSize = _maxSize;
+    return maxSize > 0 && size <= std::min(_maxEntrySize, maxSize / NUM_SHARDS);
+}
+
+QByteArray AssetCache::get(const AssetHash& hash) {
+    auto& shard = shardFor(hash);
+    Lock lock(shard.mutex);
+
+    auto it = shard.index.find(hash);
+    if (it == shard.index.end()) {
+        return QByteArray();
+    }
+
+    // bump this entry to the front of the LRU list
+    shard.entries.splice(shard.entries.begin(), shard.entries, it.value());
+    ++_hits;
+    return it.value()->second;
+}
+
+void AssetCache::insert(const AssetHash& hash, const QByteArray& data) {
+    auto maxShardSize = _maxSize / NUM_SHARDS;
+    if (!isCacheable(data.size())) {
+        return;
+    }
+
+    ++_misses;
+
+    auto& shard = shardFor(hash);
+    Lock lock(shard.mutex);
+
+    if (shard.index.contains(hash)) {
+        // another task beat us to it, assets are immutable so there is nothing to update
+        return;
+    }
+
+    shard.entries.emplace_front(hash, data);
+    shard.index.insert(hash, shard.entries.begin());
+    shard.size += data.size();
+    _size += data.size();
+
+    trimShard(shard, maxShardSize);
+}
+
+void AssetCache::trimShard(Shard& shard, qint64 maxShardSize) {
+    while (shard.size > maxShardSize && !shard.entries.empty()) {
+        const auto& entry = shard.entries.back();
+        auto entrySize = entry.second.size();
+
+        shard.index.remove(entry.first);
+        shard.entries.pop_back();
+
+        shard.size -= entrySize;
+        _size -= entrySize;
+        ++_evictions;
+    }
+}
+
+QJsonObject AssetCache::getStats() const {
+    quint64 hits = _hits;
+    quint64 misses = _misses;
+    auto lookups = hits + misses;
+
+    QJsonObject stats;
+    stats["1. Size (MB)"] = (double)_size / BYTES_PER_MEGABYTE;
+    stats["2. Max Size (MB)"] = (double)_maxSize / BYTES_PER_MEGABYTE;
+    stats["3. Hits"] = (double)hits;
+    stats["4. Misses"] = (double)misses;
+    stats["5. Hit Rate (%)"] = lookups > 0 ? (100.0 * hits) / lookups : 0.0;
+    stats["6. Evictions"] = (double)_evictions;
+    return stats;
+}
@@ -0,0 +1,86 @@
+//
+//  AssetCache.h
+//  assignment-client/src/assets
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_AssetCache_h
+#define hifi_AssetCache_h
+
+#include <array>
+#include <atomic>
+#include <list>
+#include <mutex>
+
+#include <QtCore/QByteArray>
+#include <QtCore/QHash>
+#include <QtCore/QJsonObject>
+
+#include "AssetUtils.h"
+
+// In-memory LRU cache of asset file contents, shared by all the SendAssetTasks of an AssetServer.
+// Assets are keyed by their hash and are immutable, so entries never need to be invalidated,
+// they only get evicted when the cache goes over its size budget.
+// The cache is split in shards, each with its own lock, to keep contention low on the task pool.
+class AssetCache {
+public:
+    static const qint64 DEFAULT_MAX_SIZE; // bytes
+    static const qint64 DEFAULT_MAX_ENTRY_SIZE; // bytes
+
+    AssetCache(qint64 maxSize = DEFAULT_MAX_SIZE, qint64 maxEntrySize = DEFAULT_MAX_ENTRY_SIZE);
+
+    void setMaxSize(qint64 maxSize);
+    qint64 getMaxSize() const { return _maxSize; }
+    qint64 getMaxEntrySize() const { return _maxEntrySize; }
+
+    /// Returns true if an asset of this size is allowed in the cache
+    bool isCacheable(qint64 size) const;
+
+    /// Returns the cached contents for `hash`, or a null QByteArray if it isn't cached.
+    /// Only counts hits, whether a failed lookup is a miss depends on what the caller finds on disk.
+    QByteArray get(const AssetHash& hash);
+
+    /// Adds the contents of `hash` to the cache, evicting least recently used assets as needed.
+    /// Assets are only inserted after their lookup failed, so inserting a cacheable asset counts as a miss, and
+    /// assets that don't exist or are too large for the cache don't skew the hit rate.
+    void insert(const AssetHash& hash, const QByteArray& data);
+
+    qint64 getSize() const { return _size; }
+    QJsonObject getStats() const;
+
+private:
+    static const int NUM_SHARDS = 16;
+
+    using Mutex = std::mutex;
+    using Lock = std::lock_guard<Mutex>;
+    using Entry = std::pair<AssetHash, QByteArray>;
+    using EntryList = std::list<Entry>;
+
+    struct Shard {
+        Mutex mutex;
+        EntryList entries; // most recently used at the front
+        QHash<AssetHash, EntryList::iterator> index;
+        qint64 size { 0 };
+    };
+
+    Shard& shardFor(const AssetHash& hash) { return _shards[qHash(hash) % NUM_SHARDS]; }
+
+    // evicts the least recently used entries of the shard until it fits its budget, expects the shard lock to be held
+    void trimShard(Shard& shard, qint64 maxShardSize);
+
+    std::array<Shard, NUM_SHARDS> _shards;
+
+    std::atomic<qint64> _maxSize;
+    const qint64 _maxEntrySize;
+
+    std::atomic<qint64> _size { 0 };
+    std::atomic<quint64> _hits { 0 };
+    std::atomic<quint64> _misses { 0 };
+    std::atomic<quint64> _evictions { 0 };
+};
+
+#endif // hifi_AssetCache_h
@@ -0,0 +1,197 @@
+//
+//  AssetChunkStore.cpp
+//  assignment-client/src/assets
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "AssetChunkStore.h"
+
+#include <algorithm>
+
+#include <QtCore/QDataStream>
+#include <QtCore/QDebug>
+#include <QtCore/QFile>
+#include <QtCore/QTemporaryFile>
+
+static const QString ASSET_CHUNKS_SUBDIR = "chunks";
+static const QString ASSET_MANIFESTS_SUBDIR = "manifests";
+
+static const quint32 MANIFEST_VERSION = 1;
+
+bool AssetChunkStore::init(const QDir& resourcesDirectory) {
+    _chunksDirectory = resourcesDirectory;
+    _manifestsDirectory = resourcesDirectory;
+
+    return resourcesDirectory.mkpath(ASSET_CHUNKS_SUBDIR) && _chunksDirectory.cd(ASSET_CHUNKS_SUBDIR)
+        && resourcesDirectory.mkpath(ASSET_MANIFESTS_SUBDIR) && _manifestsDirectory.cd(ASSET_MANIFESTS_SUBDIR);
+}
+
+bool AssetChunkStore::hasChunk(const QByteArray& chunkHash) const {
+    return QFile::exists(_chunksDirectory.filePath(chunkHash.toHex()));
+}
+
+QByteArray AssetChunkStore::readChunk(const QByteArray& chunkHash) const {
+    QFile file { _chunksDirectory.filePath(chunkHash.toHex()) };
+
+    if (file.open(QIODevice::ReadOnly)) {
+        return file.readAll();
+    }
+
+    return QByteArray();
+}
+
+bool AssetChunkStore::writeChunk(const QByteArray& chunkHash, const QByteArray& data) {
+    return hasChunk(chunkHash) || writeFileAtomically(_chunksDirectory.filePath(chunkHash.toHex()), data);
+}
+
+bool AssetChunkStore::hasManifest(const AssetHash& hash) const {
+    return QFile::exists(_manifestsDirectory.filePath(hash));
+}
+
+bool AssetChunkStore::readManifest(const AssetHash& hash, AssetChunkList& chunks) const {
+    QFile file { _manifestsDirectory.filePath(hash) };
+
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream stream { &file };
+
+    quint32 version;
+    quint32 numChunks;
+    stream >> version >> numChunks;
+
+    if (version != MANIFEST_VERSION) {
+        qWarning() << "Unsupported version" << version << "for asset manifest" << hash;
+        return false;
+    }
+
+    chunks.clear();
+    chunks.reserve(numChunks);
+
+    qint64 offset = 0;
+    for (quint32 i = 0; i < numChunks && stream.status() == QDataStream::Ok; ++i) {
+        QByteArray chunkHash(SHA256_HASH_LENGTH, Qt::Uninitialized);
+        stream.readRawData(chunkHash.data(), SHA256_HASH_LENGTH);
+
+        qint64 chunkSize;
+        stream >> chunkSize;
+
+        chunks.push_back({ offset, chunkSize, chunkHash });
+        offset += chunkSize;
+    }
+
+    return stream.status() == QDataStream::Ok;
+}
+
+bool AssetChunkStore::writeManifest(const AssetHash& hash, const AssetChunkList& chunks) {
+    QByteArray data;
+    QDataStream stream { &data, QIODevice::WriteOnly };
+
+    stream << MANIFEST_VERSION << (quint32)chunks.size();
+    for (const auto& chunk : chunks) {
+        stream.writeRawData(chunk.hash.constData(), chunk.hash.size());
+        stream << (qint64)chunk.size;
+    }
+
+    return writeFileAtomically(_manifestsDirectory.filePath(hash), data);
+}
+
+bool AssetChunkStore::removeManifest(const AssetHash& hash) {
+    return QFile::remove(_manifestsDirectory.filePath(hash));
+}
+
+QStringList AssetChunkStore::getManifestHashes() const {
+    QRegExp hashFileRegex { "^[a-f0-9]{" + QString::number(SHA256_HASH_HEX_LENGTH) + "}$" };
+    return _manifestsDirectory.entryList(QDir::Files).filter(hashFileRegex);
+}
+
+int64_t AssetChunkStore::getAssetSize(const AssetHash& hash) const {
+    AssetChunkList chunks;
+    if (!readManifest(hash, chunks)) {
+        return -1;
+    }
+
+    return chunks.empty() ? 0 : chunks.back().offset + chunks.back().size;
+}
+
+QByteArray AssetChunkStore::readAsset(const AssetHash& hash, int64_t offset, int64_t size) const {
+    AssetChunkList chunks;
+    if (!readManifest(hash, chunks)) {
+        return QByteArray();
+    }
+
+    QByteArray data;
+    data.reserve(size);
+
+    auto end = offset + size;
+    for (const auto& chunk : chunks) {
+        auto chunkEnd = chunk.offset + chunk.size;
+        if (chunkEnd <= offset) {
+            continue;
+        }
+        if (chunk.offset >= end) {
+            break;
+        }
+
+        auto chunkData = readChunk(chunk.hash);
+        if (chunkData.size() != chunk.size) {
+            qWarning() << "Missing or truncated chunk" << chunk.hash.toHex() << "for asset" << hash;
+            return QByteArray();
+        }
+
+        // only keep the part of the chunk that is in the requested range
+        auto from = std::max(offset, chunk.offset) - chunk.offset;
+        auto to = std::min(end, chunkEnd) - chunk.offset;
+        data.append(chunkData.constData() + from, to - from);
+    }
+
+    return data;
+}
+
+int AssetChunkStore::removeUnreferencedChunks() {
+    QSet<QString> referencedChunks;
+
+    for (const auto& hash : getManifestHashes()) {
+        AssetChunkList chunks;
+        if (!readManifest(hash, chunks)) {
+            // we can't tell which chunks this asset needs, don't risk deleting any
+            qWarning() << "Could not read manifest for" << hash << "- skipping unreferenced chunk cleanup.";
+            return 0;
+        }
+
+        for (const auto& chunk : chunks) {
+            referencedChunks << chunk.hash.toHex();
+        }
+    }
+
+    int removedChunks = 0;
+    for (const auto& fileName : _chunksDirectory.entryList(QDir::Files)) {
+        if (!referencedChunks.contains(fileName) && QFile::remove(_chunksDirectory.filePath(fileName))) {
+            ++removedChunks;
+        }
+    }
+
+    return removedChunks;
+}
+
+bool AssetChunkStore::writeFileAtomically(const QString& filePath, const QByteArray& data) {
+    QTemporaryFile tempFile { filePath + ".XXXXXX" };
+
+    if (!tempFile.open() || tempFile.write(data) != data.size() || !tempFile.flush()) {
+        return false;
+    }
+    tempFile.close();
+
+    if (QFile::rename(tempFile.fileName(), filePath)) {
+        tempFile.setAutoRemove(false);
+        return true;
+    }
+
+    // we may have raced another task writing the same content
+    return QFile::exists(filePath);
+}
@@ -0,0 +1,56 @@
+//
+//  AssetChunkStore.h
+//  assignment-client/src/assets
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_AssetChunkStore_h
+#define hifi_AssetChunkStore_h
+
+#include <QtCore/QDir>
+#include <QtCore/QSet>
+
+#include <AssetChunking.h>
+#include <AssetUtils.h>
+
+// On-disk storage for assets uploaded in chunks.
+// Each chunk is stored once, named by its hash, and shared by every asset that contains it. An asset stored this way
+// has a manifest, named by the asset hash, listing its chunks in order.
+// Chunks and manifests are written to a temporary file and renamed into place, so the store can be used from
+// any of the asset-server task threads.
+class AssetChunkStore {
+public:
+    bool init(const QDir& resourcesDirectory);
+
+    bool hasChunk(const QByteArray& chunkHash) const;
+    QByteArray readChunk(const QByteArray& chunkHash) const;
+    bool writeChunk(const QByteArray& chunkHash, const QByteArray& data);
+
+    bool hasManifest(const AssetHash& hash) const;
+    bool readManifest(const AssetHash& hash, AssetChunkList& chunks) const;
+    bool writeManifest(const AssetHash& hash, const AssetChunkList& chunks);
+    bool removeManifest(const AssetHash& hash);
+    QStringList getManifestHashes() const;
+
+    /// Returns the size of the asset, or -1 if it isn't stored in chunks
+    int64_t getAssetSize(const AssetHash& hash) const;
+
+    /// Reassembles `size` bytes of the asset starting at `offset`. Returns a null QByteArray on failure.
+    QByteArray readAsset(const AssetHash& hash, int64_t offset, int64_t size) const;
+
+    /// Deletes the chunks that aren't listed in any manifest. Returns the number of chunks deleted.
+    /// Only safe to call while no chunked upload is in progress.
+    int removeUnreferencedChunks();
+
+private:
+    bool writeFileAtomically(const QString& filePath, const QByteArray& data);
+
+    QDir _chunksDirectory;
+    QDir _manifestsDirectory;
+};
+
+#endif // hifi_AssetChunkStore_h
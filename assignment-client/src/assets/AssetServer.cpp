@@ -20,16 +20,25 @@
 #include <QtCore/QDir>
 #include <QtCore/QFile>
 #include <QtCore/QFileInfo>
+#include <QtCore/QFutureWatcher>
+#include <QtCore/QJsonArray>
 #include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QSaveFile>
 #include <QtCore/QString>
+#include <QtCore/QTimer>
+#include <QtConcurrent/QtConcurrentRun>
 
+#include <NumericalConstants.h>
 #include <SharedUtil.h>
 #include <PathUtils.h>
 
 #include "NetworkLogging.h"
+#include "BakeTextureTask.h"
 #include "NodeType.h"
 #include "SendAssetTask.h"
 #include "UploadAssetTask.h"
+#include "UploadChunkedAssetTask.h"
 #include <ClientServerUtils.h>
 
 static const uint8_t MIN_CORES_FOR_MULTICORE = 4;
@@ -39,6 +48,11 @@ static const uint8_t CPU_AFFINITY_COUNT_LOW = 1;
 static const int INTERFACE_RUNNING_CHECK_FREQUENCY_MS = 1000;
 #endif
 
+static const int CHUNK_COLLECTION_INTERVAL_MS = 10 * 60 * 1000;
+
+// clients send their chunked upload right after the asset-server answered which chunks it is missing
+static const quint64 CHUNK_QUERY_GRACE_USECS = 60 * USECS_PER_SECOND;
+
 const QString ASSET_SERVER_LOGGING_TARGET_NAME = "asset-server";
 
 bool interfaceRunning() {
@@ -74,7 +88,9 @@ void updateConsumedCores() {
 
 AssetServer::AssetServer(ReceivedMessage& message) :
     ThreadedAssignment(message),
-    _taskPool(this)
+    _taskPool(this),
+    _uploadTaskPool(this),
+    _bakeTaskPool(this)
 {
 
     // Most of the work will be I/O bound, reading from disk and constructing packet objects,
@@ -82,11 +98,24 @@ AssetServer::AssetServer(ReceivedMessage& message) :
     static const int TASK_POOL_THREAD_COUNT = 50;
     _taskPool.setMaxThreadCount(TASK_POOL_THREAD_COUNT);
 
+    // Upload tasks hash and write uploads to disk as they arrive, keep them in their own pool
+    // so that a burst of uploads can't starve the tasks sending assets.
+    static const int UPLOAD_TASK_POOL_THREAD_COUNT = 10;
+    _uploadTaskPool.setMaxThreadCount(UPLOAD_TASK_POOL_THREAD_COUNT);
+
+    // Baking a texture already spreads its processing over the cores, bake them one at a time
+    // so that the other tasks always have some left.
+    static const int BAKE_TASK_POOL_THREAD_COUNT = 1;
+    _bakeTaskPool.setMaxThreadCount(BAKE_TASK_POOL_THREAD_COUNT);
+
     auto& packetReceiver = DependencyManager::get<NodeList>()->getPacketReceiver();
     packetReceiver.registerListener(PacketType::AssetGet, this, "handleAssetGet");
     packetReceiver.registerListener(PacketType::AssetGetInfo, this, "handleAssetGetInfo");
-    packetReceiver.registerListener(PacketType::AssetUpload, this, "handleAssetUpload");
+    // uploads are handed to an UploadAssetTask as soon as their first packet arrives so they can be streamed to disk
+    packetReceiver.registerListener(PacketType::AssetUpload, this, "handleAssetUpload", true);
     packetReceiver.registerListener(PacketType::AssetMappingOperation, this, "handleAssetMappingOperation");
+    packetReceiver.registerListener(PacketType::AssetChunkQuery, this, "handleAssetChunkQuery");
+    packetReceiver.registerListener(PacketType::AssetChunkedUpload, this, "handleAssetChunkedUpload", true);
     
 #ifdef Q_OS_WIN
     updateConsumedCores();
@@ -145,6 +174,26 @@ void AssetServer::completeSetup() {
                     " (" << maxBandwidth << "bits/s)";
     }
 
+    static const QString CACHE_SIZE_OPTION = "cache_size";
+    auto cacheSizeValue = assetServerObject[CACHE_SIZE_OPTION];
+    if (cacheSizeValue.isDouble()) {
+        const qint64 BYTES_PER_MEGABYTE = 1024 * 1024;
+        _assetCache->setMaxSize(cacheSizeValue.toDouble() * BYTES_PER_MEGABYTE);
+        qInfo() << "Set in-memory asset cache size to" << cacheSizeValue.toDouble() << "MB.";
+    }
+
+    static const QString CHUNKED_UPLOADS_OPTION = "chunked_uploads";
+    _chunkedUploadsEnabled = assetServerObject[CHUNKED_UPLOADS_OPTION].toBool(false);
+    if (_chunkedUploadsEnabled) {
+        qInfo() << "Chunked uploads are enabled, new assets uploaded in chunks will be stored deduplicated.";
+    }
+
+    static const QString BAKE_TEXTURES_OPTION = "bake_textures";
+    _textureBakingEnabled = assetServerObject[BAKE_TEXTURES_OPTION].toBool(false);
+    if (_textureBakingEnabled) {
+        qInfo() << "Texture baking is enabled, mapped images will be baked into KTX textures.";
+    }
+
     // get the path to the asset folder from the domain server settings
     static const QString ASSETS_PATH_OPTION = "assets_path";
     auto assetsJSONValue = assetServerObject[ASSETS_PATH_OPTION];
@@ -177,6 +226,24 @@ void AssetServer::completeSetup() {
         return;
     }
 
+    if (!_chunkStore->init(_resourcesDirectory)) {
+        qCritical() << "Unable to create chunk directories for asset-server files. Stopping assignment.";
+        setFinished(true);
+        return;
+    }
+
+    if (!_compressedStore->init(_resourcesDirectory)) {
+        qCritical() << "Unable to create compressed variants directory for asset-server files. Stopping assignment.";
+        setFinished(true);
+        return;
+    }
+
+    if (!_bakedTextureStore->init(_resourcesDirectory)) {
+        qCritical() << "Unable to create baked textures directory for asset-server files. Stopping assignment.";
+        setFinished(true);
+        return;
+    }
+
     // load whatever mappings we currently have from the local file
     if (loadMappingsFromFile()) {
         qInfo() << "Serving files from: " << _filesDirectory.path();
@@ -187,12 +254,31 @@ void AssetServer::completeSetup() {
         QRegExp hashFileRegex { ASSET_HASH_REGEX_STRING };
         auto hashedFiles = files.filter(hashFileRegex);
 
-        qInfo() << "There are" << hashedFiles.size() << "asset files in the asset directory.";
+        qInfo() << "There are" << hashedFiles.size() << "asset files and" << _chunkStore->getManifestHashes().size()
+            << "chunked assets in the asset directory.";
+
+        removeIncompleteUploads();
 
         if (_fileMappings.count() > 0) {
             cleanupUnmappedFiles();
         }
 
+        // chunks are shared between assets, they are collected here before anything can be uploading them
+        auto removedChunks = _chunkStore->removeUnreferencedChunks();
+        if (removedChunks > 0) {
+            qInfo() << "Deleted" << removedChunks << "chunks no longer used by any asset.";
+        }
+
+        // and then again while the asset-server runs, once assets stored in chunks were removed
+        QTimer* chunkCollectionTimer = new QTimer(this);
+        connect(chunkCollectionTimer, &QTimer::timeout, this, &AssetServer::collectUnreferencedChunks);
+        chunkCollectionTimer->start(CHUNK_COLLECTION_INTERVAL_MS);
+
+        // catch up on the images mapped while baking was disabled, or before the last shutdown
+        for (auto it = _fileMappings.cbegin(); it != _fileMappings.cend(); ++it) {
+            bakeTextureIfNeeded(it.key(), it.value());
+        }
+
         nodeList->addSetOfNodeTypesToNodeInterestSet({ NodeType::Agent, NodeType::EntityScriptServer });
     } else {
         qCritical() << "Asset Server assignment will not continue because mapping file could not be loaded.";
@@ -206,14 +292,19 @@ void AssetServer::cleanupUnmappedFiles() {
 
     auto files = _filesDirectory.entryInfoList(QDir::Files);
 
-    // grab the currently mapped hashes
-    auto mappedHashes = _fileMappings.values();
-
     qInfo() << "Performing unmapped asset cleanup.";
 
+    // forget the bakes of unmapped images first, their textures are then unmapped files like any other
+    for (const auto& hash : _bakedTextureStore->getBakedAssetHashes()) {
+        if (!_hashReferenceCounts.contains(hash)) {
+            _bakedTextureStore->removeBakeRecord(hash);
+        }
+    }
+
     for (const auto& fileInfo : files) {
         if (hashFileRegex.exactMatch(fileInfo.fileName())) {
-            if (!mappedHashes.contains(fileInfo.fileName())) {
+            if (!_hashReferenceCounts.contains(fileInfo.fileName())
+                && !_bakedTextureStore->isBakedTexture(fileInfo.fileName())) {
                 // remove the unmapped file
                 QFile removeableFile { fileInfo.absoluteFilePath() };
 
@@ -225,6 +316,113 @@ void AssetServer::cleanupUnmappedFiles() {
             }
         }
     }
+
+    for (const auto& hash : _chunkStore->getManifestHashes()) {
+        if (!_hashReferenceCounts.contains(hash)) {
+            if (_chunkStore->removeManifest(hash)) {
+                qDebug() << "\tDeleted manifest for" << hash << "since it is unmapped.";
+            } else {
+                qDebug() << "\tAttempt to delete manifest for unmapped asset" << hash << "failed";
+            }
+        }
+    }
+
+    for (const auto& hash : _compressedStore->getCompressedAssetHashes()) {
+        if (!_hashReferenceCounts.contains(hash) && _compressedStore->removeCompressedAsset(hash)) {
+            qDebug() << "\tDeleted compressed variant of" << hash << "since it is unmapped.";
+        }
+    }
+}
+
+void AssetServer::removeAssetFile(const AssetHash& hash) {
+    // the texture baked from an image goes with it, unless it is also mapped itself
+    auto bakedHash = _bakedTextureStore->removeBakeRecord(hash);
+    if (!bakedHash.isEmpty() && !_hashReferenceCounts.contains(bakedHash)) {
+        removeAssetFile(bakedHash);
+    }
+
+    // a KTX that was also mapped is still needed by the image it was baked from
+    if (_bakedTextureStore->isBakedTexture(hash)) {
+        return;
+    }
+
+    QFile removeableFile { _filesDirectory.absoluteFilePath(hash) };
+
+    // the same asset may have been uploaded whole and in chunks, with chunked uploads enabled at one time only
+    bool removedFile = removeableFile.remove();
+    bool removedManifest = _chunkStore->removeManifest(hash);
+
+    if (removedFile) {
+        qDebug() << "\tDeleted" << hash << "from asset files directory since it is now unmapped.";
+    }
+
+    if (removedManifest) {
+        qDebug() << "\tDeleted manifest for" << hash << "since it is now unmapped.";
+
+        // its chunks that no other asset uses are left for collectUnreferencedChunks
+        _mayHaveUnreferencedChunks = true;
+    }
+
+    if (!removedFile && !removedManifest) {
+        qDebug() << "\tAttempt to delete unmapped file" << hash << "failed";
+    }
+
+    // the compressed variant is only a copy, it doesn't need to be reported on
+    _compressedStore->removeCompressedAsset(hash);
+}
+
+void AssetServer::collectUnreferencedChunks() {
+    if (!_mayHaveUnreferencedChunks || _isCollectingChunks || _chunkedUploadsInProgress > 0
+        || usecTimestampNow() - _lastChunkQueryUsecs < CHUNK_QUERY_GRACE_USECS) {
+        return;
+    }
+
+    _mayHaveUnreferencedChunks = false;
+    _isCollectingChunks = true;
+
+    auto chunkStore = _chunkStore;
+    auto watcher = new QFutureWatcher<int>(this);
+
+    connect(watcher, &QFutureWatcher<int>::finished, this, [this, watcher] {
+        _isCollectingChunks = false;
+
+        auto removedChunks = watcher->result();
+        if (removedChunks > 0) {
+            qInfo() << "Deleted" << removedChunks << "chunks no longer used by any asset.";
+        }
+
+        watcher->deleteLater();
+    });
+
+    watcher->setFuture(QtConcurrent::run(&_taskPool, [chunkStore] {
+        return chunkStore->removeUnreferencedChunks();
+    }));
+}
+
+void AssetServer::bakeTextureIfNeeded(const AssetPath& path, const AssetHash& hash) {
+    if (!_textureBakingEnabled || !BakedTextureStore::isBakeablePath(path) || !_bakedTextureStore->startBake(hash)) {
+        return;
+    }
+
+    qDebug() << "Starting a BakeTextureTask for" << path << "(" << hash << ")";
+
+    auto task = new BakeTextureTask(hash, _filesDirectory, _chunkStore, _bakedTextureStore);
+    _bakeTaskPool.start(task);
+}
+
+void AssetServer::removeIncompleteUploads() {
+    // uploads that were still being received when the asset-server last went down leave their temporary file behind
+    auto tempFiles = _filesDirectory.entryInfoList({ "*" + UploadAssetTask::TEMPORARY_FILE_SUFFIX }, QDir::Files);
+
+    for (const auto& fileInfo : tempFiles) {
+        QFile removeableFile { fileInfo.absoluteFilePath() };
+
+        if (removeableFile.remove()) {
+            qDebug() << "\tDeleted incomplete upload" << fileInfo.fileName() << "from asset files directory.";
+        } else {
+            qDebug() << "\tAttempt to delete incomplete upload" << fileInfo.fileName() << "failed";
+        }
+    }
 }
 
 void AssetServer::handleAssetMappingOperation(QSharedPointer<ReceivedMessage> message, SharedNodePointer senderNode) {
@@ -258,6 +456,14 @@ void AssetServer::handleAssetMappingOperation(QSharedPointer<ReceivedMessage> me
             handleRenameMappingOperation(*message, senderNode, *replyPacket);
             break;
         }
+        case AssetMappingOperationType::GetBakedTexture: {
+            handleGetBakedTextureOperation(*message, senderNode, *replyPacket);
+            break;
+        }
+        case AssetMappingOperationType::GetServerCapabilities: {
+            handleGetServerCapabilitiesOperation(*message, senderNode, *replyPacket);
+            break;
+        }
     }
 
     auto nodeList = DependencyManager::get<NodeList>();
@@ -269,7 +475,7 @@ void AssetServer::handleGetMappingOperation(ReceivedMessage& message, SharedNode
 
     auto it = _fileMappings.find(assetPath);
     if (it != _fileMappings.end()) {
-        auto assetHash = it->toString();
+        auto assetHash = it.value();
         replyPacket.writePrimitive(AssetServerError::NoError);
         replyPacket.write(QByteArray::fromHex(assetHash.toUtf8()));
     } else {
@@ -286,7 +492,7 @@ void AssetServer::handleGetAllMappingOperation(ReceivedMessage& message, SharedN
 
     for (auto it = _fileMappings.cbegin(); it != _fileMappings.cend(); ++ it) {
         replyPacket.writeString(it.key());
-        replyPacket.write(QByteArray::fromHex(it.value().toString().toUtf8()));
+        replyPacket.write(QByteArray::fromHex(it.value().toUtf8()));
     }
 }
 
@@ -342,6 +548,41 @@ void AssetServer::handleRenameMappingOperation(ReceivedMessage& message, SharedN
     }
 }
 
+void AssetServer::handleGetBakedTextureOperation(ReceivedMessage& message, SharedNodePointer senderNode, NLPacketList& replyPacket) {
+    // textures are requested either by path or by hash
+    QString pathOrHash = message.readString();
+
+    AssetHash assetHash;
+    if (isValidFilePath(pathOrHash)) {
+        assetHash = _fileMappings.value(pathOrHash);
+    } else if (isValidHash(pathOrHash)) {
+        assetHash = pathOrHash.toLower();
+    }
+
+    auto bakedHash = assetHash.isEmpty() ? AssetHash() : _bakedTextureStore->getBakedTextureHash(assetHash);
+
+    if (!bakedHash.isEmpty()) {
+        replyPacket.writePrimitive(AssetServerError::NoError);
+        replyPacket.write(QByteArray::fromHex(bakedHash.toUtf8()));
+    } else {
+        replyPacket.writePrimitive(AssetServerError::AssetNotFound);
+    }
+}
+
+void AssetServer::handleGetServerCapabilitiesOperation(ReceivedMessage& message, SharedNodePointer senderNode,
+                                                       NLPacketList& replyPacket) {
+    uint32_t capabilities { 0 };
+    if (_textureBakingEnabled) {
+        capabilities |= AssetServerCapability::HasBakedTextures;
+    }
+    if (_chunkedUploadsEnabled) {
+        capabilities |= AssetServerCapability::CanUploadChunks;
+    }
+
+    replyPacket.writePrimitive(AssetServerError::NoError);
+    replyPacket.writePrimitive(capabilities);
+}
+
 void AssetServer::handleAssetGetInfo(QSharedPointer<ReceivedMessage> message, SharedNodePointer senderNode) {
     QByteArray assetHash;
     MessageID messageID;
@@ -365,10 +606,15 @@ void AssetServer::handleAssetGetInfo(QSharedPointer<ReceivedMessage> message, Sh
     QString fileName = QString(hexHash);
     QFileInfo fileInfo { _filesDirectory.filePath(fileName) };
 
+    int64_t chunkedAssetSize = -1;
+
     if (fileInfo.exists() && fileInfo.isReadable()) {
         qDebug() << "Opening file: " << fileInfo.filePath();
         replyPacket->writePrimitive(AssetServerError::NoError);
         replyPacket->writePrimitive(fileInfo.size());
+    } else if ((chunkedAssetSize = _chunkStore->getAssetSize(fileName)) >= 0) {
+        replyPacket->writePrimitive(AssetServerError::NoError);
+        replyPacket->writePrimitive((qint64)chunkedAssetSize);
     } else {
         qDebug() << "Asset not found: " << QString(hexHash);
         replyPacket->writePrimitive(AssetServerError::AssetNotFound);
@@ -380,7 +626,8 @@ void AssetServer::handleAssetGetInfo(QSharedPointer<ReceivedMessage> message, Sh
 
 void AssetServer::handleAssetGet(QSharedPointer<ReceivedMessage> message, SharedNodePointer senderNode) {
 
-    auto minSize = qint64(sizeof(MessageID) + SHA256_HASH_LENGTH + sizeof(DataOffset) + sizeof(DataOffset));
+    auto minSize = qint64(sizeof(MessageID) + SHA256_HASH_LENGTH + sizeof(DataOffset) + sizeof(DataOffset)
+                          + sizeof(AssetGetFlag));
 
     if (message->getSize() < minSize) {
         qDebug() << "ERROR bad file request";
@@ -388,7 +635,8 @@ void AssetServer::handleAssetGet(QSharedPointer<ReceivedMessage> message, Shared
     }
 
     // Queue task
-    auto task = new SendAssetTask(message, senderNode, _filesDirectory);
+    auto task = new SendAssetTask(message, senderNode, _filesDirectory, _assetCache, _chunkStore,
+                                  _compressedStore);
     _taskPool.start(task);
 }
 
@@ -397,8 +645,9 @@ void AssetServer::handleAssetUpload(QSharedPointer<ReceivedMessage> message, Sha
     if (senderNode->getCanWriteToAssetServer()) {
         qDebug() << "Starting an UploadAssetTask for upload from" << uuidStringWithoutCurlyBraces(senderNode->getUUID());
 
-        auto task = new UploadAssetTask(message, senderNode, _filesDirectory);
-        _taskPool.start(task);
+        // the task consumes the upload on the upload pool as it arrives and deletes itself once done
+        auto task = new UploadAssetTask(message, senderNode, _uploadTaskPool, _filesDirectory, _compressedStore);
+        task->start();
     } else {
         // this is a node the domain told us is not allowed to rez entities
         // for now this also means it isn't allowed to add assets
@@ -406,8 +655,10 @@ void AssetServer::handleAssetUpload(QSharedPointer<ReceivedMessage> message, Sha
 
         auto permissionErrorPacket = NLPacket::create(PacketType::AssetUploadReply, sizeof(MessageID) + sizeof(AssetServerError), true);
 
+        // the rest of the message may still be arriving, only read from its head and drop the rest as it comes
         MessageID messageID;
-        message->readPrimitive(&messageID);
+        message->readHeadPrimitive(&messageID);
+        message->discardReceivedData();
 
         // write the message ID and a permission denied error
         permissionErrorPacket->writePrimitive(messageID);
@@ -419,6 +670,80 @@ void AssetServer::handleAssetUpload(QSharedPointer<ReceivedMessage> message, Sha
     }
 }
 
+void AssetServer::handleAssetChunkQuery(QSharedPointer<ReceivedMessage> message, SharedNodePointer senderNode) {
+    MessageID messageID;
+    message->readPrimitive(&messageID);
+
+    auto replyPacket = NLPacketList::create(PacketType::AssetChunkQueryReply, QByteArray(), true, true);
+    replyPacket->writePrimitive(messageID);
+
+    if (!senderNode->getCanWriteToAssetServer()) {
+        replyPacket->writePrimitive(AssetServerError::PermissionDenied);
+    } else if (!_chunkedUploadsEnabled || _isCollectingChunks) {
+        // the client will fall back to a regular upload, the chunks we have may be going away while we collect them
+        replyPacket->writePrimitive(AssetServerError::ChunkedUploadsDisabled);
+    } else {
+        _lastChunkQueryUsecs = usecTimestampNow();
+
+        uint32_t numChunks { 0 };
+        message->readPrimitive(&numChunks);
+
+        std::vector<uint32_t> missingChunks;
+
+        for (uint32_t i = 0; i < numChunks && message->getBytesLeftToRead() >= (qint64)SHA256_HASH_LENGTH; ++i) {
+            auto chunkHash = message->readWithoutCopy(SHA256_HASH_LENGTH);
+            if (!_chunkStore->hasChunk(chunkHash)) {
+                missingChunks.push_back(i);
+            }
+        }
+
+        qDebug() << "Asset-server is missing" << missingChunks.size() << "of" << numChunks << "chunks for upload from"
+            << uuidStringWithoutCurlyBraces(senderNode->getUUID());
+
+        replyPacket->writePrimitive(AssetServerError::NoError);
+        replyPacket->writePrimitive((uint32_t)missingChunks.size());
+        for (auto chunkIndex : missingChunks) {
+            replyPacket->writePrimitive(chunkIndex);
+        }
+    }
+
+    auto nodeList = DependencyManager::get<NodeList>();
+    nodeList->sendPacketList(std::move(replyPacket), *senderNode);
+}
+
+void AssetServer::handleAssetChunkedUpload(QSharedPointer<ReceivedMessage> message, SharedNodePointer senderNode) {
+    if (senderNode->getCanWriteToAssetServer() && _chunkedUploadsEnabled) {
+        qDebug() << "Starting an UploadChunkedAssetTask for upload from" << uuidStringWithoutCurlyBraces(senderNode->getUUID());
+
+        // the task consumes the chunks on the upload pool as they arrive and deletes itself once done
+        auto task = new UploadChunkedAssetTask(message, senderNode, _uploadTaskPool, _filesDirectory, _chunkStore,
+                                               _compressedStore);
+
+        // an upload that failed leaves the chunks it had written behind
+        ++_chunkedUploadsInProgress;
+        connect(task, &QObject::destroyed, this, [this] {
+            --_chunkedUploadsInProgress;
+            _mayHaveUnreferencedChunks = true;
+        });
+
+        task->start();
+    } else {
+        auto errorPacket = NLPacket::create(PacketType::AssetUploadReply, sizeof(MessageID) + sizeof(AssetServerError), true);
+
+        // the rest of the message may still be arriving, only read from its head and drop the rest as it comes
+        MessageID messageID;
+        message->readHeadPrimitive(&messageID);
+        message->discardReceivedData();
+
+        errorPacket->writePrimitive(messageID);
+        errorPacket->writePrimitive(senderNode->getCanWriteToAssetServer() ? AssetServerError::ChunkedUploadsDisabled
+                                                                           : AssetServerError::PermissionDenied);
+
+        auto nodeList = DependencyManager::get<NodeList>();
+        nodeList->sendPacket(std::move(errorPacket), *senderNode);
+    }
+}
+
 void AssetServer::sendStatsPacket() {
     QJsonObject serverStats;
 
@@ -484,81 +809,247 @@ void AssetServer::sendStatsPacket() {
         serverStats[uuid] = nodeStats;
     }
 
+    serverStats["Asset Cache"] = _assetCache->getStats();
+
     // send off the stats packets
     ThreadedAssignment::addPacketStatsAndSendStatsPacket(serverStats);
 }
 
 static const QString MAP_FILE_NAME = "map.json";
+static const QString MAP_JOURNAL_FILE_NAME = "map.journal";
+
+static const QString JOURNAL_SET_KEY = "set";
+static const QString JOURNAL_REMOVE_KEY = "remove";
+
+// the journal is compacted into the map file once it grows past the size of the map file itself
+// (or this minimum), which keeps the cost of rewriting the map file amortized over the operations
+static const qint64 MIN_JOURNAL_COMPACTION_SIZE = 1024 * 1024;
 
 bool AssetServer::loadMappingsFromFile() {
 
     auto mapFilePath = _resourcesDirectory.absoluteFilePath(MAP_FILE_NAME);
 
+    _fileMappings.clear();
+
     QFile mapFile { mapFilePath };
     if (mapFile.exists()) {
-        if (mapFile.open(QIODevice::ReadOnly)) {
-            QJsonParseError error;
-
-            auto jsonDocument = QJsonDocument::fromJson(mapFile.readAll(), &error);
-
-            if (error.error == QJsonParseError::NoError) {
-                _fileMappings = jsonDocument.object().toVariantHash();
-
-                // remove any mappings that don't match the expected format
-                auto it = _fileMappings.begin();
-                while (it != _fileMappings.end()) {
-                    bool shouldDrop = false;
-
-                    if (!isValidFilePath(it.key())) {
-                        qWarning() << "Will not keep mapping for" << it.key() << "since it is not a valid path.";
-                        shouldDrop = true;
-                    }
-
-                    if (!isValidHash(it.value().toString())) {
-                        qWarning() << "Will not keep mapping for" << it.key() << "since it does not have a valid hash.";
-                        shouldDrop = true;
-                    }
-
-                    if (shouldDrop) {
-                        it = _fileMappings.erase(it);
-                    } else {
-                        ++it;
-                    }
-                }
+        if (!mapFile.open(QIODevice::ReadOnly)) {
+            qCritical() << "Failed to read mapping file at" << mapFilePath;
+            return false;
+        }
 
-                qInfo() << "Loaded" << _fileMappings.count() << "mappings from map file at" << mapFilePath;
-                return true;
-            }
+        QJsonParseError error;
+        auto jsonDocument = QJsonDocument::fromJson(mapFile.readAll(), &error);
+
+        if (error.error != QJsonParseError::NoError) {
+            qCritical() << "Failed to read mapping file at" << mapFilePath;
+            return false;
         }
 
-        qCritical() << "Failed to read mapping file at" << mapFilePath;
-        return false;
+        auto jsonObject = jsonDocument.object();
+        for (auto it = jsonObject.constBegin(); it != jsonObject.constEnd(); ++it) {
+            _fileMappings.insert(it.key(), it.value().toString());
+        }
+
+        _mappingsFileSize = mapFile.size();
     } else {
         qInfo() << "No existing mappings loaded from file since no file was found at" << mapFilePath;
     }
 
-    return true;
+    // replay whatever was journaled since the map file was last written
+    int replayedTransactions = replayMappingsJournal();
+    if (replayedTransactions < 0) {
+        return false;
+    }
+
+    // remove any mappings that don't match the expected format
+    auto it = _fileMappings.begin();
+    while (it != _fileMappings.end()) {
+        bool shouldDrop = false;
+
+        if (!isValidFilePath(it.key())) {
+            qWarning() << "Will not keep mapping for" << it.key() << "since it is not a valid path.";
+            shouldDrop = true;
+        }
+
+        if (!isValidHash(it.value())) {
+            qWarning() << "Will not keep mapping for" << it.key() << "since it does not have a valid hash.";
+            shouldDrop = true;
+        }
+
+        if (shouldDrop) {
+            it = _fileMappings.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    _hashReferenceCounts.clear();
+    for (const auto& hash : _fileMappings) {
+        ++_hashReferenceCounts[hash];
+    }
+
+    qInfo() << "Loaded" << _fileMappings.count() << "mappings from map file at" << mapFilePath
+        << "and" << replayedTransactions << "transactions from its journal";
+
+    // fold the replayed journal into the map file, which also opens a fresh journal
+    return compactMappingsFile();
+}
+
+int AssetServer::replayMappingsJournal() {
+    auto journalFilePath = _resourcesDirectory.absoluteFilePath(MAP_JOURNAL_FILE_NAME);
+
+    QFile journalFile { journalFilePath };
+    if (!journalFile.exists()) {
+        return 0;
+    }
+
+    if (!journalFile.open(QIODevice::ReadOnly)) {
+        qCritical() << "Failed to read mapping journal at" << journalFilePath;
+        return -1;
+    }
+
+    int replayedTransactions = 0;
+
+    while (!journalFile.atEnd()) {
+        auto line = journalFile.readLine();
+
+        QJsonParseError error;
+        auto jsonDocument = QJsonDocument::fromJson(line, &error);
+
+        if (error.error != QJsonParseError::NoError || !line.endsWith('\n')) {
+            // a transaction is a single line, a torn or corrupted one was never acknowledged so we stop here
+            qWarning() << "Ignoring incomplete transaction at the end of mapping journal" << journalFilePath;
+            break;
+        }
+
+        auto transaction = jsonDocument.object();
+
+        Mappings setMappings;
+        auto setObject = transaction[JOURNAL_SET_KEY].toObject();
+        for (auto it = setObject.constBegin(); it != setObject.constEnd(); ++it) {
+            setMappings.insert(it.key(), it.value().toString());
+        }
+
+        AssetPathList removedPaths;
+        for (const auto& path : transaction[JOURNAL_REMOVE_KEY].toArray()) {
+            removedPaths << path.toString();
+        }
+
+        applyMappingChanges(setMappings, removedPaths);
+        ++replayedTransactions;
+    }
+
+    return replayedTransactions;
 }
 
-bool AssetServer::writeMappingsToFile() {
+bool AssetServer::compactMappingsFile() {
     auto mapFilePath = _resourcesDirectory.absoluteFilePath(MAP_FILE_NAME);
 
-    QFile mapFile { mapFilePath };
-    if (mapFile.open(QIODevice::WriteOnly)) {
-        auto jsonObject = QJsonObject::fromVariantHash(_fileMappings);
-        QJsonDocument jsonDocument { jsonObject };
+    QJsonObject jsonObject;
+    for (auto it = _fileMappings.cbegin(); it != _fileMappings.cend(); ++it) {
+        jsonObject.insert(it.key(), it.value());
+    }
+    auto jsonData = QJsonDocument(jsonObject).toJson();
 
-        if (mapFile.write(jsonDocument.toJson()) != -1) {
-            qDebug() << "Wrote JSON mappings to file at" << mapFilePath;
-            return true;
+    // write the new map file atomically so that a crash leaves either the old map file and its journal, or the new one
+    QSaveFile mapFile { mapFilePath };
+    if (!mapFile.open(QIODevice::WriteOnly) || mapFile.write(jsonData) != jsonData.size() || !mapFile.commit()) {
+        qWarning() << "Failed to write JSON mappings to file at" << mapFilePath;
+        return false;
+    }
+
+    qDebug() << "Wrote JSON mappings to file at" << mapFilePath;
+    _mappingsFileSize = jsonData.size();
+
+    // everything in the journal is now in the map file, start it over
+    _mappingsJournal.close();
+    _mappingsJournal.setFileName(_resourcesDirectory.absoluteFilePath(MAP_JOURNAL_FILE_NAME));
+
+    if (!_mappingsJournal.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "Failed to open mapping journal at" << _mappingsJournal.fileName();
+        return false;
+    }
+
+    return true;
+}
+
+bool AssetServer::commitMappingChanges(const Mappings& setMappings, const AssetPathList& removedPaths) {
+    if (setMappings.isEmpty() && removedPaths.isEmpty()) {
+        return true;
+    }
+
+    if (!_mappingsJournal.isOpen()) {
+        qWarning() << "Cannot persist mapping changes since the mapping journal is not open";
+        return false;
+    }
+
+    QJsonObject transaction;
+
+    if (!setMappings.isEmpty()) {
+        QJsonObject setObject;
+        for (auto it = setMappings.cbegin(); it != setMappings.cend(); ++it) {
+            setObject.insert(it.key(), it.value());
+        }
+        transaction[JOURNAL_SET_KEY] = setObject;
+    }
+
+    if (!removedPaths.isEmpty()) {
+        transaction[JOURNAL_REMOVE_KEY] = QJsonArray::fromStringList(removedPaths);
+    }
+
+    auto line = QJsonDocument(transaction).toJson(QJsonDocument::Compact) + '\n';
+
+    auto journalSize = _mappingsJournal.size();
+    if (_mappingsJournal.write(line) != line.size() || !_mappingsJournal.flush()) {
+        qWarning() << "Failed to write mapping transaction to journal at" << _mappingsJournal.fileName();
+
+        // drop whatever part of the transaction made it to the journal
+        _mappingsJournal.resize(journalSize);
+        return false;
+    }
+
+    // the transaction is persisted, it can now be applied in memory
+    applyMappingChanges(setMappings, removedPaths);
+
+    if (_mappingsJournal.size() > std::max(MIN_JOURNAL_COMPACTION_SIZE, _mappingsFileSize)) {
+        if (!compactMappingsFile()) {
+            // the mappings are safe in the old map file and its journal, we'll try again on the next change
+            qWarning() << "Failed to compact mapping journal";
+        }
+    }
+
+    return true;
+}
+
+void AssetServer::applyMappingChanges(const Mappings& setMappings, const AssetPathList& removedPaths) {
+    // removals are applied first so that a transaction can move mappings within overlapping folders
+    for (const auto& path : removedPaths) {
+        auto it = _fileMappings.find(path);
+        if (it != _fileMappings.end()) {
+            releaseHashReference(it.value());
+            _fileMappings.erase(it);
+        }
+    }
+
+    for (auto it = setMappings.cbegin(); it != setMappings.cend(); ++it) {
+        auto existing = _fileMappings.find(it.key());
+        if (existing != _fileMappings.end()) {
+            releaseHashReference(existing.value());
+            existing.value() = it.value();
         } else {
-            qWarning() << "Failed to write JSON mappings to file at" << mapFilePath;
+            _fileMappings.insert(it.key(), it.value());
         }
-    } else {
-        qWarning() << "Failed to open map file at" << mapFilePath;
+
+        ++_hashReferenceCounts[it.value()];
     }
+}
 
-    return false;
+void AssetServer::releaseHashReference(const AssetHash& hash) {
+    auto it = _hashReferenceCounts.find(hash);
+    if (it != _hashReferenceCounts.end() && --it.value() <= 0) {
+        _hashReferenceCounts.erase(it);
+    }
 }
 
 bool AssetServer::setMapping(AssetPath path, AssetHash hash) {
@@ -574,27 +1065,13 @@ bool AssetServer::setMapping(AssetPath path, AssetHash hash) {
         return false;
     }
 
-    // remember what the old mapping was in case persistence fails
-    auto oldMapping = _fileMappings.value(path).toString();
-
-    // update the in memory QHash
-    _fileMappings[path] = hash;
-
-    // attempt to write to file
-    if (writeMappingsToFile()) {
+    if (commitMappingChanges({ { path, hash } }, {})) {
         // persistence succeeded, we are good to go
         qDebug() << "Set mapping:" << path << "=>" << hash;
+        bakeTextureIfNeeded(path, hash);
         return true;
     } else {
-        // failed to persist this mapping to file - put back the old one in our in-memory representation
-        if (oldMapping.isEmpty()) {
-            _fileMappings.remove(path);
-        } else {
-            _fileMappings[path] = oldMapping;
-        }
-
         qWarning() << "Failed to persist mapping:" << path << "=>" << hash;
-
         return false;
     }
 }
@@ -603,88 +1080,74 @@ bool pathIsFolder(const AssetPath& path) {
     return path.endsWith('/');
 }
 
-bool AssetServer::deleteMappings(AssetPathList& paths) {
-    // take a copy of the current mappings in case persistence of these deletes fails
-    auto oldMappings = _fileMappings;
+AssetPathList AssetServer::mappingsInFolder(const AssetPath& folder) const {
+    AssetPathList paths;
+
+    // mappings are sorted by path, so everything in the folder is in a single range starting at the folder path
+    for (auto it = _fileMappings.lowerBound(folder); it != _fileMappings.cend() && it.key().startsWith(folder); ++it) {
+        paths << it.key();
+    }
+
+    return paths;
+}
 
+bool AssetServer::deleteMappings(AssetPathList& paths) {
+    AssetPathList removedPaths;
     QSet<QString> hashesToCheckForDeletion;
 
-    // enumerate the paths to delete and remove them all
+    // enumerate the paths to delete and collect the mappings they remove
     for (auto& path : paths) {
 
         path = path.trimmed();
 
         // figure out if this path will delete a file or folder
         if (pathIsFolder(path)) {
-            // enumerate the in memory file mappings and remove anything that matches
-            auto it = _fileMappings.begin();
-            auto sizeBefore = _fileMappings.size();
-
-            while (it != _fileMappings.end()) {
-                if (it.key().startsWith(path)) {
-                    // add this hash to the list we need to check for asset removal from the server
-                    hashesToCheckForDeletion << it.value().toString();
+            auto folderPaths = mappingsInFolder(path);
 
-                    it = _fileMappings.erase(it);
-                } else {
-                    ++it;
-                }
-            }
-
-            auto sizeNow = _fileMappings.size();
-            if (sizeBefore != sizeNow) {
-                qDebug() << "Deleted" << sizeBefore - sizeNow << "mappings in folder: " << path;
+            if (!folderPaths.isEmpty()) {
+                qDebug() << "Deleting" << folderPaths.size() << "mappings in folder: " << path;
             } else {
                 qDebug() << "Did not find any mappings to delete in folder:" << path;
             }
 
+            for (const auto& folderPath : folderPaths) {
+                // add this hash to the list we need to check for asset removal from the server
+                hashesToCheckForDeletion << _fileMappings.value(folderPath);
+            }
+            removedPaths << folderPaths;
         } else {
-            auto oldMapping = _fileMappings.take(path);
-            if (!oldMapping.isNull()) {
+            auto it = _fileMappings.find(path);
+            if (it != _fileMappings.end()) {
                 // add this hash to the list we need to check for asset removal from server
-                hashesToCheckForDeletion << oldMapping.toString();
+                hashesToCheckForDeletion << it.value();
+                removedPaths << path;
 
-                qDebug() << "Deleted a mapping:" << path << "=>" << oldMapping.toString();
+                qDebug() << "Deleting a mapping:" << path << "=>" << it.value();
             } else {
                 qDebug() << "Unable to delete a mapping that was not found:" << path;
             }
         }
     }
 
-    // deleted the old mappings, attempt to persist to file
-    if (writeMappingsToFile()) {
-        // persistence succeeded we are good to go
+    removedPaths.removeDuplicates();
 
-        // grab the current mapped hashes
-        auto mappedHashes = _fileMappings.values();
+    // attempt to persist the deletions
+    if (commitMappingChanges({}, removedPaths)) {
+        // persistence succeeded we are good to go
 
-        // enumerate the mapped hashes and clear the list of hashes to check for anything that's present
-        for (auto& hashVariant : mappedHashes) {
-            auto it = hashesToCheckForDeletion.find(hashVariant.toString());
-            if (it != hashesToCheckForDeletion.end()) {
-                hashesToCheckForDeletion.erase(it);
+        // we now have a set of hashes that might be unmapped - we will delete those asset files
+        for (auto& hash : hashesToCheckForDeletion) {
+            if (_hashReferenceCounts.contains(hash)) {
+                continue;
             }
-        }
 
-        // we now have a set of hashes that are unmapped - we will delete those asset files
-        for (auto& hash : hashesToCheckForDeletion) {
             // remove the unmapped file
-            QFile removeableFile { _filesDirectory.absoluteFilePath(hash) };
-
-            if (removeableFile.remove()) {
-                qDebug() << "\tDeleted" << hash << "from asset files directory since it is now unmapped.";
-            } else {
-                qDebug() << "\tAttempt to delete unmapped file" << hash << "failed";
-            }
+            removeAssetFile(hash);
         }
 
         return true;
     } else {
-        qWarning() << "Failed to persist deleted mappings, rolling back";
-
-        // we didn't delete the previous mapping, put it back in our in-memory representation
-        _fileMappings = oldMappings;
-
+        qWarning() << "Failed to persist deleted mappings";
         return false;
     }
 }
@@ -709,34 +1172,23 @@ bool AssetServer::renameMapping(AssetPath oldPath, AssetPath newPath) {
             return false;
         }
 
-        // take a copy of the old mappings
-        auto oldMappings = _fileMappings;
-
-        // iterate the current mappings and adjust any that matches the renamed folder
-        auto it = oldMappings.begin();
+        // move every mapping in the old folder to the new one
+        auto removedPaths = mappingsInFolder(oldPath);
 
-        while (it != oldMappings.end()) {
-            if (it.key().startsWith(oldPath)) {
-                auto newKey = it.key();
-                newKey.replace(0, oldPath.size(), newPath);
-
-                // remove the old version from the in memory file mappings
-                _fileMappings.remove(it.key());
-                _fileMappings.insert(newKey, it.value());
-            }
+        Mappings setMappings;
+        for (const auto& path : removedPaths) {
+            auto newKey = path;
+            newKey.replace(0, oldPath.size(), newPath);
 
-            ++it;
+            setMappings.insert(newKey, _fileMappings.value(path));
         }
 
-        if (writeMappingsToFile()) {
+        if (commitMappingChanges(setMappings, removedPaths)) {
             // persisted the changed mappings, return success
             qDebug() << "Renamed folder mapping:" << oldPath << "=>" << newPath;
 
             return true;
         } else {
-            // couldn't persist the renamed paths, rollback and return failure
-            _fileMappings = oldMappings;
-
             qWarning() << "Failed to persist renamed folder mapping:" << oldPath << "=>" << newPath;
 
             return false;
@@ -749,32 +1201,15 @@ bool AssetServer::renameMapping(AssetPath oldPath, AssetPath newPath) {
             return false;
         }
 
-        // take the old hash to remove the old mapping
-        auto oldSourceMapping = _fileMappings.take(oldPath).toString();
-
-        // in case we're overwriting, keep the current destination mapping for potential rollback
-        auto oldDestinationMapping = _fileMappings.value(newPath);
-
-        if (!oldSourceMapping.isEmpty()) {
-            _fileMappings[newPath] = oldSourceMapping;
+        auto it = _fileMappings.find(oldPath);
 
-            if (writeMappingsToFile()) {
+        if (it != _fileMappings.end()) {
+            if (commitMappingChanges({ { newPath, it.value() } }, { oldPath })) {
                 // persisted the renamed mapping, return success
                 qDebug() << "Renamed mapping:" << oldPath << "=>" << newPath;
 
                 return true;
             } else {
-                // we couldn't persist the renamed mapping, rollback and return failure
-                _fileMappings[oldPath] = oldSourceMapping;
-
-                if (!oldDestinationMapping.isNull()) {
-                    // put back the overwritten mapping for the destination path
-                    _fileMappings[newPath] = oldDestinationMapping.toString();
-                } else {
-                    // clear the new mapping
-                    _fileMappings.remove(newPath);
-                }
-
                 qDebug() << "Failed to persist renamed mapping:" << oldPath << "=>" << newPath;
 
                 return false;
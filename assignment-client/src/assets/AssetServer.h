@@ -13,11 +13,17 @@
 #define hifi_AssetServer_h
 
 #include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QMap>
 #include <QtCore/QThreadPool>
 
 #include <ThreadedAssignment.h>
 
+#include "AssetCache.h"
+#include "AssetChunkStore.h"
 #include "AssetUtils.h"
+#include "BakedTextureStore.h"
+#include "CompressedAssetStore.h"
 #include "ReceivedMessage.h"
 
 class AssetServer : public ThreadedAssignment {
@@ -34,22 +40,45 @@ private slots:
     void handleAssetGetInfo(QSharedPointer<ReceivedMessage> packet, SharedNodePointer senderNode);
     void handleAssetGet(QSharedPointer<ReceivedMessage> packet, SharedNodePointer senderNode);
     void handleAssetUpload(QSharedPointer<ReceivedMessage> packetList, SharedNodePointer senderNode);
+    void handleAssetChunkQuery(QSharedPointer<ReceivedMessage> message, SharedNodePointer senderNode);
+    void handleAssetChunkedUpload(QSharedPointer<ReceivedMessage> message, SharedNodePointer senderNode);
     void handleAssetMappingOperation(QSharedPointer<ReceivedMessage> message, SharedNodePointer senderNode);
 
     void sendStatsPacket() override;
 
+    // deletes the chunks no longer used by any asset on the task pool, when no chunked upload can be relying on them
+    void collectUnreferencedChunks();
+
 private:
-    using Mappings = QVariantHash;
+    // sorted by path so that the mappings in a folder can be found without scanning all of them
+    using Mappings = QMap<AssetPath, AssetHash>;
 
     void handleGetMappingOperation(ReceivedMessage& message, SharedNodePointer senderNode, NLPacketList& replyPacket);
     void handleGetAllMappingOperation(ReceivedMessage& message, SharedNodePointer senderNode, NLPacketList& replyPacket);
     void handleSetMappingOperation(ReceivedMessage& message, SharedNodePointer senderNode, NLPacketList& replyPacket);
     void handleDeleteMappingsOperation(ReceivedMessage& message, SharedNodePointer senderNode, NLPacketList& replyPacket);
     void handleRenameMappingOperation(ReceivedMessage& message, SharedNodePointer senderNode, NLPacketList& replyPacket);
+    void handleGetBakedTextureOperation(ReceivedMessage& message, SharedNodePointer senderNode, NLPacketList& replyPacket);
+    void handleGetServerCapabilitiesOperation(ReceivedMessage& message, SharedNodePointer senderNode,
+                                              NLPacketList& replyPacket);
 
     // Mapping file operations must be called from main assignment thread only
+    // Mappings are persisted as a JSON map file plus a journal of the transactions applied since it was written.
     bool loadMappingsFromFile();
-    bool writeMappingsToFile();
+
+    /// Replays the mapping journal on top of the loaded map file. Returns the number of transactions replayed, or -1 on error.
+    int replayMappingsJournal();
+
+    /// Rewrites the map file from the in-memory mappings and starts a new, empty journal
+    bool compactMappingsFile();
+
+    /// Journals a transaction of mapping changes and applies it in memory once persisted. Returns `true` on success.
+    bool commitMappingChanges(const Mappings& setMappings, const AssetPathList& removedPaths);
+    void applyMappingChanges(const Mappings& setMappings, const AssetPathList& removedPaths);
+    void releaseHashReference(const AssetHash& hash);
+
+    /// Returns the paths of all the mappings in `folder`
+    AssetPathList mappingsInFolder(const AssetPath& folder) const;
 
     /// Set the mapping for path to hash
     bool setMapping(AssetPath path, AssetHash hash);
@@ -63,11 +92,49 @@ private:
     // deletes any unmapped files from the local asset directory
     void cleanupUnmappedFiles();
 
+    // queues the baking of the asset mapped at `path` into a KTX texture, if it is an image that wasn't baked yet
+    void bakeTextureIfNeeded(const AssetPath& path, const AssetHash& hash);
+
+    // deletes the temporary files of uploads that never completed
+    void removeIncompleteUploads();
+
+    // deletes the local asset file and manifest, an asset uploaded both whole and in chunks has both
+    void removeAssetFile(const AssetHash& hash);
+
     Mappings _fileMappings;
 
+    // number of mappings pointing at each hash, used to find unmapped asset files
+    QHash<AssetHash, int> _hashReferenceCounts;
+
+    QFile _mappingsJournal;
+    qint64 _mappingsFileSize { 0 };
+
     QDir _resourcesDirectory;
     QDir _filesDirectory;
+
+    // shared with the SendAssetTasks, which can outlive us while the task pool drains
+    std::shared_ptr<AssetCache> _assetCache { std::make_shared<AssetCache>() };
+
+    // assets uploaded in chunks are stored deduplicated here, whether or not chunked uploads are currently enabled
+    std::shared_ptr<AssetChunkStore> _chunkStore { std::make_shared<AssetChunkStore>() };
+    bool _chunkedUploadsEnabled { false };
+
+    // chunks can only be collected while no upload relies on them, the ones that were queried for included
+    int _chunkedUploadsInProgress { 0 };
+    quint64 _lastChunkQueryUsecs { 0 };
+    bool _mayHaveUnreferencedChunks { false };
+    bool _isCollectingChunks { false };
+
+    // gzipped copies of text-like assets, generated by the upload tasks
+    std::shared_ptr<CompressedAssetStore> _compressedStore { std::make_shared<CompressedAssetStore>() };
+
+    // KTX textures baked from the mapped images, used by the clients instead of processing the images themselves
+    std::shared_ptr<BakedTextureStore> _bakedTextureStore { std::make_shared<BakedTextureStore>() };
+    bool _textureBakingEnabled { false };
+
     QThreadPool _taskPool;
+    QThreadPool _uploadTaskPool;
+    QThreadPool _bakeTaskPool;
 };
 
 #endif
@@ -0,0 +1,113 @@
+//
+//  BakeTextureTask.cpp
+//  assignment-client/src/assets
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "BakeTextureTask.h"
+
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDebug>
+#include <QtCore/QFile>
+#include <QtCore/QSaveFile>
+
+#include <gpu/Texture.h>
+#include <image/Image.h>
+#include <ktx/KTX.h>
+#include <Profile.h>
+
+BakeTextureTask::BakeTextureTask(const AssetHash& hash, const QDir& resourcesDir, std::shared_ptr<AssetChunkStore> chunkStore,
+                                 std::shared_ptr<BakedTextureStore> bakedStore) :
+    _hash(hash),
+    _resourcesDir(resourcesDir),
+    _chunkStore(chunkStore),
+    _bakedStore(bakedStore)
+{
+
+}
+
+void BakeTextureTask::run() {
+    PROFILE_RANGE_EX(resource_parse_image, "BakeTextureTask", 0xffff0000, 0, { { "hash", _hash } });
+
+    auto data = readAsset();
+
+    AssetHash bakedHash;
+    bool wroteBakedFile = false;
+    if (data.isNull()) {
+        qWarning() << "Failed to read asset" << _hash << "to bake it";
+    } else {
+        bakedHash = bake(data, wroteBakedFile);
+    }
+
+    if (!_bakedStore->finishBake(_hash, bakedHash)) {
+        qDebug() << "Asset" << _hash << "was removed while it was baked, dropping its baked texture";
+
+        // only remove the KTX written for this bake, and only if no other image was baked into it since
+        if (wroteBakedFile && !_bakedStore->isBakedTexture(bakedHash)) {
+            QFile::remove(_resourcesDir.filePath(bakedHash));
+        }
+    }
+}
+
+QByteArray BakeTextureTask::readAsset() const {
+    QFile file { _resourcesDir.filePath(_hash) };
+
+    if (file.open(QIODevice::ReadOnly)) {
+        auto data = file.readAll();
+        return data.size() == file.size() ? data : QByteArray();
+    }
+
+    // assets uploaded in chunks don't have a file
+    auto size = _chunkStore->getAssetSize(_hash);
+    if (size >= 0) {
+        auto data = _chunkStore->readAsset(_hash, 0, size);
+        return data.size() == size ? data : QByteArray();
+    }
+
+    return QByteArray();
+}
+
+AssetHash BakeTextureTask::bake(const QByteArray& data, bool& wroteBakedFile) const {
+    // clients use the baked texture in place of the ones they make for color maps, which are all processed the same way.
+    // The compression is given explicitly, the assignment-client has no settings to read the clients' one from.
+    static const QVariantMap BAKE_OPTIONS { { "compress", false } };
+    auto texture = image::processImage(data, _hash.toStdString(), ABSOLUTE_MAX_TEXTURE_NUM_PIXELS,
+                                       image::TextureUsage::DEFAULT_TEXTURE, BAKE_OPTIONS);
+    if (!texture) {
+        qDebug() << "Asset" << _hash << "is not an image that can be baked";
+        return AssetHash();
+    }
+
+    // clients key their local KTX cache by the MD5 of the image, the baked texture carries it so that both are interchangeable
+    texture->setSourceHash(QCryptographicHash::hash(data, QCryptographicHash::Md5).toHex().toStdString());
+
+    auto memKtx = gpu::Texture::serialize(*texture);
+    if (!memKtx) {
+        qWarning() << "Failed to serialize the texture baked from" << _hash;
+        return AssetHash();
+    }
+
+    auto ktxData = QByteArray::fromRawData(reinterpret_cast<const char*>(memKtx->_storage->data()), (int)memKtx->_storage->size());
+    AssetHash bakedHash = hashData(ktxData).toHex();
+
+    QString filePath = _resourcesDir.filePath(bakedHash);
+
+    // the same KTX may already have been baked from an identical image, or uploaded as is
+    if (!QFile::exists(filePath)) {
+        QSaveFile file { filePath };
+
+        if (!file.open(QIODevice::WriteOnly) || file.write(ktxData) != ktxData.size() || !file.commit()) {
+            qWarning() << "Failed to write the texture baked from" << _hash;
+            return AssetHash();
+        }
+
+        wroteBakedFile = true;
+    }
+
+    qDebug() << "Baked" << _hash << "into" << bakedHash << "-" << data.size() << "to" << ktxData.size() << "bytes";
+    return bakedHash;
+}
@@ -0,0 +1,46 @@
+//
+//  BakeTextureTask.h
+//  assignment-client/src/assets
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#pragma once
+
+#ifndef hifi_BakeTextureTask_h
+#define hifi_BakeTextureTask_h
+
+#include <memory>
+
+#include <QtCore/QDir>
+#include <QtCore/QRunnable>
+
+#include "AssetChunkStore.h"
+#include "AssetUtils.h"
+#include "BakedTextureStore.h"
+
+// Processes an image asset into the KTX texture the clients would make of it, and stores it as an asset of its own
+class BakeTextureTask : public QRunnable {
+public:
+    BakeTextureTask(const AssetHash& hash, const QDir& resourcesDir, std::shared_ptr<AssetChunkStore> chunkStore,
+                    std::shared_ptr<BakedTextureStore> bakedStore);
+
+    void run() override;
+
+private:
+    QByteArray readAsset() const;
+
+    // returns the hash of the baked KTX, or an empty hash if the asset couldn't be baked.
+    // `wroteBakedFile` is set if the KTX file didn't exist before.
+    AssetHash bake(const QByteArray& data, bool& wroteBakedFile) const;
+
+    AssetHash _hash;
+    QDir _resourcesDir;
+    std::shared_ptr<AssetChunkStore> _chunkStore;
+    std::shared_ptr<BakedTextureStore> _bakedStore;
+};
+
+#endif // hifi_BakeTextureTask_h
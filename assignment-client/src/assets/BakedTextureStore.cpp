@@ -0,0 +1,120 @@
+//
+//  BakedTextureStore.cpp
+//  assignment-client/src/assets
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "BakedTextureStore.h"
+
+#include <QtCore/QDebug>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QSaveFile>
+
+static const QString ASSET_BAKED_SUBDIR = "baked";
+static const QString BAKE_RECORD_FILE_SUFFIX = ".bake";
+
+bool BakedTextureStore::isBakeablePath(const AssetPath& path) {
+    static const QStringList BAKEABLE_EXTENSIONS { "png", "jpg", "jpeg", "tga", "bmp" };
+
+    return BAKEABLE_EXTENSIONS.contains(QFileInfo(path).suffix(), Qt::CaseInsensitive);
+}
+
+bool BakedTextureStore::init(const QDir& resourcesDirectory) {
+    _bakedDirectory = resourcesDirectory;
+
+    if (!resourcesDirectory.mkpath(ASSET_BAKED_SUBDIR) || !_bakedDirectory.cd(ASSET_BAKED_SUBDIR)) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    for (const auto& fileName : _bakedDirectory.entryList({ "*" + BAKE_RECORD_FILE_SUFFIX }, QDir::Files)) {
+        QFile file { _bakedDirectory.filePath(fileName) };
+
+        if (file.open(QIODevice::ReadOnly)) {
+            auto hash = fileName.left(fileName.size() - BAKE_RECORD_FILE_SUFFIX.size());
+            auto bakedHash = QString::fromLatin1(file.readAll()).trimmed();
+
+            // an empty record is an image that failed to bake
+            _bakedHashes[hash] = bakedHash;
+            if (!bakedHash.isEmpty()) {
+                _bakedTextures.insert(bakedHash);
+            }
+        }
+    }
+
+    return true;
+}
+
+bool BakedTextureStore::startBake(const AssetHash& hash) {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (_bakedHashes.contains(hash) || _pendingBakes.contains(hash)) {
+        return false;
+    }
+
+    _pendingBakes.insert(hash);
+    return true;
+}
+
+bool BakedTextureStore::finishBake(const AssetHash& hash, const AssetHash& bakedHash) {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    // the asset was removed while it was being baked, its record would outlive it
+    if (!_pendingBakes.remove(hash)) {
+        return false;
+    }
+
+    QSaveFile file { filePathFor(hash) };
+    bool recorded = file.open(QIODevice::WriteOnly) && file.write(bakedHash.toLatin1()) == bakedHash.size() && file.commit();
+
+    if (!recorded) {
+        qWarning() << "Failed to record the baked texture of" << hash;
+    }
+
+    // keep the result in memory either way, the bake will be attempted again on the next start if it wasn't recorded
+    _bakedHashes[hash] = bakedHash;
+    if (!bakedHash.isEmpty()) {
+        _bakedTextures.insert(bakedHash);
+    }
+
+    return true;
+}
+
+AssetHash BakedTextureStore::getBakedTextureHash(const AssetHash& hash) const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _bakedHashes.value(hash);
+}
+
+bool BakedTextureStore::isBakedTexture(const AssetHash& bakedHash) const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _bakedTextures.contains(bakedHash);
+}
+
+AssetHash BakedTextureStore::removeBakeRecord(const AssetHash& hash) {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    QFile::remove(filePathFor(hash));
+
+    // a bake still running for the asset is dropped when it finishes
+    _pendingBakes.remove(hash);
+
+    auto bakedHash = _bakedHashes.take(hash);
+    _bakedTextures.remove(bakedHash);
+
+    return bakedHash;
+}
+
+QStringList BakedTextureStore::getBakedAssetHashes() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _bakedHashes.keys();
+}
+
+QString BakedTextureStore::filePathFor(const AssetHash& hash) const {
+    return _bakedDirectory.filePath(hash + BAKE_RECORD_FILE_SUFFIX);
+}
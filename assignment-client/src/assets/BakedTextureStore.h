@@ -0,0 +1,64 @@
+//
+//  BakedTextureStore.h
+//  assignment-client/src/assets
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_BakedTextureStore_h
+#define hifi_BakedTextureStore_h
+
+#include <mutex>
+
+#include <QtCore/QDir>
+#include <QtCore/QHash>
+#include <QtCore/QSet>
+
+#include <AssetUtils.h>
+
+// Keeps track of the KTX textures baked from the images in the asset-server.
+// The KTX files are regular asset files, stored under their own hash so that clients can request ranges of them,
+// and this store records which image each of them was baked from.
+// Images that failed to bake are recorded too, so that they are not baked again.
+// Records are read and written by the bake tasks as well as the asset-server, all the methods are thread safe.
+class BakedTextureStore {
+public:
+    /// Returns true if the asset at `path` looks like an image that clients load as a texture
+    static bool isBakeablePath(const AssetPath& path);
+
+    bool init(const QDir& resourcesDirectory);
+
+    /// Marks the asset as being baked. Returns false if it was already baked, or is being baked.
+    bool startBake(const AssetHash& hash);
+
+    /// Records the hash of the KTX baked from an asset, or an empty hash if it could not be baked.
+    /// Returns false if the asset was removed while it was baked, in which case nothing is recorded.
+    bool finishBake(const AssetHash& hash, const AssetHash& bakedHash);
+
+    /// Returns the hash of the KTX baked from the asset, or an empty hash if there is none
+    AssetHash getBakedTextureHash(const AssetHash& hash) const;
+
+    /// Returns true if the asset is the KTX baked from another asset
+    bool isBakedTexture(const AssetHash& bakedHash) const;
+
+    /// Forgets the bake of an asset and returns the hash of the KTX it had, so that the caller can remove it.
+    /// A bake of the asset that is still running is cancelled.
+    AssetHash removeBakeRecord(const AssetHash& hash);
+
+    QStringList getBakedAssetHashes() const;
+
+private:
+    QString filePathFor(const AssetHash& hash) const;
+
+    QDir _bakedDirectory;
+
+    mutable std::mutex _mutex;
+    QHash<AssetHash, AssetHash> _bakedHashes;
+    QSet<AssetHash> _bakedTextures;
+    QSet<AssetHash> _pendingBakes;
+};
+
+#endif // hifi_BakedTextureStore_h
@@ -0,0 +1,182 @@
+//
+//  CompressedAssetStore.cpp
+//  assignment-client/src/assets
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "CompressedAssetStore.h"
+
+#include <algorithm>
+
+#include <QtCore/QDebug>
+#include <QtCore/QFile>
+#include <QtCore/QSaveFile>
+
+#include <Gzip.h>
+
+static const QString ASSET_COMPRESSED_SUBDIR = "compressed";
+static const QString GZIP_FILE_SUFFIX = ".gz";
+
+// a variant has to save at least this fraction of the asset size to be kept
+static const float MIN_COMPRESSION_SAVINGS = 0.1f;
+
+// text assets can have a few odd bytes in them (BOM, latin-1 comments...), but binary ones are full of them
+static const float MAX_BINARY_BYTE_RATIO = 0.05f;
+
+const int64_t CompressedAssetStore::MAX_COMPRESSIBLE_ASSET_SIZE = 64 * 1024 * 1024;
+const int CompressedAssetStore::COMPRESSIBLE_SAMPLE_SIZE = 4096;
+
+bool CompressedAssetStore::isCompressible(int64_t assetSize, const QByteArray& sample) {
+    if (assetSize > MAX_COMPRESSIBLE_ASSET_SIZE || sample.isEmpty()) {
+        return false;
+    }
+
+    int binaryBytes = 0;
+    for (auto byte : sample) {
+        auto c = static_cast<uint8_t>(byte);
+
+        if (c == 0) {
+            // no text format we serve has NUL bytes, binary FBX has one in its magic
+            return false;
+        }
+
+        // anything at or above 0x80 may be part of a UTF-8 sequence, only count the control characters
+        if (c < 0x20 && c != '\t' && c != '\n' && c != '\r' && c != '\f') {
+            ++binaryBytes;
+        }
+    }
+
+    return binaryBytes <= sample.size() * MAX_BINARY_BYTE_RATIO;
+}
+
+CompressedAssetStore::Compressor::Compressor(int64_t assetSize) :
+    _assetSize(assetSize)
+{
+}
+
+CompressedAssetStore::Compressor::~Compressor() {
+}
+
+void CompressedAssetStore::Compressor::addData(const QByteArray& data) {
+    int numSampled = 0;
+
+    if (_sample.size() < COMPRESSIBLE_SAMPLE_SIZE) {
+        numSampled = std::min(data.size(), COMPRESSIBLE_SAMPLE_SIZE - _sample.size());
+        _sample.append(data.constData(), numSampled);
+
+        if (_sample.size() == COMPRESSIBLE_SAMPLE_SIZE && isCompressible(_assetSize, _sample)) {
+            _compressor.reset(new GzipCompressor());
+            compress(_sample);
+        }
+    }
+
+    if (_compressor && numSampled < data.size()) {
+        compress(data.mid(numSampled));
+    }
+}
+
+void CompressedAssetStore::Compressor::compress(const QByteArray& data) {
+    // the compressed data only grows, once it is too large the rest of the asset won't make up for it
+    if (!_compressor->addData(data) || !isWorthKeeping(_assetSize, _compressor->getCompressedData().size())) {
+        _compressor.reset();
+    }
+}
+
+void CompressedAssetStore::Compressor::store(CompressedAssetStore& store, const AssetHash& hash) {
+    // the asset is stored either way, it just won't be sent compressed if this fails
+    if (_sample.size() < COMPRESSIBLE_SAMPLE_SIZE) {
+        // the whole asset fit in its sample
+        if (isCompressible(_assetSize, _sample)) {
+            store.compressAsset(hash, _sample);
+        }
+    } else if (_compressor && _compressor->finish()) {
+        store.storeCompressedAsset(hash, _assetSize, _compressor->getCompressedData());
+    }
+    _compressor.reset();
+}
+
+bool CompressedAssetStore::init(const QDir& resourcesDirectory) {
+    _compressedDirectory = resourcesDirectory;
+
+    return resourcesDirectory.mkpath(ASSET_COMPRESSED_SUBDIR) && _compressedDirectory.cd(ASSET_COMPRESSED_SUBDIR);
+}
+
+bool CompressedAssetStore::compressAsset(const AssetHash& hash, const QByteArray& data) {
+    if (hasCompressedAsset(hash)) {
+        return true;
+    }
+
+    QByteArray compressedData;
+    if (!gzip(data, compressedData)) {
+        qWarning() << "Failed to compress asset" << hash;
+        return false;
+    }
+
+    return storeCompressedAsset(hash, data.size(), compressedData);
+}
+
+bool CompressedAssetStore::storeCompressedAsset(const AssetHash& hash, int64_t assetSize, const QByteArray& compressedData) {
+    if (!isWorthKeeping(assetSize, compressedData.size())) {
+        // not worth the trouble of decompressing it on the other side
+        return false;
+    }
+
+    if (hasCompressedAsset(hash)) {
+        return true;
+    }
+
+    // concurrent uploads of the same asset write the same content, whichever commits last wins
+    QSaveFile file { filePathFor(hash) };
+
+    if (file.open(QIODevice::WriteOnly) && file.write(compressedData) == compressedData.size() && file.commit()) {
+        qDebug() << "Stored compressed variant of" << hash << "-" << assetSize << "to" << compressedData.size() << "bytes";
+        return true;
+    }
+
+    qWarning() << "Failed to write compressed variant of" << hash;
+    return false;
+}
+
+bool CompressedAssetStore::isWorthKeeping(int64_t assetSize, int64_t compressedSize) {
+    return compressedSize <= assetSize * (1.0f - MIN_COMPRESSION_SAVINGS);
+}
+
+bool CompressedAssetStore::hasCompressedAsset(const AssetHash& hash) const {
+    return QFile::exists(filePathFor(hash));
+}
+
+QByteArray CompressedAssetStore::readCompressedAsset(const AssetHash& hash) const {
+    QFile file { filePathFor(hash) };
+
+    if (file.open(QIODevice::ReadOnly)) {
+        auto data = file.readAll();
+
+        if (data.size() == file.size()) {
+            return data;
+        }
+    }
+
+    return QByteArray();
+}
+
+bool CompressedAssetStore::removeCompressedAsset(const AssetHash& hash) {
+    return QFile::remove(filePathFor(hash));
+}
+
+QStringList CompressedAssetStore::getCompressedAssetHashes() const {
+    QStringList hashes;
+
+    for (const auto& fileName : _compressedDirectory.entryList({ "*" + GZIP_FILE_SUFFIX }, QDir::Files)) {
+        hashes << fileName.left(fileName.size() - GZIP_FILE_SUFFIX.size());
+    }
+
+    return hashes;
+}
+
+QString CompressedAssetStore::filePathFor(const AssetHash& hash) const {
+    return _compressedDirectory.filePath(hash + GZIP_FILE_SUFFIX);
+}
@@ -0,0 +1,83 @@
+//
+//  CompressedAssetStore.h
+//  assignment-client/src/assets
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_CompressedAssetStore_h
+#define hifi_CompressedAssetStore_h
+
+#include <memory>
+
+#include <QtCore/QDir>
+
+#include <AssetUtils.h>
+
+class GzipCompressor;
+
+// Gzipped copies of the text-like assets (ascii FBX, OBJ, JSON, scripts...), sent instead of the asset itself
+// to the clients that accept them.
+// Variants are only kept when they are noticeably smaller than the asset, and can always be regenerated
+// from it, so losing one is never an error.
+class CompressedAssetStore {
+public:
+    // Compresses an asset as it is streamed in, from its start, once its sample says it is worth it.
+    // Gives up as soon as the variant can't end up small enough, so binary assets cost nothing past their sample.
+    class Compressor {
+    public:
+        Compressor(int64_t assetSize);
+        ~Compressor();
+
+        void addData(const QByteArray& data);
+
+        /// Stores the compressed variant of the asset once all of it was added, if it is worth keeping
+        void store(CompressedAssetStore& store, const AssetHash& hash);
+
+    private:
+        void compress(const QByteArray& data);
+
+        int64_t _assetSize;
+        QByteArray _sample;
+        std::unique_ptr<GzipCompressor> _compressor;
+    };
+
+    // the compressed variants are held in memory while they are made, larger assets are always sent as is
+    static const int64_t MAX_COMPRESSIBLE_ASSET_SIZE;
+
+    // how much of the start of an asset is looked at to decide if it is worth compressing
+    static const int COMPRESSIBLE_SAMPLE_SIZE;
+
+    /// Returns true if an asset of this size, starting with `sample`, looks like text that would compress well
+    static bool isCompressible(int64_t assetSize, const QByteArray& sample);
+
+    bool init(const QDir& resourcesDirectory);
+
+    /// Compresses the asset and stores the result if it is small enough to be worth sending instead.
+    /// Returns true if a compressed variant was stored.
+    bool compressAsset(const AssetHash& hash, const QByteArray& data);
+
+    /// Stores the gzipped asset if it is small enough to be worth sending instead of an asset of `assetSize` bytes.
+    /// Returns true if a compressed variant was stored.
+    bool storeCompressedAsset(const AssetHash& hash, int64_t assetSize, const QByteArray& compressedData);
+
+    bool hasCompressedAsset(const AssetHash& hash) const;
+
+    /// Returns the gzipped asset, or a null QByteArray if there is no compressed variant for it
+    QByteArray readCompressedAsset(const AssetHash& hash) const;
+
+    bool removeCompressedAsset(const AssetHash& hash);
+    QStringList getCompressedAssetHashes() const;
+
+private:
+    static bool isWorthKeeping(int64_t assetSize, int64_t compressedSize);
+
+    QString filePathFor(const AssetHash& hash) const;
+
+    QDir _compressedDirectory;
+};
+
+#endif // hifi_CompressedAssetStore_h
@@ -26,11 +26,16 @@
 #include "ByteRange.h"
 #include "ClientServerUtils.h"
 
-SendAssetTask::SendAssetTask(QSharedPointer<ReceivedMessage> message, const SharedNodePointer& sendToNode, const QDir& resourcesDir) :
+SendAssetTask::SendAssetTask(QSharedPointer<ReceivedMessage> message, const SharedNodePointer& sendToNode, const QDir& resourcesDir,
+                             std::shared_ptr<AssetCache> cache, std::shared_ptr<AssetChunkStore> chunkStore,
+                             std::shared_ptr<CompressedAssetStore> compressedStore) :
     QRunnable(),
     _message(message),
     _senderNode(sendToNode),
-    _resourcesDir(resourcesDir)
+    _resourcesDir(resourcesDir),
+    _cache(cache),
+    _chunkStore(chunkStore),
+    _compressedStore(compressedStore)
 {
     
 }
@@ -47,7 +52,10 @@ void SendAssetTask::run() {
     // starting at index 1.
     _message->readPrimitive(&byteRange.fromInclusive);
     _message->readPrimitive(&byteRange.toExclusive);
-    
+
+    uint8_t flags;
+    _message->readPrimitive(&flags);
+
     QString hexHash = assetHash.toHex();
     
     qDebug() << "Received a request for the file (" << messageID << "): " << hexHash << " from "
@@ -60,21 +68,64 @@ void SendAssetTask::run() {
 
     replyPacketList->writePrimitive(messageID);
 
+    // compressed variants can only stand in for the whole asset, a range of the asset is always sent as is
+    QByteArray compressedData;
+    if ((flags & AcceptGzipEncoding) && !byteRange.isSet()) {
+        compressedData = getCompressedAsset(hexHash);
+    }
+
     if (!byteRange.isValid()) {
         replyPacketList->writePrimitive(AssetServerError::InvalidByteRange);
+    } else if (!compressedData.isNull()) {
+        replyPacketList->writePrimitive(AssetServerError::NoError);
+        replyPacketList->writePrimitive(AssetEncoding::Gzip);
+        replyPacketList->writePrimitive(DataOffset(compressedData.size()));
+        replyPacketList->write(compressedData);
+
+        qCDebug(networking) << "Sending compressed asset: " << hexHash;
     } else {
         QString filePath = _resourcesDir.filePath(QString(hexHash));
+
+        // popular assets are kept in memory, check the cache before going to disk
+        QByteArray assetData = _cache->get(hexHash);
         
         QFile file { filePath };
 
-        if (file.open(QIODevice::ReadOnly)) {
+        // assets that were uploaded in chunks don't have a file, they are reassembled from their chunks
+        int64_t chunkedAssetSize = -1;
+
+        if (!assetData.isNull() || file.open(QIODevice::ReadOnly)
+            || (chunkedAssetSize = _chunkStore->getAssetSize(hexHash)) >= 0) {
+
+            if (assetData.isNull() && file.isOpen() && _cache->isCacheable(file.size())) {
+                // small enough to be cached - read it all in once so the next requests can skip the disk
+                assetData = file.readAll();
+
+                if (assetData.size() == file.size()) {
+                    _cache->insert(hexHash, assetData);
+                    file.close();
+                } else {
+                    // short read, fall back to reading the requested range from the file
+                    assetData = QByteArray();
+                }
+            } else if (assetData.isNull() && chunkedAssetSize >= 0 && _cache->isCacheable(chunkedAssetSize)) {
+                assetData = _chunkStore->readAsset(hexHash, 0, chunkedAssetSize);
+
+                if (assetData.size() == chunkedAssetSize) {
+                    _cache->insert(hexHash, assetData);
+                } else {
+                    assetData = QByteArray();
+                }
+            }
+
+            qint64 assetSize = !assetData.isNull() ? assetData.size() : (file.isOpen() ? file.size() : chunkedAssetSize);
 
             // first fixup the range based on the now known file size
-            byteRange.fixupRange(file.size());
+            byteRange.fixupRange(assetSize);
 
             // check if we're being asked to read data that we just don't have
             // because of the file size
-            if (file.size() < byteRange.fromInclusive || file.size() < byteRange.toExclusive) {
+            if (assetSize < byteRange.fromInclusive || assetSize < byteRange.toExclusive) {
                 replyPacketList->writePrimitive(AssetServerError::InvalidByteRange);
                 qCDebug(networking) << "Bad byte range: " << hexHash << " "
                     << byteRange.fromInclusive << ":" << byteRange.toExclusive;
@@ -82,27 +133,31 @@ void SendAssetTask::run() {
                 // we have a valid byte range, handle it and send the asset
                 auto size = byteRange.size();
 
-                if (byteRange.fromInclusive >= 0) {
+                // a positive range means we just need to seek into the asset and read from there,
+                // a negative range means the read starts back from the end of the asset
+                auto offset = byteRange.fromInclusive >= 0 ? byteRange.fromInclusive : assetSize + byteRange.fromInclusive;
 
-                    // this range is positive, meaning we just need to seek into the file and then read from there
-                    file.seek(byteRange.fromInclusive);
-                    replyPacketList->writePrimitive(AssetServerError::NoError);
-                    replyPacketList->writePrimitive(size);
-                    replyPacketList->write(file.read(size));
+                QByteArray rangeData;
+                if (!assetData.isNull()) {
+                    rangeData = QByteArray::fromRawData(assetData.constData() + offset, size);
+                } else if (file.isOpen()) {
+                    file.seek(offset);
+                    rangeData = file.read(size);
                 } else {
-                    // this range is negative, at least the first part of the read will be back into the end of the file
-
-                    // seek to the part of the file where the negative range begins
-                    file.seek(file.size() + byteRange.fromInclusive);
+                    rangeData = _chunkStore->readAsset(hexHash, offset, size);
+                }
 
+                if (rangeData.size() == size) {
                     replyPacketList->writePrimitive(AssetServerError::NoError);
+                    replyPacketList->writePrimitive(AssetEncoding::Identity);
                     replyPacketList->writePrimitive(size);
+                    replyPacketList->write(rangeData);
 
-                    // first write everything from the negative range to the end of the file
-                    replyPacketList->write(file.read(size));
+                    qCDebug(networking) << "Sending asset: " << hexHash;
+                } else {
+                    qCWarning(networking) << "Failed to read asset: " << hexHash;
+                    replyPacketList->writePrimitive(AssetServerError::FileOperationFailed);
                 }
-
-                qCDebug(networking) << "Sending asset: " << hexHash;
             }
             file.close();
         } else {
@@ -114,3 +169,25 @@ void SendAssetTask::run() {
     auto nodeList = DependencyManager::get<NodeList>();
     nodeList->sendPacketList(std::move(replyPacketList), *_senderNode);
 }
+
+QByteArray SendAssetTask::getCompressedAsset(const QString& hexHash) {
+    // most assets don't have a variant, don't count them as cache misses
+    if (!_compressedStore->hasCompressedAsset(hexHash)) {
+        return QByteArray();
+    }
+
+    // the cache is keyed by file name, which keeps variants apart from the assets themselves
+    auto cacheKey = hexHash + ".gz";
+
+    auto compressedData = _cache->get(cacheKey);
+    if (!compressedData.isNull()) {
+        return compressedData;
+    }
+
+    compressedData = _compressedStore->readCompressedAsset(hexHash);
+    if (!compressedData.isNull() && _cache->isCacheable(compressedData.size())) {
+        _cache->insert(cacheKey, compressedData);
+    }
+
+    return compressedData;
+}
@@ -17,7 +17,10 @@
 #include <QtCore/QString>
 #include <QtCore/QRunnable>
 
+#include "AssetCache.h"
+#include "AssetChunkStore.h"
 #include "AssetUtils.h"
+#include "CompressedAssetStore.h"
 #include "AssetServer.h"
 #include "Node.h"
 
@@ -25,14 +28,22 @@ class NLPacket;
 
 class SendAssetTask : public QRunnable {
 public:
-    SendAssetTask(QSharedPointer<ReceivedMessage> message, const SharedNodePointer& sendToNode, const QDir& resourcesDir);
+    SendAssetTask(QSharedPointer<ReceivedMessage> message, const SharedNodePointer& sendToNode, const QDir& resourcesDir,
+                  std::shared_ptr<AssetCache> cache, std::shared_ptr<AssetChunkStore> chunkStore,
+                  std::shared_ptr<CompressedAssetStore> compressedStore);
 
     void run() override;
 
 private:
+    // returns the gzipped variant of the asset, or a null QByteArray if it doesn't have one
+    QByteArray getCompressedAsset(const QString& hexHash);
+
     QSharedPointer<ReceivedMessage> _message;
     SharedNodePointer _senderNode;
     QDir _resourcesDir;
+    std::shared_ptr<AssetCache> _cache;
+    std::shared_ptr<AssetChunkStore> _chunkStore;
+    std::shared_ptr<CompressedAssetStore> _compressedStore;
 };
 
 #endif
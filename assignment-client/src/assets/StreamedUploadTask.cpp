@@ -0,0 +1,141 @@
+//
+//  StreamedUploadTask.cpp
+//  assignment-client/src/assets
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "StreamedUploadTask.h"
+
+#include <chrono>
+
+#include <NodeList.h>
+#include <NLPacket.h>
+
+// how long we wait for the next packet of an upload before giving up on it
+static const std::chrono::milliseconds UPLOAD_INACTIVITY_TIMEOUT { std::chrono::seconds(60) };
+
+StreamedUploadTask::StreamedUploadTask(QSharedPointer<ReceivedMessage> message, QSharedPointer<Node> senderNode,
+                                       QThreadPool& pool) :
+    _receivedMessage(message),
+    _senderNode(senderNode),
+    _pool(pool)
+{
+    // runs are started from the task's thread, which also deletes it once no run is left
+    setAutoDelete(false);
+
+    // the upload header is always in the first packet of the message, which we have by now
+    _receivedMessage->readHeadPrimitive(&_messageID);
+
+    _inactivityTimer.setSingleShot(true);
+    _inactivityTimer.setInterval((int)UPLOAD_INACTIVITY_TIMEOUT.count());
+    connect(&_inactivityTimer, &QTimer::timeout, this, &StreamedUploadTask::onTimeout);
+}
+
+void StreamedUploadTask::start() {
+    connect(_receivedMessage.data(), &ReceivedMessage::progress, this, &StreamedUploadTask::onDataReceived);
+    connect(_receivedMessage.data(), &ReceivedMessage::completed, this, &StreamedUploadTask::onDataReceived);
+
+    // consume what was received before we were connected
+    onDataReceived();
+}
+
+void StreamedUploadTask::onDataReceived() {
+    if (_isFinished) {
+        return;
+    }
+
+    _inactivityTimer.start();
+
+    if (_isRunning) {
+        _hasDataSinceRun = true;
+    } else {
+        startRun();
+    }
+}
+
+void StreamedUploadTask::onTimeout() {
+    if (_isFinished || _receivedMessage->isComplete()) {
+        return;
+    }
+
+    qWarning() << "Timed out waiting for upload data from" << uuidStringWithoutCurlyBraces(_senderNode->getUUID());
+
+    _hasTimedOut = true;
+
+    if (_isRunning) {
+        _hasDataSinceRun = true;
+    } else {
+        startRun();
+    }
+}
+
+void StreamedUploadTask::startRun() {
+    _isRunning = true;
+    _hasDataSinceRun = false;
+    _pool.start(this);
+}
+
+void StreamedUploadTask::onRunFinished() {
+    _isRunning = false;
+
+    if (_isFinished) {
+        _inactivityTimer.stop();
+        disconnect(_receivedMessage.data(), nullptr, this, nullptr);
+        deleteLater();
+    } else if (_hasDataSinceRun) {
+        startRun();
+    }
+}
+
+void StreamedUploadTask::run() {
+    while (!_isFinished) {
+        bool wasComplete = _receivedMessage->isComplete();
+        auto data = _receivedMessage->takeReceivedData();
+
+        if (_hasTimedOut) {
+            reply(AssetServerError::FileOperationFailed);
+        } else if (!data.isEmpty()) {
+            auto error = processData(data);
+
+            if (error != AssetServerError::NoError) {
+                reply(error);
+            }
+        } else if (!wasComplete) {
+            // wait for more data to arrive
+            break;
+        } else if (_receivedMessage->failed()) {
+            qWarning() << "Upload from" << uuidStringWithoutCurlyBraces(_senderNode->getUUID()) << "failed to arrive";
+            reply(AssetServerError::FileOperationFailed);
+        } else {
+            reply(AssetServerError::NoError);
+        }
+    }
+
+    // the task can only be deleted from its own thread, where this is the last we hear of the run
+    QMetaObject::invokeMethod(this, "onRunFinished", Qt::QueuedConnection);
+}
+
+void StreamedUploadTask::reply(AssetServerError error) {
+    auto replyPacket = NLPacket::create(PacketType::AssetUploadReply, -1, true);
+    replyPacket->writePrimitive(_messageID);
+
+    if (error == AssetServerError::NoError) {
+        error = finishUpload(*replyPacket);
+    }
+
+    if (error != AssetServerError::NoError) {
+        replyPacket->writePrimitive(error);
+
+        // the rest of an abandoned upload is dropped as it arrives
+        _receivedMessage->discardReceivedData();
+    }
+
+    _isFinished = true;
+
+    auto nodeList = DependencyManager::get<NodeList>();
+    nodeList->sendPacket(std::move(replyPacket), *_senderNode);
+}
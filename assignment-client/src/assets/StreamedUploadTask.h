@@ -0,0 +1,75 @@
+//
+//  StreamedUploadTask.h
+//  assignment-client/src/assets
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#pragma once
+
+#ifndef hifi_StreamedUploadTask_h
+#define hifi_StreamedUploadTask_h
+
+#include <atomic>
+
+#include <QtCore/QObject>
+#include <QtCore/QRunnable>
+#include <QtCore/QSharedPointer>
+#include <QtCore/QThreadPool>
+#include <QtCore/QTimer>
+
+#include "AssetUtils.h"
+#include "ReceivedMessage.h"
+
+class NLPacket;
+class Node;
+
+// Base of the tasks that consume an upload while it is still being received.
+// The task lives on the thread that created it, where it follows the progress of the message, and the data received
+// since its last run is consumed by a run on the given pool, so that no pool thread ever waits on the network.
+// An upload that stops progressing for too long is abandoned, and the task deletes itself once it has replied.
+class StreamedUploadTask : public QObject, public QRunnable {
+    Q_OBJECT
+public:
+    StreamedUploadTask(QSharedPointer<ReceivedMessage> message, QSharedPointer<Node> senderNode, QThreadPool& pool);
+
+    // starts consuming the upload, from the thread that created the task
+    void start();
+
+    void run() override;
+
+protected:
+    // Consumes the next data of the upload, in the order it was received. Returning an error abandons the upload.
+    virtual AssetServerError processData(const QByteArray& data) = 0;
+
+    // Stores the upload once all of it was consumed. Writes the result to the reply on success, returns the error otherwise.
+    virtual AssetServerError finishUpload(NLPacket& replyPacket) = 0;
+
+    QSharedPointer<ReceivedMessage> _receivedMessage;
+    QSharedPointer<Node> _senderNode;
+
+private slots:
+    void onDataReceived();
+    void onRunFinished();
+    void onTimeout();
+
+private:
+    void startRun();
+    void reply(AssetServerError error);
+
+    QThreadPool& _pool;
+    QTimer _inactivityTimer;
+    MessageID _messageID { 0 };
+
+    // only used on the thread of the task, a run is in progress and more data arrived since it started
+    bool _isRunning { false };
+    bool _hasDataSinceRun { false };
+
+    std::atomic<bool> _hasTimedOut { false };
+    std::atomic<bool> _isFinished { false };
+};
+
+#endif // hifi_StreamedUploadTask_h
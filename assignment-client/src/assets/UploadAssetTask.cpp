@@ -11,97 +11,115 @@
 
 #include "UploadAssetTask.h"
 
-#include <QtCore/QBuffer>
+#include <algorithm>
+
 #include <QtCore/QFile>
 
-#include <AssetUtils.h>
 #include <NodeList.h>
-#include <NLPacketList.h>
+#include <NLPacket.h>
 
 #include "ClientServerUtils.h"
 
+const QString UploadAssetTask::TEMPORARY_FILE_SUFFIX = ".upload";
 
-UploadAssetTask::UploadAssetTask(QSharedPointer<ReceivedMessage> receivedMessage, SharedNodePointer senderNode,
-                                 const QDir& resourcesDir) :
-    _receivedMessage(receivedMessage),
-    _senderNode(senderNode),
-    _resourcesDir(resourcesDir)
+UploadAssetTask::UploadAssetTask(QSharedPointer<ReceivedMessage> message, QSharedPointer<Node> senderNode,
+                                 QThreadPool& pool, const QDir& resourcesDir,
+                                 std::shared_ptr<CompressedAssetStore> compressedStore) :
+    StreamedUploadTask(message, senderNode, pool),
+    _resourcesDir(resourcesDir),
+    _compressedStore(compressedStore),
+    _temporaryFile(resourcesDir.filePath("XXXXXX" + TEMPORARY_FILE_SUFFIX))
 {
-    
-}
+    // the rest of the upload header follows the message ID in the first packet
+    _receivedMessage->readHeadPrimitive(&_fileSize);
+    _compressor.reset(new CompressedAssetStore::Compressor(_fileSize));
+
+    _temporaryFile.setAutoRemove(true);
 
-void UploadAssetTask::run() {
-    auto data = _receivedMessage->getMessage();
-    
-    QBuffer buffer { &data };
-    buffer.open(QIODevice::ReadOnly);
-    
-    MessageID messageID;
-    buffer.read(reinterpret_cast<char*>(&messageID), sizeof(messageID));
-    
-    uint64_t fileSize;
-    buffer.read(reinterpret_cast<char*>(&fileSize), sizeof(fileSize));
-    
-    qDebug() << "UploadAssetTask reading a file of " << fileSize << "bytes from"
+    qDebug() << "UploadAssetTask reading a file of " << _fileSize << "bytes from"
         << uuidStringWithoutCurlyBraces(_senderNode->getUUID());
-    
-    auto replyPacket = NLPacket::create(PacketType::AssetUploadReply, -1, true);
-    replyPacket->writePrimitive(messageID);
-    
-    if (fileSize > MAX_UPLOAD_SIZE) {
-        replyPacket->writePrimitive(AssetServerError::AssetTooLarge);
+}
+
+bool UploadAssetTask::openTemporaryFile() {
+    if (_temporaryFile.isOpen()) {
+        return true;
+    }
+
+    if (!_temporaryFile.open()) {
+        qWarning() << "Failed to open a temporary file for upload from" << uuidStringWithoutCurlyBraces(_senderNode->getUUID());
+        return false;
+    }
+
+    return true;
+}
+
+AssetServerError UploadAssetTask::processData(const QByteArray& data) {
+    if (_fileSize > MAX_UPLOAD_SIZE) {
+        return AssetServerError::AssetTooLarge;
+    }
+
+    if (!openTemporaryFile()) {
+        return AssetServerError::FileOperationFailed;
+    }
+
+    // never take more than the announced size, which is at most MAX_UPLOAD_SIZE
+    auto fileData = data.left((int)std::min<uint64_t>(_fileSize - _bytesReceived, data.size()));
+
+    _hasher.addData(fileData);
+    _bytesReceived += fileData.size();
+
+    _compressor->addData(fileData);
+
+    // a failed write only fails the upload if we don't already have the asset, which we only know once it is hashed
+    if (!_writeFailed && _temporaryFile.write(fileData) != fileData.size()) {
+        _writeFailed = true;
+    }
+
+    return AssetServerError::NoError;
+}
+
+AssetServerError UploadAssetTask::finishUpload(NLPacket& replyPacket) {
+    if (_fileSize > MAX_UPLOAD_SIZE) {
+        return AssetServerError::AssetTooLarge;
+    }
+
+    if (_bytesReceived != _fileSize) {
+        qWarning() << "Upload from" << uuidStringWithoutCurlyBraces(_senderNode->getUUID()) << "was incomplete -"
+            << _bytesReceived << "of" << _fileSize << "bytes received.";
+        return AssetServerError::FileOperationFailed;
+    }
+
+    auto hash = _hasher.result();
+    auto hexHash = hash.toHex();
+
+    qDebug() << "Hash for uploaded file from" << uuidStringWithoutCurlyBraces(_senderNode->getUUID())
+        << "is: (" << hexHash << ") ";
+
+    auto filePath = _resourcesDir.filePath(QString(hexHash));
+
+    // files are only ever renamed into place once complete, so an existing file named by this hash is the same asset
+    if (QFile::exists(filePath)) {
+        qDebug() << "Not overwriting existing file: " << hexHash;
+    } else if (!openTemporaryFile() || _writeFailed || !_temporaryFile.flush()) {
+        qWarning() << "Failed to write upload" << hexHash << "to disk - upload failed.";
+        return AssetServerError::FileOperationFailed;
     } else {
-        QByteArray fileData = buffer.read(fileSize);
-        
-        auto hash = hashData(fileData);
-        auto hexHash = hash.toHex();
-        
-        qDebug() << "Hash for uploaded file from" << uuidStringWithoutCurlyBraces(_senderNode->getUUID())
-            << "is: (" << hexHash << ") ";
-        
-        QFile file { _resourcesDir.filePath(QString(hexHash)) };
-
-        bool existingCorrectFile = false;
-        
-        if (file.exists()) {
-            // check if the local file has the correct contents, otherwise we overwrite
-            if (file.open(QIODevice::ReadOnly) && hashData(file.readAll()) == hash) {
-                qDebug() << "Not overwriting existing verified file: " << hexHash;
-
-                existingCorrectFile = true;
-
-                replyPacket->writePrimitive(AssetServerError::NoError);
-                replyPacket->write(hash);
-            } else {
-                qDebug() << "Overwriting an existing file whose contents did not match the expected hash: " << hexHash;
-                file.close();
-            }
-        }
+        _temporaryFile.close();
+
+        // a concurrent upload of the same asset may have beaten us to the rename, which is just as good
+        if (QFile::rename(_temporaryFile.fileName(), filePath)) {
+            _temporaryFile.setAutoRemove(false);
+            qDebug() << "Wrote file" << hexHash << "to disk. Upload complete";
 
-        if (!existingCorrectFile) {
-            if (file.open(QIODevice::WriteOnly) && file.write(fileData) == qint64(fileSize)) {
-                qDebug() << "Wrote file" << hexHash << "to disk. Upload complete";
-                file.close();
-
-                replyPacket->writePrimitive(AssetServerError::NoError);
-                replyPacket->write(hash);
-            } else {
-                qWarning() << "Failed to upload or write to file" << hexHash << " - upload failed.";
-
-                // upload has failed - remove the file and return an error
-                auto removed = file.remove();
-
-                if (!removed) {
-                    qWarning() << "Removal of failed upload file" << hexHash << "failed.";
-                }
-                
-                replyPacket->writePrimitive(AssetServerError::FileOperationFailed);
-            }
+            _compressor->store(*_compressedStore, hexHash);
+        } else if (!QFile::exists(filePath)) {
+            qWarning() << "Failed to move upload" << hexHash << "into place - upload failed.";
+            return AssetServerError::FileOperationFailed;
         }
+    }
 
+    replyPacket.writePrimitive(AssetServerError::NoError);
+    replyPacket.write(hash);
 
-    }
-    
-    auto nodeList = DependencyManager::get<NodeList>();
-    nodeList->sendPacket(std::move(replyPacket), *_senderNode);
+    return AssetServerError::NoError;
 }
@@ -14,26 +14,46 @@
 #ifndef hifi_UploadAssetTask_h
 #define hifi_UploadAssetTask_h
 
-#include <QtCore/QDir>
-#include <QtCore/QObject>
-#include <QtCore/QRunnable>
-#include <QtCore/QSharedPointer>
+#include <memory>
 
-#include "ReceivedMessage.h"
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDir>
+#include <QtCore/QTemporaryFile>
 
-class NLPacketList;
-class Node;
+#include "AssetUtils.h"
+#include "CompressedAssetStore.h"
+#include "StreamedUploadTask.h"
 
-class UploadAssetTask : public QRunnable {
+// Receives an upload as its packets arrive, streaming it to a temporary file that is renamed
+// into place under its hash once complete
+class UploadAssetTask : public StreamedUploadTask {
 public:
-    UploadAssetTask(QSharedPointer<ReceivedMessage> message, QSharedPointer<Node> senderNode, const QDir& resourcesDir);
+    static const QString TEMPORARY_FILE_SUFFIX;
 
-    void run() override;
+    UploadAssetTask(QSharedPointer<ReceivedMessage> message, QSharedPointer<Node> senderNode, QThreadPool& pool,
+                    const QDir& resourcesDir, std::shared_ptr<CompressedAssetStore> compressedStore);
+
+protected:
+    AssetServerError processData(const QByteArray& data) override;
+    AssetServerError finishUpload(NLPacket& replyPacket) override;
 
 private:
-    QSharedPointer<ReceivedMessage> _receivedMessage;
-    QSharedPointer<Node> _senderNode;
+    bool openTemporaryFile();
+
     QDir _resourcesDir;
+    std::shared_ptr<CompressedAssetStore> _compressedStore;
+
+    uint64_t _fileSize { 0 };
+
+    // the upload is streamed to a temporary file in the resources directory, and hashed as it comes in,
+    // so that we never hold more than a few packets of it in memory
+    QTemporaryFile _temporaryFile;
+    QCryptographicHash _hasher { QCryptographicHash::Sha256 };
+    uint64_t _bytesReceived { 0 };
+    bool _writeFailed { false };
+
+    // compresses the upload as it comes in, if it is worth storing a compressed variant of it
+    std::unique_ptr<CompressedAssetStore::Compressor> _compressor;
 };
 
 #endif // hifi_UploadAssetTask_h
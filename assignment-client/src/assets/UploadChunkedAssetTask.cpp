@@ -0,0 +1,171 @@
+//
+//  UploadChunkedAssetTask.cpp
+//  assignment-client/src/assets
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "UploadChunkedAssetTask.h"
+
+#include <QtCore/QFile>
+
+#include <NodeList.h>
+#include <NLPacket.h>
+
+#include "ClientServerUtils.h"
+
+static const qint64 CHUNK_HEADER_SIZE = SHA256_HASH_LENGTH + sizeof(uint32_t) + sizeof(uint8_t);
+
+UploadChunkedAssetTask::UploadChunkedAssetTask(QSharedPointer<ReceivedMessage> message, QSharedPointer<Node> senderNode,
+                                               QThreadPool& pool, const QDir& resourcesDir,
+                                               std::shared_ptr<AssetChunkStore> chunkStore,
+                                               std::shared_ptr<CompressedAssetStore> compressedStore) :
+    StreamedUploadTask(message, senderNode, pool),
+    _resourcesDir(resourcesDir),
+    _chunkStore(chunkStore),
+    _compressedStore(compressedStore)
+{
+    // the rest of the upload header follows the message ID in the first packet
+    _receivedMessage->readHeadPrimitive(&_fileSize);
+    _receivedMessage->readHeadPrimitive(&_numChunks);
+
+    _compressor.reset(new CompressedAssetStore::Compressor(_fileSize));
+
+    qDebug() << "UploadChunkedAssetTask reading a file of " << _fileSize << "bytes in" << _numChunks << "chunks from"
+        << uuidStringWithoutCurlyBraces(_senderNode->getUUID());
+}
+
+AssetServerError UploadChunkedAssetTask::processData(const QByteArray& data) {
+    if (_fileSize > MAX_UPLOAD_SIZE) {
+        return AssetServerError::AssetTooLarge;
+    }
+
+    _pendingData.append(data);
+
+    qint64 position = 0;
+    while ((uint32_t)_chunks.size() < _numChunks) {
+        AssetServerError error = AssetServerError::NoError;
+        auto chunkLength = storeNextChunk(_pendingData, position, error);
+
+        if (error != AssetServerError::NoError) {
+            return error;
+        } else if (chunkLength == 0) {
+            break;
+        }
+
+        position += chunkLength;
+    }
+
+    // only keep the partial chunk, anything past the last chunk is ignored
+    if ((uint32_t)_chunks.size() < _numChunks) {
+        _pendingData.remove(0, position);
+    } else {
+        _pendingData.clear();
+    }
+
+    return AssetServerError::NoError;
+}
+
+qint64 UploadChunkedAssetTask::storeNextChunk(const QByteArray& data, qint64 position, AssetServerError& error) {
+    if (data.size() - position < CHUNK_HEADER_SIZE) {
+        return 0;
+    }
+
+    const char* header = data.constData() + position;
+
+    auto chunkHash = QByteArray(header, SHA256_HASH_LENGTH);
+
+    uint32_t chunkSize;
+    memcpy(&chunkSize, header + SHA256_HASH_LENGTH, sizeof(chunkSize));
+
+    uint8_t hasData;
+    memcpy(&hasData, header + SHA256_HASH_LENGTH + sizeof(chunkSize), sizeof(hasData));
+
+    if (chunkSize > MAX_ASSET_CHUNK_SIZE || _offset + chunkSize > _fileSize) {
+        qWarning() << "Chunked upload from" << uuidStringWithoutCurlyBraces(_senderNode->getUUID())
+            << "has an invalid chunk size";
+        error = AssetServerError::FileOperationFailed;
+        return 0;
+    }
+
+    QByteArray chunkData;
+    qint64 chunkLength = CHUNK_HEADER_SIZE;
+
+    if (hasData) {
+        if (data.size() - position - CHUNK_HEADER_SIZE < chunkSize) {
+            return 0;
+        }
+
+        // only referenced for the duration of this call, `data` outlives it
+        chunkData = QByteArray::fromRawData(header + CHUNK_HEADER_SIZE, chunkSize);
+        chunkLength += chunkSize;
+
+        if (hashData(chunkData) != chunkHash) {
+            qWarning() << "Chunk" << chunkHash.toHex() << "from" << uuidStringWithoutCurlyBraces(_senderNode->getUUID())
+                << "does not match its hash";
+            error = AssetServerError::FileOperationFailed;
+            return 0;
+        }
+
+        if (!_chunkStore->writeChunk(chunkHash, chunkData)) {
+            qWarning() << "Failed to write chunk" << chunkHash.toHex() << "to disk - upload failed.";
+            error = AssetServerError::FileOperationFailed;
+            return 0;
+        }
+    } else {
+        chunkData = _chunkStore->readChunk(chunkHash);
+
+        if ((uint32_t)chunkData.size() != chunkSize) {
+            qWarning() << "Chunked upload from" << uuidStringWithoutCurlyBraces(_senderNode->getUUID())
+                << "relies on missing chunk" << chunkHash.toHex();
+            error = AssetServerError::FileOperationFailed;
+            return 0;
+        }
+    }
+
+    _hasher.addData(chunkData);
+
+    _compressor->addData(chunkData);
+
+    _chunks.push_back({ (int64_t)_offset, chunkSize, chunkHash });
+    _offset += chunkSize;
+
+    return chunkLength;
+}
+
+AssetServerError UploadChunkedAssetTask::finishUpload(NLPacket& replyPacket) {
+    if (_fileSize > MAX_UPLOAD_SIZE) {
+        return AssetServerError::AssetTooLarge;
+    }
+
+    if ((uint32_t)_chunks.size() != _numChunks || _offset != _fileSize) {
+        qWarning() << "Chunked upload from" << uuidStringWithoutCurlyBraces(_senderNode->getUUID()) << "was incomplete -"
+            << _offset << "of" << _fileSize << "bytes received.";
+        return AssetServerError::FileOperationFailed;
+    }
+
+    auto hash = _hasher.result();
+    auto hexHash = hash.toHex();
+
+    qDebug() << "Hash for chunked upload from" << uuidStringWithoutCurlyBraces(_senderNode->getUUID())
+        << "is: (" << hexHash << ") ";
+
+    if (QFile::exists(_resourcesDir.filePath(QString(hexHash))) || _chunkStore->hasManifest(hexHash)) {
+        qDebug() << "Not overwriting existing asset: " << hexHash;
+    } else if (_chunkStore->writeManifest(hexHash, _chunks)) {
+        qDebug() << "Wrote manifest for" << hexHash << "with" << _numChunks << "chunks. Upload complete";
+
+        _compressor->store(*_compressedStore, hexHash);
+    } else {
+        qWarning() << "Failed to write manifest for" << hexHash << " - upload failed.";
+        return AssetServerError::FileOperationFailed;
+    }
+
+    replyPacket.writePrimitive(AssetServerError::NoError);
+    replyPacket.write(hash);
+
+    return AssetServerError::NoError;
+}
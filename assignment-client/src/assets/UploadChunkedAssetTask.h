@@ -0,0 +1,61 @@
+//
+//  UploadChunkedAssetTask.h
+//  assignment-client/src/assets
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#pragma once
+
+#ifndef hifi_UploadChunkedAssetTask_h
+#define hifi_UploadChunkedAssetTask_h
+
+#include <memory>
+
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDir>
+
+#include "AssetChunkStore.h"
+#include "CompressedAssetStore.h"
+#include "StreamedUploadTask.h"
+
+// Stores an asset uploaded as a list of chunks, where only the chunks the asset-server was missing carry data.
+// Chunks are verified and written as they arrive, only the chunk being received is held in memory.
+class UploadChunkedAssetTask : public StreamedUploadTask {
+public:
+    UploadChunkedAssetTask(QSharedPointer<ReceivedMessage> message, QSharedPointer<Node> senderNode, QThreadPool& pool,
+                           const QDir& resourcesDir, std::shared_ptr<AssetChunkStore> chunkStore,
+                           std::shared_ptr<CompressedAssetStore> compressedStore);
+
+protected:
+    AssetServerError processData(const QByteArray& data) override;
+    AssetServerError finishUpload(NLPacket& replyPacket) override;
+
+private:
+    // stores the chunk at the start of `data`, returns the number of bytes it used or 0 if it isn't all there yet
+    qint64 storeNextChunk(const QByteArray& data, qint64 position, AssetServerError& error);
+
+    QDir _resourcesDir;
+    std::shared_ptr<AssetChunkStore> _chunkStore;
+    std::shared_ptr<CompressedAssetStore> _compressedStore;
+
+    uint64_t _fileSize { 0 };
+    uint32_t _numChunks { 0 };
+
+    // the received data that doesn't hold a whole chunk yet
+    QByteArray _pendingData;
+
+    // The asset hash covers the whole asset, so we hash the chunks we already had along with the uploaded ones.
+    // That costs a read of the existing chunks but means we never have to trust the hash claimed by a client.
+    QCryptographicHash _hasher { QCryptographicHash::Sha256 };
+    AssetChunkList _chunks;
+    uint64_t _offset { 0 };
+
+    // compresses the asset as its chunks come in, if it is worth storing a compressed variant of it
+    std::unique_ptr<CompressedAssetStore::Compressor> _compressor;
+};
+
+#endif // hifi_UploadChunkedAssetTask_h
@@ -11,6 +11,8 @@
 
 #include <limits>
 
+#include <QtConcurrent/QtConcurrentMap>
+
 #include <NumericalConstants.h>
 #include <udt/PacketHeaders.h>
 #include <PerfStat.h>
@@ -19,8 +21,11 @@
 #include "OctreeServerConsts.h"
 #include "OctreeInboundPacketProcessor.h"
 
-static QUuid DEFAULT_NODE_ID_REF;
 const quint64 TOO_LONG_SINCE_LAST_NACK = 1 * USECS_PER_SECOND;
+const quint64 MAX_LOCK_HOLD_TIME = USECS_PER_MSEC; // how long the edits can hold the tree write lock at a time
+const int EDITS_PER_SECOND_SAMPLES = 10;
+
+const quint64 OctreeInboundPacketProcessor::LOCK_HOLD_TIME_BUCKET_BOUNDS[] = { 50, 100, 250, 500, 1000, 2500 };
 
 OctreeInboundPacketProcessor::OctreeInboundPacketProcessor(OctreeServer* myServer) :
     _myServer(myServer),
@@ -31,8 +36,13 @@ OctreeInboundPacketProcessor::OctreeInboundPacketProcessor(OctreeServer* myServe
     _totalElementsInPacket(0),
     _totalPackets(0),
     _lastNackTime(usecTimestampNow()),
-    _shuttingDown(false)
+    _shuttingDown(false),
+    _editsPerSecond(EDITS_PER_SECOND_SAMPLES),
+    _lastEditRateUpdate(usecTimestampNow())
 {
+    for (auto& count : _lockHoldTimeHistogram) {
+        count = 0;
+    }
 }
 
 void OctreeInboundPacketProcessor::resetStats() {
@@ -42,6 +52,10 @@ void OctreeInboundPacketProcessor::resetStats() {
     _totalElementsInPacket = 0;
     _totalPackets = 0;
     _lastNackTime = usecTimestampNow();
+    for (auto& count : _lockHoldTimeHistogram) {
+        count = 0;
+    }
+    _editsPerSecond.reset();
 
     QWriteLocker locker(&_senderStatsLock);
     _singleSenderStats.clear();
@@ -64,6 +78,7 @@ void OctreeInboundPacketProcessor::preProcess() {
         _lastNackTime = now;
         sendNackPackets();
     }
+    updateEditRate();
 }
 
 void OctreeInboundPacketProcessor::midProcess() {
@@ -76,139 +91,177 @@ void OctreeInboundPacketProcessor::midProcess() {
 }
 
 void OctreeInboundPacketProcessor::processPacket(QSharedPointer<ReceivedMessage> message, SharedNodePointer sendingNode) {
+    std::list<NodeSharedReceivedMessagePair> packets { { sendingNode, message } };
+    processPackets(packets);
+}
+
+void OctreeInboundPacketProcessor::processPackets(std::list<NodeSharedReceivedMessagePair>& packets) {
     if (_shuttingDown) {
-        qDebug() << "OctreeInboundPacketProcessor::processPacket() while shutting down... ignoring incoming packet";
+        qDebug() << "OctreeInboundPacketProcessor::processPackets() while shutting down... ignoring incoming packets";
         return;
     }
 
-    bool debugProcessPacket = _myServer->wantsVerboseDebug();
-
-    if (debugProcessPacket) {
-        qDebug("OctreeInboundPacketProcessor::processPacket() payload=%p payloadLength=%lld",
-               message->getRawMessage(),
-               message->getSize());
+    std::vector<InboundEditPacket> editPackets(packets.size());
+    auto packetItr = packets.begin();
+    for (auto& packet : editPackets) {
+        packet.sendingNode = packetItr->first;
+        packet.message = packetItr->second;
+        ++packetItr;
     }
 
-    // Ask our tree subclass if it can handle the incoming packet...
-    PacketType packetType = message->getType();
-    
-    if (_myServer->getOctree()->handlesEditPacketType(packetType)) {
-        PerformanceWarning warn(debugProcessPacket, "processPacket KNOWN TYPE", debugProcessPacket);
-        _receivedPacketCount++;
-
-        unsigned short int sequence;
-        message->readPrimitive(&sequence);
-
-        quint64 sentAt;
-        message->readPrimitive(&sentAt);
-        
-        quint64 arrivedAt = usecTimestampNow();
-        if (sentAt > arrivedAt) {
-            if (debugProcessPacket || _myServer->wantsDebugReceiving()) {
-                qDebug() << "unreasonable sentAt=" << sentAt << " usecs";
-                qDebug() << "setting sentAt to arrivedAt=" << arrivedAt << " usecs";
+    // decode and validate the edits of all the packets at once, without the tree lock
+    QtConcurrent::blockingMap(editPackets, [this](InboundEditPacket& packet) {
+        prepareEditPacket(packet);
+    });
+
+    // then apply them in order, which keeps the order of the edits of each sender, releasing the lock regularly
+    auto octree = _myServer->getOctree();
+    size_t packetIndex = 0;
+    size_t editIndex = 0;
+    while (packetIndex < editPackets.size()) {
+        size_t firstPacketIndex = packetIndex;
+        int editsApplied = 0;
+        quint64 startHold = 0;
+        quint64 startLock = usecTimestampNow();
+        octree->withWriteLock([&] {
+            startHold = usecTimestampNow();
+            editPackets[packetIndex].lockWaitTime += startHold - startLock;
+            while (packetIndex < editPackets.size()) {
+                InboundEditPacket& packet = editPackets[packetIndex];
+                if (!packet.handled || !applyNextEdit(packet, editIndex)) {
+                    packetIndex++;
+                    editIndex = 0;
+                    continue;
+                }
+                editsApplied++;
+                if (usecTimestampNow() - startHold >= MAX_LOCK_HOLD_TIME) {
+                    break;
+                }
+            }
+        });
+        trackLockHoldTime(usecTimestampNow() - startHold, editsApplied);
+
+        for (size_t i = firstPacketIndex; i < packetIndex; i++) {
+            const InboundEditPacket& packet = editPackets[i];
+            if (packet.handled) {
+                // Make sure our Node and NodeList knows we've heard from this node.
+                QUuid nodeUUID = packet.sendingNode ? packet.sendingNode->getUUID() : QUuid();
+                trackInboundPacket(nodeUUID, packet.sequence, packet.transitTime, packet.editsInPacket,
+                                   packet.processTime, packet.lockWaitTime);
             }
-            sentAt = arrivedAt;
         }
 
-        quint64 transitTime = arrivedAt - sentAt;
-        int editsInPacket = 0;
-        quint64 processTime = 0;
-        quint64 lockWaitTime = 0;
-
-        if (debugProcessPacket || _myServer->wantsDebugReceiving()) {
-            qDebug() << "PROCESSING THREAD: got '" << packetType << "' packet - " << _receivedPacketCount << " command from client";
-            qDebug() << "    receivedBytes=" << message->getSize();
-            qDebug() << "         sequence=" << sequence;
-            qDebug() << "           sentAt=" << sentAt << " usecs";
-            qDebug() << "        arrivedAt=" << arrivedAt << " usecs";
-            qDebug() << "      transitTime=" << transitTime << " usecs";
-            qDebug() << "      sendingNode->getClockSkewUsec()=" << sendingNode->getClockSkewUsec() << " usecs";
-
+        midProcess();
+    }
+}
 
-        }
+// reads the header of the packet and prepares as many of its edits as the tree can, the rest are processed in
+// applyNextEdit(), runs on the QtConcurrent pool
+void OctreeInboundPacketProcessor::prepareEditPacket(InboundEditPacket& packet) {
+    ReceivedMessage& message = *packet.message;
+    bool debugProcessPacket = _myServer->wantsVerboseDebug();
 
-        if (debugProcessPacket) {
-            qDebug() << "    numBytesPacketHeader=" << NLPacket::totalHeaderSize(packetType);
-            qDebug() << "    sizeof(sequence)=" << sizeof(sequence);
-            qDebug() << "    sizeof(sentAt)=" << sizeof(sentAt);
-            qDebug() << "    atByte (in payload)=" << message->getPosition();
-            qDebug() << "    payload size=" << message->getSize();
+    // Ask our tree subclass if it can handle the incoming packet...
+    PacketType packetType = message.getType();
+    auto octree = _myServer->getOctree();
+    if (!octree->handlesEditPacketType(packetType)) {
+        qDebug("unknown packet ignored... packetType=%hhu", (unsigned char)packetType);
+        return;
+    }
 
-            if (!message->getBytesLeftToRead()) {
-                qDebug() << "    ----- UNEXPECTED ---- got a packet without any edit details!!!! --------";
-            }
-        }
-        
-        const unsigned char* editData = nullptr;
-        
-        while (message->getBytesLeftToRead() > 0) {
+    PerformanceWarning warn(debugProcessPacket, "processPacket KNOWN TYPE", debugProcessPacket);
+    packet.handled = true;
+    int receivedPacketCount = ++_receivedPacketCount;
 
-            editData = reinterpret_cast<const unsigned char*>(message->getRawMessage() + message->getPosition());
+    message.readPrimitive(&packet.sequence);
 
-            int maxSize = message->getBytesLeftToRead();
+    quint64 sentAt;
+    message.readPrimitive(&sentAt);
 
-            if (debugProcessPacket) {
-                qDebug() << " --- inside while loop ---";
-                qDebug() << "    maxSize=" << maxSize;
-                qDebug("OctreeInboundPacketProcessor::processPacket() %hhu "
-                       "payload=%p payloadLength=%lld editData=%p payloadPosition=%lld maxSize=%d",
-                       (unsigned char)packetType, message->getRawMessage(), message->getSize(), editData,
-                        message->getPosition(), maxSize);
-            }
+    quint64 arrivedAt = usecTimestampNow();
+    if (sentAt > arrivedAt) {
+        if (debugProcessPacket || _myServer->wantsDebugReceiving()) {
+            qDebug() << "unreasonable sentAt=" << sentAt << " usecs";
+            qDebug() << "setting sentAt to arrivedAt=" << arrivedAt << " usecs";
+        }
+        sentAt = arrivedAt;
+    }
+    packet.transitTime = arrivedAt - sentAt;
+
+    if (debugProcessPacket || _myServer->wantsDebugReceiving()) {
+        qDebug() << "PROCESSING THREAD: got '" << packetType << "' packet - " << receivedPacketCount << " command from client";
+        qDebug() << "    receivedBytes=" << message.getSize();
+        qDebug() << "         sequence=" << packet.sequence;
+        qDebug() << "           sentAt=" << sentAt << " usecs";
+        qDebug() << "        arrivedAt=" << arrivedAt << " usecs";
+        qDebug() << "      transitTime=" << packet.transitTime << " usecs";
+        qDebug() << "      sendingNode->getClockSkewUsec()=" << packet.sendingNode->getClockSkewUsec() << " usecs";
+    }
 
-            quint64 startProcess, startLock = usecTimestampNow();
-            int editDataBytesRead;
-            _myServer->getOctree()->withWriteLock([&] {
-                startProcess = usecTimestampNow();
-                editDataBytesRead =
-                    _myServer->getOctree()->processEditPacketData(*message, editData, maxSize, sendingNode);
-            });
-            quint64 endProcess = usecTimestampNow();
-
-            if (debugProcessPacket) {
-                qDebug() << "OctreeInboundPacketProcessor::processPacket() after processEditPacketData()..."
-                    << "editDataBytesRead=" << editDataBytesRead;
-            }
+    if (debugProcessPacket && !message.getBytesLeftToRead()) {
+        qDebug() << "    ----- UNEXPECTED ---- got a packet without any edit details!!!! --------";
+    }
 
-            editsInPacket++;
-            quint64 thisProcessTime = endProcess - startProcess;
-            quint64 thisLockWaitTime = startProcess - startLock;
-            processTime += thisProcessTime;
-            lockWaitTime += thisLockWaitTime;
+    quint64 startPrepare = usecTimestampNow();
+    while (message.getBytesLeftToRead() > 0) {
+        auto editData = reinterpret_cast<const unsigned char*>(message.getRawMessage() + message.getPosition());
+        auto edit = octree->prepareEditPacketData(message, editData, message.getBytesLeftToRead(), packet.sendingNode);
+        if (!edit) {
+            break;
+        }
 
-            // skip to next edit record in the packet
-            message->seek(message->getPosition() + editDataBytesRead);
+        // skip to next edit record in the packet, or give up on the packet if the edit couldn't be read
+        int editDataBytesRead = edit->processedBytes;
+        message.seek(editDataBytesRead > 0 ? message.getPosition() + editDataBytesRead : message.getSize());
+        packet.edits.push_back(std::move(edit));
+    }
+    packet.processTime += usecTimestampNow() - startPrepare;
+}
 
-            if (debugProcessPacket) {
-                qDebug() << "    editDataBytesRead=" << editDataBytesRead;
-                qDebug() << "    AFTER processEditPacketData payload position=" << message->getPosition();
-                qDebug() << "    AFTER processEditPacketData payload size=" << message->getSize();
-            }
+// applies the next edit of the packet under the write lock, returns false once they are all applied
+bool OctreeInboundPacketProcessor::applyNextEdit(InboundEditPacket& packet, size_t& editIndex) {
+    ReceivedMessage& message = *packet.message;
+    auto octree = _myServer->getOctree();
+
+    quint64 startProcess = usecTimestampNow();
+    if (editIndex < packet.edits.size()) {
+        octree->applyPreparedEdit(*packet.edits[editIndex], packet.sendingNode);
+        packet.edits[editIndex].reset();
+        editIndex++;
+    } else if (message.getBytesLeftToRead() > 0) {
+        // the tree couldn't prepare the rest of the packet, so it is processed here
+        auto editData = reinterpret_cast<const unsigned char*>(message.getRawMessage() + message.getPosition());
+        int editDataBytesRead =
+            octree->processEditPacketData(message, editData, message.getBytesLeftToRead(), packet.sendingNode);
+
+        // skip to next edit record in the packet
+        message.seek(message.getPosition() + editDataBytesRead);
+    } else {
+        return false;
+    }
+    packet.editsInPacket++;
+    packet.processTime += usecTimestampNow() - startProcess;
+    return true;
+}
 
-        }
+void OctreeInboundPacketProcessor::trackLockHoldTime(quint64 holdTime, int editsApplied) {
+    int bucket = 0;
+    while (bucket < NUM_LOCK_HOLD_TIME_BUCKETS - 1 && holdTime > LOCK_HOLD_TIME_BUCKET_BOUNDS[bucket]) {
+        bucket++;
+    }
+    _lockHoldTimeHistogram[bucket]++;
 
-        if (debugProcessPacket) {
-            qDebug("OctreeInboundPacketProcessor::processPacket() DONE LOOPING FOR %hhu "
-                   "payload=%p payloadLength=%lld editData=%p payloadPosition=%lld",
-                   (unsigned char)packetType, message->getRawMessage(), message->getSize(), editData, message->getPosition());
-        }
+    _editsSinceLastRateUpdate += editsApplied;
+    updateEditRate();
+}
 
-        // Make sure our Node and NodeList knows we've heard from this node.
-        QUuid& nodeUUID = DEFAULT_NODE_ID_REF;
-        if (sendingNode) {
-            nodeUUID = sendingNode->getUUID();
-            if (debugProcessPacket) {
-                qDebug() << "sender has uuid=" << nodeUUID;
-            }
-        } else {
-            if (debugProcessPacket) {
-                qDebug() << "sender has no known nodeUUID.";
-            }
-        }
-        trackInboundPacket(nodeUUID, sequence, transitTime, editsInPacket, processTime, lockWaitTime);
-    } else {
-        qDebug("unknown packet ignored... packetType=%hhu", (unsigned char)packetType);
+void OctreeInboundPacketProcessor::updateEditRate() {
+    quint64 now = usecTimestampNow();
+    quint64 sinceLastRateUpdate = now - _lastEditRateUpdate;
+    if (sinceLastRateUpdate >= USECS_PER_SECOND) {
+        _editsPerSecond.updateAverage((float)_editsSinceLastRateUpdate * USECS_PER_SECOND / sinceLastRateUpdate);
+        _editsSinceLastRateUpdate = 0;
+        _lastEditRateUpdate = now;
     }
 }
 
@@ -14,7 +14,12 @@
 #ifndef hifi_OctreeInboundPacketProcessor_h
 #define hifi_OctreeInboundPacketProcessor_h
 
+#include <array>
+#include <vector>
+
+#include <Octree.h>
 #include <ReceivedPacketProcessor.h>
+#include <SimpleMovingAverage.h>
 
 #include "SequenceNumberStats.h"
 
@@ -55,9 +60,15 @@ typedef QHash<QUuid, SingleSenderStats>::const_iterator NodeToSenderStatsMapCons
 
 /// Handles processing of incoming network packets for the octee servers. As with other ReceivedPacketProcessor classes
 /// the user is responsible for reading inbound packets and adding them to the processing queue by calling queueReceivedPacket()
+/// The edits of the packets dequeued together are decoded and validated in parallel, then applied in the order they were
+/// received, in short write lock windows that let the send threads in between.
 class OctreeInboundPacketProcessor : public ReceivedPacketProcessor {
     Q_OBJECT
 public:
+    static const int NUM_LOCK_HOLD_TIME_BUCKETS = 7;
+    /// the upper bounds, in usecs, of the buckets of the lock hold time histogram, the last bucket has no bound
+    static const quint64 LOCK_HOLD_TIME_BUCKET_BOUNDS[NUM_LOCK_HOLD_TIME_BUCKETS - 1];
+
     OctreeInboundPacketProcessor(OctreeServer* myServer);
 
     quint64 getAverageTransitTimePerPacket() const { return _totalPackets == 0 ? 0 : _totalTransitTime / _totalPackets; }
@@ -70,6 +81,11 @@ public:
     quint64 getAverageLockWaitTimePerElement() const
                 { return _totalElementsInPacket == 0 ? 0 : _totalLockWaitTime / _totalElementsInPacket; }
 
+    float getEditsPerSecond() const { return _editsPerSecond.getAverage(); }
+
+    /// number of write lock windows the edits were applied in, by how long they held the lock
+    quint64 getLockHoldTimeCount(int bucket) const { return _lockHoldTimeHistogram[bucket]; }
+
     void resetStats();
 
     NodeToSenderStatsMap getSingleSenderStats() { QReadLocker locker(&_senderStatsLock); return _singleSenderStats; }
@@ -79,6 +95,7 @@ public:
 protected:
 
     virtual void processPacket(QSharedPointer<ReceivedMessage> message, SharedNodePointer sendingNode) override;
+    virtual void processPackets(std::list<NodeSharedReceivedMessagePair>& packets) override;
 
     virtual uint32_t getMaxWait() const override;
     virtual void preProcess() override;
@@ -88,11 +105,28 @@ private:
     int sendNackPackets();
 
 private:
+    struct InboundEditPacket {
+        QSharedPointer<ReceivedMessage> message;
+        SharedNodePointer sendingNode;
+        bool handled { false };
+        unsigned short int sequence { 0 };
+        quint64 transitTime { 0 };
+        std::vector<OctreePreparedEditPointer> edits;
+        int editsInPacket { 0 };
+        quint64 processTime { 0 };
+        quint64 lockWaitTime { 0 };
+    };
+
+    void prepareEditPacket(InboundEditPacket& packet);
+    bool applyNextEdit(InboundEditPacket& packet, size_t& editIndex);
+    void trackLockHoldTime(quint64 holdTime, int editsApplied);
+    void updateEditRate();
+
     void trackInboundPacket(const QUuid& nodeUUID, unsigned short int sequence, quint64 transitTime,
             int elementsInPacket, quint64 processTime, quint64 lockWaitTime);
 
     OctreeServer* _myServer;
-    int _receivedPacketCount;
+    std::atomic<int> _receivedPacketCount;
     
     std::atomic<uint64_t> _totalTransitTime;
     std::atomic<uint64_t> _totalProcessTime;
@@ -105,5 +139,10 @@ private:
 
     std::atomic<uint64_t> _lastNackTime;
     bool _shuttingDown;
+
+    std::array<std::atomic<uint64_t>, NUM_LOCK_HOLD_TIME_BUCKETS> _lockHoldTimeHistogram;
+    SimpleMovingAverage _editsPerSecond;
+    quint64 _lastEditRateUpdate;
+    int _editsSinceLastRateUpdate { 0 };
 };
 #endif // hifi_OctreeInboundPacketProcessor_h
@@ -708,6 +708,20 @@ bool OctreeServer::handleHTTPRequest(HTTPConnection* connection, const QUrl& url
         statsString += QString("            Average Filter Time: %1 usecs\r\n")
             .arg(locale.toString((uint)averageFilterTime).rightJustified(COLUMN_WIDTH, ' '));
 
+        statsString += QString("            Applied Edits Rate: %1 edits/sec\r\n")
+            .arg(locale.toString(_octreeInboundPacketProcessor->getEditsPerSecond(), 'f', FLOAT_PRECISION)
+                .rightJustified(COLUMN_WIDTH, ' '));
+        statsString += QString("   Edit Write Lock Hold Times:\r\n");
+        for (int i = 0; i < OctreeInboundPacketProcessor::NUM_LOCK_HOLD_TIME_BUCKETS; i++) {
+            QString bucketName = i < OctreeInboundPacketProcessor::NUM_LOCK_HOLD_TIME_BUCKETS - 1 ?
+                QString("<= %1").arg(OctreeInboundPacketProcessor::LOCK_HOLD_TIME_BUCKET_BOUNDS[i]) :
+                QString("> %1").arg(OctreeInboundPacketProcessor::LOCK_HOLD_TIME_BUCKET_BOUNDS[i - 1]);
+            statsString += QString("%1 usecs: %2 windows\r\n")
+                .arg(bucketName.rightJustified(25, ' '))
+                .arg(locale.toString((qulonglong)_octreeInboundPacketProcessor->getLockHoldTimeCount(i))
+                    .rightJustified(COLUMN_WIDTH, ' '));
+        }
+
 
         int senderNumber = 0;
         NodeToSenderStatsMap allSenderStats = _octreeInboundPacketProcessor->getSingleSenderStats();
@@ -1608,6 +1622,7 @@ void OctreeServer::sendStatsPacket() {
         dataArray2["1. packetQueue"] = (double)_octreeInboundPacketProcessor->packetsToProcessCount();
         dataArray2["2. totalPackets"] = (double)_octreeInboundPacketProcessor->getTotalPacketsProcessed();
         dataArray2["3. totalElements"] = (double)_octreeInboundPacketProcessor->getTotalElementsProcessed();
+        dataArray2["4. editsPerSecond"] = (double)_octreeInboundPacketProcessor->getEditsPerSecond();
 
         timingArray2["1. avgTransitTimePerPacket"] = (double)_octreeInboundPacketProcessor->getAverageTransitTimePerPacket();
         timingArray2["2. avgProcessTimePerPacket"] = (double)_octreeInboundPacketProcessor->getAverageProcessTimePerPacket();
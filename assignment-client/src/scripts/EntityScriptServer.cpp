@@ -23,6 +23,7 @@
 #include <MessagesClient.h>
 #include <plugins/CodecPlugin.h>
 #include <plugins/PluginManager.h>
+#include <ResourceCache.h>
 #include <ResourceManager.h>
 #include <ScriptCache.h>
 #include <ScriptEngines.h>
@@ -154,6 +155,11 @@ void EntityScriptServer::handleSettings() {
 
     auto entityScriptServerSettings = settingsObject[ENTITY_SCRIPT_SERVER_SETTINGS_KEY].toObject();
 
+    static const QString RESOURCE_MEMORY_LIMIT_OPTION = "resource_memory_limit";
+
+    int resourceMemoryLimitMB = std::max(0, entityScriptServerSettings[RESOURCE_MEMORY_LIMIT_OPTION].toInt());
+    ResourceCache::setProcessMemoryLimit(resourceMemoryLimitMB * BYTES_PER_MEGABYTES);
+
     static const QString MAX_ENTITY_PPS_OPTION = "max_total_entity_pps";
     static const QString ENTITY_PPS_PER_SCRIPT = "entity_pps_per_script";
 
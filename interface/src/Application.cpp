@@ -1583,6 +1583,7 @@ Application::Application(int& argc, char** argv, QElapsedTimer& startupTimer, bo
         properties["active_downloads"] = loadingRequests.size();
         properties["pending_downloads"] = ResourceCache::getPendingRequestCount();
         properties["active_downloads_details"] = loadingRequestsStats;
+        properties["download_queue_waits"] = QJsonObject::fromVariantMap(ResourceCache::getRequestQueueStats());
 
         auto statTracker = DependencyManager::get<StatTracker>();
 
@@ -0,0 +1,65 @@
+//
+//  EntityEditCoalescer.cpp
+//  libraries/entities/src
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "EntityEditCoalescer.h"
+
+bool EntityEditCoalescer::canCoalesce(const EntityItemProperties& properties) {
+    EntityPropertyFlags changedProperties = properties.getChangedProperties();
+    return !changedProperties.getHasProperty(PROP_SIMULATION_OWNER) &&
+        !changedProperties.getHasProperty(PROP_SERVER_SCRIPTS);
+}
+
+void EntityEditCoalescer::addEdit(const EntityItemID& entityItemID, const EntityItemProperties& properties, quint64 now,
+                                  const Sender& send) {
+    if (!coalesce(entityItemID, properties, now)) {
+        flush(send);
+        send(entityItemID, properties);
+    }
+}
+
+bool EntityEditCoalescer::coalesce(const EntityItemID& entityItemID, const EntityItemProperties& properties, quint64 now) {
+    if (!canCoalesce(properties)) {
+        return false;
+    }
+
+    auto itr = _edits.find(entityItemID);
+    if (itr == _edits.end()) {
+        if (_edits.isEmpty()) {
+            _oldestEditTime = now;
+        }
+        CoalescedEdit& edit = _edits[entityItemID];
+        edit.properties = properties;
+        edit.changedProperties = properties.getChangedProperties();
+        _order.push_back(entityItemID);
+        return true;
+    }
+
+    // the later values win, and merge() stamps the delta with the current time so restore the time of the edit
+    CoalescedEdit& edit = itr.value();
+    EntityPropertyFlags changedProperties = edit.changedProperties | properties.getChangedProperties();
+    edit.properties.merge(properties);
+    edit.properties.setType(properties.getType());
+    edit.properties.setLastEdited(properties.getLastEdited());
+
+    // in case merge() missed some other property, the merged delta is still right to send before the whole edit
+    if (edit.properties.getChangedProperties() != changedProperties) {
+        return false;
+    }
+    edit.changedProperties = changedProperties;
+    return true;
+}
+
+void EntityEditCoalescer::flush(const Sender& send) {
+    for (const auto& entityItemID : _order) {
+        send(entityItemID, _edits[entityItemID].properties);
+    }
+    _edits.clear();
+    _order.clear();
+}
@@ -0,0 +1,59 @@
+//
+//  EntityEditCoalescer.h
+//  libraries/entities/src
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_EntityEditCoalescer_h
+#define hifi_EntityEditCoalescer_h
+
+#include <functional>
+#include <vector>
+
+#include <QtCore/QHash>
+
+#include "EntityItemID.h"
+#include "EntityItemProperties.h"
+
+// The EntityEdit property deltas waiting to be sent, one per entity, in the order their entities were first edited.
+// The later edits to an entity are merged into its delta with EntityItemProperties::merge(), the later values winning.
+// The edits carrying properties merge() doesn't carry (the simulation owner and the server scripts) are sent whole,
+// after all the pending deltas so the order of the edits to each entity is kept.
+// Not thread safe, EntityEditPacketSender guards it with its mutex.
+class EntityEditCoalescer {
+public:
+    using Sender = std::function<void(const EntityItemID& entityItemID, const EntityItemProperties& properties)>;
+
+    /// Merges the edit into the delta of its entity, or sends the pending deltas and then the edit
+    void addEdit(const EntityItemID& entityItemID, const EntityItemProperties& properties, quint64 now,
+                 const Sender& send);
+
+    /// Sends the pending deltas and forgets them
+    void flush(const Sender& send);
+
+    bool contains(const EntityItemID& entityItemID) const { return _edits.contains(entityItemID); }
+    bool isEmpty() const { return _edits.isEmpty(); }
+
+    /// The time the oldest pending delta was started at
+    quint64 getOldestEditTime() const { return _oldestEditTime; }
+
+    static bool canCoalesce(const EntityItemProperties& properties);
+
+private:
+    struct CoalescedEdit {
+        EntityItemProperties properties;
+        EntityPropertyFlags changedProperties;
+    };
+
+    bool coalesce(const EntityItemID& entityItemID, const EntityItemProperties& properties, quint64 now);
+
+    QHash<EntityItemID, CoalescedEdit> _edits;
+    std::vector<EntityItemID> _order;
+    quint64 _oldestEditTime { 0 };
+};
+
+#endif // hifi_EntityEditCoalescer_h
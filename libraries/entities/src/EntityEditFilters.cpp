@@ -10,11 +10,201 @@
 //
 
 
+#include <list>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include <QJsonValue>
 #include <QUrl>
 
+#include <NLPacket.h>
 #include <ResourceManager.h>
 #include "EntityEditFilters.h"
 
+// Copied from ScriptEngine.cpp. We should make this a class method for reuse.
+// Note: I've deliberately stopped short of using ScriptEngine instead of QScriptEngine, as that is out of project scope at this point.
+static bool hasCorrectSyntax(const QScriptProgram& program) {
+    const auto syntaxCheck = QScriptEngine::checkSyntax(program.sourceCode());
+    if (syntaxCheck.state() != QScriptSyntaxCheckResult::Valid) {
+        const auto error = syntaxCheck.errorMessage();
+        const auto line = QString::number(syntaxCheck.errorLineNumber());
+        const auto column = QString::number(syntaxCheck.errorColumnNumber());
+        const auto message = QString("[SyntaxError] %1 in %2:%3(%4)").arg(error, program.fileName(), line, column);
+        qCritical() << qPrintable(message);
+        return false;
+    }
+    return true;
+}
+static bool hadUncaughtExceptions(QScriptEngine& engine, const QString& fileName) {
+    if (engine.hasUncaughtException()) {
+        const auto backtrace = engine.uncaughtExceptionBacktrace();
+        const auto exception = engine.uncaughtException().toString();
+        const auto line = QString::number(engine.uncaughtExceptionLineNumber());
+        engine.clearExceptions();
+
+        static const QString SCRIPT_EXCEPTION_FORMAT = "[UncaughtException] %1 in %2:%3";
+        auto message = QString(SCRIPT_EXCEPTION_FORMAT).arg(exception, fileName, line);
+        if (!backtrace.empty()) {
+            static const auto lineSeparator = "\n    ";
+            message += QString("\n[Backtrace]%1%2").arg(lineSeparator, backtrace.join(lineSeparator));
+        }
+        qCritical() << qPrintable(message);
+        return true;
+    }
+    return false;
+}
+
+// The engines of a filter are created as the edits need them, so that each thread filtering edits at once gets its own,
+// and are kept for the next edits.
+// The results that leave the edits unchanged are cached by the edit they were given, which assumes that the filters only
+// depend on their input, its lastEdited time aside. The least recently used results are evicted once the cache is full.
+class EntityEditFilters::Filter {
+public:
+    struct Engine {
+        QScriptEngine engine;
+        QScriptValue filterFn;
+    };
+    using EnginePointer = std::unique_ptr<Engine>;
+
+    Filter(const QString& scriptContents, const QString& url) : _scriptContents(scriptContents), _url(url) {}
+
+    const QString& getURL() const { return _url; }
+
+    /// Evaluates the script in a new engine, returns null if it threw
+    EnginePointer createEngine();
+
+    /// Returns an engine that no other thread is using, or null if the script threw
+    EnginePointer acquireEngine();
+    void releaseEngine(EnginePointer engine);
+
+    void setFilteredProperties(const EntityPropertyFlags& filteredProperties);
+
+    /// True if the filter declared the properties it looks at, and none of them is in properties
+    bool ignores(const EntityPropertyFlags& properties) const;
+
+    bool findResult(const QByteArray& key, bool& accepted);
+    void cacheResult(const QByteArray& key, bool accepted);
+
+private:
+    static const int MAX_CACHED_RESULTS = 1024;
+
+    const QString _scriptContents;
+    const QString _url;
+    bool _hasFilteredProperties { false };
+    EntityPropertyFlags _filteredProperties;
+
+    std::mutex _mutex;
+    std::vector<EnginePointer> _freeEngines;
+
+    // the cached results, most recently used first, and their index by key
+    using ResultList = std::list<std::pair<QByteArray, bool>>;
+    ResultList _results;
+    QHash<QByteArray, ResultList::iterator> _resultsByKey;
+};
+
+EntityEditFilters::Filter::EnginePointer EntityEditFilters::Filter::createEngine() {
+    EnginePointer result(new Engine());
+    QScriptEngine& engine = result->engine;
+    engine.evaluate(_scriptContents, _url);
+    if (hadUncaughtExceptions(engine, _url)) {
+        return EnginePointer();
+    }
+
+    // now get the filter function
+    auto global = engine.globalObject();
+    auto entitiesObject = engine.newObject();
+    entitiesObject.setProperty("ADD_FILTER_TYPE", EntityTree::FilterType::Add);
+    entitiesObject.setProperty("EDIT_FILTER_TYPE", EntityTree::FilterType::Edit);
+    entitiesObject.setProperty("PHYSICS_FILTER_TYPE", EntityTree::FilterType::Physics);
+    global.setProperty("Entities", entitiesObject);
+    result->filterFn = global.property("filter");
+    return result;
+}
+
+EntityEditFilters::Filter::EnginePointer EntityEditFilters::Filter::acquireEngine() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_freeEngines.empty()) {
+            EnginePointer engine = std::move(_freeEngines.back());
+            _freeEngines.pop_back();
+            return engine;
+        }
+    }
+    // the other engines are busy, this thread gets its own
+    EnginePointer engine = createEngine();
+    if (engine && !engine->filterFn.isFunction()) {
+        engine.reset();
+    }
+    return engine;
+}
+
+void EntityEditFilters::Filter::releaseEngine(EnginePointer engine) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _freeEngines.push_back(std::move(engine));
+}
+
+void EntityEditFilters::Filter::setFilteredProperties(const EntityPropertyFlags& filteredProperties) {
+    _hasFilteredProperties = true;
+    _filteredProperties = filteredProperties;
+}
+
+bool EntityEditFilters::Filter::ignores(const EntityPropertyFlags& properties) const {
+    return _hasFilteredProperties && (properties & _filteredProperties).isEmpty();
+}
+
+bool EntityEditFilters::Filter::findResult(const QByteArray& key, bool& accepted) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto iter = _resultsByKey.constFind(key);
+    if (iter == _resultsByKey.constEnd()) {
+        return false;
+    }
+    _results.splice(_results.begin(), _results, iter.value());
+    accepted = iter.value()->second;
+    return true;
+}
+
+void EntityEditFilters::Filter::cacheResult(const QByteArray& key, bool accepted) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto iter = _resultsByKey.find(key);
+    if (iter != _resultsByKey.end()) {
+        // another thread ran the filter on the same edit meanwhile
+        _results.splice(_results.begin(), _results, iter.value());
+        iter.value()->second = accepted;
+        return;
+    }
+    if ((int)_results.size() >= MAX_CACHED_RESULTS) {
+        _resultsByKey.remove(_results.back().first);
+        _results.pop_back();
+    }
+    _results.emplace_front(key, accepted);
+    _resultsByKey.insert(key, _results.begin());
+}
+
+// The key of the result of a filter for an edit: the edited entity, the filter type, and the edit as it is encoded in
+// an edit packet, without its lastEdited time. This is built from the properties directly, so that an edit whose result
+// is cached doesn't need its script input. Returns an empty key for an edit that can't be encoded, which isn't cached.
+static QByteArray resultKey(const EntityItemProperties& properties, const EntityItemID& entityID,
+                            EntityTree::FilterType filterType) {
+    EntityItemProperties keyProperties = properties;
+    keyProperties.setLastEdited(UNKNOWN_CREATED_TIME); // clamps to the creation time
+
+    QByteArray encodedProperties(NLPacket::maxPayloadSize(PacketType::EntityEdit), 0);
+    if (!EntityItemProperties::encodeEntityEditPacket(PacketType::EntityEdit, entityID, keyProperties, encodedProperties)) {
+        return QByteArray();
+    }
+
+    // edit packets don't carry the creation time, which the filters are given
+    QByteArray key;
+    key.reserve(sizeof(int) + sizeof(quint64) + encodedProperties.size());
+    int type = (int)filterType;
+    quint64 created = properties.getCreated();
+    key.append(reinterpret_cast<const char*>(&type), sizeof(type));
+    key.append(reinterpret_cast<const char*>(&created), sizeof(created));
+    key.append(encodedProperties);
+    return key;
+}
+
 QList<EntityItemID> EntityEditFilters::getZonesByPosition(glm::vec3& position) {
     QList<EntityItemID> zones;
     QList<EntityItemID> missingZones;
@@ -61,32 +251,14 @@ bool EntityEditFilters::filter(glm::vec3& position, EntityItemProperties& proper
             if (filterData.rejectAll) {
                 return false;
             }
-            auto oldProperties = propertiesIn.getDesiredProperties();
-            auto specifiedProperties = propertiesIn.getChangedProperties();
-            propertiesIn.setDesiredProperties(specifiedProperties);
-            QScriptValue inputValues = propertiesIn.copyToScriptValue(filterData.engine, false, true, true);
-            propertiesIn.setDesiredProperties(oldProperties);
-
-            auto in = QJsonValue::fromVariant(inputValues.toVariant()); // grab json copy now, because the inputValues might be side effected by the filter.
-            QScriptValueList args;
-            args << inputValues;
-            args << filterType;
-
-            QScriptValue result = filterData.filterFn.call(_nullObjectForFilter, args);
-            if (filterData.uncaughtExceptions()) {
-                return false;
-            }
+            // the filter keeps running if it gets removed meanwhile, as we hold a reference to it
+            Filter& filter = *filterData.filter;
 
-            if (result.isObject()){
-                // make propertiesIn reflect the changes, for next filter...
-                propertiesIn.copyFromScriptValue(result, false);
-
-                // and update propertiesOut too.  TODO: this could be more efficient...
-                propertiesOut.copyFromScriptValue(result, false);
-                // Javascript objects are == only if they are the same object. To compare arbitrary values, we need to use JSON.
-                auto out = QJsonValue::fromVariant(result.toVariant());
-                wasChanged |= (in != out);
-            } else {
+            // edits of existing entities that don't change the properties the filter looks at get through it untouched
+            if (filterType != EntityTree::FilterType::Add && filter.ignores(propertiesIn.getChangedProperties())) {
+                continue;
+            }
+            if (!runFilter(filter, propertiesIn, propertiesOut, wasChanged, filterType, itemID)) {
                 return false;
             }
         }
@@ -95,12 +267,63 @@ bool EntityEditFilters::filter(glm::vec3& position, EntityItemProperties& proper
     return true;
 }
 
+bool EntityEditFilters::runFilter(Filter& filter, EntityItemProperties& propertiesIn, EntityItemProperties& propertiesOut,
+                                  bool& wasChanged, EntityTree::FilterType filterType, const EntityItemID& entityID) {
+    // the same edit, but for its time, gets the same answer from the filter
+    QByteArray cacheKey = resultKey(propertiesIn, entityID, filterType);
+    bool accepted;
+    if (!cacheKey.isEmpty() && filter.findResult(cacheKey, accepted)) {
+        return accepted;
+    }
+
+    auto engine = filter.acquireEngine();
+    if (!engine) {
+        return false;
+    }
+
+    auto oldProperties = propertiesIn.getDesiredProperties();
+    auto specifiedProperties = propertiesIn.getChangedProperties();
+    propertiesIn.setDesiredProperties(specifiedProperties);
+    QScriptValue inputValues = propertiesIn.copyToScriptValue(&engine->engine, false, true, true);
+    propertiesIn.setDesiredProperties(oldProperties);
+
+    auto in = QJsonValue::fromVariant(inputValues.toVariant()); // grab json copy now, because the inputValues might be side effected by the filter.
+
+    QScriptValueList args;
+    args << inputValues;
+    args << filterType;
+
+    QScriptValue result = engine->filterFn.call(QScriptValue(), args);
+    if (hadUncaughtExceptions(engine->engine, filter.getURL())) {
+        filter.releaseEngine(std::move(engine));
+        return false;
+    }
+
+    accepted = result.isObject();
+    if (accepted) {
+        // make propertiesIn reflect the changes, for next filter...
+        propertiesIn.copyFromScriptValue(result, false);
+
+        // and update propertiesOut too.  TODO: this could be more efficient...
+        propertiesOut.copyFromScriptValue(result, false);
+        // Javascript objects are == only if they are the same object. To compare arbitrary values, we need to use JSON.
+        auto out = QJsonValue::fromVariant(result.toVariant());
+        bool changed = (in != out);
+        wasChanged |= changed;
+
+        // the changed properties are evaluated again each time, as filters often randomize them on purpose
+        if (!changed && !cacheKey.isEmpty()) {
+            filter.cacheResult(cacheKey, true);
+        }
+    } else if (!cacheKey.isEmpty()) {
+        filter.cacheResult(cacheKey, false);
+    }
+    filter.releaseEngine(std::move(engine));
+    return accepted;
+}
+
 void EntityEditFilters::removeFilter(EntityItemID entityID) {
     QWriteLocker writeLock(&_lock);
-    FilterData filterData = _filterDataMap.value(entityID);
-    if (filterData.valid()) {
-        delete filterData.engine;
-    }
     _filterDataMap.remove(entityID);
 }
 
@@ -146,39 +369,6 @@ void EntityEditFilters::addFilter(EntityItemID entityID, QString filterURL) {
     qDebug() << "script request sent for entity " << entityID;
 }
 
-// Copied from ScriptEngine.cpp. We should make this a class method for reuse.
-// Note: I've deliberately stopped short of using ScriptEngine instead of QScriptEngine, as that is out of project scope at this point.
-static bool hasCorrectSyntax(const QScriptProgram& program) {
-    const auto syntaxCheck = QScriptEngine::checkSyntax(program.sourceCode());
-    if (syntaxCheck.state() != QScriptSyntaxCheckResult::Valid) {
-        const auto error = syntaxCheck.errorMessage();
-        const auto line = QString::number(syntaxCheck.errorLineNumber());
-        const auto column = QString::number(syntaxCheck.errorColumnNumber());
-        const auto message = QString("[SyntaxError] %1 in %2:%3(%4)").arg(error, program.fileName(), line, column);
-        qCritical() << qPrintable(message);
-        return false;
-    }
-    return true;
-}
-static bool hadUncaughtExceptions(QScriptEngine& engine, const QString& fileName) {
-    if (engine.hasUncaughtException()) {
-        const auto backtrace = engine.uncaughtExceptionBacktrace();
-        const auto exception = engine.uncaughtException().toString();
-        const auto line = QString::number(engine.uncaughtExceptionLineNumber());
-        engine.clearExceptions();
-
-        static const QString SCRIPT_EXCEPTION_FORMAT = "[UncaughtException] %1 in %2:%3";
-        auto message = QString(SCRIPT_EXCEPTION_FORMAT).arg(exception, fileName, line);
-        if (!backtrace.empty()) {
-            static const auto lineSeparator = "\n    ";
-            message += QString("\n[Backtrace]%1%2").arg(lineSeparator, backtrace.join(lineSeparator));
-        }
-        qCritical() << qPrintable(message);
-        return true;
-    }
-    return false;
-}
-
 void EntityEditFilters::scriptRequestFinished(EntityItemID entityID) {
     qDebug() << "script request completed for entity " << entityID;
     auto scriptRequest = qobject_cast<ResourceRequest*>(sender());
@@ -188,31 +378,28 @@ void EntityEditFilters::scriptRequestFinished(EntityItemID entityID) {
         qInfo() << "Downloaded script:" << scriptContents;
         QScriptProgram program(scriptContents, urlString);
         if (hasCorrectSyntax(program)) {
-            // create a QScriptEngine for this script
-            QScriptEngine* engine = new QScriptEngine();
-            engine->evaluate(scriptContents);
-            if (!hadUncaughtExceptions(*engine, urlString)) {
-                // put the engine in the engine map (so we don't leak them, etc...)
+            auto filter = std::make_shared<Filter>(scriptContents, urlString);
+
+            // evaluate the script once now, so that it gets reported if it's broken
+            auto engine = filter->createEngine();
+            if (engine) {
                 FilterData filterData;
-                filterData.engine = engine;
                 filterData.rejectAll = false;
-                
-                // define the uncaughtException function
-                QScriptEngine& engineRef = *engine;
-                filterData.uncaughtExceptions = [this, &engineRef, urlString]() { return hadUncaughtExceptions(engineRef, urlString); };
-
-                // now get the filter function
-                auto global = engine->globalObject();
-                auto entitiesObject = engine->newObject();
-                entitiesObject.setProperty("ADD_FILTER_TYPE", EntityTree::FilterType::Add);
-                entitiesObject.setProperty("EDIT_FILTER_TYPE", EntityTree::FilterType::Edit);
-                entitiesObject.setProperty("PHYSICS_FILTER_TYPE", EntityTree::FilterType::Physics);
-                global.setProperty("Entities", entitiesObject);
-                filterData.filterFn = global.property("filter");
-                if (!filterData.filterFn.isFunction()) {
+
+                if (!engine->filterFn.isFunction()) {
                     qDebug() << "Filter function specified but not found. Will reject all edits for those without lock rights.";
-                    delete engine;
-                    filterData.rejectAll=true;
+                    filterData.rejectAll = true;
+                } else {
+                    // the filter can list the properties it looks at, e.g. filter.filteredProperties = ["position"],
+                    // so that the edits of other properties skip it
+                    auto filteredPropertiesValue = engine->filterFn.property("filteredProperties");
+                    if (filteredPropertiesValue.isArray() || filteredPropertiesValue.isString()) {
+                        EntityPropertyFlags filteredProperties;
+                        EntityItemProperties::entityPropertyFlagsFromScriptValue(filteredPropertiesValue, filteredProperties);
+                        filter->setFilteredProperties(filteredProperties);
+                    }
+                    filter->releaseEngine(std::move(engine));
+                    filterData.filter = filter;
                 }
                
                 
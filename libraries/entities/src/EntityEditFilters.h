@@ -18,6 +18,7 @@
 #include <glm/glm.hpp>
 
 #include <functional>
+#include <memory>
 
 #include "EntityItemID.h"
 #include "EntityItemProperties.h"
@@ -26,14 +27,15 @@
 class EntityEditFilters : public QObject, public Dependency {
     Q_OBJECT
 public:
+    // a filter script, with the pool of engines evaluating it and the results it gave
+    class Filter;
+
     struct FilterData {
-        QScriptValue filterFn;
-        std::function<bool()> uncaughtExceptions;
-        QScriptEngine* engine;
+        std::shared_ptr<Filter> filter;
         bool rejectAll;
         
-        FilterData(): engine(nullptr), rejectAll(false) {};
-        bool valid() { return (rejectAll || (engine != nullptr && filterFn.isFunction() && uncaughtExceptions)); }
+        FilterData(): rejectAll(false) {};
+        bool valid() { return (rejectAll || filter); }
     };
 
     EntityEditFilters() {};
@@ -53,10 +55,11 @@ private slots:
     
 private:
     QList<EntityItemID> getZonesByPosition(glm::vec3& position);
+    bool runFilter(Filter& filter, EntityItemProperties& propertiesIn, EntityItemProperties& propertiesOut, bool& wasChanged,
+                   EntityTree::FilterType filterType, const EntityItemID& entityID);
 
     EntityTreePointer _tree {};
     bool _rejectAll {false};
-    QScriptValue _nullObjectForFilter{};
     
     QReadWriteLock _lock;
     QMap<EntityItemID, FilterData> _filterDataMap;
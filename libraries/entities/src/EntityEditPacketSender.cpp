@@ -19,6 +19,9 @@
 #include "EntityItem.h"
 #include "EntityItemProperties.h"
 
+// about a frame, so that the scripts editing entities every frame send half as many edits
+const quint64 EntityEditPacketSender::DEFAULT_EDIT_COALESCING_INTERVAL = USECS_PER_SECOND / 60;
+
 EntityEditPacketSender::EntityEditPacketSender() {
     auto& packetReceiver = DependencyManager::get<NodeList>()->getPacketReceiver();
     packetReceiver.registerDirectListener(PacketType::EntityEditNack, this, "processEntityEditNackPacket");
@@ -90,6 +93,36 @@ void EntityEditPacketSender::queueEditEntityMessage(PacketType type,
         return;
     }
 
+    if (type == PacketType::EntityEdit && _editCoalescingInterval > 0) {
+        bool startedCoalescing;
+        {
+            std::lock_guard<std::mutex> lock(_coalescingMutex);
+            bool wasEmpty = _coalescedEdits.isEmpty();
+            _coalescedEdits.addEdit(entityItemID, properties, usecTimestampNow(),
+                                    [this, type](const EntityItemID& entityItemID, const EntityItemProperties& properties) {
+                encodeAndQueueEditMessage(type, entityItemID, properties);
+            });
+            startedCoalescing = wasEmpty && !_coalescedEdits.isEmpty();
+        }
+        if (startedCoalescing && isThreaded()) {
+            // the thread may be waiting for packets with no time out, have it wait for the end of the interval instead
+            wakeUp();
+        }
+        return;
+    }
+
+    {
+        // the coalesced edits to this entity were queued before this message, so they have to be sent before it
+        std::lock_guard<std::mutex> lock(_coalescingMutex);
+        if (_coalescedEdits.contains(entityItemID)) {
+            queueCoalescedEdits();
+        }
+    }
+    encodeAndQueueEditMessage(type, entityItemID, properties);
+}
+
+void EntityEditPacketSender::encodeAndQueueEditMessage(PacketType type, const EntityItemID& entityItemID,
+                                                       const EntityItemProperties& properties) {
     QByteArray bufferOut(NLPacket::maxPayloadSize(type), 0);
 
     bool success;
@@ -113,6 +146,58 @@ void EntityEditPacketSender::queueEditEntityMessage(PacketType type,
     }
 }
 
+void EntityEditPacketSender::queueCoalescedEdits() {
+    _coalescedEdits.flush([this](const EntityItemID& entityItemID, const EntityItemProperties& properties) {
+        encodeAndQueueEditMessage(PacketType::EntityEdit, entityItemID, properties);
+    });
+}
+
+void EntityEditPacketSender::flushCoalescedEdits() {
+    std::lock_guard<std::mutex> lock(_coalescingMutex);
+    queueCoalescedEdits();
+}
+
+void EntityEditPacketSender::setEditCoalescingInterval(quint64 usecs) {
+    std::lock_guard<std::mutex> lock(_coalescingMutex);
+    _editCoalescingInterval = usecs;
+    if (_editCoalescingInterval == 0) {
+        queueCoalescedEdits();
+    }
+}
+
+bool EntityEditPacketSender::process() {
+    bool queuedEdits = false;
+    {
+        std::lock_guard<std::mutex> lock(_coalescingMutex);
+        if (!_coalescedEdits.isEmpty() && usecTimestampNow() - _coalescedEdits.getOldestEditTime() >= _editCoalescingInterval) {
+            queueCoalescedEdits();
+            queuedEdits = true;
+        }
+    }
+    if (queuedEdits) {
+        // send the packed edits now rather than waiting for them to fill a packet
+        releaseQueuedMessages();
+    }
+
+    return OctreeEditPacketSender::process();
+}
+
+quint64 EntityEditPacketSender::getMaxWaitForPacketsUsecs() {
+    std::lock_guard<std::mutex> lock(_coalescingMutex);
+    if (_coalescedEdits.isEmpty()) {
+        return 0;
+    }
+    // wake up in time to queue the coalesced edits
+    quint64 elapsed = usecTimestampNow() - _coalescedEdits.getOldestEditTime();
+    const quint64 MIN_WAIT_USECS = 1;
+    return elapsed < _editCoalescingInterval ? _editCoalescingInterval - elapsed : MIN_WAIT_USECS;
+}
+
+bool EntityEditPacketSender::hasCoalescedEdits() {
+    std::lock_guard<std::mutex> lock(_coalescingMutex);
+    return !_coalescedEdits.isEmpty();
+}
+
 void EntityEditPacketSender::queueEraseEntityMessage(const EntityItemID& entityItemID) {
     if (!_shouldSend) {
         return; // bail early
@@ -123,6 +208,13 @@ void EntityEditPacketSender::queueEraseEntityMessage(const EntityItemID& entityI
         _myAvatar->clearAvatarEntity(entityItemID);
     }
 
+    {
+        std::lock_guard<std::mutex> lock(_coalescingMutex);
+        if (_coalescedEdits.contains(entityItemID)) {
+            queueCoalescedEdits();
+        }
+    }
+
     QByteArray bufferOut(NLPacket::maxPayloadSize(PacketType::EntityErase), 0);
 
     if (EntityItemProperties::encodeEraseEntityMessage(entityItemID, bufferOut)) {
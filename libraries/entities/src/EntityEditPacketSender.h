@@ -16,7 +16,9 @@
 
 #include <mutex>
 
+#include "EntityEditCoalescer.h"
 #include "EntityItem.h"
+#include "EntityItemProperties.h"
 #include "AvatarData.h"
 
 /// Utility for processing, packing, queueing and sending of outbound edit voxel messages.
@@ -39,20 +41,48 @@ public:
 
     void queueEraseEntityMessage(const EntityItemID& entityItemID);
 
+    /// EntityEdit messages to the same entity queued within the coalescing interval are merged into a single property
+    /// delta, and the deltas of all the entities are packed together once the interval of the oldest one has passed.
+    /// An interval of 0 queues every edit message as it comes.
+    void setEditCoalescingInterval(quint64 usecs);
+    quint64 getEditCoalescingInterval() const { return _editCoalescingInterval; }
+
+    /// Queues the coalesced edit messages right away, rather than when their interval has passed
+    void flushCoalescedEdits();
+
+    /// Are there edit messages waiting for their coalescing interval to pass
+    bool hasCoalescedEdits();
+
+    static const quint64 DEFAULT_EDIT_COALESCING_INTERVAL;
+
+    virtual bool process() override;
+
     // My server type is the model server
     virtual char getMyNodeType() const override { return NodeType::EntityServer; }
     virtual void adjustEditPacketForClockSkew(PacketType type, QByteArray& buffer, qint64 clockSkew) override;
 
+protected:
+    virtual quint64 getMaxWaitForPacketsUsecs() override;
+
 public slots:
     void processEntityEditNackPacket(QSharedPointer<ReceivedMessage> message, SharedNodePointer sendingNode);
 
 private:
     void queueEditAvatarEntityMessage(PacketType type, EntityTreePointer entityTree,
                                       EntityItemID entityItemID, const EntityItemProperties& properties);
+    void encodeAndQueueEditMessage(PacketType type, const EntityItemID& entityItemID,
+                                   const EntityItemProperties& properties);
+
+    // expects _coalescingMutex to be locked
+    void queueCoalescedEdits();
 
 private:
     std::mutex _mutex;
     AvatarData* _myAvatar { nullptr };
     QScriptEngine _scriptEngine;
+
+    std::mutex _coalescingMutex;
+    quint64 _editCoalescingInterval { DEFAULT_EDIT_COALESCING_INTERVAL };
+    EntityEditCoalescer _coalescedEdits;
 };
 #endif // hifi_EntityEditPacketSender_h
@@ -0,0 +1,123 @@
+//
+//  EntityExpiryQueue.cpp
+//  libraries/entities/src
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "EntityExpiryQueue.h"
+
+const quint64 EntityExpiryQueue::NEVER;
+
+bool EntityExpiryQueue::set(const EntityItemPointer& entity, quint64 expiry) {
+    auto it = _indices.find(entity.get());
+    if (it != _indices.end()) {
+        auto index = it->second;
+        auto oldExpiry = _heap[index].expiry;
+        _heap[index].expiry = expiry;
+
+        if (expiry < oldExpiry) {
+            siftUp(index);
+        } else if (expiry > oldExpiry) {
+            siftDown(index);
+        }
+        return false;
+    }
+
+    Entry entry;
+    entry.key = entity.get();
+    entry.entity = entity;
+    entry.expiry = expiry;
+
+    _heap.push_back(Entry());
+    place(_heap.size() - 1, std::move(entry));
+    siftUp(_heap.size() - 1);
+    return true;
+}
+
+bool EntityExpiryQueue::remove(const EntityItem* entity) {
+    auto it = _indices.find(entity);
+    if (it == _indices.end()) {
+        return false;
+    }
+
+    removeAt(it->second);
+    return true;
+}
+
+EntityItemPointer EntityExpiryQueue::pop() {
+    EntityItemPointer entity;
+    if (!_heap.empty()) {
+        entity = _heap.front().entity;
+        removeAt(0);
+    }
+    return entity;
+}
+
+void EntityExpiryQueue::clear() {
+    _heap.clear();
+    _indices.clear();
+}
+
+void EntityExpiryQueue::removeAt(size_t index) {
+    _indices.erase(_heap[index].key);
+
+    auto lastIndex = _heap.size() - 1;
+    if (index != lastIndex) {
+        place(index, std::move(_heap[lastIndex]));
+        _heap.pop_back();
+
+        if (index > 0 && _heap[index].expiry < _heap[(index - 1) / 2].expiry) {
+            siftUp(index);
+        } else {
+            siftDown(index);
+        }
+    } else {
+        _heap.pop_back();
+    }
+}
+
+void EntityExpiryQueue::siftUp(size_t index) {
+    Entry entry = std::move(_heap[index]);
+
+    while (index > 0) {
+        auto parent = (index - 1) / 2;
+        if (!(entry.expiry < _heap[parent].expiry)) {
+            break;
+        }
+        place(index, std::move(_heap[parent]));
+        index = parent;
+    }
+
+    place(index, std::move(entry));
+}
+
+void EntityExpiryQueue::siftDown(size_t index) {
+    Entry entry = std::move(_heap[index]);
+    auto size = _heap.size();
+
+    while (true) {
+        auto child = 2 * index + 1;
+        if (child >= size) {
+            break;
+        }
+        if (child + 1 < size && _heap[child + 1].expiry < _heap[child].expiry) {
+            ++child;
+        }
+        if (!(_heap[child].expiry < entry.expiry)) {
+            break;
+        }
+        place(index, std::move(_heap[child]));
+        index = child;
+    }
+
+    place(index, std::move(entry));
+}
+
+void EntityExpiryQueue::place(size_t index, Entry&& entry) {
+    _indices[entry.key] = index;
+    _heap[index] = std::move(entry);
+}
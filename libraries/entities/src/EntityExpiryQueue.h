@@ -0,0 +1,62 @@
+//
+//  EntityExpiryQueue.h
+//  libraries/entities/src
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_EntityExpiryQueue_h
+#define hifi_EntityExpiryQueue_h
+
+#include <unordered_map>
+#include <vector>
+
+#include <QtGlobal>
+
+#include "EntityItem.h"
+
+// A min-heap of the mortal entities ordered by expiry, indexed by entity so that the expiry of a queued entity can be
+// changed, or the entity removed, in logarithmic time, and the expired entities dequeued without visiting the others.
+// Not thread safe, EntitySimulation guards it with its mutex.
+class EntityExpiryQueue {
+public:
+    static const quint64 NEVER = quint64(-1);
+
+    /// Queues the entity, or changes its expiry if it is already queued. Returns true if it was newly queued.
+    bool set(const EntityItemPointer& entity, quint64 expiry);
+
+    /// Removes a queued entity. Returns false if the entity isn't queued.
+    bool remove(const EntityItem* entity);
+
+    bool contains(const EntityItem* entity) const { return _indices.find(entity) != _indices.end(); }
+
+    /// Returns the earliest expiry of the queued entities, or NEVER if there are none
+    quint64 getNextExpiry() const { return _heap.empty() ? NEVER : _heap.front().expiry; }
+
+    /// Dequeues the entity that expires first
+    EntityItemPointer pop();
+
+    size_t size() const { return _heap.size(); }
+    bool isEmpty() const { return _heap.empty(); }
+    void clear();
+
+private:
+    struct Entry {
+        const EntityItem* key;
+        EntityItemPointer entity;
+        quint64 expiry;
+    };
+
+    void removeAt(size_t index);
+    void siftUp(size_t index);
+    void siftDown(size_t index);
+    void place(size_t index, Entry&& entry);
+
+    std::vector<Entry> _heap;
+    std::unordered_map<const EntityItem*, size_t> _indices;
+};
+
+#endif // hifi_EntityExpiryQueue_h
@@ -31,6 +31,7 @@
 #include "EntityTree.h"
 #include "EntitySimulation.h"
 #include "EntityDynamicFactoryInterface.h"
+#include "KinematicMotion.h"
 
 
 int EntityItem::_maxActionsDataSize = 800;
@@ -128,17 +129,20 @@ OctreeElement::AppendState EntityItem::appendEntityData(OctreePacketData* packet
 
     // encode our type as a byte count coded byte stream
     ByteCountCoded<quint32> typeCoder = getType();
-    QByteArray encodedType = typeCoder;
+    uint8_t encodedType[MAX_BYTE_COUNT_CODED_SIZE];
+    int encodedTypeLength = typeCoder.encode(encodedType, MAX_BYTE_COUNT_CODED_SIZE);
 
     // last updated (animations, non-physics changes)
     quint64 updateDelta = getLastUpdated() <= getLastEdited() ? 0 : getLastUpdated() - getLastEdited();
     ByteCountCoded<quint64> updateDeltaCoder = updateDelta;
-    QByteArray encodedUpdateDelta = updateDeltaCoder;
+    uint8_t encodedUpdateDelta[MAX_BYTE_COUNT_CODED_SIZE];
+    int encodedUpdateDeltaLength = updateDeltaCoder.encode(encodedUpdateDelta, MAX_BYTE_COUNT_CODED_SIZE);
 
     // last simulated (velocity, angular velocity, physics changes)
     quint64 simulatedDelta = getLastSimulated() <= getLastEdited() ? 0 : getLastSimulated() - getLastEdited();
     ByteCountCoded<quint64> simulatedDeltaCoder = simulatedDelta;
-    QByteArray encodedSimulatedDelta = simulatedDeltaCoder;
+    uint8_t encodedSimulatedDelta[MAX_BYTE_COUNT_CODED_SIZE];
+    int encodedSimulatedDeltaLength = simulatedDeltaCoder.encode(encodedSimulatedDelta, MAX_BYTE_COUNT_CODED_SIZE);
 
 
     EntityPropertyFlags propertyFlags(PROP_LAST_ITEM);
@@ -177,7 +181,7 @@ OctreeElement::AppendState EntityItem::appendEntityData(OctreePacketData* packet
 
     successIDFits = packetData->appendRawData(encodedID);
     if (successIDFits) {
-        successTypeFits = packetData->appendRawData(encodedType);
+        successTypeFits = packetData->appendRawData(encodedType, encodedTypeLength);
     }
     if (successTypeFits) {
         successCreatedFits = packetData->appendValue(_created);
@@ -186,10 +190,10 @@ OctreeElement::AppendState EntityItem::appendEntityData(OctreePacketData* packet
         successLastEditedFits = packetData->appendValue(lastEdited);
     }
     if (successLastEditedFits) {
-        successLastUpdatedFits = packetData->appendRawData(encodedUpdateDelta);
+        successLastUpdatedFits = packetData->appendRawData(encodedUpdateDelta, encodedUpdateDeltaLength);
     }
     if (successLastUpdatedFits) {
-        successLastSimulatedFits = packetData->appendRawData(encodedSimulatedDelta);
+        successLastSimulatedFits = packetData->appendRawData(encodedSimulatedDelta, encodedSimulatedDeltaLength);
     }
 
     if (successLastSimulatedFits) {
@@ -952,12 +956,15 @@ void EntityItem::setCollisionSoundURL(const QString& value) {
     }
 }
 
-void EntityItem::simulate(const quint64& now) {
+float EntityItem::getKinematicTimeElapsed(const quint64& now) {
     if (getLastSimulated() == 0) {
         setLastSimulated(now);
     }
+    return (float)(now - getLastSimulated()) / (float)(USECS_PER_SECOND);
+}
 
-    float timeElapsed = (float)(now - getLastSimulated()) / (float)(USECS_PER_SECOND);
+void EntityItem::simulate(const quint64& now) {
+    float timeElapsed = getKinematicTimeElapsed(now);
 
     #ifdef WANT_DEBUG
         qCDebug(entities) << "********** EntityItem::simulate()";
@@ -1013,106 +1020,60 @@ bool EntityItem::stepKinematicMotion(float timeElapsed) {
     glm::vec3 linearVelocity;
     glm::vec3 angularVelocity;
     getLocalTransformAndVelocities(transform, linearVelocity, angularVelocity);
+    glm::vec3 position = transform.getTranslation();
+    glm::quat rotation = transform.getRotation();
 
-    // find out if it is moving
-    bool isSpinning = (glm::length2(angularVelocity) > 0.0f);
-    float linearSpeedSquared = glm::length2(linearVelocity);
-    bool isTranslating = linearSpeedSquared > 0.0f;
-    bool moving = isTranslating || isSpinning;
-    if (!moving) {
+    if (!::stepKinematicMotion(position, rotation, linearVelocity, angularVelocity, getLocalKinematicAcceleration(),
+                               getDamping(), getAngularDamping(), timeElapsed)) {
         return false;
     }
 
-    if (timeElapsed <= 0.0f) {
-        // someone gave us a useless time value so bail early
-        // but return 'true' because it is moving
-        return true;
-    }
-
-    const float MAX_TIME_ELAPSED = 1.0f; // seconds
-    if (timeElapsed > MAX_TIME_ELAPSED) {
-        qCWarning(entities) << "kinematic timestep = " << timeElapsed << " truncated to " << MAX_TIME_ELAPSED;
+    if (timeElapsed > 0.0f) {
+        transform.setTranslation(position);
+        transform.setRotation(rotation);
+        setLocalTransformAndVelocities(transform, linearVelocity, angularVelocity);
     }
-    timeElapsed = glm::min(timeElapsed, MAX_TIME_ELAPSED);
+    return true;
+}
 
-    if (isSpinning) {
-        float angularDamping = getAngularDamping();
-        // angular damping
-        if (angularDamping > 0.0f) {
-            angularVelocity *= powf(1.0f - angularDamping, timeElapsed);
-        }
+size_t EntityItem::appendKinematicMotion(KinematicMotions& motions, const quint64& now) {
+    float timeElapsed = getKinematicTimeElapsed(now);
 
-        const float MIN_KINEMATIC_ANGULAR_SPEED_SQUARED =
-            KINEMATIC_ANGULAR_SPEED_THRESHOLD * KINEMATIC_ANGULAR_SPEED_THRESHOLD;
-        if (glm::length2(angularVelocity) < MIN_KINEMATIC_ANGULAR_SPEED_SQUARED) {
-            angularVelocity = Vectors::ZERO;
-        } else {
-            // for improved agreement with the way Bullet integrates rotations we use an approximation
-            // and break the integration into bullet-sized substeps
-            glm::quat rotation = transform.getRotation();
-            float dt = timeElapsed;
-            while (dt > 0.0f) {
-                glm::quat  dQ = computeBulletRotationStep(angularVelocity, glm::min(dt, PHYSICS_ENGINE_FIXED_SUBSTEP));
-                rotation = glm::normalize(dQ * rotation);
-                dt -= PHYSICS_ENGINE_FIXED_SUBSTEP;
-            }
-            transform.setRotation(rotation);
-        }
-    }
+    Transform transform;
+    glm::vec3 linearVelocity;
+    glm::vec3 angularVelocity;
+    getLocalTransformAndVelocities(transform, linearVelocity, angularVelocity);
 
-    glm::vec3 position = transform.getTranslation();
-    const float MIN_KINEMATIC_LINEAR_SPEED_SQUARED =
-        KINEMATIC_LINEAR_SPEED_THRESHOLD * KINEMATIC_LINEAR_SPEED_THRESHOLD;
-    if (isTranslating) {
-        glm::vec3 deltaVelocity = Vectors::ZERO;
-
-        // linear damping
-        float damping = getDamping();
-        if (damping > 0.0f) {
-            deltaVelocity = (powf(1.0f - damping, timeElapsed) - 1.0f) * linearVelocity;
-        }
+    return motions.append(transform.getTranslation(), transform.getRotation(), linearVelocity, angularVelocity,
+                          getLocalKinematicAcceleration(), getDamping(), getAngularDamping(), timeElapsed);
+}
 
-        const float MIN_KINEMATIC_LINEAR_ACCELERATION_SQUARED = 1.0e-4f; // 0.01 m/sec^2
-        vec3 acceleration = getAcceleration();
-        if (glm::length2(acceleration) > MIN_KINEMATIC_LINEAR_ACCELERATION_SQUARED) {
-            // yes acceleration
-            // acceleration is in world-frame but we need it in local-frame
-            glm::vec3 linearAcceleration = acceleration;
-            bool success;
-            Transform parentTransform = getParentTransform(success);
-            if (success) {
-                linearAcceleration = glm::inverse(parentTransform.getRotation()) * linearAcceleration;
-            }
-            deltaVelocity += linearAcceleration * timeElapsed;
+void EntityItem::applyKinematicMotion(const KinematicMotions& motions, size_t index, const quint64& now) {
+    if (!motions.moving[index]) {
+        // this entity is no longer moving
+        // flag it to transition from KINEMATIC to STATIC
+        markDirtyFlags(Simulation::DIRTY_MOTION_TYPE);
+        setAcceleration(Vectors::ZERO);
+    } else if (motions.timesElapsed[index] > 0.0f) {
+        Transform transform = getLocalTransform();
+        transform.setTranslation(motions.positions[index]);
+        transform.setRotation(motions.rotations[index]);
+        setLocalTransformAndVelocities(transform, motions.linearVelocities[index], motions.angularVelocities[index]);
+    }
+    setLastSimulated(now);
+}
 
-            if (linearSpeedSquared < MIN_KINEMATIC_LINEAR_SPEED_SQUARED
-                    && glm::length2(deltaVelocity) < MIN_KINEMATIC_LINEAR_SPEED_SQUARED
-                    && glm::length2(linearVelocity + deltaVelocity) < MIN_KINEMATIC_LINEAR_SPEED_SQUARED) {
-                linearVelocity = Vectors::ZERO;
-            } else {
-                // NOTE: we do NOT include the second-order acceleration term (0.5 * a * dt^2)
-                // when computing the displacement because Bullet also ignores that term.  Yes,
-                // this is an approximation and it works best when dt is small.
-                position += timeElapsed * linearVelocity;
-                linearVelocity += deltaVelocity;
-            }
-        } else {
-            // no acceleration
-            if (linearSpeedSquared < MIN_KINEMATIC_LINEAR_SPEED_SQUARED) {
-                linearVelocity = Vectors::ZERO;
-            } else {
-                // NOTE: we don't use second-order acceleration term for linear displacement
-                // because Bullet doesn't use it.
-                position += timeElapsed * linearVelocity;
-                linearVelocity += deltaVelocity;
-            }
+glm::vec3 EntityItem::getLocalKinematicAcceleration() const {
+    // acceleration is in world-frame but we need it in local-frame
+    glm::vec3 acceleration = getAcceleration();
+    if (glm::length2(acceleration) > MIN_KINEMATIC_LINEAR_ACCELERATION_SQUARED) {
+        bool success;
+        Transform parentTransform = getParentTransform(success);
+        if (success) {
+            acceleration = glm::inverse(parentTransform.getRotation()) * acceleration;
         }
     }
-
-    transform.setTranslation(position);
-    setLocalTransformAndVelocities(transform, linearVelocity, angularVelocity);
-
-    return true;
+    return acceleration;
 }
 
 bool EntityItem::isMoving() const {
@@ -2422,6 +2383,10 @@ void EntityItem::requiresRecalcBoxes() {
         _recalcMinAACube = true; 
         _recalcMaxAACube = true;
     });
+    EntityTreePointer tree = getTree();
+    if (tree) {
+        tree->entityBoundsChanged(getThisPointer());
+    }
 }
 
 QString EntityItem::getHref() const {
@@ -58,6 +58,7 @@ using EntityTreeElementExtraEncodeDataPointer = std::shared_ptr<EntityTreeElemen
 #define debugTreeVector(V) V << "[" << V << " in meters ]"
 
 class MeshProxyList;
+class KinematicMotions;
 
 /// EntityItem class this is the base class for all entity types. It handles the basic properties and functionality available
 /// to all other entity types. In particular: postion, size, rotation, age, lifetime, velocity, gravity. You can not instantiate
@@ -151,6 +152,10 @@ public:
     void simulate(const quint64& now);
     bool stepKinematicMotion(float timeElapsed); // return 'true' if moving
 
+    // simulate() split in steps, so that the motion of many entities can be stepped at once, see EntitySimulation
+    size_t appendKinematicMotion(KinematicMotions& motions, const quint64& now);
+    void applyKinematicMotion(const KinematicMotions& motions, size_t index, const quint64& now);
+
     virtual bool needsToCallUpdate() const { return false; }
 
     virtual void debugDump() const;
@@ -465,6 +470,9 @@ protected:
 
     void setSimulated(bool simulated) { _simulated = simulated; }
 
+    float getKinematicTimeElapsed(const quint64& now);
+    glm::vec3 getLocalKinematicAcceleration() const;
+
     const QByteArray getDynamicDataInternal() const;
     void setDynamicDataInternal(QByteArray dynamicData);
 
@@ -234,7 +234,7 @@ enum EntityPropertyList {
     // WARNING!!! DO NOT ADD PROPS_xxx here unless you really really meant to.... Add them UP above
 };
 
-typedef PropertyFlags<EntityPropertyList> EntityPropertyFlags;
+typedef PropertyFlags<EntityPropertyList, PROP_AFTER_LAST_ITEM> EntityPropertyFlags;
 
 // this is set at the top of EntityItemProperties.cpp to PROP_AFTER_LAST_ITEM - 1.  PROP_AFTER_LAST_ITEM is always
 // one greater than the last item property due to the enum's auto-incrementing.
@@ -0,0 +1,812 @@
+//
+//  EntityQueryIndex.cpp
+//  libraries/entities/src
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "EntityQueryIndex.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#include "EntityItem.h"
+
+static const int NODE_WIDTH = 4;
+static const uint32_t MAX_LEAF_ITEMS = 4;
+
+// the hierarchy is rebuilt once the linearly tested entities, or the refits and removals, outweigh it
+static const size_t MIN_LOOSE_ITEMS_TO_REBUILD = 64;
+static const size_t MIN_CHANGES_TO_REBUILD = 1024;
+
+// keeps the inverse direction of the rays finite, so that the slab tests never compute 0 * inf
+static const float MIN_RAY_DIRECTION = 1.0e-20f;
+
+struct QueryBounds {
+    glm::vec3 minimum;
+    glm::vec3 maximum;
+};
+
+// the bounds of the 4 slots of a node are stored by coordinate, so that the queries test them together
+struct QueryNode {
+    float minX[NODE_WIDTH];
+    float minY[NODE_WIDTH];
+    float minZ[NODE_WIDTH];
+    float maxX[NODE_WIDTH];
+    float maxY[NODE_WIDTH];
+    float maxZ[NODE_WIDTH];
+
+    // the child node of each slot, or the index in the item order of the first item of a leaf, or -1 for an empty slot
+    int32_t children[NODE_WIDTH];
+
+    // the number of items of a leaf, or 0 for a child node
+    uint32_t counts[NODE_WIDTH];
+};
+
+struct RayQuery {
+    glm::vec3 origin;
+    glm::vec3 inverseDirection;
+    bool negative[3]; // the ray enters the slab of the axis at its maximum
+};
+
+// empty bounds fail all the tests, they are used for the empty slots and the items that aren't in the hierarchy
+static const QueryBounds EMPTY_BOUNDS = { glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX) };
+
+static QueryNode makeEmptyNode() {
+    QueryNode node;
+    for (int slot = 0; slot < NODE_WIDTH; ++slot) {
+        node.minX[slot] = node.minY[slot] = node.minZ[slot] = FLT_MAX;
+        node.maxX[slot] = node.maxY[slot] = node.maxZ[slot] = -FLT_MAX;
+        node.children[slot] = -1;
+        node.counts[slot] = 0;
+    }
+    return node;
+}
+
+static const QueryNode EMPTY_NODE = makeEmptyNode();
+
+static inline bool isEmpty(const QueryBounds& bounds) {
+    return bounds.minimum.x > bounds.maximum.x;
+}
+
+static inline bool operator==(const QueryBounds& a, const QueryBounds& b) {
+    return a.minimum == b.minimum && a.maximum == b.maximum;
+}
+
+static inline QueryBounds unite(const QueryBounds& a, const QueryBounds& b) {
+    QueryBounds bounds = { glm::min(a.minimum, b.minimum), glm::max(a.maximum, b.maximum) };
+    return bounds;
+}
+
+static inline QueryBounds getSlotBounds(const QueryNode& node, int slot) {
+    QueryBounds bounds = {
+        glm::vec3(node.minX[slot], node.minY[slot], node.minZ[slot]),
+        glm::vec3(node.maxX[slot], node.maxY[slot], node.maxZ[slot])
+    };
+    return bounds;
+}
+
+static inline void setSlotBounds(QueryNode& node, int slot, const QueryBounds& bounds) {
+    node.minX[slot] = bounds.minimum.x;
+    node.minY[slot] = bounds.minimum.y;
+    node.minZ[slot] = bounds.minimum.z;
+    node.maxX[slot] = bounds.maximum.x;
+    node.maxY[slot] = bounds.maximum.y;
+    node.maxZ[slot] = bounds.maximum.z;
+}
+
+static inline QueryBounds getNodeBounds(const QueryNode& node) {
+    QueryBounds bounds = EMPTY_BOUNDS;
+    for (int slot = 0; slot < NODE_WIDTH; ++slot) {
+        bounds = unite(bounds, getSlotBounds(node, slot));
+    }
+    return bounds;
+}
+
+static inline bool touches(const QueryBounds& bounds, const QueryBounds& box) {
+    return bounds.minimum.x <= box.maximum.x && bounds.maximum.x >= box.minimum.x &&
+        bounds.minimum.y <= box.maximum.y && bounds.maximum.y >= box.minimum.y &&
+        bounds.minimum.z <= box.maximum.z && bounds.maximum.z >= box.minimum.z;
+}
+
+static inline bool touchesSphere(const QueryBounds& bounds, const glm::vec3& center, float radiusSquared) {
+    glm::vec3 offset = glm::max(glm::max(bounds.minimum - center, center - bounds.maximum), glm::vec3(0.0f));
+    return glm::dot(offset, offset) <= radiusSquared;
+}
+
+static inline bool touchesFrustum(const QueryBounds& bounds, const ViewFrustum& frustum) {
+    AABox box(bounds.minimum, bounds.maximum - bounds.minimum);
+    return frustum.boxIntersectsFrustum(box) || frustum.boxIntersectsKeyhole(box);
+}
+
+static inline bool entersBounds(const QueryBounds& bounds, const RayQuery& ray, float maxDistance, float& entry) {
+    glm::vec3 nearCorner(ray.negative[0] ? bounds.maximum.x : bounds.minimum.x,
+                         ray.negative[1] ? bounds.maximum.y : bounds.minimum.y,
+                         ray.negative[2] ? bounds.maximum.z : bounds.minimum.z);
+    glm::vec3 farCorner(ray.negative[0] ? bounds.minimum.x : bounds.maximum.x,
+                        ray.negative[1] ? bounds.minimum.y : bounds.maximum.y,
+                        ray.negative[2] ? bounds.minimum.z : bounds.maximum.z);
+    glm::vec3 nearDistances = (nearCorner - ray.origin) * ray.inverseDirection;
+    glm::vec3 farDistances = (farCorner - ray.origin) * ray.inverseDirection;
+    entry = std::max(std::max(nearDistances.x, nearDistances.y), std::max(nearDistances.z, 0.0f));
+    float exit = std::min(std::min(farDistances.x, farDistances.y), std::min(farDistances.z, maxDistance));
+    return entry <= exit;
+}
+
+//
+// on x86 architecture, assume that SSE2 is present
+//
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+
+#include <xmmintrin.h>
+
+// returns the mask of the slots of the node that touch the box
+static inline int touchesMask(const QueryNode& node, const QueryBounds& box) {
+    __m128 x = _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(node.minX), _mm_set1_ps(box.maximum.x)),
+                          _mm_cmpge_ps(_mm_loadu_ps(node.maxX), _mm_set1_ps(box.minimum.x)));
+    __m128 y = _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(node.minY), _mm_set1_ps(box.maximum.y)),
+                          _mm_cmpge_ps(_mm_loadu_ps(node.maxY), _mm_set1_ps(box.minimum.y)));
+    __m128 z = _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(node.minZ), _mm_set1_ps(box.maximum.z)),
+                          _mm_cmpge_ps(_mm_loadu_ps(node.maxZ), _mm_set1_ps(box.minimum.z)));
+    return _mm_movemask_ps(_mm_and_ps(_mm_and_ps(x, y), z));
+}
+
+// returns the mask of the slots of the node that touch the sphere
+static inline int touchesSphereMask(const QueryNode& node, const glm::vec3& center, float radiusSquared) {
+    const __m128 zero = _mm_setzero_ps();
+    __m128 centerX = _mm_set1_ps(center.x);
+    __m128 centerY = _mm_set1_ps(center.y);
+    __m128 centerZ = _mm_set1_ps(center.z);
+    __m128 x = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(node.minX), centerX),
+                                     _mm_sub_ps(centerX, _mm_loadu_ps(node.maxX))), zero);
+    __m128 y = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(node.minY), centerY),
+                                     _mm_sub_ps(centerY, _mm_loadu_ps(node.maxY))), zero);
+    __m128 z = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(node.minZ), centerZ),
+                                     _mm_sub_ps(centerZ, _mm_loadu_ps(node.maxZ))), zero);
+    __m128 distanceSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+    return _mm_movemask_ps(_mm_cmple_ps(distanceSquared, _mm_set1_ps(radiusSquared)));
+}
+
+// returns the mask of the slots of the node that the ray enters before maxDistance, and where it enters them
+static inline int entersMask(const QueryNode& node, const RayQuery& ray, float maxDistance, float entries[NODE_WIDTH]) {
+    // the slab of each axis is entered at its near side and left at its far side
+    __m128 nearX = _mm_loadu_ps(ray.negative[0] ? node.maxX : node.minX);
+    __m128 nearY = _mm_loadu_ps(ray.negative[1] ? node.maxY : node.minY);
+    __m128 nearZ = _mm_loadu_ps(ray.negative[2] ? node.maxZ : node.minZ);
+    __m128 farX = _mm_loadu_ps(ray.negative[0] ? node.minX : node.maxX);
+    __m128 farY = _mm_loadu_ps(ray.negative[1] ? node.minY : node.maxY);
+    __m128 farZ = _mm_loadu_ps(ray.negative[2] ? node.minZ : node.maxZ);
+
+    __m128 originX = _mm_set1_ps(ray.origin.x);
+    __m128 originY = _mm_set1_ps(ray.origin.y);
+    __m128 originZ = _mm_set1_ps(ray.origin.z);
+    __m128 inverseX = _mm_set1_ps(ray.inverseDirection.x);
+    __m128 inverseY = _mm_set1_ps(ray.inverseDirection.y);
+    __m128 inverseZ = _mm_set1_ps(ray.inverseDirection.z);
+
+    __m128 entry = _mm_max_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(nearX, originX), inverseX),
+                                         _mm_mul_ps(_mm_sub_ps(nearY, originY), inverseY)),
+                              _mm_max_ps(_mm_mul_ps(_mm_sub_ps(nearZ, originZ), inverseZ), _mm_setzero_ps()));
+    __m128 exit = _mm_min_ps(_mm_min_ps(_mm_mul_ps(_mm_sub_ps(farX, originX), inverseX),
+                                        _mm_mul_ps(_mm_sub_ps(farY, originY), inverseY)),
+                             _mm_min_ps(_mm_mul_ps(_mm_sub_ps(farZ, originZ), inverseZ), _mm_set1_ps(maxDistance)));
+    _mm_storeu_ps(entries, entry);
+    return _mm_movemask_ps(_mm_cmple_ps(entry, exit));
+}
+
+#else
+
+static inline int touchesMask(const QueryNode& node, const QueryBounds& box) {
+    int mask = 0;
+    for (int slot = 0; slot < NODE_WIDTH; ++slot) {
+        mask |= touches(getSlotBounds(node, slot), box) ? (1 << slot) : 0;
+    }
+    return mask;
+}
+
+static inline int touchesSphereMask(const QueryNode& node, const glm::vec3& center, float radiusSquared) {
+    int mask = 0;
+    for (int slot = 0; slot < NODE_WIDTH; ++slot) {
+        mask |= touchesSphere(getSlotBounds(node, slot), center, radiusSquared) ? (1 << slot) : 0;
+    }
+    return mask;
+}
+
+static inline int entersMask(const QueryNode& node, const RayQuery& ray, float maxDistance, float entries[NODE_WIDTH]) {
+    int mask = 0;
+    for (int slot = 0; slot < NODE_WIDTH; ++slot) {
+        mask |= entersBounds(getSlotBounds(node, slot), ray, maxDistance, entries[slot]) ? (1 << slot) : 0;
+    }
+    return mask;
+}
+
+#endif
+
+// An array cut in chunks that the snapshots share: a snapshot copied from another one only copies the chunks it changes.
+template <typename T>
+class SharedChunks {
+public:
+    static const size_t CHUNK_SHIFT = 8;
+    static const size_t CHUNK_SIZE = 1 << CHUNK_SHIFT;
+    static const size_t CHUNK_MASK = CHUNK_SIZE - 1;
+
+    size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+
+    const T& operator[](size_t index) const { return (*_chunks[index >> CHUNK_SHIFT])[index & CHUNK_MASK]; }
+
+    /// Returns the element to change, copying its chunk first if it is shared
+    T& edit(size_t index) { return own(index >> CHUNK_SHIFT)[index & CHUNK_MASK]; }
+
+    void push_back(const T& value) {
+        if ((_size & CHUNK_MASK) == 0) {
+            auto chunk = std::make_shared<std::vector<T>>();
+            chunk->reserve(CHUNK_SIZE);
+            _chunks.push_back(chunk);
+            _isOwned.push_back(true);
+        }
+        own(_chunks.size() - 1).push_back(value);
+        ++_size;
+    }
+
+    void pop_back() {
+        size_t last = _chunks.size() - 1;
+        own(last).pop_back();
+        if (_chunks[last]->empty()) {
+            _chunks.pop_back();
+            _isOwned.pop_back();
+        }
+        --_size;
+    }
+
+    void assign(const std::vector<T>& values) {
+        clear();
+        for (const auto& value : values) {
+            push_back(value);
+        }
+    }
+
+    void clear() {
+        _chunks.clear();
+        _isOwned.clear();
+        _size = 0;
+    }
+
+    /// Marks all the chunks as shared, to be called on a copy before it is changed
+    void share() { std::fill(_isOwned.begin(), _isOwned.end(), false); }
+
+private:
+    std::vector<T>& own(size_t chunk) {
+        if (!_isOwned[chunk]) {
+            _chunks[chunk] = std::make_shared<std::vector<T>>(*_chunks[chunk]);
+            _isOwned[chunk] = true;
+        }
+        return *_chunks[chunk];
+    }
+
+    std::vector<std::shared_ptr<std::vector<T>>> _chunks;
+    std::vector<bool> _isOwned;
+    size_t _size { 0 };
+};
+
+// removes the item from an unordered list of items, returns false if it isn't in it
+static bool eraseItem(SharedChunks<uint32_t>& items, uint32_t item) {
+    size_t size = items.size();
+    for (size_t i = 0; i < size; ++i) {
+        if (items[i] == item) {
+            if (i != size - 1) {
+                items.edit(i) = items[size - 1];
+            }
+            items.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
+
+class EntityQueryIndex::Snapshot {
+public:
+    /// Prepares a copy of a published snapshot to be changed without changing the original
+    void share();
+
+    // calls nodeMask(node) for the nodes of the hierarchy that are reached, and itemTest(bounds) for the items
+    template <typename NodeMask, typename ItemTest>
+    void collect(NodeMask nodeMask, ItemTest itemTest, QVector<EntityItemPointer>& foundEntities) const;
+
+    void visitRay(const RayQuery& ray, float& distance, const EntityQueryIndex::RayVisitor& visitor) const;
+
+    SharedChunks<QueryNode> nodes;
+    SharedChunks<uint32_t> itemOrder; // the items of the leaves, leaf after leaf
+    SharedChunks<QueryBounds> itemBounds;
+    SharedChunks<uint32_t> looseItems; // the items added since the hierarchy was built
+    SharedChunks<uint32_t> unboundedItems;
+    SharedChunks<EntityItemWeakPointer> entities;
+    size_t numEntities { 0 };
+};
+
+void EntityQueryIndex::Snapshot::share() {
+    nodes.share();
+    itemOrder.share();
+    itemBounds.share();
+    looseItems.share();
+    unboundedItems.share();
+    entities.share();
+}
+
+template <typename NodeMask, typename ItemTest>
+void EntityQueryIndex::Snapshot::collect(NodeMask nodeMask, ItemTest itemTest,
+                                         QVector<EntityItemPointer>& foundEntities) const {
+    foundEntities.clear();
+
+    auto addItem = [&](uint32_t item) {
+        EntityItemPointer entity = entities[item].lock();
+        if (entity) {
+            foundEntities.push_back(entity);
+        }
+    };
+
+    if (!nodes.empty()) {
+        std::vector<int32_t> stack;
+        stack.reserve(64);
+        stack.push_back(0);
+        while (!stack.empty()) {
+            const QueryNode& node = nodes[stack.back()];
+            stack.pop_back();
+
+            int mask = nodeMask(node);
+            for (int slot = 0; slot < NODE_WIDTH; ++slot) {
+                if (!(mask & (1 << slot)) || node.children[slot] < 0) {
+                    continue;
+                }
+                if (node.counts[slot] == 0) {
+                    stack.push_back(node.children[slot]);
+                    continue;
+                }
+                uint32_t end = node.children[slot] + node.counts[slot];
+                for (uint32_t i = node.children[slot]; i < end; ++i) {
+                    uint32_t item = itemOrder[i];
+                    if (itemTest(itemBounds[item])) {
+                        addItem(item);
+                    }
+                }
+            }
+        }
+    }
+
+    for (size_t i = 0; i < looseItems.size(); ++i) {
+        if (itemTest(itemBounds[looseItems[i]])) {
+            addItem(looseItems[i]);
+        }
+    }
+    for (size_t i = 0; i < unboundedItems.size(); ++i) {
+        addItem(unboundedItems[i]);
+    }
+}
+
+void EntityQueryIndex::Snapshot::visitRay(const RayQuery& ray, float& distance,
+                                          const EntityQueryIndex::RayVisitor& visitor) const {
+    auto visitItem = [&](uint32_t item) {
+        float entry;
+        if (entersBounds(itemBounds[item], ray, distance, entry)) {
+            EntityItemPointer entity = entities[item].lock();
+            if (entity) {
+                visitor(entity, distance);
+            }
+        }
+    };
+
+    if (!nodes.empty()) {
+        // the nodes and leaves to visit, with where the ray enters them, the nearest on top
+        struct StackEntry {
+            float entry;
+            int32_t node;
+            int32_t slot; // the leaf slot of the node, or -1 for the whole node
+        };
+        std::vector<StackEntry> stack;
+        stack.reserve(64);
+        stack.push_back({ 0.0f, 0, -1 });
+        while (!stack.empty()) {
+            StackEntry top = stack.back();
+            stack.pop_back();
+            if (top.entry > distance) {
+                continue;
+            }
+
+            const QueryNode& node = nodes[top.node];
+            if (top.slot >= 0) {
+                uint32_t end = node.children[top.slot] + node.counts[top.slot];
+                for (uint32_t i = node.children[top.slot]; i < end; ++i) {
+                    visitItem(itemOrder[i]);
+                }
+                continue;
+            }
+
+            float entries[NODE_WIDTH];
+            int mask = entersMask(node, ray, distance, entries);
+
+            // push the slots that are hit farthest first
+            size_t firstHit = stack.size();
+            for (int slot = 0; slot < NODE_WIDTH; ++slot) {
+                if (!(mask & (1 << slot)) || node.children[slot] < 0) {
+                    continue;
+                }
+                StackEntry hit;
+                hit.entry = entries[slot];
+                hit.node = node.counts[slot] == 0 ? node.children[slot] : top.node;
+                hit.slot = node.counts[slot] == 0 ? -1 : slot;
+
+                size_t i = stack.size();
+                stack.push_back(hit);
+                for (; i > firstHit && stack[i - 1].entry < hit.entry; --i) {
+                    stack[i] = stack[i - 1];
+                }
+                stack[i] = hit;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < looseItems.size(); ++i) {
+        visitItem(looseItems[i]);
+    }
+}
+
+EntityQueryIndex::EntityQueryIndex() :
+    _snapshot(std::make_shared<Snapshot>())
+{
+}
+
+void EntityQueryIndex::addEntity(const EntityItemPointer& entity) {
+    queueUpdate(entity, true);
+}
+
+void EntityQueryIndex::updateEntity(const EntityItemPointer& entity) {
+    queueUpdate(entity, false);
+}
+
+void EntityQueryIndex::queueUpdate(const EntityItemPointer& entity, bool add) {
+    EntityItemID id = entity->getEntityItemID();
+    std::lock_guard<std::mutex> lock(_pendingMutex);
+    auto itr = _pendingUpdates.find(id);
+    if (itr != _pendingUpdates.end()) {
+        itr.value().entity = entity;
+        itr.value().add |= add;
+    } else {
+        _pendingUpdates.insert(id, { entity, add });
+    }
+    if (add) {
+        _pendingRemovals.remove(id);
+    }
+    _hasPendingChanges = true;
+}
+
+void EntityQueryIndex::removeEntity(const EntityItemID& id) {
+    std::lock_guard<std::mutex> lock(_pendingMutex);
+    _pendingUpdates.remove(id);
+    _pendingRemovals.insert(id);
+    _hasPendingChanges = true;
+}
+
+void EntityQueryIndex::clear() {
+    std::lock_guard<std::mutex> lock(_pendingMutex);
+    _pendingUpdates.clear();
+    _pendingRemovals.clear();
+    _pendingClear = true;
+    _hasPendingChanges = true;
+}
+
+void EntityQueryIndex::publish() {
+    std::lock_guard<std::mutex> publishLock(_publishMutex);
+
+    QHash<EntityItemID, PendingUpdate> updates;
+    QSet<EntityItemID> removals;
+    bool clear;
+    {
+        std::lock_guard<std::mutex> lock(_pendingMutex);
+        updates.swap(_pendingUpdates);
+        removals.swap(_pendingRemovals);
+        clear = _pendingClear;
+        _pendingClear = false;
+        _hasPendingChanges = false;
+    }
+    if (!clear && updates.isEmpty() && removals.isEmpty()) {
+        return;
+    }
+
+    std::shared_ptr<Snapshot> snapshot;
+    if (clear) {
+        snapshot = std::make_shared<Snapshot>();
+        _itemIndices.clear();
+        _itemSlots.clear();
+        _nodeSlots.clear();
+        _freeItems.clear();
+        _numRefitsSinceRebuild = 0;
+        _numRemovalsSinceRebuild = 0;
+    } else {
+        // the snapshot being read is never modified, the changes are made to a copy of it that shares its chunks
+        snapshot = std::make_shared<Snapshot>(*std::atomic_load(&_snapshot));
+        snapshot->share();
+    }
+
+    applyChanges(*snapshot, updates, removals);
+
+    std::atomic_store(&_snapshot, SnapshotPointer(snapshot));
+}
+
+EntityQueryIndex::SnapshotPointer EntityQueryIndex::getSnapshot() {
+    return std::atomic_load(&_snapshot);
+}
+
+size_t EntityQueryIndex::getNumEntities() {
+    return getSnapshot()->numEntities;
+}
+
+void EntityQueryIndex::findEntities(const AABox& box, QVector<EntityItemPointer>& foundEntities) {
+    QueryBounds query = { box.getMinimumPoint(), box.getMaximumPoint() };
+    getSnapshot()->collect([&](const QueryNode& node) {
+        return touchesMask(node, query);
+    }, [&](const QueryBounds& bounds) {
+        return touches(bounds, query);
+    }, foundEntities);
+}
+
+void EntityQueryIndex::findEntities(const glm::vec3& center, float radius, QVector<EntityItemPointer>& foundEntities) {
+    float radiusSquared = radius * radius;
+    getSnapshot()->collect([&](const QueryNode& node) {
+        return touchesSphereMask(node, center, radiusSquared);
+    }, [&](const QueryBounds& bounds) {
+        return touchesSphere(bounds, center, radiusSquared);
+    }, foundEntities);
+}
+
+void EntityQueryIndex::findEntities(const ViewFrustum& frustum, QVector<EntityItemPointer>& foundEntities) {
+    getSnapshot()->collect([&](const QueryNode& node) {
+        int mask = 0;
+        for (int slot = 0; slot < NODE_WIDTH; ++slot) {
+            if (node.children[slot] >= 0 && touchesFrustum(getSlotBounds(node, slot), frustum)) {
+                mask |= 1 << slot;
+            }
+        }
+        return mask;
+    }, [&](const QueryBounds& bounds) {
+        return !isEmpty(bounds) && touchesFrustum(bounds, frustum);
+    }, foundEntities);
+}
+
+void EntityQueryIndex::findRayCandidates(const glm::vec3& origin, const glm::vec3& direction, float& distance,
+                                         const RayVisitor& visitor) {
+    RayQuery ray;
+    ray.origin = origin;
+    for (int axis = 0; axis < 3; ++axis) {
+        float component = direction[axis];
+        ray.negative[axis] = component < 0.0f;
+        if (fabsf(component) < MIN_RAY_DIRECTION) {
+            component = ray.negative[axis] ? -MIN_RAY_DIRECTION : MIN_RAY_DIRECTION;
+        }
+        ray.inverseDirection[axis] = 1.0f / component;
+    }
+    getSnapshot()->visitRay(ray, distance, visitor);
+}
+
+void EntityQueryIndex::applyChanges(Snapshot& snapshot, const QHash<EntityItemID, PendingUpdate>& updates,
+                                    const QSet<EntityItemID>& removals) {
+    for (const auto& id : removals) {
+        auto itr = _itemIndices.find(id);
+        if (itr == _itemIndices.end()) {
+            continue;
+        }
+        uint32_t item = itr.value();
+        _itemIndices.erase(itr);
+
+        snapshot.entities.edit(item).reset();
+        if (!eraseItem(snapshot.unboundedItems, item) && _itemSlots[item] < 0) {
+            eraseItem(snapshot.looseItems, item);
+        }
+        snapshot.itemBounds.edit(item) = EMPTY_BOUNDS;
+        if (_itemSlots[item] >= 0) {
+            // the item stays in its leaf until the next rebuild, or until its index is reused
+            refit(snapshot, item);
+        }
+        _freeItems.push_back(item);
+        ++_numRemovalsSinceRebuild;
+    }
+
+    for (auto itr = updates.begin(); itr != updates.end(); ++itr) {
+        EntityItemPointer entity = itr.value().entity.lock();
+        if (!entity) {
+            continue;
+        }
+
+        uint32_t item;
+        bool isNew = false;
+        auto found = _itemIndices.find(itr.key());
+        if (found != _itemIndices.end()) {
+            item = found.value();
+            if (itr.value().add) {
+                // the entity may have been removed and added again since the last publish
+                snapshot.entities.edit(item) = entity;
+            }
+        } else if (itr.value().add) {
+            isNew = true;
+            if (!_freeItems.empty()) {
+                item = _freeItems.back();
+                _freeItems.pop_back();
+            } else {
+                item = (uint32_t)snapshot.itemBounds.size();
+                snapshot.itemBounds.push_back(EMPTY_BOUNDS);
+                _itemSlots.push_back(-1);
+                snapshot.entities.push_back(EntityItemWeakPointer());
+            }
+            _itemIndices.insert(itr.key(), item);
+            snapshot.entities.edit(item) = entity;
+        } else {
+            // the entity moved after it was removed from the tree
+            continue;
+        }
+
+        bool success;
+        AABox box = entity->getAABox(success);
+        bool wasUnbounded = false;
+        if (!isNew) {
+            for (size_t i = 0; i < snapshot.unboundedItems.size() && !wasUnbounded; ++i) {
+                wasUnbounded = snapshot.unboundedItems[i] == item;
+            }
+        }
+        bool isLoose = !isNew && !wasUnbounded && _itemSlots[item] < 0;
+
+        if (success) {
+            QueryBounds bounds = { box.getMinimumPoint(), box.getMaximumPoint() };
+            snapshot.itemBounds.edit(item) = bounds;
+            if (wasUnbounded) {
+                eraseItem(snapshot.unboundedItems, item);
+            }
+            if (_itemSlots[item] >= 0) {
+                refit(snapshot, item);
+                ++_numRefitsSinceRebuild;
+            } else if (!isLoose) {
+                snapshot.looseItems.push_back(item);
+            }
+        } else if (!wasUnbounded) {
+            if (isLoose) {
+                eraseItem(snapshot.looseItems, item);
+            }
+            snapshot.unboundedItems.push_back(item);
+            snapshot.itemBounds.edit(item) = EMPTY_BOUNDS;
+            if (_itemSlots[item] >= 0) {
+                refit(snapshot, item);
+            }
+        }
+    }
+
+    size_t numItems = _itemIndices.size();
+    snapshot.numEntities = numItems;
+    if (snapshot.looseItems.size() > std::max(MIN_LOOSE_ITEMS_TO_REBUILD, numItems / 8) ||
+            _numRemovalsSinceRebuild > std::max(MIN_CHANGES_TO_REBUILD, numItems / 4) ||
+            _numRefitsSinceRebuild > std::max(MIN_CHANGES_TO_REBUILD, numItems * 4)) {
+        rebuild(snapshot);
+    }
+}
+
+void EntityQueryIndex::rebuild(Snapshot& snapshot) {
+    // the hierarchy is built in plain arrays, and cut in chunks at the end
+    std::vector<uint32_t> itemOrder;
+    itemOrder.reserve(_itemIndices.size());
+    std::vector<glm::vec3> centers(snapshot.itemBounds.size());
+    for (auto item : _itemIndices) {
+        const QueryBounds& bounds = snapshot.itemBounds[item];
+        if (!isEmpty(bounds)) {
+            itemOrder.push_back(item);
+            centers[item] = 0.5f * (bounds.minimum + bounds.maximum);
+        }
+    }
+
+    std::vector<QueryNode> nodes;
+    _nodeSlots.clear();
+    std::fill(_itemSlots.begin(), _itemSlots.end(), -1);
+    if (!itemOrder.empty()) {
+        buildNode(snapshot, centers, itemOrder, nodes, 0, (uint32_t)itemOrder.size(), -1);
+    }
+
+    snapshot.nodes.assign(nodes);
+    snapshot.itemOrder.assign(itemOrder);
+    snapshot.looseItems.clear();
+
+    _numRefitsSinceRebuild = 0;
+    _numRemovalsSinceRebuild = 0;
+}
+
+int32_t EntityQueryIndex::buildNode(const Snapshot& snapshot, const std::vector<glm::vec3>& centers,
+                                    std::vector<uint32_t>& itemOrder, std::vector<QueryNode>& nodes, uint32_t begin,
+                                    uint32_t end, int32_t parentSlot) {
+    int32_t nodeIndex = (int32_t)nodes.size();
+    nodes.push_back(EMPTY_NODE);
+    _nodeSlots.push_back(parentSlot);
+
+    // split the items in up to 4 ranges, halving the largest range along the longest axis of its centers each time
+    uint32_t firsts[NODE_WIDTH] = { begin };
+    uint32_t lasts[NODE_WIDTH] = { end };
+    int numRanges = 1;
+    while (numRanges < NODE_WIDTH) {
+        int largest = 0;
+        for (int i = 1; i < numRanges; ++i) {
+            if (lasts[i] - firsts[i] > lasts[largest] - firsts[largest]) {
+                largest = i;
+            }
+        }
+        uint32_t first = firsts[largest];
+        uint32_t last = lasts[largest];
+        if (last - first <= MAX_LEAF_ITEMS) {
+            break;
+        }
+
+        glm::vec3 low(FLT_MAX);
+        glm::vec3 high(-FLT_MAX);
+        for (uint32_t i = first; i < last; ++i) {
+            low = glm::min(low, centers[itemOrder[i]]);
+            high = glm::max(high, centers[itemOrder[i]]);
+        }
+        glm::vec3 extent = high - low;
+        int axis = (extent.x >= extent.y && extent.x >= extent.z) ? 0 : (extent.y >= extent.z ? 1 : 2);
+
+        uint32_t middle = first + (last - first) / 2;
+        std::nth_element(itemOrder.begin() + first, itemOrder.begin() + middle, itemOrder.begin() + last,
+                         [&](uint32_t a, uint32_t b) {
+            return centers[a][axis] < centers[b][axis];
+        });
+
+        firsts[numRanges] = middle;
+        lasts[numRanges] = last;
+        lasts[largest] = middle;
+        ++numRanges;
+    }
+
+    for (int slot = 0; slot < numRanges; ++slot) {
+        uint32_t count = lasts[slot] - firsts[slot];
+        QueryBounds bounds = EMPTY_BOUNDS;
+        if (count <= MAX_LEAF_ITEMS) {
+            for (uint32_t i = firsts[slot]; i < lasts[slot]; ++i) {
+                uint32_t item = itemOrder[i];
+                bounds = unite(bounds, snapshot.itemBounds[item]);
+                _itemSlots[item] = nodeIndex * NODE_WIDTH + slot;
+            }
+            nodes[nodeIndex].children[slot] = (int32_t)firsts[slot];
+            nodes[nodeIndex].counts[slot] = count;
+        } else {
+            int32_t child = buildNode(snapshot, centers, itemOrder, nodes, firsts[slot], lasts[slot],
+                                      nodeIndex * NODE_WIDTH + slot);
+            bounds = getNodeBounds(nodes[child]);
+            nodes[nodeIndex].children[slot] = child;
+            nodes[nodeIndex].counts[slot] = 0;
+        }
+        setSlotBounds(nodes[nodeIndex], slot, bounds);
+    }
+    return nodeIndex;
+}
+
+void EntityQueryIndex::refit(Snapshot& snapshot, uint32_t item) {
+    int32_t nodeSlot = _itemSlots[item];
+    const QueryNode& leafNode = snapshot.nodes[nodeSlot / NODE_WIDTH];
+    int leafSlot = nodeSlot % NODE_WIDTH;
+
+    QueryBounds bounds = EMPTY_BOUNDS;
+    uint32_t end = leafNode.children[leafSlot] + leafNode.counts[leafSlot];
+    for (uint32_t i = leafNode.children[leafSlot]; i < end; ++i) {
+        bounds = unite(bounds, snapshot.itemBounds[snapshot.itemOrder[i]]);
+    }
+
+    // update the slots up to the root, until one doesn't change, copying only the chunks of the nodes that do
+    while (nodeSlot >= 0) {
+        int32_t nodeIndex = nodeSlot / NODE_WIDTH;
+        int slot = nodeSlot % NODE_WIDTH;
+        if (getSlotBounds(snapshot.nodes[nodeIndex], slot) == bounds) {
+            break;
+        }
+        QueryNode& node = snapshot.nodes.edit(nodeIndex);
+        setSlotBounds(node, slot, bounds);
+        bounds = getNodeBounds(node);
+        nodeSlot = _nodeSlots[nodeIndex];
+    }
+}
@@ -0,0 +1,119 @@
+//
+//  EntityQueryIndex.h
+//  libraries/entities/src
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_EntityQueryIndex_h
+#define hifi_EntityQueryIndex_h
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <QtCore/QHash>
+#include <QtCore/QSet>
+#include <QtCore/QVector>
+
+#include <glm/glm.hpp>
+
+#include <AABox.h>
+#include <ViewFrustum.h>
+
+#include "EntityItemID.h"
+#include "EntityTypes.h"
+
+struct QueryNode;
+
+// A bounding volume hierarchy over the world frame boxes of the entities of an EntityTree, that answers the spatial
+// queries of the tree without walking its elements or taking its lock.
+// The hierarchy is flattened into arrays of 4-wide nodes, and published as an immutable snapshot that the queries grab
+// atomically, without a lock. The arrays are cut in chunks that the snapshots share, so a publish only copies the chunks
+// it changes. The changes to the entities are queued, then applied by EntityTree::update(), so the queries see them from
+// the next update on: moved entities are refitted in place and added ones are tested linearly, until there are enough
+// of them, or enough refits, to rebuild the hierarchy.
+// The queries only test the boxes of the entities, callers apply the exact per-entity tests to what they return.
+// The entities whose box can't be computed yet, because their parent isn't known, are returned by all the queries but
+// the ray ones, like the tree elements do.
+// All the methods are thread safe.
+class EntityQueryIndex {
+public:
+    EntityQueryIndex();
+
+    /// Queues the entity to be indexed
+    void addEntity(const EntityItemPointer& entity);
+
+    /// Queues the box of the entity to be updated, if it is still indexed by then
+    void updateEntity(const EntityItemPointer& entity);
+
+    void removeEntity(const EntityItemID& id);
+    void clear();
+
+    bool hasPendingChanges() const { return _hasPendingChanges; }
+
+    /// Applies the queued changes and publishes them to the queries
+    void publish();
+
+    /// Replaces the contents of foundEntities with the entities whose box touches the query box
+    void findEntities(const AABox& box, QVector<EntityItemPointer>& foundEntities);
+
+    /// Replaces the contents of foundEntities with the entities whose box touches the query sphere
+    void findEntities(const glm::vec3& center, float radius, QVector<EntityItemPointer>& foundEntities);
+
+    /// Replaces the contents of foundEntities with the entities whose box intersects the frustum or its keyhole
+    void findEntities(const ViewFrustum& frustum, QVector<EntityItemPointer>& foundEntities);
+
+    /// Calls the visitor with the entities whose box the ray enters closer than distance, roughly nearest first.
+    /// The visitor lowers distance when it finds an intersection, which prunes the entities behind it.
+    using RayVisitor = std::function<void(const EntityItemPointer& entity, float& distance)>;
+    void findRayCandidates(const glm::vec3& origin, const glm::vec3& direction, float& distance, const RayVisitor& visitor);
+
+    size_t getNumEntities();
+
+private:
+    class Snapshot;
+    using SnapshotPointer = std::shared_ptr<const Snapshot>;
+
+    struct PendingUpdate {
+        EntityItemWeakPointer entity;
+        bool add;
+    };
+
+    void queueUpdate(const EntityItemPointer& entity, bool add);
+    SnapshotPointer getSnapshot();
+
+    void applyChanges(Snapshot& snapshot, const QHash<EntityItemID, PendingUpdate>& updates,
+                      const QSet<EntityItemID>& removals);
+    void rebuild(Snapshot& snapshot);
+    int32_t buildNode(const Snapshot& snapshot, const std::vector<glm::vec3>& centers, std::vector<uint32_t>& itemOrder,
+                      std::vector<QueryNode>& nodes, uint32_t begin, uint32_t end, int32_t parentSlot);
+    void refit(Snapshot& snapshot, uint32_t item);
+
+    // the changes waiting for the next publish
+    std::mutex _pendingMutex;
+    QHash<EntityItemID, PendingUpdate> _pendingUpdates;
+    QSet<EntityItemID> _pendingRemovals;
+    bool _pendingClear { false };
+    std::atomic<bool> _hasPendingChanges { false };
+
+    // the state of the publisher, that doesn't need to be in the snapshots
+    std::mutex _publishMutex;
+    QHash<EntityItemID, uint32_t> _itemIndices;
+    std::vector<int32_t> _itemSlots; // the leaf slot (node * 4 + slot) holding each item, or -1
+    std::vector<int32_t> _nodeSlots; // the slot of its parent holding each node, or -1 for the root
+    std::vector<uint32_t> _freeItems;
+    size_t _numRefitsSinceRebuild { 0 };
+    size_t _numRemovalsSinceRebuild { 0 };
+
+    // only accessed with std::atomic_load and std::atomic_store
+    SnapshotPointer _snapshot;
+};
+
+#endif // hifi_EntityQueryIndex_h
@@ -309,82 +309,110 @@ EntityItemProperties EntityScriptingInterface::getEntityProperties(QUuid identit
 QUuid EntityScriptingInterface::editEntity(QUuid id, const EntityItemProperties& scriptSideProperties) {
     PROFILE_RANGE(script_entities, __FUNCTION__);
 
-    _activityTracking.editedEntityCount++;
+    QVector<EntityEdit> edits { EntityEdit(id, scriptSideProperties) };
+    return editEntitiesWorker(edits).first();
+}
 
-    EntityItemProperties properties = scriptSideProperties;
+QVector<QUuid> EntityScriptingInterface::editEntities(const QScriptValue& edits) {
+    PROFILE_RANGE(script_entities, __FUNCTION__);
 
-    auto dimensions = properties.getDimensions();
-    float volume = dimensions.x * dimensions.y * dimensions.z;
-    auto density = properties.getDensity();
-    auto newVelocity = properties.getVelocity().length();
-    float oldVelocity = { 0.0f };
+    QVector<EntityEdit> entityEdits(edits.property("length").toInt32());
+    for (int i = 0; i < entityEdits.size(); ++i) {
+        QScriptValue edit = edits.property(i);
+        entityEdits[i].first = QUuid(edit.property("id").toString());
+        EntityItemPropertiesFromScriptValueHonorReadOnly(edit.property("properties"), entityEdits[i].second);
+    }
+    return editEntitiesWorker(entityEdits);
+}
+
+QVector<QUuid> EntityScriptingInterface::editEntitiesWorker(QVector<EntityEdit>& edits) {
+    _activityTracking.editedEntityCount += edits.size();
+
+    struct EditCost {
+        float mass;
+        float oldVelocity;
+        float newVelocity;
+    };
+    QVector<EditCost> costs(edits.size());
+    QVector<QUuid> results(edits.size());
+    for (int i = 0; i < edits.size(); ++i) {
+        const EntityItemProperties& properties = edits[i].second;
+        auto dimensions = properties.getDimensions();
+        float volume = dimensions.x * dimensions.y * dimensions.z;
+        costs[i].mass = properties.getDensity() * volume;
+        costs[i].oldVelocity = 0.0f;
+        costs[i].newVelocity = properties.getVelocity().length();
+    }
 
-    EntityItemID entityID(id);
     if (!_entityTree) {
-        queueEntityMessage(PacketType::EntityEdit, entityID, properties);
+        for (int i = 0; i < edits.size(); ++i) {
+            queueEntityMessage(PacketType::EntityEdit, EntityItemID(edits[i].first), edits[i].second);
 
-        //if there is no local entity entity tree, no existing velocity, use 0.
-        float cost = calculateCost(density * volume, oldVelocity, newVelocity);
-        cost *= costMultiplier;
+            //if there is no local entity entity tree, no existing velocity, use 0.
+            float cost = calculateCost(costs[i].mass, costs[i].oldVelocity, costs[i].newVelocity);
+            cost *= costMultiplier;
 
-        if (cost > _currentAvatarEnergy) {
-            return QUuid();
-        } else {
-            //debit the avatar energy and continue
-            emit debitEnergySource(cost);
+            if (cost > _currentAvatarEnergy) {
+                results[i] = QUuid();
+            } else {
+                //debit the avatar energy and continue
+                emit debitEnergySource(cost);
+                results[i] = edits[i].first;
+            }
         }
-
-        return id;
+        return results;
     }
     // If we have a local entity tree set, then also update it.
 
-    bool updatedEntity = false;
+    auto nodeList = DependencyManager::get<NodeList>();
     _entityTree->withWriteLock([&] {
-        EntityItemPointer entity = _entityTree->findEntityByEntityItemID(entityID);
-        if (!entity) {
-            return;
-        }
+        for (int i = 0; i < edits.size(); ++i) {
+            EntityItemID entityID(edits[i].first);
+            EntityItemProperties& properties = edits[i].second;
+            EntityItemPointer entity = _entityTree->findEntityByEntityItemID(entityID);
+            if (!entity) {
+                continue;
+            }
 
-        auto nodeList = DependencyManager::get<NodeList>();
-        if (entity->getClientOnly() && entity->getOwningAvatarID() != nodeList->getSessionUUID()) {
-            // don't edit other avatar's avatarEntities
-            return;
-        }
+            if (entity->getClientOnly() && entity->getOwningAvatarID() != nodeList->getSessionUUID()) {
+                // don't edit other avatar's avatarEntities
+                continue;
+            }
 
-        if (scriptSideProperties.parentRelatedPropertyChanged()) {
-            // All of parentID, parentJointIndex, position, rotation are needed to make sense of any of them.
-            // If any of these changed, pull any missing properties from the entity.
+            if (properties.parentRelatedPropertyChanged()) {
+                // All of parentID, parentJointIndex, position, rotation are needed to make sense of any of them.
+                // If any of these changed, pull any missing properties from the entity.
 
-            //existing entity, retrieve old velocity for check down below
-            oldVelocity = entity->getVelocity().length();
+                //existing entity, retrieve old velocity for check down below
+                costs[i].oldVelocity = entity->getVelocity().length();
 
-            if (!scriptSideProperties.parentIDChanged()) {
-                properties.setParentID(entity->getParentID());
-            }
-            if (!scriptSideProperties.parentJointIndexChanged()) {
-                properties.setParentJointIndex(entity->getParentJointIndex());
-            }
-            if (!scriptSideProperties.localPositionChanged() && !scriptSideProperties.positionChanged()) {
-                properties.setPosition(entity->getPosition());
-            }
-            if (!scriptSideProperties.localRotationChanged() && !scriptSideProperties.rotationChanged()) {
-                properties.setRotation(entity->getOrientation());
+                bool positionChanged = properties.localPositionChanged() || properties.positionChanged();
+                bool rotationChanged = properties.localRotationChanged() || properties.rotationChanged();
+                if (!properties.parentIDChanged()) {
+                    properties.setParentID(entity->getParentID());
+                }
+                if (!properties.parentJointIndexChanged()) {
+                    properties.setParentJointIndex(entity->getParentJointIndex());
+                }
+                if (!positionChanged) {
+                    properties.setPosition(entity->getPosition());
+                }
+                if (!rotationChanged) {
+                    properties.setRotation(entity->getOrientation());
+                }
             }
-        }
-        properties = convertLocationFromScriptSemantics(properties);
-        properties.setClientOnly(entity->getClientOnly());
-        properties.setOwningAvatarID(entity->getOwningAvatarID());
+            properties = convertLocationFromScriptSemantics(properties);
+            properties.setClientOnly(entity->getClientOnly());
+            properties.setOwningAvatarID(entity->getOwningAvatarID());
 
-        float cost = calculateCost(density * volume, oldVelocity, newVelocity);
-        cost *= costMultiplier;
+            float cost = calculateCost(costs[i].mass, costs[i].oldVelocity, costs[i].newVelocity);
+            cost *= costMultiplier;
 
-        if (cost > _currentAvatarEnergy) {
-            updatedEntity = false;
-        } else {
-            //debit the avatar energy and continue
-            updatedEntity = _entityTree->updateEntity(entityID, properties);
-            if (updatedEntity) {
-                emit debitEnergySource(cost);
+            if (cost <= _currentAvatarEnergy) {
+                //debit the avatar energy and continue
+                if (_entityTree->updateEntity(entityID, properties)) {
+                    emit debitEnergySource(cost);
+                }
             }
         }
     });
@@ -398,17 +426,20 @@ QUuid EntityScriptingInterface::editEntity(QUuid id, const EntityItemProperties&
     //     return QUuid();
     // }
 
-    bool entityFound { false };
+    QVector<bool> entitiesFound(edits.size(), false);
     _entityTree->withReadLock([&] {
-        EntityItemPointer entity = _entityTree->findEntityByEntityItemID(entityID);
-        if (entity) {
-            entityFound = true;
+        for (int i = 0; i < edits.size(); ++i) {
+            EntityItemProperties& properties = edits[i].second;
+            EntityItemPointer entity = _entityTree->findEntityByEntityItemID(EntityItemID(edits[i].first));
+            if (!entity) {
+                continue;
+            }
+            entitiesFound[i] = true;
             // make sure the properties has a type, so that the encode can know which properties to include
             properties.setType(entity->getType());
             bool hasTerseUpdateChanges = properties.hasTerseUpdateChanges();
             bool hasPhysicsChanges = properties.hasMiscPhysicsChanges() || hasTerseUpdateChanges;
             if (_bidOnSimulationOwnership && hasPhysicsChanges) {
-                auto nodeList = DependencyManager::get<NodeList>();
                 const QUuid myNodeID = nodeList->getSessionUUID();
 
                 if (entity->getSimulatorID() == myNodeID) {
@@ -457,11 +488,13 @@ QUuid EntityScriptingInterface::editEntity(QUuid id, const EntityItemProperties&
             });
         }
     });
-    if (!entityFound) {
-        // we've made an edit to an entity we don't know about, or to a non-entity.  If it's a known non-entity,
-        // print a warning and don't send an edit packet to the entity-server.
-        QSharedPointer<SpatialParentFinder> parentFinder = DependencyManager::get<SpatialParentFinder>();
-        if (parentFinder) {
+
+    QSharedPointer<SpatialParentFinder> parentFinder = DependencyManager::get<SpatialParentFinder>();
+    for (int i = 0; i < edits.size(); ++i) {
+        const QUuid& id = edits[i].first;
+        if (!entitiesFound[i] && parentFinder) {
+            // we've made an edit to an entity we don't know about, or to a non-entity.  If it's a known non-entity,
+            // print a warning and don't send an edit packet to the entity-server.
             bool success;
             auto nestableWP = parentFinder->find(id, success, static_cast<SpatialParentTree*>(_entityTree.get()));
             if (success) {
@@ -470,16 +503,18 @@ QUuid EntityScriptingInterface::editEntity(QUuid id, const EntityItemProperties&
                     NestableType nestableType = nestable->getNestableType();
                     if (nestableType == NestableType::Overlay || nestableType == NestableType::Avatar) {
                         qCWarning(entities) << "attempted edit on non-entity: " << id << nestable->getName();
-                        return QUuid(); // null UUID to indicate failure
+                        results[i] = QUuid(); // null UUID to indicate failure
+                        continue;
                     }
                 }
             }
         }
+        // we queue edit packets even if we don't know about the entity.  This is to allow AC agents
+        // to edit entities they know only by ID.
+        queueEntityMessage(PacketType::EntityEdit, EntityItemID(id), edits[i].second);
+        results[i] = id;
     }
-    // we queue edit packets even if we don't know about the entity.  This is to allow AC agents
-    // to edit entities they know only by ID.
-    queueEntityMessage(PacketType::EntityEdit, entityID, properties);
-    return id;
+    return results;
 }
 
 void EntityScriptingInterface::deleteEntity(QUuid id) {
@@ -585,9 +620,7 @@ QVector<QUuid> EntityScriptingInterface::findEntities(const glm::vec3& center, f
     QVector<QUuid> result;
     if (_entityTree) {
         QVector<EntityItemPointer> entities;
-        _entityTree->withReadLock([&] {
-            _entityTree->findEntities(center, radius, entities);
-        });
+        _entityTree->findEntities(center, radius, entities);
 
         foreach (EntityItemPointer entity, entities) {
             result << entity->getEntityItemID();
@@ -602,10 +635,8 @@ QVector<QUuid> EntityScriptingInterface::findEntitiesInBox(const glm::vec3& corn
     QVector<QUuid> result;
     if (_entityTree) {
         QVector<EntityItemPointer> entities;
-        _entityTree->withReadLock([&] {
-            AABox box(corner, dimensions);
-            _entityTree->findEntities(box, entities);
-        });
+        AABox box(corner, dimensions);
+        _entityTree->findEntities(box, entities);
 
         foreach (EntityItemPointer entity, entities) {
             result << entity->getEntityItemID();
@@ -645,9 +676,7 @@ QVector<QUuid> EntityScriptingInterface::findEntitiesInFrustum(QVariantMap frust
 
         if (_entityTree) {
             QVector<EntityItemPointer> entities;
-            _entityTree->withReadLock([&] {
-                _entityTree->findEntities(viewFrustum, entities);
-            });
+            _entityTree->findEntities(viewFrustum, entities);
 
             foreach(EntityItemPointer entity, entities) {
                 result << entity->getEntityItemID();
@@ -664,9 +693,7 @@ QVector<QUuid> EntityScriptingInterface::findEntitiesByType(const QString entity
 	QVector<QUuid> result;
 	if (_entityTree) {
 		QVector<EntityItemPointer> entities;
-		_entityTree->withReadLock([&] {
-			_entityTree->findEntities(center, radius, entities);
-		});
+		_entityTree->findEntities(center, radius, entities);
 
 		foreach(EntityItemPointer entity, entities) {
 			if (entity->getType() == type) {
@@ -168,6 +168,17 @@ public slots:
      */
     Q_INVOKABLE QUuid editEntity(QUuid entityID, const EntityItemProperties& properties);
 
+    /**jsdoc
+     * Updates several entities at once. The entity tree is locked once for the whole batch rather than once per entity,
+     * and the edits are queued together, to be packed into as few packets as possible.
+     *
+     * @function Entities.editEntities
+     * @param {Object[]} edits Array of <code>{ id: EntityID, properties: EntityItemProperties }</code> objects.
+     * @return {EntityID[]} The EntityID of each edited entity if its edit was successful, otherwise the null {EntityID}, in
+     *     the order of the edits.
+     */
+    Q_INVOKABLE QVector<QUuid> editEntities(const QScriptValue& edits);
+
     /**jsdoc
      * Deletes an entity.
      *
@@ -415,6 +426,10 @@ private:
     bool setPoints(QUuid entityID, std::function<bool(LineEntityItem&)> actor);
     void queueEntityMessage(PacketType packetType, EntityItemID entityID, const EntityItemProperties& properties);
 
+    /// applies the edits to the local entity tree and queues them, the properties are converted in place
+    using EntityEdit = std::pair<QUuid, EntityItemProperties>;
+    QVector<QUuid> editEntitiesWorker(QVector<EntityEdit>& edits);
+
     EntityItemPointer checkForTreeEntityAndTypeMatch(const QUuid& entityID,
                                                      EntityTypes::EntityType entityType = EntityTypes::Unknown);
 
@@ -18,7 +18,6 @@
 void EntitySimulation::setEntityTree(EntityTreePointer tree) {
     if (_entityTree && _entityTree != tree) {
         _mortalEntities.clear();
-        _nextExpiry = quint64(-1);
         _entitiesToUpdate.clear();
         _entitiesToSort.clear();
         _simpleKinematicEntities.clear();
@@ -51,7 +50,7 @@ void EntitySimulation::takeEntitiesToDelete(VectorOfEntities& entitiesToDelete)
 void EntitySimulation::removeEntityInternal(EntityItemPointer entity) {
     QMutexLocker lock(&_mutex);
     // remove from all internal lists except _entitiesToDelete
-    _mortalEntities.remove(entity);
+    _mortalEntities.remove(entity.get());
     _entitiesToUpdate.remove(entity);
     _entitiesToSort.remove(entity);
     _simpleKinematicEntities.remove(entity);
@@ -93,28 +92,17 @@ void EntitySimulation::changeEntityInternal(EntityItemPointer entity) {
 
 // protected
 void EntitySimulation::expireMortalEntities(const quint64& now) {
-    if (now > _nextExpiry) {
-        // only search for expired entities if we expect to find one
-        _nextExpiry = quint64(-1);
-        QMutexLocker lock(&_mutex);
-        SetOfEntities::iterator itemItr = _mortalEntities.begin();
-        while (itemItr != _mortalEntities.end()) {
-            EntityItemPointer entity = *itemItr;
-            quint64 expiry = entity->getExpiry();
-            if (expiry < now) {
-                itemItr = _mortalEntities.erase(itemItr);
-                entity->die();
-                prepareEntityForDelete(entity);
-            } else {
-                if (expiry < _nextExpiry) {
-                    // remember the smallest _nextExpiry so we know when to start the next search
-                    _nextExpiry = expiry;
-                }
-                ++itemItr;
-            }
-        }
-        if (_mortalEntities.size() < 1) {
-            _nextExpiry = -1;
+    QMutexLocker lock(&_mutex);
+    // only the entities that expired are visited
+    while (_mortalEntities.getNextExpiry() < now) {
+        EntityItemPointer entity = _mortalEntities.pop();
+        // the expiry is queued when the lifetime changes, check it again in case the creation time changed since
+        quint64 expiry = entity->getExpiry();
+        if (expiry < now) {
+            entity->die();
+            prepareEntityForDelete(entity);
+        } else if (entity->isMortal()) {
+            _mortalEntities.set(entity, expiry);
         }
     }
 }
@@ -172,11 +160,7 @@ void EntitySimulation::addEntity(EntityItemPointer entity) {
     assert(entity);
     entity->deserializeActions();
     if (entity->isMortal()) {
-        _mortalEntities.insert(entity);
-        quint64 expiry = entity->getExpiry();
-        if (expiry < _nextExpiry) {
-            _nextExpiry = expiry;
-        }
+        _mortalEntities.set(entity, entity->getExpiry());
     }
     if (entity->needsToCallUpdate()) {
         _entitiesToUpdate.insert(entity);
@@ -220,13 +204,9 @@ void EntitySimulation::changeEntity(EntityItemPointer entity) {
     if (!wasRemoved) {
         if (dirtyFlags & Simulation::DIRTY_LIFETIME) {
             if (entity->isMortal()) {
-                _mortalEntities.insert(entity);
-                quint64 expiry = entity->getExpiry();
-                if (expiry < _nextExpiry) {
-                    _nextExpiry = expiry;
-                }
+                _mortalEntities.set(entity, entity->getExpiry());
             } else {
-                _mortalEntities.remove(entity);
+                _mortalEntities.remove(entity.get());
             }
             entity->clearDirtyFlags(Simulation::DIRTY_LIFETIME);
         }
@@ -242,7 +222,6 @@ void EntitySimulation::changeEntity(EntityItemPointer entity) {
 void EntitySimulation::clearEntities() {
     QMutexLocker lock(&_mutex);
     _mortalEntities.clear();
-    _nextExpiry = quint64(-1);
     _entitiesToUpdate.clear();
     _entitiesToSort.clear();
     _simpleKinematicEntities.clear();
@@ -258,6 +237,12 @@ void EntitySimulation::clearEntities() {
 }
 
 void EntitySimulation::moveSimpleKinematics(const quint64& now) {
+    PerformanceTimer perfTimer("moveSimpleKinematics");
+
+    // gather the motion of the entities, step it all at once, then apply it back
+    _kinematicEntities.clear();
+    _kinematicMotions.clear();
+
     SetOfEntities::iterator itemItr = _simpleKinematicEntities.begin();
     while (itemItr != _simpleKinematicEntities.end()) {
         EntityItemPointer entity = *itemItr;
@@ -269,14 +254,23 @@ void EntitySimulation::moveSimpleKinematics(const quint64& now) {
         bool hasAvatarAncestor = entity->hasAncestorOfType(NestableType::Avatar);
 
         if (entity->isMovingRelativeToParent() && !entity->getPhysicsInfo() && ancestryIsKnown && !hasAvatarAncestor) {
-            entity->simulate(now);
-            _entitiesToSort.insert(entity);
+            entity->appendKinematicMotion(_kinematicMotions, now);
+            _kinematicEntities.push_back(entity);
             ++itemItr;
         } else {
             // the entity is no longer non-physical-kinematic
             itemItr = _simpleKinematicEntities.erase(itemItr);
         }
     }
+
+    _kinematicMotions.step();
+
+    for (size_t i = 0; i < _kinematicEntities.size(); ++i) {
+        const auto& entity = _kinematicEntities[i];
+        entity->applyKinematicMotion(_kinematicMotions, i, now);
+        _entitiesToSort.insert(entity);
+    }
+    _kinematicEntities.clear();
 }
 
 void EntitySimulation::addDynamic(EntityDynamicPointer dynamic) {
@@ -19,8 +19,10 @@
 #include <PerfStat.h>
 
 #include "EntityDynamicInterface.h"
+#include "EntityExpiryQueue.h"
 #include "EntityItem.h"
 #include "EntityTree.h"
+#include "KinematicMotion.h"
 
 using EntitySimulationPointer = std::shared_ptr<EntitySimulation>;
 using SetOfEntities = QSet<EntityItemPointer>;
@@ -45,7 +47,7 @@ const int DIRTY_SIMULATION_FLAGS =
 class EntitySimulation : public QObject, public std::enable_shared_from_this<EntitySimulation> {
 Q_OBJECT
 public:
-    EntitySimulation() : _mutex(QMutex::Recursive), _entityTree(NULL), _nextExpiry(quint64(-1)) { }
+    EntitySimulation() : _mutex(QMutex::Recursive), _entityTree(NULL) { }
     virtual ~EntitySimulation() { setEntityTree(NULL); }
 
     inline EntitySimulationPointer getThisPointer() const {
@@ -119,12 +121,15 @@ private:
     // We maintain multiple lists, each for its distinct purpose.
     // An entity may be in more than one list.
     SetOfEntities _allEntities; // tracks all entities added the simulation
-    SetOfEntities _mortalEntities; // entities that have an expiry
-    quint64 _nextExpiry;
+    EntityExpiryQueue _mortalEntities; // entities that have an expiry, by expiry
 
 
     SetOfEntities _entitiesToUpdate; // entities that need to call EntityItem::update()
 
+    // the simple kinematic entities being moved and their motion, kept to reuse their storage
+    std::vector<EntityItemPointer> _kinematicEntities;
+    KinematicMotions _kinematicMotions;
+
 };
 
 #endif // hifi_EntitySimulation_h
@@ -24,6 +24,7 @@ typedef std::shared_ptr<EntityTree> EntityTreePointer;
 
 #include "EntityTreeElement.h"
 #include "DeleteEntityOperator.h"
+#include "EntityQueryIndex.h"
 
 class EntityEditFilters;
 class Model;
@@ -90,6 +91,9 @@ public:
     void fixupTerseEditLogging(EntityItemProperties& properties, QList<QString>& changedProperties);
     virtual int processEditPacketData(ReceivedMessage& message, const unsigned char* editData, int maxLength,
                                       const SharedNodePointer& senderNode) override;
+    virtual OctreePreparedEditPointer prepareEditPacketData(ReceivedMessage& message, const unsigned char* editData,
+                                                            int maxLength, const SharedNodePointer& senderNode) override;
+    virtual void applyPreparedEdit(OctreePreparedEdit& edit, const SharedNodePointer& senderNode) override;
 
     virtual bool findRayIntersection(const glm::vec3& origin, const glm::vec3& direction,
         QVector<EntityItemID> entityIdsToInclude, QVector<EntityItemID> entityIdsToDiscard,
@@ -136,6 +140,8 @@ public:
     EntityItemID assignEntityID(const EntityItemID& entityItemID); /// Assigns a known ID for a creator token ID
 
 
+    // The findEntities() queries use the query index, they don't need the tree to be locked
+
     /// finds all entities that touch a sphere
     /// \param center the center of the sphere in world-frame (meters)
     /// \param radius the radius of the sphere in world-frame (meters)
@@ -195,6 +201,9 @@ public:
 
     void entityChanged(EntityItemPointer entity);
 
+    /// Called when the bounding box of an entity of the tree has changed
+    void entityBoundsChanged(const EntityItemPointer& entity) { _queryIndex.updateEntity(entity); }
+
     void emitEntityScriptChanging(const EntityItemID& entityItemID, bool reload);
     void emitEntityServerScriptChanging(const EntityItemID& entityItemID, bool reload);
 
@@ -275,10 +284,6 @@ protected:
     bool updateEntity(EntityItemPointer entity, const EntityItemProperties& properties,
             const SharedNodePointer& senderNode = SharedNodePointer(nullptr));
     static bool findNearPointOperation(const OctreeElementPointer& element, void* extraData);
-    static bool findInSphereOperation(const OctreeElementPointer& element, void* extraData);
-    static bool findInCubeOperation(const OctreeElementPointer& element, void* extraData);
-    static bool findInBoxOperation(const OctreeElementPointer& element, void* extraData);
-    static bool findInFrustumOperation(const OctreeElementPointer& element, void* extraData);
     static bool sendEntitiesOperation(const OctreeElementPointer& element, void* extraData);
     static void bumpTimestamp(EntityItemProperties& properties);
 
@@ -308,6 +313,8 @@ protected:
     mutable QReadWriteLock _entityMapLock;
     QHash<EntityItemID, EntityItemPointer> _entityMap;
 
+    EntityQueryIndex _queryIndex;
+
     EntitySimulationPointer _simulation;
 
     bool _wantEditLogging = false;
@@ -344,6 +351,9 @@ protected:
     float _maxTmpEntityLifetime { DEFAULT_MAX_TMP_ENTITY_LIFETIME };
 
     bool filterProperties(EntityItemPointer& existingEntity, EntityItemProperties& propertiesIn, EntityItemProperties& propertiesOut, bool& wasChanged, FilterType filterType);
+
+    class PreparedEntityEdit;
+    void prepareEntityEdit(PreparedEntityEdit& edit, const SharedNodePointer& senderNode);
     bool _hasEntityEditFilter{ false };
     QStringList _entityScriptSourceWhitelist;
 };
@@ -157,6 +157,19 @@ public:
     virtual bool findSpherePenetration(const glm::vec3& center, float radius,
                         glm::vec3& penetration, void** penetratedObject) const override;
 
+    /// Returns false if the entity is filtered out of ray picks
+    static bool isEntityPickable(const EntityItemPointer& entity, const QVector<EntityItemID>& entityIdsToInclude,
+                                 const QVector<EntityItemID>& entityIdsToDiscard, bool visibleOnly, bool collidableOnly);
+
+    /// Returns true if the ray intersects the entity closer than distance, which is then updated with the intersection
+    static bool findEntityRayIntersection(const EntityItemPointer& entity, const glm::vec3& origin, const glm::vec3& direction,
+                                          bool& keepSearching, OctreeElementPointer& element, float& distance,
+                                          BoxFace& face, glm::vec3& surfaceNormal, void** intersectedObject,
+                                          bool precisionPicking);
+
+    /// Returns true if the entity touches the sphere
+    static bool entityTouchesSphere(const EntityItemPointer& entity, const glm::vec3& position, float radius);
+
 
     template <typename F>
     void forEachEntity(F f) const {
@@ -0,0 +1,162 @@
+//
+//  KinematicMotion.cpp
+//  libraries/entities/src
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "KinematicMotion.h"
+
+#include <QtConcurrent/QtConcurrentMap>
+
+#include <glm/gtx/norm.hpp>
+
+#include <GLMHelpers.h>
+#include <PhysicsHelpers.h>
+
+#include "EntitiesLogging.h"
+
+// the motions stepped by each parallel job, fewer motions than that are stepped on the calling thread
+static const size_t MOTIONS_PER_CHUNK = 256;
+
+bool stepKinematicMotion(glm::vec3& position, glm::quat& rotation, glm::vec3& linearVelocity, glm::vec3& angularVelocity,
+                         const glm::vec3& acceleration, float damping, float angularDamping, float timeElapsed) {
+    // find out if it is moving
+    bool isSpinning = (glm::length2(angularVelocity) > 0.0f);
+    float linearSpeedSquared = glm::length2(linearVelocity);
+    bool isTranslating = linearSpeedSquared > 0.0f;
+    bool moving = isTranslating || isSpinning;
+    if (!moving) {
+        return false;
+    }
+
+    if (timeElapsed <= 0.0f) {
+        // someone gave us a useless time value so bail early
+        // but return 'true' because it is moving
+        return true;
+    }
+
+    const float MAX_TIME_ELAPSED = 1.0f; // seconds
+    if (timeElapsed > MAX_TIME_ELAPSED) {
+        qCWarning(entities) << "kinematic timestep = " << timeElapsed << " truncated to " << MAX_TIME_ELAPSED;
+    }
+    timeElapsed = glm::min(timeElapsed, MAX_TIME_ELAPSED);
+
+    if (isSpinning) {
+        // angular damping
+        if (angularDamping > 0.0f) {
+            angularVelocity *= powf(1.0f - angularDamping, timeElapsed);
+        }
+
+        const float MIN_KINEMATIC_ANGULAR_SPEED_SQUARED =
+            KINEMATIC_ANGULAR_SPEED_THRESHOLD * KINEMATIC_ANGULAR_SPEED_THRESHOLD;
+        if (glm::length2(angularVelocity) < MIN_KINEMATIC_ANGULAR_SPEED_SQUARED) {
+            angularVelocity = Vectors::ZERO;
+        } else {
+            // for improved agreement with the way Bullet integrates rotations we use an approximation
+            // and break the integration into bullet-sized substeps
+            float dt = timeElapsed;
+            while (dt > 0.0f) {
+                glm::quat  dQ = computeBulletRotationStep(angularVelocity, glm::min(dt, PHYSICS_ENGINE_FIXED_SUBSTEP));
+                rotation = glm::normalize(dQ * rotation);
+                dt -= PHYSICS_ENGINE_FIXED_SUBSTEP;
+            }
+        }
+    }
+
+    const float MIN_KINEMATIC_LINEAR_SPEED_SQUARED =
+        KINEMATIC_LINEAR_SPEED_THRESHOLD * KINEMATIC_LINEAR_SPEED_THRESHOLD;
+    if (isTranslating) {
+        glm::vec3 deltaVelocity = Vectors::ZERO;
+
+        // linear damping
+        if (damping > 0.0f) {
+            deltaVelocity = (powf(1.0f - damping, timeElapsed) - 1.0f) * linearVelocity;
+        }
+
+        if (glm::length2(acceleration) > MIN_KINEMATIC_LINEAR_ACCELERATION_SQUARED) {
+            // yes acceleration
+            deltaVelocity += acceleration * timeElapsed;
+
+            if (linearSpeedSquared < MIN_KINEMATIC_LINEAR_SPEED_SQUARED
+                    && glm::length2(deltaVelocity) < MIN_KINEMATIC_LINEAR_SPEED_SQUARED
+                    && glm::length2(linearVelocity + deltaVelocity) < MIN_KINEMATIC_LINEAR_SPEED_SQUARED) {
+                linearVelocity = Vectors::ZERO;
+            } else {
+                // NOTE: we do NOT include the second-order acceleration term (0.5 * a * dt^2)
+                // when computing the displacement because Bullet also ignores that term.  Yes,
+                // this is an approximation and it works best when dt is small.
+                position += timeElapsed * linearVelocity;
+                linearVelocity += deltaVelocity;
+            }
+        } else {
+            // no acceleration
+            if (linearSpeedSquared < MIN_KINEMATIC_LINEAR_SPEED_SQUARED) {
+                linearVelocity = Vectors::ZERO;
+            } else {
+                // NOTE: we don't use second-order acceleration term for linear displacement
+                // because Bullet doesn't use it.
+                position += timeElapsed * linearVelocity;
+                linearVelocity += deltaVelocity;
+            }
+        }
+    }
+
+    return true;
+}
+
+void KinematicMotions::clear() {
+    positions.clear();
+    rotations.clear();
+    linearVelocities.clear();
+    angularVelocities.clear();
+    accelerations.clear();
+    dampings.clear();
+    angularDampings.clear();
+    timesElapsed.clear();
+    moving.clear();
+}
+
+size_t KinematicMotions::append(const glm::vec3& position, const glm::quat& rotation, const glm::vec3& linearVelocity,
+                                const glm::vec3& angularVelocity, const glm::vec3& acceleration, float damping,
+                                float angularDamping, float timeElapsed) {
+    positions.push_back(position);
+    rotations.push_back(rotation);
+    linearVelocities.push_back(linearVelocity);
+    angularVelocities.push_back(angularVelocity);
+    accelerations.push_back(acceleration);
+    dampings.push_back(damping);
+    angularDampings.push_back(angularDamping);
+    timesElapsed.push_back(timeElapsed);
+    moving.push_back(0);
+    return positions.size() - 1;
+}
+
+void KinematicMotions::step() {
+    auto numMotions = size();
+    if (numMotions <= MOTIONS_PER_CHUNK) {
+        step(0, numMotions);
+        return;
+    }
+
+    std::vector<std::pair<size_t, size_t>> chunks;
+    chunks.reserve((numMotions + MOTIONS_PER_CHUNK - 1) / MOTIONS_PER_CHUNK);
+    for (size_t begin = 0; begin < numMotions; begin += MOTIONS_PER_CHUNK) {
+        chunks.emplace_back(begin, std::min(begin + MOTIONS_PER_CHUNK, numMotions));
+    }
+
+    // the chunks write disjoint ranges of the arrays
+    QtConcurrent::blockingMap(chunks, [this](const std::pair<size_t, size_t>& chunk) {
+        step(chunk.first, chunk.second);
+    });
+}
+
+void KinematicMotions::step(size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+        moving[i] = stepKinematicMotion(positions[i], rotations[i], linearVelocities[i], angularVelocities[i],
+                                        accelerations[i], dampings[i], angularDampings[i], timesElapsed[i]) ? 1 : 0;
+    }
+}
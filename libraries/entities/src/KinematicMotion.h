@@ -0,0 +1,57 @@
+//
+//  KinematicMotion.h
+//  libraries/entities/src
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_KinematicMotion_h
+#define hifi_KinematicMotion_h
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+const float MIN_KINEMATIC_LINEAR_ACCELERATION_SQUARED = 1.0e-4f; // 0.01 m/sec^2
+
+/// Steps the motion of an entity moving without physics by timeElapsed seconds, in the frame of its parent.
+/// The acceleration is in the frame of the parent too. Returns false if the entity isn't moving.
+/// The state is left untouched if timeElapsed isn't positive.
+bool stepKinematicMotion(glm::vec3& position, glm::quat& rotation, glm::vec3& linearVelocity, glm::vec3& angularVelocity,
+                         const glm::vec3& acceleration, float damping, float angularDamping, float timeElapsed);
+
+// The kinematic state of many entities, in contiguous arrays, so that their motion can be stepped in parallel chunks
+// without touching the entities, nor their locks. EntityItem gathers its state into it and applies the result.
+class KinematicMotions {
+public:
+    void clear();
+    size_t size() const { return positions.size(); }
+
+    /// Returns the index of the appended motion
+    size_t append(const glm::vec3& position, const glm::quat& rotation, const glm::vec3& linearVelocity,
+                  const glm::vec3& angularVelocity, const glm::vec3& acceleration, float damping, float angularDamping,
+                  float timeElapsed);
+
+    /// Steps all the motions, in parallel chunks if there are enough of them
+    void step();
+
+    std::vector<glm::vec3> positions;
+    std::vector<glm::quat> rotations;
+    std::vector<glm::vec3> linearVelocities;
+    std::vector<glm::vec3> angularVelocities;
+    std::vector<glm::vec3> accelerations;
+    std::vector<float> dampings;
+    std::vector<float> angularDampings;
+    std::vector<float> timesElapsed;
+    std::vector<uint8_t> moving; // set by step()
+
+private:
+    void step(size_t begin, size_t end);
+};
+
+#endif // hifi_KinematicMotion_h
@@ -76,6 +76,11 @@ void MovingEntitiesOperator::addEntityToMoveList(EntityItemPointer entity, const
     // If the original containing element is the best fit for the requested newCube locations then
     // we don't actually need to add the entity for moving and we can short circuit all this work
     if (!oldContainingElement->bestFitBounds(newCubeClamped)) {
+        if (_entityIDsToMove.contains(entity->getEntityItemID())) {
+            return;
+        }
+        _entityIDsToMove.insert(entity->getEntityItemID());
+
         // check our tree, to determine if this entity is known
         EntityToMoveDetails details;
         details.oldContainingElement = oldContainingElement;
@@ -85,7 +90,7 @@ void MovingEntitiesOperator::addEntityToMoveList(EntityItemPointer entity, const
         details.newFound = false;
         details.newCube = newCube;
         details.newCubeClamped = newCubeClamped;
-        _entitiesToMove << details;
+        _entitiesToMove.push_back(details);
         _lookingCount++;
 
         if (_wantDebug) {
@@ -152,71 +157,68 @@ bool MovingEntitiesOperator::preRecursion(const OctreeElementPointer& element) {
     //
     // Note: it's often the case that the branch in question contains both the old entity
     // and the new entity.
-    
+    //
+    // Branches that contain none of the entities still searched for are not recursed, so only the
+    // elements on the way to the ones whose contents change are visited.
+
     bool keepSearching = (_foundOldCount < _lookingCount) || (_foundNewCount < _lookingCount);
+    if (!keepSearching) {
+        return false;
+    }
 
-    // If we haven't yet found all the entities, and this sub tree contains at least one of our
-    // entities, then we need to keep searching.
-    if (keepSearching && shouldRecurseSubTree(element)) {
+    const AACube& elementCube = element->getAACube();
+    bool containsSearchedEntity = false;
 
-        // check against each of our search entities
-        int detailIndex = 0;
-        foreach(const EntityToMoveDetails& details, _entitiesToMove) {
-        
-            if (_wantDebug) {
-                qCDebug(entities) << "MovingEntitiesOperator::preRecursion() details["<< detailIndex <<"]-----------------------------";
-                qCDebug(entities) << "    entityTreeElement:" << entityTreeElement->getAACube();
-                qCDebug(entities) << "    entityTreeElement->bestFitBounds(details.newCube):" << entityTreeElement->bestFitBounds(details.newCube);
-                qCDebug(entities) << "    details.entity:" << details.entity->getEntityItemID();
-                qCDebug(entities) << "    details.oldContainingElementCube:" << details.oldContainingElementCube;
-                qCDebug(entities) << "    entityTreeElement:" << entityTreeElement.get();
-                qCDebug(entities) << "    details.newCube:" << details.newCube;
-                qCDebug(entities) << "    details.newCubeClamped:" << details.newCubeClamped;
-                qCDebug(entities) << "    _lookingCount:" << _lookingCount;
-                qCDebug(entities) << "    _foundOldCount:" << _foundOldCount;
-                qCDebug(entities) << "--------------------------------------------------------------------------";
-            }
-        
-
-            // If this is one of the old elements we're looking for, then ask it to remove the old entity
-            if (!details.oldFound && entityTreeElement == details.oldContainingElement) {
-                // DO NOT remove the entity here.  It will be removed when added to the destination element.
-                _foundOldCount++;
-                //details.oldFound = true; // TODO: would be nice to add this optimization
-                if (_wantDebug) {
-                    qCDebug(entities) << "MovingEntitiesOperator::preRecursion() -----------------------------";
-                    qCDebug(entities) << "    FOUND OLD - REMOVING";
-                    qCDebug(entities) << "    entityTreeElement == details.oldContainingElement";
-                    qCDebug(entities) << "--------------------------------------------------------------------------";
-                }
-            }
+    // check against each of our search entities
+    for (auto& details : _entitiesToMove) {
+        bool searchOld = !details.oldFound && elementCube.contains(details.oldContainingElementCube);
+        bool searchNew = !details.newFound && elementCube.contains(details.newCubeClamped);
+        if (!searchOld && !searchNew) {
+            continue;
+        }
 
-            // If this element is the best fit for the new bounds of this entity then add the entity to the element
-            if (!details.newFound && entityTreeElement->bestFitBounds(details.newCube)) {
-                // remove from the old before adding
-                EntityTreeElementPointer oldElement = details.entity->getElement();
-                if (oldElement != entityTreeElement) {
-                    if (oldElement) {
-                        oldElement->removeEntityItem(details.entity);
-                    }
-                    entityTreeElement->addEntityItem(details.entity);
-                }
-                _foundNewCount++;
-                //details.newFound = true; // TODO: would be nice to add this optimization
-                if (_wantDebug) {
-                    qCDebug(entities) << "MovingEntitiesOperator::preRecursion() -----------------------------";
-                    qCDebug(entities) << "    FOUND NEW - ADDING";
-                    qCDebug(entities) << "    entityTreeElement->bestFitBounds(details.newCube)";
-                    qCDebug(entities) << "--------------------------------------------------------------------------";
+        if (_wantDebug) {
+            qCDebug(entities) << "MovingEntitiesOperator::preRecursion() -----------------------------";
+            qCDebug(entities) << "    entityTreeElement:" << entityTreeElement->getAACube();
+            qCDebug(entities) << "    entityTreeElement->bestFitBounds(details.newCube):" << entityTreeElement->bestFitBounds(details.newCube);
+            qCDebug(entities) << "    details.entity:" << details.entity->getEntityItemID();
+            qCDebug(entities) << "    details.oldContainingElementCube:" << details.oldContainingElementCube;
+            qCDebug(entities) << "    entityTreeElement:" << entityTreeElement.get();
+            qCDebug(entities) << "    details.newCube:" << details.newCube;
+            qCDebug(entities) << "    details.newCubeClamped:" << details.newCubeClamped;
+            qCDebug(entities) << "    _lookingCount:" << _lookingCount;
+            qCDebug(entities) << "    _foundOldCount:" << _foundOldCount;
+            qCDebug(entities) << "--------------------------------------------------------------------------";
+        }
+
+        // If this is one of the old elements we're looking for, then ask it to remove the old entity
+        if (searchOld && entityTreeElement == details.oldContainingElement) {
+            // DO NOT remove the entity here.  It will be removed when added to the destination element.
+            _foundOldCount++;
+            details.oldFound = true;
+        }
+
+        // If this element is the best fit for the new bounds of this entity then add the entity to the element
+        if (searchNew && entityTreeElement->bestFitBounds(details.newCube)) {
+            // remove from the old before adding
+            EntityTreeElementPointer oldElement = details.entity->getElement();
+            if (oldElement != entityTreeElement) {
+                if (oldElement) {
+                    oldElement->removeEntityItem(details.entity);
                 }
+                entityTreeElement->addEntityItem(details.entity);
             }
-            detailIndex++;
+            _foundNewCount++;
+            details.newFound = true;
+        }
+
+        // the children may hold what is still searched for this entity
+        if (!details.oldFound || !details.newFound) {
+            containsSearchedEntity = true;
         }
-        // if we haven't found all of our search for entities, then keep looking
-        keepSearching = (_foundOldCount < _lookingCount) || (_foundNewCount < _lookingCount);
     }
 
-    return keepSearching; // if we haven't yet found it, keep looking
+    return containsSearchedEntity;
 }
 
 bool MovingEntitiesOperator::postRecursion(const OctreeElementPointer& element) {
@@ -270,7 +272,7 @@ OctreeElementPointer MovingEntitiesOperator::possiblyCreateChildAt(const OctreeE
         foreach(const EntityToMoveDetails& details, _entitiesToMove) {
 
             // if the scale of our desired cube is smaller than our children, then consider making a child
-            if (details.newCubeClamped.getLargestDimension() <= childElementScale) {
+            if (!details.newFound && details.newCubeClamped.getLargestDimension() <= childElementScale) {
 
                 int indexOfChildContainingNewEntity = element->getMyChildContaining(details.newCubeClamped);
             
@@ -24,14 +24,6 @@ public:
     bool newFound;
 };
 
-inline uint qHash(const EntityToMoveDetails& a, uint seed) {
-    return qHash(a.entity->getEntityItemID(), seed);
-}
-
-inline bool operator==(const EntityToMoveDetails& a, const EntityToMoveDetails& b) {
-    return a.entity->getEntityItemID() == b.entity->getEntityItemID();
-}
-
 class MovingEntitiesOperator : public RecurseOctreeOperator {
 public:
     MovingEntitiesOperator(EntityTreePointer tree);
@@ -44,7 +36,9 @@ public:
     bool hasMovingEntities() const { return _entitiesToMove.size() > 0; }
 private:
     EntityTreePointer _tree;
-    QSet<EntityToMoveDetails> _entitiesToMove;
+    // only the entities that changed element, the recursion only visits the branches leading to their old and new elements
+    QVector<EntityToMoveDetails> _entitiesToMove;
+    QSet<EntityItemID> _entityIDsToMove;
     quint64 _changeTime;
     int _foundOldCount;
     int _foundNewCount;
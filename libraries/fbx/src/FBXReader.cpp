@@ -11,6 +11,7 @@
 
 #include <iostream>
 #include <QBuffer>
+#include <QtConcurrent/QtConcurrentMap>
 #include <QDataStream>
 #include <QIODevice>
 #include <QStringList>
@@ -30,6 +31,7 @@
 #include <OctalCode.h>
 #include <gpu/Format.h>
 #include <LogHandler.h>
+#include <SharedUtil.h>
 
 #include "FBXReader.h"
 #include "ModelFormatLogging.h"
@@ -467,9 +469,36 @@ QByteArray fileOnUrl(const QByteArray& filepath, const QString& url) {
     return filepath.mid(filepath.lastIndexOf('/') + 1);
 }
 
+namespace {
+
+// a mesh whose extraction from its Geometry node is deferred until all the objects have been read
+struct MeshExtraction {
+    const FBXNode* object;
+    ExtractedMesh* extracted;
+    unsigned int meshIndex;
+};
+
+// the per mesh work of extractFBXGeometry that can run once all the joints are known
+struct MeshSkinning {
+    QString meshID;
+    ExtractedMesh* extracted;
+    glm::mat4 modelTransform;
+    bool generateTangents;
+    QVector<QString> clusterIDs;
+
+    // the joint-frame points of the mesh for each joint it is attached to, merged in mesh order
+    std::map<int, ShapeVertices> shapePoints;
+};
+
+}
+
 FBXGeometry* FBXReader::extractFBXGeometry(const QVariantHash& mapping, const QString& url) {
+    _extractionTimes = FBXExtractionTimes();
+    quint64 stageStart = usecTimestampNow();
+
     const FBXNode& node = _fbxNode;
     QMap<QString, ExtractedMesh> meshes;
+    QMap<QString, MeshExtraction> meshExtractions;
     QHash<QString, QString> modelIDsToNames;
     QHash<QString, int> meshIDsToMeshIndices;
     QHash<QString, QString> ooChildToParent;
@@ -600,7 +629,9 @@ FBXGeometry* FBXReader::extractFBXGeometry(const QVariantHash& mapping, const QS
             foreach (const FBXNode& object, child.children) {
                 if (object.name == "Geometry") {
                     if (object.properties.at(2) == "Mesh") {
-                        meshes.insert(getID(object.properties), extractMesh(object, meshIndex));
+                        // meshes only depend on their own node, they are all extracted in parallel after this loop
+                        QString meshID = getID(object.properties);
+                        meshExtractions.insert(meshID, { &object, &meshes[meshID], meshIndex++ });
                     } else { // object.properties.at(2) == "Shape"
                         ExtractedBlendshape extracted = { getID(object.properties), extractBlendshape(object) };
                         blendshapes.append(extracted);
@@ -775,6 +806,7 @@ FBXGeometry* FBXReader::extractFBXGeometry(const QVariantHash& mapping, const QS
                             }
                         } else if (subobject.name == "Vertices") {
                             // it's a mesh as well as a model
+                            meshExtractions.remove(getID(object.properties));
                             mesh = &meshes[getID(object.properties)];
                             *mesh = extractMesh(object, meshIndex);
 
@@ -1283,6 +1315,21 @@ FBXGeometry* FBXReader::extractFBXGeometry(const QVariantHash& mapping, const QS
 #endif
     }
 
+    _extractionTimes.objects = usecTimestampNow() - stageStart;
+    stageStart = usecTimestampNow();
+
+    {
+        PROFILE_RANGE(resource_parse, "extractMeshes");
+        auto extractions = meshExtractions.values();
+        QtConcurrent::blockingMap(extractions, [this](MeshExtraction& extraction) {
+            unsigned int meshIndex = extraction.meshIndex;
+            *extraction.extracted = extractMesh(*extraction.object, meshIndex);
+        });
+    }
+
+    _extractionTimes.meshes = usecTimestampNow() - stageStart;
+    stageStart = usecTimestampNow();
+
     // TODO: check if is code is needed
     if (!lights.empty()) {
         if (hifiGlobalNodeID.isEmpty()) {
@@ -1514,25 +1561,28 @@ FBXGeometry* FBXReader::extractFBXGeometry(const QVariantHash& mapping, const QS
     // see if any materials have texture children
     bool materialsHaveTextures = checkMaterialsHaveTextures(_fbxMaterials, _textureFilenames, _connectionChildMap);
 
+    _extractionTimes.joints = usecTimestampNow() - stageStart;
+    stageStart = usecTimestampNow();
+
+    // Meshes are done in two passes. The first one resolves the clusters of every mesh to their joints, which
+    // overrides the joint bind transforms, and runs serially. The second one only reads the joints, so the extents,
+    // tangents and skinning weights of each mesh are computed in parallel.
+    std::vector<MeshSkinning> meshSkinnings;
+    meshSkinnings.reserve(meshes.size());
+
     for (QMap<QString, ExtractedMesh>::iterator it = meshes.begin(); it != meshes.end(); it++) {
         ExtractedMesh& extracted = it.value();
 
+        MeshSkinning skinning;
+        skinning.meshID = it.key();
+        skinning.extracted = &extracted;
+
         extracted.mesh.meshExtents.reset();
 
         // accumulate local transforms
         QString modelID = models.contains(it.key()) ? it.key() : _connectionParentMap.value(it.key());
         glm::mat4 modelTransform = getGlobalTransform(_connectionParentMap, models, modelID, geometry.applicationName == "mixamo.com", url);
-
-        // compute the mesh extents from the transformed vertices
-        foreach (const glm::vec3& vertex, extracted.mesh.vertices) {
-            glm::vec3 transformedVertex = glm::vec3(modelTransform * glm::vec4(vertex, 1.0f));
-            geometry.meshExtents.minimum = glm::min(geometry.meshExtents.minimum, transformedVertex);
-            geometry.meshExtents.maximum = glm::max(geometry.meshExtents.maximum, transformedVertex);
-
-            extracted.mesh.meshExtents.minimum = glm::min(extracted.mesh.meshExtents.minimum, transformedVertex);
-            extracted.mesh.meshExtents.maximum = glm::max(extracted.mesh.meshExtents.maximum, transformedVertex);
-            extracted.mesh.modelTransform = modelTransform;
-        }
+        skinning.modelTransform = modelTransform;
 
         // look for textures, material properties
         // allocate the Part material library
@@ -1570,32 +1620,9 @@ FBXGeometry* FBXReader::extractFBXGeometry(const QVariantHash& mapping, const QS
                 textureIndex++;
             }
         }
-
-        // if we have a normal map (and texture coordinates), we must compute tangents
-        if (generateTangents && !extracted.mesh.texCoords.isEmpty()) {
-            extracted.mesh.tangents.resize(extracted.mesh.vertices.size());
-            foreach (const FBXMeshPart& part, extracted.mesh.parts) {
-                for (int i = 0; i < part.quadIndices.size(); i += 4) {
-                    setTangents(extracted.mesh, part.quadIndices.at(i), part.quadIndices.at(i + 1));
-                    setTangents(extracted.mesh, part.quadIndices.at(i + 1), part.quadIndices.at(i + 2));
-                    setTangents(extracted.mesh, part.quadIndices.at(i + 2), part.quadIndices.at(i + 3));
-                    setTangents(extracted.mesh, part.quadIndices.at(i + 3), part.quadIndices.at(i));
-                }
-                // <= size - 3 in order to prevent overflowing triangleIndices when (i % 3) != 0
-                // This is most likely evidence of a further problem in extractMesh()
-                for (int i = 0; i <= part.triangleIndices.size() - 3; i += 3) {
-                    setTangents(extracted.mesh, part.triangleIndices.at(i), part.triangleIndices.at(i + 1));
-                    setTangents(extracted.mesh, part.triangleIndices.at(i + 1), part.triangleIndices.at(i + 2));
-                    setTangents(extracted.mesh, part.triangleIndices.at(i + 2), part.triangleIndices.at(i));
-                }
-                if ((part.triangleIndices.size() % 3) != 0){
-                    qCDebug(modelformat) << "Error in extractFBXGeometry part.triangleIndices.size() is not divisible by three ";
-                }
-            }
-        }
+        skinning.generateTangents = generateTangents;
 
         // find the clusters with which the mesh is associated
-        QVector<QString> clusterIDs;
         foreach (const QString& childID, _connectionChildMap.values(it.key())) {
             foreach (const QString& clusterID, _connectionChildMap.values(childID)) {
                 if (!clusters.contains(clusterID)) {
@@ -1603,7 +1630,7 @@ FBXGeometry* FBXReader::extractFBXGeometry(const QVariantHash& mapping, const QS
                 }
                 FBXCluster fbxCluster;
                 const Cluster& cluster = clusters[clusterID];
-                clusterIDs.append(clusterID);
+                skinning.clusterIDs.append(clusterID);
 
                 // see http://stackoverflow.com/questions/13566608/loading-skinning-information-from-fbx for a discussion
                 // of skinning information in FBX
@@ -1639,10 +1666,53 @@ FBXGeometry* FBXReader::extractFBXGeometry(const QVariantHash& mapping, const QS
             extracted.mesh.clusters.append(cluster);
         }
 
+        meshSkinnings.push_back(skinning);
+    }
+
+    // from here on the joints are only read
+    const FBXGeometry& constGeometry = geometry;
+    const QHash<QString, Cluster>& constClusters = clusters;
+
+    QtConcurrent::blockingMap(meshSkinnings, [&constGeometry, &constClusters, &url](MeshSkinning& skinning) {
+        ExtractedMesh& extracted = *skinning.extracted;
+        const glm::mat4& modelTransform = skinning.modelTransform;
+        const QVector<FBXJoint>& joints = constGeometry.joints;
+
+        // compute the mesh extents from the transformed vertices
+        foreach (const glm::vec3& vertex, extracted.mesh.vertices) {
+            glm::vec3 transformedVertex = glm::vec3(modelTransform * glm::vec4(vertex, 1.0f));
+            extracted.mesh.meshExtents.minimum = glm::min(extracted.mesh.meshExtents.minimum, transformedVertex);
+            extracted.mesh.meshExtents.maximum = glm::max(extracted.mesh.meshExtents.maximum, transformedVertex);
+            extracted.mesh.modelTransform = modelTransform;
+        }
+
+        // if we have a normal map (and texture coordinates), we must compute tangents
+        if (skinning.generateTangents && !extracted.mesh.texCoords.isEmpty()) {
+            extracted.mesh.tangents.resize(extracted.mesh.vertices.size());
+            foreach (const FBXMeshPart& part, extracted.mesh.parts) {
+                for (int i = 0; i < part.quadIndices.size(); i += 4) {
+                    setTangents(extracted.mesh, part.quadIndices.at(i), part.quadIndices.at(i + 1));
+                    setTangents(extracted.mesh, part.quadIndices.at(i + 1), part.quadIndices.at(i + 2));
+                    setTangents(extracted.mesh, part.quadIndices.at(i + 2), part.quadIndices.at(i + 3));
+                    setTangents(extracted.mesh, part.quadIndices.at(i + 3), part.quadIndices.at(i));
+                }
+                // <= size - 3 in order to prevent overflowing triangleIndices when (i % 3) != 0
+                // This is most likely evidence of a further problem in extractMesh()
+                for (int i = 0; i <= part.triangleIndices.size() - 3; i += 3) {
+                    setTangents(extracted.mesh, part.triangleIndices.at(i), part.triangleIndices.at(i + 1));
+                    setTangents(extracted.mesh, part.triangleIndices.at(i + 1), part.triangleIndices.at(i + 2));
+                    setTangents(extracted.mesh, part.triangleIndices.at(i + 2), part.triangleIndices.at(i));
+                }
+                if ((part.triangleIndices.size() % 3) != 0){
+                    qCDebug(modelformat) << "Error in extractFBXGeometry part.triangleIndices.size() is not divisible by three ";
+                }
+            }
+        }
+
         // whether we're skinned depends on how many clusters are attached
         const FBXCluster& firstFBXCluster = extracted.mesh.clusters.at(0);
         glm::mat4 inverseModelTransform = glm::inverse(modelTransform);
-        if (clusterIDs.size() > 1) {
+        if (skinning.clusterIDs.size() > 1) {
             // this is a multi-mesh joint
             const int WEIGHTS_PER_VERTEX = 4;
             int numClusterIndices = extracted.mesh.vertices.size() * WEIGHTS_PER_VERTEX;
@@ -1650,19 +1720,19 @@ FBXGeometry* FBXReader::extractFBXGeometry(const QVariantHash& mapping, const QS
             QVector<float> weightAccumulators;
             weightAccumulators.fill(0.0f, numClusterIndices);
 
-            for (int i = 0; i < clusterIDs.size(); i++) {
-                QString clusterID = clusterIDs.at(i);
-                const Cluster& cluster = clusters[clusterID];
+            for (int i = 0; i < skinning.clusterIDs.size(); i++) {
+                QString clusterID = skinning.clusterIDs.at(i);
+                const Cluster& cluster = *constClusters.constFind(clusterID);
                 const FBXCluster& fbxCluster = extracted.mesh.clusters.at(i);
                 int jointIndex = fbxCluster.jointIndex;
-                FBXJoint& joint = geometry.joints[jointIndex];
+                const FBXJoint& joint = joints[jointIndex];
                 glm::mat4 transformJointToMesh = inverseModelTransform * joint.bindTransform;
                 glm::vec3 boneEnd = extractTranslation(transformJointToMesh);
                 glm::vec3 boneBegin = boneEnd;
                 glm::vec3 boneDirection;
                 float boneLength = 0.0f;
                 if (joint.parentIndex != -1) {
-                    boneBegin = extractTranslation(inverseModelTransform * geometry.joints[joint.parentIndex].bindTransform);
+                    boneBegin = extractTranslation(inverseModelTransform * joints[joint.parentIndex].bindTransform);
                     boneDirection = boneEnd - boneBegin;
                     boneLength = glm::length(boneDirection);
                     if (boneLength > EPSILON) {
@@ -1672,7 +1742,7 @@ FBXGeometry* FBXReader::extractFBXGeometry(const QVariantHash& mapping, const QS
 
                 float clusterScale = extractUniformScale(fbxCluster.inverseBindMatrix);
                 glm::mat4 meshToJoint = glm::inverse(joint.bindTransform) * modelTransform;
-                ShapeVertices& points = shapeVertices.at(jointIndex);
+                ShapeVertices& points = skinning.shapePoints[jointIndex];
 
                 for (int j = 0; j < cluster.indices.size(); j++) {
                     int oldIndex = cluster.indices.at(j);
@@ -1737,12 +1807,12 @@ FBXGeometry* FBXReader::extractFBXGeometry(const QVariantHash& mapping, const QS
         } else {
             // this is a single-mesh joint
             int jointIndex = firstFBXCluster.jointIndex;
-            FBXJoint& joint = geometry.joints[jointIndex];
+            const FBXJoint& joint = joints[jointIndex];
 
             // transform cluster vertices to joint-frame and save for later
             float clusterScale = extractUniformScale(firstFBXCluster.inverseBindMatrix);
             glm::mat4 meshToJoint = glm::inverse(joint.bindTransform) * modelTransform;
-            ShapeVertices& points = shapeVertices.at(jointIndex);
+            ShapeVertices& points = skinning.shapePoints[jointIndex];
             foreach (const glm::vec3& vertex, extracted.mesh.vertices) {
                 const glm::mat4 vertexTransform = meshToJoint * glm::translate(vertex);
                 points.push_back(extractTranslation(vertexTransform) * clusterScale);
@@ -1757,12 +1827,28 @@ FBXGeometry* FBXReader::extractFBXGeometry(const QVariantHash& mapping, const QS
             }
         }
         buildModelMesh(extracted.mesh, url);
+    });
+
+    // join the meshes back, in order
+    for (auto& skinning : meshSkinnings) {
+        const FBXMesh& mesh = skinning.extracted->mesh;
 
-        geometry.meshes.append(extracted.mesh);
+        geometry.meshExtents.minimum = glm::min(geometry.meshExtents.minimum, mesh.meshExtents.minimum);
+        geometry.meshExtents.maximum = glm::max(geometry.meshExtents.maximum, mesh.meshExtents.maximum);
+
+        for (auto& jointPoints : skinning.shapePoints) {
+            ShapeVertices& points = shapeVertices.at(jointPoints.first);
+            points.insert(points.end(), jointPoints.second.begin(), jointPoints.second.end());
+        }
+
+        geometry.meshes.append(mesh);
         int meshIndex = geometry.meshes.size() - 1;
-        meshIDsToMeshIndices.insert(it.key(), meshIndex);
+        meshIDsToMeshIndices.insert(skinning.meshID, meshIndex);
     }
 
+    _extractionTimes.skinning = usecTimestampNow() - stageStart;
+    stageStart = usecTimestampNow();
+
     const float INV_SQRT_3 = 0.57735026918f;
     ShapeVertices cardinalDirections = {
         Vectors::UNIT_X,
@@ -1813,6 +1899,8 @@ FBXGeometry* FBXReader::extractFBXGeometry(const QVariantHash& mapping, const QS
     }
     geometry.palmDirection = parseVec3(mapping.value("palmDirection", "0, -1, 0").toString());
 
+    _extractionTimes.shapes = usecTimestampNow() - stageStart;
+
     // attempt to map any meshes to a named model
     for (QHash<QString, int>::const_iterator m = meshIDsToMeshIndices.constBegin();
             m != meshIDsToMeshIndices.constEnd(); m++) {
@@ -1840,7 +1928,7 @@ FBXGeometry* readFBX(const QByteArray& model, const QVariantHash& mapping, const
 
 FBXGeometry* readFBX(QIODevice* device, const QVariantHash& mapping, const QString& url, bool loadLightmaps, float lightmapLevel) {
     FBXReader reader;
-    reader._fbxNode = FBXReader::parseFBX(device);
+    reader._fbxNode = FBXReader::parseFBX(device, true);
     reader._loadLightmaps = loadLightmaps;
     reader._lightmapLevel = lightmapLevel;
 
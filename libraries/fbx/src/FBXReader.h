@@ -398,15 +398,31 @@ public:
 
 class ExtractedMesh;
 
+/// How long each stage of FBXReader::extractFBXGeometry took, in microseconds
+class FBXExtractionTimes {
+public:
+    quint64 objects { 0 };  // reading the object nodes
+    quint64 meshes { 0 };  // extracting the meshes from their geometry nodes
+    quint64 joints { 0 };  // blendshapes, joints and materials
+    quint64 skinning { 0 };  // clusters, tangents, skinning weights and model meshes
+    quint64 shapes { 0 };  // joint shape info
+};
+
 class FBXReader {
 public:
     FBXGeometry* _fbxGeometry;
 
     FBXNode _fbxNode;
-    static FBXNode parseFBX(QIODevice* device);
+
+    /// Parses the node tree of a text or binary FBX document. When skipUnusedSections is set, the top level sections
+    /// that extractFBXGeometry doesn't use are left out of binary documents.
+    static FBXNode parseFBX(QIODevice* device, bool skipUnusedSections = false);
 
     FBXGeometry* extractFBXGeometry(const QVariantHash& mapping, const QString& url);
 
+    /// The stage timings of the last call to extractFBXGeometry
+    FBXExtractionTimes _extractionTimes;
+
     ExtractedMesh extractMesh(const FBXNode& object, unsigned int& meshIndex);
     QHash<QString, ExtractedMesh> meshes;
     static void buildModelMesh(FBXMesh& extractedMesh, const QString& url);
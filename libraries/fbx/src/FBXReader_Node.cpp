@@ -11,192 +11,182 @@
 
 #include "FBXReader.h"
 
+#include <algorithm>
 #include <iostream>
+#include <vector>
+
+#include <QtConcurrent/QtConcurrentMap>
 #include <QtCore/QBuffer>
-#include <QtCore/QDataStream>
+#include <QtCore/QFileDevice>
 #include <QtCore/QIODevice>
+#include <QtCore/QSet>
 #include <QtCore/QStringList>
 #include <QtCore/QTextStream>
 #include <QtCore/QDebug>
 #include <QtCore/QtEndian>
 #include <QtCore/QFileInfo>
 
+#include <zlib.h>
+
 #include <shared/NsightHelpers.h>
 #include "ModelFormatLogging.h"
 
-template<class T> int streamSize() {
-    return sizeof(T);
+// Parses the node tree of a binary FBX file straight out of its data (a memory mapped file or the buffer it was
+// downloaded to), without going through a QDataStream or copying the array properties around.
+// Deflated arrays are only allocated during the parse, they are all inflated afterwards, in parallel, directly into
+// the QVector held by their property.
+class BinaryFBXParser {
+public:
+    BinaryFBXParser(const char* data, qint64 size, bool has64BitPositions, bool skipUnusedSections) :
+        _data(data), _size(size), _has64BitPositions(has64BitPositions), _skipUnusedSections(skipUnusedSections) {}
+
+    FBXNode parse(qint64 position);
+
+private:
+    struct DeflatedArray {
+        const char* compressedData;
+        quint32 compressedLength;
+        char* destination; // the data of the QVector boxed in the property
+        qint64 length;
+        int elementSize;
+        bool failed;
+    };
+
+    const char* take(qint64 length);
+    template<class T> T read();
+
+    FBXNode parseNode(int depth);
+    QVariant parseProperty();
+    template<class T> QVariant parseArray();
+
+    void inflateArrays();
+    static void inflateArray(DeflatedArray& array);
+
+    const char* _data;
+    qint64 _size;
+    qint64 _position { 0 };
+    bool _has64BitPositions;
+    bool _skipUnusedSections;
+
+    std::vector<DeflatedArray> _deflatedArrays;
+};
+
+// top level sections that FBXReader::extractFBXGeometry never looks at, "Takes" holds the FBX 6 animations
+static const QSet<QByteArray> UNUSED_TOP_LEVEL_SECTIONS { "Documents", "References", "Definitions", "Takes" };
+
+// zlib can't do better than about 1032:1, anything above that is a corrupt array length
+static const quint64 MAX_DEFLATE_RATIO = 1032;
+
+// below this much compressed data, the arrays are inflated on the parsing thread
+static const qint64 MIN_PARALLEL_INFLATE_SIZE = 256 * 1024;
+
+template<class T> static void swapToHostOrder(char* data, qint64 count) {
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+    for (qint64 i = 0; i < count; ++i) {
+        std::reverse(data + i * sizeof(T), data + (i + 1) * sizeof(T));
+    }
+#else
+    Q_UNUSED(data);
+    Q_UNUSED(count);
+#endif
 }
 
-template<bool> int streamSize() {
-    return 1;
+const char* BinaryFBXParser::take(qint64 length) {
+    if (length < 0 || length > _size - _position) {
+        throw QString("corrupt fbx file");
+    }
+    auto data = _data + _position;
+    _position += length;
+    return data;
 }
 
-template<class T> QVariant readBinaryArray(QDataStream& in, int& position) {
-    quint32 arrayLength;
-    quint32 encoding;
-    quint32 compressedLength;
-
-    in >> arrayLength;
-    in >> encoding;
-    in >> compressedLength;
-    position += sizeof(quint32) * 3;
-
-    QVector<T> values;
-    if ((int)QSysInfo::ByteOrder == (int)in.byteOrder()) {
-        values.resize(arrayLength);
-        const unsigned int DEFLATE_ENCODING = 1;
-        QByteArray arrayData;
-        if (encoding == DEFLATE_ENCODING) {
-            // preface encoded data with uncompressed length
-            QByteArray compressed(sizeof(quint32) + compressedLength, 0);
-            *((quint32*)compressed.data()) = qToBigEndian<quint32>(arrayLength * sizeof(T));
-            in.readRawData(compressed.data() + sizeof(quint32), compressedLength);
-            position += compressedLength;
-            arrayData = qUncompress(compressed);
-            if (arrayData.isEmpty() ||
-                (unsigned int)arrayData.size() != (sizeof(T) * arrayLength)) { // answers empty byte array if corrupt
-                throw QString("corrupt fbx file");
-            }
-        } else {
-            arrayData.resize(sizeof(T) * arrayLength);
-            position += sizeof(T) * arrayLength;
-            in.readRawData(arrayData.data(), arrayData.size());
-        }
+template<class T> T BinaryFBXParser::read() {
+    T value;
+    memcpy(&value, take(sizeof(T)), sizeof(T));
+    swapToHostOrder<T>(reinterpret_cast<char*>(&value), 1);
+    return value;
+}
 
-        if (arrayData.size() > 0) {
-            memcpy(&values[0], arrayData.constData(), arrayData.size());
-        }
-    } else {
-        values.reserve(arrayLength);
-        const unsigned int DEFLATE_ENCODING = 1;
-        if (encoding == DEFLATE_ENCODING) {
-            // preface encoded data with uncompressed length
-            QByteArray compressed(sizeof(quint32) + compressedLength, 0);
-            *((quint32*)compressed.data()) = qToBigEndian<quint32>(arrayLength * sizeof(T));
-            in.readRawData(compressed.data() + sizeof(quint32), compressedLength);
-            position += compressedLength;
-            QByteArray uncompressed = qUncompress(compressed);
-            if (uncompressed.isEmpty()) { // answers empty byte array if corrupt
-                throw QString("corrupt fbx file");
-            }
-            QDataStream uncompressedIn(uncompressed);
-            uncompressedIn.setByteOrder(QDataStream::LittleEndian);
-            uncompressedIn.setVersion(QDataStream::Qt_4_5); // for single/double precision switch
-            for (quint32 i = 0; i < arrayLength; i++) {
-                T value;
-                uncompressedIn >> value;
-                values.append(value);
-            }
-        } else {
-            for (quint32 i = 0; i < arrayLength; i++) {
-                T value;
-                in >> value;
-                position += streamSize<T>();
-                values.append(value);
-            }
+template<class T> QVariant BinaryFBXParser::parseArray() {
+    auto arrayLength = read<quint32>();
+    auto encoding = read<quint32>();
+    auto compressedLength = read<quint32>();
+
+    const quint32 DEFLATE_ENCODING = 1;
+    qint64 length = (qint64)arrayLength * sizeof(T);
+
+    if (encoding == DEFLATE_ENCODING && (quint64)length > MAX_DEFLATE_RATIO * compressedLength) {
+        throw QString("corrupt fbx file");
+    }
+
+    QVector<T> values(arrayLength);
+
+    if (encoding == DEFLATE_ENCODING) {
+        auto compressedData = take(compressedLength);
+
+        // the QVariant shares the vector data, which is written to once the whole tree is parsed
+        if (length > 0) {
+            _deflatedArrays.push_back({ compressedData, compressedLength, reinterpret_cast<char*>(values.data()),
+                                        length, (int)sizeof(T), false });
         }
+    } else if (length > 0) {
+        memcpy(values.data(), take(length), length);
+        swapToHostOrder<T>(reinterpret_cast<char*>(values.data()), arrayLength);
     }
+
     return QVariant::fromValue(values);
 }
 
-QVariant parseBinaryFBXProperty(QDataStream& in, int& position) {
-    char ch;
-    in.device()->getChar(&ch);
-    position++;
+QVariant BinaryFBXParser::parseProperty() {
+    char ch = *take(1);
     switch (ch) {
-        case 'Y': {
-            qint16 value;
-            in >> value;
-            position += sizeof(qint16);
-            return QVariant::fromValue(value);
-        }
-        case 'C': {
-            bool value;
-            in >> value;
-            position++;
-            return QVariant::fromValue(value);
-        }
-        case 'I': {
-            qint32 value;
-            in >> value;
-            position += sizeof(qint32);
-            return QVariant::fromValue(value);
-        }
-        case 'F': {
-            float value;
-            in >> value;
-            position += sizeof(float);
-            return QVariant::fromValue(value);
-        }
-        case 'D': {
-            double value;
-            in >> value;
-            position += sizeof(double);
-            return QVariant::fromValue(value);
-        }
-        case 'L': {
-            qint64 value;
-            in >> value;
-            position += sizeof(qint64);
-            return QVariant::fromValue(value);
-        }
-        case 'f': {
-            return readBinaryArray<float>(in, position);
-        }
-        case 'd': {
-            return readBinaryArray<double>(in, position);
-        }
-        case 'l': {
-            return readBinaryArray<qint64>(in, position);
-        }
-        case 'i': {
-            return readBinaryArray<qint32>(in, position);
-        }
-        case 'b': {
-            return readBinaryArray<bool>(in, position);
-        }
+        case 'Y':
+            return QVariant::fromValue(read<qint16>());
+        case 'C':
+            return QVariant::fromValue(read<quint8>() != 0);
+        case 'I':
+            return QVariant::fromValue(read<qint32>());
+        case 'F':
+            return QVariant::fromValue(read<float>());
+        case 'D':
+            return QVariant::fromValue(read<double>());
+        case 'L':
+            return QVariant::fromValue(read<qint64>());
+        case 'f':
+            return parseArray<float>();
+        case 'd':
+            return parseArray<double>();
+        case 'l':
+            return parseArray<qint64>();
+        case 'i':
+            return parseArray<qint32>();
+        case 'b':
+            return parseArray<bool>();
         case 'S':
         case 'R': {
-            quint32 length;
-            in >> length;
-            position += sizeof(quint32) + length;
-            return QVariant::fromValue(in.device()->read(length));
+            auto length = read<quint32>();
+            return QVariant::fromValue(QByteArray(take(length), length));
         }
         default:
             throw QString("Unknown property type: ") + ch;
     }
 }
 
-FBXNode parseBinaryFBXNode(QDataStream& in, int& position, bool has64BitPositions = false) {
+FBXNode BinaryFBXParser::parseNode(int depth) {
     qint64 endOffset;
     quint64 propertyCount;
-    quint64 propertyListLength;
-    quint8 nameLength;
 
     // FBX 2016 and beyond uses 64bit positions in the node headers, pre-2016 used 32bit values
-    // our code generally doesn't care about the size that much, so we will use 64bit values
-    // from here on out, but if the file is an older format we read the stream into temp 32bit 
-    // values and then assign to our actual 64bit values.
-    if (has64BitPositions) {
-        in >> endOffset;
-        in >> propertyCount;
-        in >> propertyListLength;
-        position += sizeof(quint64) * 3;
+    if (_has64BitPositions) {
+        endOffset = read<qint64>();
+        propertyCount = read<quint64>();
+        read<quint64>(); // property list length
     } else {
-        qint32 tempEndOffset;
-        quint32 tempPropertyCount;
-        quint32 tempPropertyListLength;
-        in >> tempEndOffset;
-        in >> tempPropertyCount;
-        in >> tempPropertyListLength;
-        position += sizeof(quint32) * 3;
-        endOffset = tempEndOffset;
-        propertyCount = tempPropertyCount;
-        propertyListLength = tempPropertyListLength;
-    }
-    in >> nameLength;
-    position += sizeof(quint8);
+        endOffset = read<qint32>();
+        propertyCount = read<quint32>();
+        read<quint32>(); // property list length
+    }
+    auto nameLength = read<quint8>();
 
     FBXNode node;
     const int MIN_VALID_OFFSET = 40;
@@ -204,15 +194,20 @@ FBXNode parseBinaryFBXNode(QDataStream& in, int& position, bool has64BitPosition
         // use a null name to indicate a null node
         return node;
     }
-    node.name = in.device()->read(nameLength);
-    position += nameLength;
+    node.name = QByteArray(take(nameLength), nameLength);
+
+    if (depth == 0 && _skipUnusedSections && UNUSED_TOP_LEVEL_SECTIONS.contains(node.name)) {
+        // jump over the whole section, the caller drops it
+        take(endOffset - _position);
+        return node;
+    }
 
-    for (quint32 i = 0; i < propertyCount; i++) {
-        node.properties.append(parseBinaryFBXProperty(in, position));
+    for (quint64 i = 0; i < propertyCount; i++) {
+        node.properties.append(parseProperty());
     }
 
-    while (endOffset > position) {
-        FBXNode child = parseBinaryFBXNode(in, position, has64BitPositions);
+    while (endOffset > _position) {
+        FBXNode child = parseNode(depth + 1);
         if (child.name.isNull()) {
             return node;
 
@@ -224,6 +219,65 @@ FBXNode parseBinaryFBXNode(QDataStream& in, int& position, bool has64BitPosition
     return node;
 }
 
+FBXNode BinaryFBXParser::parse(qint64 position) {
+    _position = position;
+
+    // parse the top-level node
+    FBXNode top;
+    while (_position < _size) {
+        FBXNode next = parseNode(0);
+        if (next.name.isNull()) {
+            break;
+
+        } else if (!_skipUnusedSections || !UNUSED_TOP_LEVEL_SECTIONS.contains(next.name)) {
+            top.children.append(next);
+        }
+    }
+
+    inflateArrays();
+
+    return top;
+}
+
+void BinaryFBXParser::inflateArray(DeflatedArray& array) {
+    uLongf length = array.length;
+    int result = uncompress(reinterpret_cast<Bytef*>(array.destination), &length,
+                            reinterpret_cast<const Bytef*>(array.compressedData), array.compressedLength);
+
+    array.failed = (result != Z_OK || (qint64)length != array.length);
+
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+    for (qint64 i = 0; i < array.length; i += array.elementSize) {
+        std::reverse(array.destination + i, array.destination + i + array.elementSize);
+    }
+#endif
+}
+
+void BinaryFBXParser::inflateArrays() {
+    PROFILE_RANGE(resource_parse, "inflateFBXArrays");
+
+    qint64 compressedSize = 0;
+    for (const auto& array : _deflatedArrays) {
+        compressedSize += array.compressedLength;
+    }
+
+    if (compressedSize < MIN_PARALLEL_INFLATE_SIZE) {
+        for (auto& array : _deflatedArrays) {
+            inflateArray(array);
+        }
+    } else {
+        // the calling thread takes part in the work, so this is safe from a thread of the same pool
+        QtConcurrent::blockingMap(_deflatedArrays, &BinaryFBXParser::inflateArray);
+    }
+
+    for (const auto& array : _deflatedArrays) {
+        if (array.failed) {
+            throw QString("corrupt fbx file");
+        }
+    }
+    _deflatedArrays.clear();
+}
+
 class Tokenizer {
 public:
 
@@ -347,7 +401,7 @@ FBXNode parseTextFBXNode(Tokenizer& tokenizer) {
     return node;
 }
 
-FBXNode FBXReader::parseFBX(QIODevice* device) {
+FBXNode FBXReader::parseFBX(QIODevice* device, bool skipUnusedSections) {
     PROFILE_RANGE_EX(resource_parse, __FUNCTION__, 0xff0000ff, device);
     // verify the prolog
     const QByteArray BINARY_PROLOG = "Kaydara FBX Binary  ";
@@ -366,9 +420,25 @@ FBXNode FBXReader::parseFBX(QIODevice* device) {
         }
         return top;
     }
-    QDataStream in(device);
-    in.setByteOrder(QDataStream::LittleEndian);
-    in.setVersion(QDataStream::Qt_4_5); // for single/double precision switch
+    // Parse straight from the file data. Models are usually downloaded to a buffer that we can use as is,
+    // files get memory mapped and anything else is read in whole.
+    QByteArray storage;
+    const char* data = nullptr;
+    qint64 size = device->size() - device->pos();
+    uchar* mappedFile = nullptr;
+
+    auto buffer = qobject_cast<QBuffer*>(device);
+    auto file = qobject_cast<QFileDevice*>(device);
+
+    if (buffer) {
+        data = buffer->data().constData() + buffer->pos();
+    } else if (file && (mappedFile = file->map(file->pos(), size))) {
+        data = reinterpret_cast<const char*>(mappedFile);
+    } else {
+        storage = device->readAll();
+        data = storage.constData();
+        size = storage.size();
+    }
 
     // see http://code.blender.org/index.php/2013/08/fbx-binary-file-format-specification/ for an explanation
     // of the FBX binary format
@@ -378,25 +448,32 @@ FBXNode FBXReader::parseFBX(QIODevice* device) {
     //   Bytes 21 - 22: [0x1A, 0x00](unknown but all observed files show these bytes).
     //   Bytes 23 - 26 : unsigned int, the version number. 7300 for version 7.3 for example.
     const int HEADER_BEFORE_VERSION = 23;
+    const int HEADER_SIZE = 27;
     const quint32 VERSION_FBX2016 = 7500;
-    in.skipRawData(HEADER_BEFORE_VERSION);
-    int position = HEADER_BEFORE_VERSION;
-    quint32 fileVersion;
-    in >> fileVersion;
-    position += sizeof(fileVersion);
+
+    if (size < HEADER_SIZE) {
+        throw QString("corrupt fbx file");
+    }
+
+    quint32 fileVersion = qFromLittleEndian<quint32>(reinterpret_cast<const uchar*>(data + HEADER_BEFORE_VERSION));
     qCDebug(modelformat) << "fileVersion:" << fileVersion;
     bool has64BitPositions = (fileVersion >= VERSION_FBX2016);
 
-    // parse the top-level node
-    FBXNode top;
-    while (device->bytesAvailable()) {
-        FBXNode next = parseBinaryFBXNode(in, position, has64BitPositions);
-        if (next.name.isNull()) {
-            return top;
+    BinaryFBXParser parser(data, size, has64BitPositions, skipUnusedSections);
 
-        } else {
-            top.children.append(next);
+    FBXNode top;
+    try {
+        top = parser.parse(HEADER_SIZE);
+    } catch (...) {
+        if (mappedFile) {
+            file->unmap(mappedFile);
         }
+        throw;
+    }
+
+    // every property was copied out of the file data by now
+    if (mappedFile) {
+        file->unmap(mappedFile);
     }
 
     return top;
@@ -0,0 +1,482 @@
+//
+//  FBXSerializer.cpp
+//  libraries/fbx/src
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "FBXSerializer.h"
+
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include <QBuffer>
+#include <QDataStream>
+
+#include "ModelFormatLogging.h"
+
+static const quint32 FBX_SERIALIZATION_MAGIC = 0x48464247; // "HFBG"
+const quint32 FBX_SERIALIZATION_VERSION = 1;
+
+namespace {
+
+class GeometryWriter {
+public:
+    GeometryWriter(QByteArray& data) : _stream(&data, QIODevice::WriteOnly) {}
+
+    template <typename T>
+    void writeArray(const T* data, int count) {
+        static_assert(std::is_trivially_copyable<T>::value, "arrays are written as raw memory");
+        _stream << (qint32)count;
+        _stream.writeRawData(reinterpret_cast<const char*>(data), count * (int)sizeof(T));
+    }
+
+    template <typename T>
+    void write(const QVector<T>& vector) { writeArray(vector.constData(), vector.size()); }
+
+    template <typename T>
+    void write(const std::vector<T>& vector) { writeArray(vector.data(), (int)vector.size()); }
+
+    template <typename T>
+    void writeValue(const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "values are written as raw memory");
+        _stream.writeRawData(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    void write(const Extents& extents) {
+        writeValue(extents.minimum);
+        writeValue(extents.maximum);
+    }
+
+    void write(const Transform& transform) {
+        writeValue(transform.getTranslation());
+        writeValue(transform.getRotation());
+        writeValue(transform.getScale());
+    }
+
+    void write(const FBXTexture& texture) {
+        _stream << texture.name << texture.filename << texture.content;
+        write(texture.transform);
+        _stream << (qint32)texture.maxNumPixels << (qint32)texture.texcoordSet << texture.texcoordSetName
+            << texture.isBumpmap;
+    }
+
+    void write(const FBXMaterial& material) {
+        writeValue(material.diffuseColor);
+        writeValue(material.specularColor);
+        writeValue(material.emissiveColor);
+        writeValue(material.lightmapParams);
+        _stream << material.diffuseFactor << material.specularFactor << material.emissiveFactor << material.shininess
+            << material.opacity << material.metallic << material.roughness << material.emissiveIntensity
+            << material.ambientFactor;
+        _stream << material.materialID << material.name << material.shadingModel;
+
+        for (auto texture : { &material.normalTexture, &material.albedoTexture, &material.opacityTexture,
+                &material.glossTexture, &material.roughnessTexture, &material.specularTexture, &material.metallicTexture,
+                &material.emissiveTexture, &material.occlusionTexture, &material.scatteringTexture,
+                &material.lightmapTexture }) {
+            write(*texture);
+        }
+
+        _stream << material.isPBSMaterial << material.useNormalMap << material.useAlbedoMap << material.useOpacityMap
+            << material.useRoughnessMap << material.useSpecularMap << material.useMetallicMap << material.useEmissiveMap
+            << material.useOcclusionMap;
+
+        // the readers derive the model material from the properties above in ways that can't be replayed from
+        // them alone, so the resulting values are kept instead
+        bool hasModelMaterial = (bool)material._material;
+        _stream << hasModelMaterial;
+        if (hasModelMaterial) {
+            const auto& modelMaterial = *material._material;
+            writeValue(modelMaterial.getEmissive(false));
+            writeValue(modelMaterial.getAlbedo(false));
+            _stream << modelMaterial.getRoughness() << modelMaterial.getMetallic() << modelMaterial.getScattering()
+                << modelMaterial.getOpacity() << modelMaterial.isUnlit() << modelMaterial.getKey().isMetallic();
+        }
+    }
+
+    void write(const FBXJoint& joint) {
+        writeValue(joint.shapeInfo.avgPoint);
+        write(joint.shapeInfo.dots);
+        write(joint.shapeInfo.points);
+        write(joint.shapeInfo.debugLines);
+        write(joint.freeLineage);
+        _stream << joint.isFree << (qint32)joint.parentIndex << joint.distanceToParent;
+        writeValue(joint.translation);
+        writeValue(joint.preTransform);
+        writeValue(joint.preRotation);
+        writeValue(joint.rotation);
+        writeValue(joint.postRotation);
+        writeValue(joint.postTransform);
+        writeValue(joint.transform);
+        writeValue(joint.rotationMin);
+        writeValue(joint.rotationMax);
+        writeValue(joint.inverseDefaultRotation);
+        writeValue(joint.inverseBindRotation);
+        writeValue(joint.bindTransform);
+        _stream << joint.name << joint.isSkeletonJoint << joint.bindTransformFoundInCluster << joint.hasGeometricOffset;
+        writeValue(joint.geometricTranslation);
+        writeValue(joint.geometricRotation);
+        writeValue(joint.geometricScaling);
+    }
+
+    void write(const FBXMesh& mesh) {
+        _stream << (qint32)mesh.parts.size();
+        for (const auto& part : mesh.parts) {
+            write(part.quadIndices);
+            write(part.quadTrianglesIndices);
+            write(part.triangleIndices);
+            _stream << part.materialID;
+        }
+
+        write(mesh.vertices);
+        write(mesh.normals);
+        write(mesh.tangents);
+        write(mesh.colors);
+        write(mesh.texCoords);
+        write(mesh.texCoords1);
+        write(mesh.clusterIndices);
+        write(mesh.clusterWeights);
+
+        _stream << (qint32)mesh.clusters.size();
+        for (const auto& cluster : mesh.clusters) {
+            _stream << (qint32)cluster.jointIndex;
+            writeValue(cluster.inverseBindMatrix);
+        }
+
+        write(mesh.meshExtents);
+        writeValue(mesh.modelTransform);
+
+        _stream << (qint32)mesh.blendshapes.size();
+        for (const auto& blendshape : mesh.blendshapes) {
+            write(blendshape.indices);
+            write(blendshape.vertices);
+            write(blendshape.normals);
+        }
+
+        _stream << (quint32)mesh.meshIndex;
+    }
+
+    void write(const FBXGeometry& geometry) {
+        _stream << FBX_SERIALIZATION_MAGIC << FBX_SERIALIZATION_VERSION;
+
+        _stream << geometry.originalURL << geometry.author << geometry.applicationName;
+
+        _stream << (qint32)geometry.joints.size();
+        for (const auto& joint : geometry.joints) {
+            write(joint);
+        }
+        _stream << geometry.jointIndices << geometry.hasSkeletonJoints;
+
+        _stream << (qint32)geometry.meshes.size();
+        for (const auto& mesh : geometry.meshes) {
+            write(mesh);
+        }
+
+        _stream << (qint32)geometry.materials.size();
+        for (auto it = geometry.materials.constBegin(); it != geometry.materials.constEnd(); ++it) {
+            _stream << it.key();
+            write(it.value());
+        }
+
+        writeValue(geometry.offset);
+        for (auto index : { geometry.leftEyeJointIndex, geometry.rightEyeJointIndex, geometry.neckJointIndex,
+                geometry.rootJointIndex, geometry.leanJointIndex, geometry.headJointIndex, geometry.leftHandJointIndex,
+                geometry.rightHandJointIndex, geometry.leftToeJointIndex, geometry.rightToeJointIndex }) {
+            _stream << (qint32)index;
+        }
+        _stream << geometry.leftEyeSize << geometry.rightEyeSize;
+        write(geometry.humanIKJointIndices);
+        writeValue(geometry.palmDirection);
+        writeValue(geometry.neckPivot);
+        write(geometry.bindExtents);
+        write(geometry.meshExtents);
+
+        _stream << (qint32)geometry.animationFrames.size();
+        for (const auto& frame : geometry.animationFrames) {
+            write(frame.rotations);
+            write(frame.translations);
+        }
+
+        _stream << geometry.meshIndicesToModelNames << geometry.blendshapeChannelNames;
+    }
+
+    bool succeeded() const { return _stream.status() == QDataStream::Ok; }
+
+private:
+    QDataStream _stream;
+};
+
+class GeometryReader {
+public:
+    GeometryReader(QIODevice* device) : _stream(device) {}
+
+    bool failed() const { return _stream.status() != QDataStream::Ok; }
+
+    // Reads a count, rejecting any that couldn't fit in what is left of the data
+    int readCount(int elementSize) {
+        qint32 count { 0 };
+        _stream >> count;
+        if (count < 0 || (qint64)count * elementSize > _stream.device()->bytesAvailable()) {
+            _stream.setStatus(QDataStream::ReadCorruptData);
+            return 0;
+        }
+        return count;
+    }
+
+    template <typename T>
+    void readArray(T* data, int count) {
+        static_assert(std::is_trivially_copyable<T>::value, "arrays are read as raw memory");
+        int length = count * (int)sizeof(T);
+        if (_stream.readRawData(reinterpret_cast<char*>(data), length) != length) {
+            _stream.setStatus(QDataStream::ReadPastEnd);
+        }
+    }
+
+    template <typename T>
+    void read(QVector<T>& vector) {
+        vector.resize(readCount(sizeof(T)));
+        readArray(vector.data(), vector.size());
+    }
+
+    template <typename T>
+    void read(std::vector<T>& vector) {
+        vector.resize(readCount(sizeof(T)));
+        readArray(vector.data(), (int)vector.size());
+    }
+
+    template <typename T>
+    void readValue(T& value) { readArray(&value, 1); }
+
+    qint32 readInt() {
+        qint32 value { 0 };
+        _stream >> value;
+        return value;
+    }
+
+    void read(Extents& extents) {
+        readValue(extents.minimum);
+        readValue(extents.maximum);
+    }
+
+    void read(Transform& transform) {
+        glm::vec3 translation;
+        glm::quat rotation;
+        glm::vec3 scale;
+        readValue(translation);
+        readValue(rotation);
+        readValue(scale);
+        transform.setTranslation(translation);
+        transform.setRotation(rotation);
+        transform.setScale(scale);
+    }
+
+    void read(FBXTexture& texture) {
+        _stream >> texture.name >> texture.filename >> texture.content;
+        read(texture.transform);
+        texture.maxNumPixels = readInt();
+        texture.texcoordSet = readInt();
+        _stream >> texture.texcoordSetName >> texture.isBumpmap;
+    }
+
+    void read(FBXMaterial& material) {
+        readValue(material.diffuseColor);
+        readValue(material.specularColor);
+        readValue(material.emissiveColor);
+        readValue(material.lightmapParams);
+        _stream >> material.diffuseFactor >> material.specularFactor >> material.emissiveFactor >> material.shininess
+            >> material.opacity >> material.metallic >> material.roughness >> material.emissiveIntensity
+            >> material.ambientFactor;
+        _stream >> material.materialID >> material.name >> material.shadingModel;
+
+        for (auto texture : { &material.normalTexture, &material.albedoTexture, &material.opacityTexture,
+                &material.glossTexture, &material.roughnessTexture, &material.specularTexture, &material.metallicTexture,
+                &material.emissiveTexture, &material.occlusionTexture, &material.scatteringTexture,
+                &material.lightmapTexture }) {
+            read(*texture);
+        }
+
+        _stream >> material.isPBSMaterial >> material.useNormalMap >> material.useAlbedoMap >> material.useOpacityMap
+            >> material.useRoughnessMap >> material.useSpecularMap >> material.useMetallicMap >> material.useEmissiveMap
+            >> material.useOcclusionMap;
+
+        bool hasModelMaterial { false };
+        _stream >> hasModelMaterial;
+        if (hasModelMaterial) {
+            glm::vec3 emissive;
+            glm::vec3 albedo;
+            float roughness, metallic, scattering, opacity;
+            bool unlit, metallicKey;
+            readValue(emissive);
+            readValue(albedo);
+            _stream >> roughness >> metallic >> scattering >> opacity >> unlit >> metallicKey;
+
+            auto modelMaterial = std::make_shared<model::Material>();
+            modelMaterial->setEmissive(emissive, false);
+            modelMaterial->setAlbedo(albedo, false);
+            modelMaterial->setRoughness(roughness);
+            modelMaterial->setMetallic(metallic);
+            // setScattering also drives the metallic bit of the key, so replay it if it was the last one to do so
+            if (scattering > 0.0f || metallicKey != (metallic > 0.0f)) {
+                modelMaterial->setScattering(scattering);
+            }
+            modelMaterial->setOpacity(opacity);
+            modelMaterial->setUnlit(unlit);
+            material._material = modelMaterial;
+        }
+    }
+
+    void read(FBXJoint& joint) {
+        readValue(joint.shapeInfo.avgPoint);
+        read(joint.shapeInfo.dots);
+        read(joint.shapeInfo.points);
+        read(joint.shapeInfo.debugLines);
+        read(joint.freeLineage);
+        _stream >> joint.isFree;
+        joint.parentIndex = readInt();
+        _stream >> joint.distanceToParent;
+        readValue(joint.translation);
+        readValue(joint.preTransform);
+        readValue(joint.preRotation);
+        readValue(joint.rotation);
+        readValue(joint.postRotation);
+        readValue(joint.postTransform);
+        readValue(joint.transform);
+        readValue(joint.rotationMin);
+        readValue(joint.rotationMax);
+        readValue(joint.inverseDefaultRotation);
+        readValue(joint.inverseBindRotation);
+        readValue(joint.bindTransform);
+        _stream >> joint.name >> joint.isSkeletonJoint >> joint.bindTransformFoundInCluster >> joint.hasGeometricOffset;
+        readValue(joint.geometricTranslation);
+        readValue(joint.geometricRotation);
+        readValue(joint.geometricScaling);
+    }
+
+    void read(FBXMesh& mesh) {
+        mesh.parts.resize(readCount(sizeof(qint32)));
+        for (auto& part : mesh.parts) {
+            read(part.quadIndices);
+            read(part.quadTrianglesIndices);
+            read(part.triangleIndices);
+            _stream >> part.materialID;
+        }
+
+        read(mesh.vertices);
+        read(mesh.normals);
+        read(mesh.tangents);
+        read(mesh.colors);
+        read(mesh.texCoords);
+        read(mesh.texCoords1);
+        read(mesh.clusterIndices);
+        read(mesh.clusterWeights);
+
+        mesh.clusters.resize(readCount(sizeof(qint32)));
+        for (auto& cluster : mesh.clusters) {
+            cluster.jointIndex = readInt();
+            readValue(cluster.inverseBindMatrix);
+        }
+
+        read(mesh.meshExtents);
+        readValue(mesh.modelTransform);
+
+        mesh.blendshapes.resize(readCount(sizeof(qint32)));
+        for (auto& blendshape : mesh.blendshapes) {
+            read(blendshape.indices);
+            read(blendshape.vertices);
+            read(blendshape.normals);
+        }
+
+        mesh.meshIndex = (unsigned int)readInt();
+    }
+
+    bool read(FBXGeometry& geometry) {
+        quint32 magic { 0 };
+        quint32 version { 0 };
+        _stream >> magic >> version;
+        if (magic != FBX_SERIALIZATION_MAGIC || version != FBX_SERIALIZATION_VERSION) {
+            return false;
+        }
+
+        _stream >> geometry.originalURL >> geometry.author >> geometry.applicationName;
+
+        geometry.joints.resize(readCount(sizeof(qint32)));
+        for (auto& joint : geometry.joints) {
+            read(joint);
+        }
+        _stream >> geometry.jointIndices >> geometry.hasSkeletonJoints;
+
+        geometry.meshes.resize(readCount(sizeof(qint32)));
+        for (auto& mesh : geometry.meshes) {
+            read(mesh);
+        }
+
+        int numMaterials = readCount(sizeof(qint32));
+        for (int i = 0; i < numMaterials && !failed(); ++i) {
+            QString materialID;
+            _stream >> materialID;
+            read(geometry.materials[materialID]);
+        }
+
+        readValue(geometry.offset);
+        for (auto index : { &geometry.leftEyeJointIndex, &geometry.rightEyeJointIndex, &geometry.neckJointIndex,
+                &geometry.rootJointIndex, &geometry.leanJointIndex, &geometry.headJointIndex, &geometry.leftHandJointIndex,
+                &geometry.rightHandJointIndex, &geometry.leftToeJointIndex, &geometry.rightToeJointIndex }) {
+            *index = readInt();
+        }
+        _stream >> geometry.leftEyeSize >> geometry.rightEyeSize;
+        read(geometry.humanIKJointIndices);
+        readValue(geometry.palmDirection);
+        readValue(geometry.neckPivot);
+        read(geometry.bindExtents);
+        read(geometry.meshExtents);
+
+        geometry.animationFrames.resize(readCount(sizeof(qint32)));
+        for (auto& frame : geometry.animationFrames) {
+            read(frame.rotations);
+            read(frame.translations);
+        }
+
+        _stream >> geometry.meshIndicesToModelNames >> geometry.blendshapeChannelNames;
+
+        return !failed() && _stream.atEnd();
+    }
+
+private:
+    QDataStream _stream;
+};
+
+}
+
+QByteArray serializeFBXGeometry(const FBXGeometry& geometry) {
+    QByteArray data;
+    GeometryWriter writer(data);
+    writer.write(geometry);
+
+    if (!writer.succeeded()) {
+        return QByteArray();
+    }
+    return data;
+}
+
+FBXGeometry* unserializeFBXGeometry(const QByteArray& data, const QString& url) {
+    QBuffer buffer(const_cast<QByteArray*>(&data));
+    buffer.open(QIODevice::ReadOnly);
+
+    std::unique_ptr<FBXGeometry> geometry(new FBXGeometry());
+    GeometryReader reader(&buffer);
+    if (!reader.read(*geometry)) {
+        qCWarning(modelformat) << "Invalid serialized geometry for" << url;
+        return nullptr;
+    }
+
+    for (auto& mesh : geometry->meshes) {
+        FBXReader::buildModelMesh(mesh, url);
+    }
+
+    return geometry.release();
+}
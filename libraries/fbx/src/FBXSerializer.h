@@ -0,0 +1,30 @@
+//
+//  FBXSerializer.h
+//  libraries/fbx/src
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_FBXSerializer_h
+#define hifi_FBXSerializer_h
+
+#include "FBXReader.h"
+
+// A binary form of an extracted FBXGeometry, so that models loaded before can be restored without parsing them again.
+// The format is only meant for local caches: arrays are written in native byte order, and any change to the
+// geometry classes that affects it must bump FBX_SERIALIZATION_VERSION.
+
+extern const quint32 FBX_SERIALIZATION_VERSION;
+
+/// Writes everything extractFBXGeometry or readOBJ produced, except the model meshes, whose buffers are rebuilt
+/// from the FBX meshes when the geometry is unserialized.
+QByteArray serializeFBXGeometry(const FBXGeometry& geometry);
+
+/// Restores a geometry written by serializeFBXGeometry and rebuilds its model meshes.
+/// Returns nullptr if the data is truncated, corrupt or from another version of the format.
+FBXGeometry* unserializeFBXGeometry(const QByteArray& data, const QString& url);
+
+#endif // hifi_FBXSerializer_h
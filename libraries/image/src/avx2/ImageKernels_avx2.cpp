@@ -0,0 +1,116 @@
+//
+//  ImageKernels_avx2.cpp
+//  image/src/avx2
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifdef __AVX2__
+
+#include <cstdint>
+#include <immintrin.h>
+
+namespace image {
+namespace kernels {
+
+// must match ImageKernels.cpp
+static const float NORMAL_Z = 255.0f / 2.0f;
+static const float NORMAL_SCALE = 127.5f;
+static const float NORMAL_BIAS = 128.0f;
+
+int countAlpha_AVX2(const uint32_t* pixels, int count, int& numOpaques, int& numTransparents) {
+    const __m256i OPAQUE_ALPHA = _mm256_set1_epi32(0xff);
+    const __m256i TRANSPARENT_ALPHA = _mm256_setzero_si256();
+
+    // the comparisons give -1 per matching pixel
+    __m256i opaques = _mm256_setzero_si256();
+    __m256i transparents = _mm256_setzero_si256();
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i alpha = _mm256_srli_epi32(_mm256_loadu_si256((const __m256i*)&pixels[i]), 24);
+        opaques = _mm256_sub_epi32(opaques, _mm256_cmpeq_epi32(alpha, OPAQUE_ALPHA));
+        transparents = _mm256_sub_epi32(transparents, _mm256_cmpeq_epi32(alpha, TRANSPARENT_ALPHA));
+    }
+
+    int32_t opaqueLanes[8];
+    int32_t transparentLanes[8];
+    _mm256_storeu_si256((__m256i*)opaqueLanes, opaques);
+    _mm256_storeu_si256((__m256i*)transparentLanes, transparents);
+    for (int lane = 0; lane < 8; ++lane) {
+        numOpaques += opaqueLanes[lane];
+        numTransparents += transparentLanes[lane];
+    }
+
+    _mm256_zeroupper();
+    return i;
+}
+
+int swapRedBlue_AVX2(const uint32_t* src, uint32_t* dst, int count) {
+    // swap bytes 0 and 2 of every pixel
+    const __m256i SWAP_RED_BLUE = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+                                                   2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i pixels = _mm256_loadu_si256((const __m256i*)&src[i]);
+        _mm256_storeu_si256((__m256i*)&dst[i], _mm256_shuffle_epi8(pixels, SWAP_RED_BLUE));
+    }
+
+    _mm256_zeroupper();
+    return i;
+}
+
+static inline __m256 load8(const uint8_t* src) {
+    return _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)src)));
+}
+
+// above, row and below point at the first pixel that has a left neighbour, and count stops before the last one
+int bumpToNormalInterior_AVX2(const uint8_t* above, const uint8_t* row, const uint8_t* below, uint32_t* normals, int count) {
+    const __m256 TWO = _mm256_set1_ps(2.0f);
+    const __m256 NORMAL_Z_SQUARED = _mm256_set1_ps(NORMAL_Z * NORMAL_Z);
+    const __m256 SCALE = _mm256_set1_ps(NORMAL_SCALE);
+    const __m256 BIAS = _mm256_set1_ps(NORMAL_BIAS);
+    const __m256i ALPHA = _mm256_set1_epi32((int)0xff000000);
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 topLeft = load8(above + i - 1);
+        __m256 top = load8(above + i);
+        __m256 topRight = load8(above + i + 1);
+        __m256 left = load8(row + i - 1);
+        __m256 right = load8(row + i + 1);
+        __m256 bottomLeft = load8(below + i - 1);
+        __m256 bottom = load8(below + i);
+        __m256 bottomRight = load8(below + i + 1);
+
+        __m256 dX = _mm256_sub_ps(_mm256_add_ps(_mm256_add_ps(topRight, _mm256_mul_ps(TWO, right)), bottomRight),
+                                  _mm256_add_ps(_mm256_add_ps(topLeft, _mm256_mul_ps(TWO, left)), bottomLeft));
+        __m256 dY = _mm256_sub_ps(_mm256_add_ps(_mm256_add_ps(bottomLeft, _mm256_mul_ps(TWO, bottom)), bottomRight),
+                                  _mm256_add_ps(_mm256_add_ps(topLeft, _mm256_mul_ps(TWO, top)), topRight));
+
+        __m256 nX = _mm256_sub_ps(_mm256_setzero_ps(), dX);
+        __m256 nY = dY;
+        __m256 lengthSquared = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nX, nX), _mm256_mul_ps(nY, nY)), NORMAL_Z_SQUARED);
+        __m256 scale = _mm256_div_ps(SCALE, _mm256_sqrt_ps(lengthSquared));
+
+        __m256i red = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(nX, scale), BIAS));
+        __m256i green = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(nY, scale), BIAS));
+        __m256i blue = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(NORMAL_Z), scale), BIAS));
+
+        __m256i pixels = _mm256_or_si256(_mm256_or_si256(_mm256_slli_epi32(red, 16), _mm256_slli_epi32(green, 8)),
+                                         _mm256_or_si256(blue, ALPHA));
+        _mm256_storeu_si256((__m256i*)&normals[i], pixels);
+    }
+
+    _mm256_zeroupper();
+    return i;
+}
+
+} // namespace kernels
+} // namespace image
+
+#endif
@@ -13,18 +13,25 @@
 
 #include <nvtt/nvtt.h>
 
+#include <list>
+
 #include <QUrl>
 #include <QImage>
 #include <QBuffer>
 #include <QImageReader>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrentRun>
 
 #include <Finally.h>
 #include <Profile.h>
 #include <StatTracker.h>
 #include <GLMHelpers.h>
 #include <SettingHandle.h>
+#include <SharedUtil.h>
 
 #include "ImageLogging.h"
+#include "ImageKernels.h"
 
 using namespace gpu;
 
@@ -67,84 +74,98 @@ glm::uvec2 rectifyToSparseSize(const glm::uvec2& size) {
 namespace image {
 
 TextureUsage::TextureLoader TextureUsage::getTextureLoaderForType(Type type, const QVariantMap& options) {
+    // a "compress" option takes precedence over the settings, which processes without a settings file can't read
+    auto isCompressionEnabled = [&](bool(*isEnabledInSettings)()) {
+        return options.contains("compress") ? options.value("compress").toBool() : isEnabledInSettings();
+    };
+
     switch (type) {
-        case ALBEDO_TEXTURE:
-            return image::TextureUsage::createAlbedoTextureFromImage;
-        case EMISSIVE_TEXTURE:
-            return image::TextureUsage::createEmissiveTextureFromImage;
-        case LIGHTMAP_TEXTURE:
-            return image::TextureUsage::createLightmapTextureFromImage;
-        case CUBE_TEXTURE:
-            if (options.value("generateIrradiance", true).toBool()) {
-                return image::TextureUsage::createCubeTextureFromImage;
-            } else {
-                return image::TextureUsage::createCubeTextureFromImageWithoutIrradiance;
-            }
+        case CUBE_TEXTURE: {
+            bool generateIrradiance = options.value("generateIrradiance", true).toBool();
+            bool compress = isCompressionEnabled(isCubeTexturesCompressionEnabled);
+            return [=](const QImage& image, const std::string& srcImageName) {
+                return processCubeTextureColorFromImage(image, srcImageName, generateIrradiance, compress);
+            };
+        }
         case BUMP_TEXTURE:
-            return image::TextureUsage::createNormalTextureFromBumpImage;
-        case NORMAL_TEXTURE:
-            return image::TextureUsage::createNormalTextureFromNormalImage;
+        case NORMAL_TEXTURE: {
+            bool isBumpMap = (type == BUMP_TEXTURE);
+            bool compress = isCompressionEnabled(isNormalTexturesCompressionEnabled);
+            return [=](const QImage& image, const std::string& srcImageName) {
+                return process2DTextureNormalMapFromImage(image, srcImageName, isBumpMap, compress);
+            };
+        }
         case ROUGHNESS_TEXTURE:
-            return image::TextureUsage::createRoughnessTextureFromImage;
         case GLOSS_TEXTURE:
-            return image::TextureUsage::createRoughnessTextureFromGlossImage;
-        case SPECULAR_TEXTURE:
-            return image::TextureUsage::createMetallicTextureFromImage;
-        case STRICT_TEXTURE:
-            return image::TextureUsage::createStrict2DTextureFromImage;
+        case SPECULAR_TEXTURE: {
+            bool isInvertedPixels = (type == GLOSS_TEXTURE);
+            bool compress = isCompressionEnabled(isGrayscaleTexturesCompressionEnabled);
+            return [=](const QImage& image, const std::string& srcImageName) {
+                return process2DTextureGrayscaleFromImage(image, srcImageName, isInvertedPixels, compress);
+            };
+        }
 
+        case ALBEDO_TEXTURE:
+        case EMISSIVE_TEXTURE:
+        case LIGHTMAP_TEXTURE:
+        case STRICT_TEXTURE:
         case DEFAULT_TEXTURE:
-        default:
-            return image::TextureUsage::create2DTextureFromImage;
+        default: {
+            bool isStrict = (type == STRICT_TEXTURE);
+            bool compress = isCompressionEnabled(isColorTexturesCompressionEnabled);
+            return [=](const QImage& image, const std::string& srcImageName) {
+                return process2DTextureColorFromImage(image, srcImageName, isStrict, compress);
+            };
+        }
     }
 }
 
 gpu::TexturePointer TextureUsage::createStrict2DTextureFromImage(const QImage& srcImage, const std::string& srcImageName) {
-    return process2DTextureColorFromImage(srcImage, srcImageName, true);
+    return process2DTextureColorFromImage(srcImage, srcImageName, true, isColorTexturesCompressionEnabled());
 }
 
 gpu::TexturePointer TextureUsage::create2DTextureFromImage(const QImage& srcImage, const std::string& srcImageName) {
-    return process2DTextureColorFromImage(srcImage, srcImageName, false);
+    return process2DTextureColorFromImage(srcImage, srcImageName, false, isColorTexturesCompressionEnabled());
 }
 
 gpu::TexturePointer TextureUsage::createAlbedoTextureFromImage(const QImage& srcImage, const std::string& srcImageName) {
-    return process2DTextureColorFromImage(srcImage, srcImageName, false);
+    return process2DTextureColorFromImage(srcImage, srcImageName, false, isColorTexturesCompressionEnabled());
 }
 
 gpu::TexturePointer TextureUsage::createEmissiveTextureFromImage(const QImage& srcImage, const std::string& srcImageName) {
-    return process2DTextureColorFromImage(srcImage, srcImageName, false);
+    return process2DTextureColorFromImage(srcImage, srcImageName, false, isColorTexturesCompressionEnabled());
 }
 
 gpu::TexturePointer TextureUsage::createLightmapTextureFromImage(const QImage& srcImage, const std::string& srcImageName) {
-    return process2DTextureColorFromImage(srcImage, srcImageName, false);
+    return process2DTextureColorFromImage(srcImage, srcImageName, false, isColorTexturesCompressionEnabled());
 }
 
 gpu::TexturePointer TextureUsage::createNormalTextureFromNormalImage(const QImage& srcImage, const std::string& srcImageName) {
-    return process2DTextureNormalMapFromImage(srcImage, srcImageName, false);
+    return process2DTextureNormalMapFromImage(srcImage, srcImageName, false, isNormalTexturesCompressionEnabled());
 }
 
 gpu::TexturePointer TextureUsage::createNormalTextureFromBumpImage(const QImage& srcImage, const std::string& srcImageName) {
-    return process2DTextureNormalMapFromImage(srcImage, srcImageName, true);
+    return process2DTextureNormalMapFromImage(srcImage, srcImageName, true, isNormalTexturesCompressionEnabled());
 }
 
 gpu::TexturePointer TextureUsage::createRoughnessTextureFromImage(const QImage& srcImage, const std::string& srcImageName) {
-    return process2DTextureGrayscaleFromImage(srcImage, srcImageName, false);
+    return process2DTextureGrayscaleFromImage(srcImage, srcImageName, false, isGrayscaleTexturesCompressionEnabled());
 }
 
 gpu::TexturePointer TextureUsage::createRoughnessTextureFromGlossImage(const QImage& srcImage, const std::string& srcImageName) {
-    return process2DTextureGrayscaleFromImage(srcImage, srcImageName, true);
+    return process2DTextureGrayscaleFromImage(srcImage, srcImageName, true, isGrayscaleTexturesCompressionEnabled());
 }
 
 gpu::TexturePointer TextureUsage::createMetallicTextureFromImage(const QImage& srcImage, const std::string& srcImageName) {
-    return process2DTextureGrayscaleFromImage(srcImage, srcImageName, false);
+    return process2DTextureGrayscaleFromImage(srcImage, srcImageName, false, isGrayscaleTexturesCompressionEnabled());
 }
 
 gpu::TexturePointer TextureUsage::createCubeTextureFromImage(const QImage& srcImage, const std::string& srcImageName) {
-    return processCubeTextureColorFromImage(srcImage, srcImageName, true);
+    return processCubeTextureColorFromImage(srcImage, srcImageName, true, isCubeTexturesCompressionEnabled());
 }
 
 gpu::TexturePointer TextureUsage::createCubeTextureFromImageWithoutIrradiance(const QImage& srcImage, const std::string& srcImageName) {
-    return processCubeTextureColorFromImage(srcImage, srcImageName, false);
+    return processCubeTextureColorFromImage(srcImage, srcImageName, false, isCubeTexturesCompressionEnabled());
 }
 
 
@@ -205,7 +226,10 @@ void setCubeTexturesCompressionEnabled(bool enabled) {
 }
 
 
-gpu::TexturePointer processImage(const QByteArray& content, const std::string& filename, int maxNumPixels, TextureUsage::Type textureType) {
+gpu::TexturePointer processImage(const QByteArray& content, const std::string& filename, int maxNumPixels, TextureUsage::Type textureType,
+                                 const QVariantMap& options) {
+    PROFILE_RANGE_EX(resource_parse, "processImage", 0xffff0000, 0, { { "file", QString::fromStdString(filename) } });
+
     // Help the QImage loader by extracting the image file format from the url filename ext.
     // Some tga are not created properly without it.
     auto filenameExtension = filename.substr(filename.find_last_of('.') + 1);
@@ -254,7 +278,7 @@ gpu::TexturePointer processImage(const QByteArray& content, const std::string& f
             QSize(imageWidth, imageHeight) << ")";
     }
     
-    auto loader = TextureUsage::getTextureLoaderForType(textureType);
+    auto loader = TextureUsage::getTextureLoaderForType(textureType, options);
     auto texture = loader(image, filename);
 
     return texture;
@@ -292,38 +316,20 @@ QImage processSourceImage(const QImage& srcImage, bool cubemap) {
     return srcImage;
 }
 
-struct MyOutputHandler : public nvtt::OutputHandler {
-    MyOutputHandler(gpu::Texture* texture, int face) : _texture(texture), _face(face) {}
+// Collects the output of a compression job
+struct MipOutputHandler : public nvtt::OutputHandler {
+    MipOutputHandler(QByteArray& output) : _output(output) {}
 
     virtual void beginImage(int size, int width, int height, int depth, int face, int miplevel) override {
-        _size = size;
-        _miplevel = miplevel;
-
-        _data = static_cast<gpu::Byte*>(malloc(size));
-        _current = _data;
+        _output.reserve(_output.size() + size);
     }
     virtual bool writeData(const void* data, int size) override {
-        assert(_current + size <= _data + _size);
-        memcpy(_current, data, size);
-        _current += size;
+        _output.append(static_cast<const char*>(data), size);
         return true;
     }
-    virtual void endImage() override {
-        if (_face >= 0) {
-            _texture->assignStoredMipFace(_miplevel, _face, _size, static_cast<const gpu::Byte*>(_data));
-        } else {
-            _texture->assignStoredMip(_miplevel, _size, static_cast<const gpu::Byte*>(_data));
-        }
-        free(_data);
-        _data = nullptr;
-    }
+    virtual void endImage() override {}
 
-    gpu::Byte* _data{ nullptr };
-    gpu::Byte* _current{ nullptr };
-    gpu::Texture* _texture{ nullptr };
-    int _miplevel = 0;
-    int _size = 0;
-    int _face = -1;
+    QByteArray& _output;
 };
 struct MyErrorHandler : public nvtt::ErrorHandler {
     virtual void error(nvtt::Error e) override {
@@ -331,103 +337,59 @@ struct MyErrorHandler : public nvtt::ErrorHandler {
     }
 };
 
-void generateMips(gpu::Texture* texture, QImage& image, int face = -1) {
-#if CPU_MIPMAPS
-    PROFILE_RANGE(resource_parse, "generateMips");
-
-    if (image.format() != QImage::Format_ARGB32) {
-        image = image.convertToFormat(QImage::Format_ARGB32);
+// Compression jobs run on their own bounded pool, where the jobs of each texture queue behind the ones
+// submitted before them instead of holding a texture loading thread for the whole mip chain.
+class CompressionThreadPool : public QThreadPool {
+public:
+    CompressionThreadPool() {
+        // leave threads to the image readers and the rest of the application
+        setMaxThreadCount(std::max(QThread::idealThreadCount() / 2, 1));
     }
+};
 
-    const int width = image.width(), height = image.height();
-    const void* data = static_cast<const void*>(image.constBits());
-
-    nvtt::TextureType textureType = nvtt::TextureType_2D;
-    nvtt::InputFormat inputFormat = nvtt::InputFormat_BGRA_8UB;
-    nvtt::WrapMode wrapMode = nvtt::WrapMode_Mirror;
-    nvtt::RoundMode roundMode = nvtt::RoundMode_None;
-    nvtt::AlphaMode alphaMode = nvtt::AlphaMode_None;
-
-    float inputGamma = 2.2f;
-    float outputGamma = 2.2f;
+static QThreadPool& getCompressionThreadPool() {
+    static CompressionThreadPool pool;
+    return pool;
+}
 
-    nvtt::InputOptions inputOptions;
-    inputOptions.setTextureLayout(textureType, width, height);
-    inputOptions.setMipmapData(data, width, height);
+// Mips taller than this are compressed in strips of this many rows, a multiple of the 4 row compression blocks
+static const int COMPRESSION_STRIP_ROWS = 256;
 
-    inputOptions.setFormat(inputFormat);
-    inputOptions.setGamma(inputGamma, outputGamma);
-    inputOptions.setAlphaMode(alphaMode);
-    inputOptions.setWrapMode(wrapMode);
-    inputOptions.setRoundMode(roundMode);
+// The rows of one mip level of one face to compress
+class MipCompressionJob {
+public:
+    QImage image;
+    int firstRow { 0 };
+    int numRows { 0 };
+    uint16 level { 0 };
+    int face { -1 };
+    quint64 queuedTime { 0 };
+    QByteArray output;
+};
 
-    inputOptions.setMipmapGeneration(true);
-    inputOptions.setMipmapFilter(nvtt::MipmapFilter_Box);
+static bool setupCompression(const gpu::Element& mipFormat, nvtt::InputOptions& inputOptions, nvtt::CompressionOptions& compressionOptions) {
+    // the mips are generated before compression, so the gamma only matters for the conversion to and from nvtt's floats
+    inputOptions.setFormat(nvtt::InputFormat_BGRA_8UB);
+    inputOptions.setGamma(2.2f, 2.2f);
+    inputOptions.setAlphaMode(nvtt::AlphaMode_None);
+    inputOptions.setWrapMode(nvtt::WrapMode_Mirror);
+    inputOptions.setRoundMode(nvtt::RoundMode_None);
+    inputOptions.setMipmapGeneration(false);
 
-    nvtt::CompressionOptions compressionOptions;
     compressionOptions.setQuality(nvtt::Quality_Production);
 
-    auto mipFormat = texture->getStoredMipFormat();
     if (mipFormat == gpu::Element::COLOR_COMPRESSED_SRGB) {
         compressionOptions.setFormat(nvtt::Format_BC1);
     } else if (mipFormat == gpu::Element::COLOR_COMPRESSED_SRGBA_MASK) {
-        alphaMode = nvtt::AlphaMode_Transparency;
         compressionOptions.setFormat(nvtt::Format_BC1a);
     } else if (mipFormat == gpu::Element::COLOR_COMPRESSED_SRGBA) {
-        alphaMode = nvtt::AlphaMode_Transparency;
         compressionOptions.setFormat(nvtt::Format_BC3);
     } else if (mipFormat == gpu::Element::COLOR_COMPRESSED_RED) {
         compressionOptions.setFormat(nvtt::Format_BC4);
     } else if (mipFormat == gpu::Element::COLOR_COMPRESSED_XY) {
         compressionOptions.setFormat(nvtt::Format_BC5);
     } else if (mipFormat == gpu::Element::COLOR_COMPRESSED_SRGBA_HIGH) {
-        alphaMode = nvtt::AlphaMode_Transparency;
         compressionOptions.setFormat(nvtt::Format_BC7);
-    } else if (mipFormat == gpu::Element::COLOR_RGBA_32) {
-        compressionOptions.setFormat(nvtt::Format_RGBA);
-        compressionOptions.setPixelType(nvtt::PixelType_UnsignedNorm);
-        compressionOptions.setPitchAlignment(4);
-        compressionOptions.setPixelFormat(32,
-                                          0x000000FF,
-                                          0x0000FF00,
-                                          0x00FF0000,
-                                          0xFF000000);
-        inputGamma = 1.0f;
-        outputGamma = 1.0f;
-    } else if (mipFormat == gpu::Element::COLOR_BGRA_32) {
-        compressionOptions.setFormat(nvtt::Format_RGBA);
-        compressionOptions.setPixelType(nvtt::PixelType_UnsignedNorm);
-        compressionOptions.setPitchAlignment(4);
-        compressionOptions.setPixelFormat(32,
-                                          0x00FF0000,
-                                          0x0000FF00,
-                                          0x000000FF,
-                                          0xFF000000);
-        inputGamma = 1.0f;
-        outputGamma = 1.0f;
-    } else if (mipFormat == gpu::Element::COLOR_SRGBA_32) {
-        compressionOptions.setFormat(nvtt::Format_RGBA);
-        compressionOptions.setPixelType(nvtt::PixelType_UnsignedNorm);
-        compressionOptions.setPitchAlignment(4);
-        compressionOptions.setPixelFormat(32,
-                                          0x000000FF,
-                                          0x0000FF00,
-                                          0x00FF0000,
-                                          0xFF000000);
-    } else if (mipFormat == gpu::Element::COLOR_SBGRA_32) {
-        compressionOptions.setFormat(nvtt::Format_RGBA);
-        compressionOptions.setPixelType(nvtt::PixelType_UnsignedNorm);
-        compressionOptions.setPitchAlignment(4);
-        compressionOptions.setPixelFormat(32,
-                                          0x00FF0000,
-                                          0x0000FF00,
-                                          0x000000FF,
-                                          0xFF000000);
-    } else if (mipFormat == gpu::Element::COLOR_R_8) {
-        compressionOptions.setFormat(nvtt::Format_RGB);
-        compressionOptions.setPixelType(nvtt::PixelType_UnsignedNorm);
-        compressionOptions.setPitchAlignment(4);
-        compressionOptions.setPixelFormat(8, 0, 0, 0);
     } else if (mipFormat == gpu::Element::VEC2NU8_XY) {
         inputOptions.setNormalMap(true);
         compressionOptions.setFormat(nvtt::Format_RGBA);
@@ -435,53 +397,275 @@ void generateMips(gpu::Texture* texture, QImage& image, int face = -1) {
         compressionOptions.setPitchAlignment(4);
         compressionOptions.setPixelFormat(8, 8, 0, 0);
     } else {
-        qCWarning(imagelogging) << "Unknown mip format";
-        Q_UNREACHABLE();
-        return;
+        return false;
     }
+    return true;
+}
+
+static void compressMipJob(MipCompressionJob& job, const gpu::Element& mipFormat) {
+    PROFILE_RANGE_EX(resource_parse, "compressMip", 0xff00ffff, job.level,
+                     { { "face", job.face }, { "rows", job.numRows }, { "queuedUsecs", (qulonglong)(usecTimestampNow() - job.queuedTime) } });
+
+    const int width = job.image.width();
+
+    nvtt::InputOptions inputOptions;
+    nvtt::CompressionOptions compressionOptions;
+    inputOptions.setTextureLayout(nvtt::TextureType_2D, width, job.numRows);
+    inputOptions.setMipmapData(job.image.constBits() + job.firstRow * job.image.bytesPerLine(), width, job.numRows);
+    setupCompression(mipFormat, inputOptions, compressionOptions);
 
     nvtt::OutputOptions outputOptions;
     outputOptions.setOutputHeader(false);
-    MyOutputHandler outputHandler(texture, face);
+    MipOutputHandler outputHandler(job.output);
     outputOptions.setOutputHandler(&outputHandler);
     MyErrorHandler errorHandler;
     outputOptions.setErrorHandler(&errorHandler);
 
     nvtt::Compressor compressor;
     compressor.process(inputOptions, compressionOptions, outputOptions);
+}
+
+static QImage downsampleImage(const QImage& image, bool gammaCorrect) {
+    const int srcWidth = image.width();
+    const int srcHeight = image.height();
+    const int srcBytesPerLine = image.bytesPerLine();
+    const uchar* srcBits = image.constBits();
+
+    QImage result(std::max(srcWidth / 2, 1), std::max(srcHeight / 2, 1), QImage::Format_ARGB32);
+    const int dstBytesPerLine = result.bytesPerLine();
+    uchar* dstBits = result.bits();
+
+    kernels::forEachRowTile(result.height(), [&](int firstRow, int endRow) {
+        for (int y = firstRow; y < endRow; ++y) {
+            auto row0 = reinterpret_cast<const uint32_t*>(srcBits + std::min(2 * y, srcHeight - 1) * srcBytesPerLine);
+            auto row1 = reinterpret_cast<const uint32_t*>(srcBits + std::min(2 * y + 1, srcHeight - 1) * srcBytesPerLine);
+            auto dst = reinterpret_cast<uint32_t*>(dstBits + y * dstBytesPerLine);
+            kernels::downsampleRows(row0, row1, dst, srcWidth, gammaCorrect);
+        }
+    });
+
+    return result;
+}
+
+// Generates the mips of the uncompressed 8 bit per channel formats without going through nvtt, with the same
+// box filter and gamma. Returns false for the formats it doesn't handle.
+// nvtt was given its 2.2 gamma before the format was looked at, so it applied it to the linear formats too.
+static bool generateUncompressedMips(gpu::Texture* texture, const QImage& image, int face) {
+    auto mipFormat = texture->getStoredMipFormat();
+    const bool gammaCorrect = true;
+    bool swapRedBlue = false;
+    bool redOnly = false;
+    if (mipFormat == gpu::Element::COLOR_SBGRA_32 || mipFormat == gpu::Element::COLOR_BGRA_32) {
+    } else if (mipFormat == gpu::Element::COLOR_SRGBA_32 || mipFormat == gpu::Element::COLOR_RGBA_32) {
+        swapRedBlue = true;
+    } else if (mipFormat == gpu::Element::COLOR_R_8) {
+        redOnly = true;
+    } else {
+        return false;
+    }
+
+    PROFILE_RANGE(resource_parse, "generateUncompressedMips");
+
+    std::vector<gpu::Byte> bytes;
+    QImage mip = image;
+    const uint16 numMips = gpu::Texture::evalMaxNumMips(gpu::Vec3u(image.width(), image.height(), 1));
+    for (uint16 level = 0; level < numMips; ++level) {
+        if (level > 0) {
+            mip = downsampleImage(mip, gammaCorrect);
+        }
+
+        const int width = mip.width();
+        const int height = mip.height();
+        const uchar* bits = mip.constBits();
+        const int bytesPerLine = mip.bytesPerLine();
+
+        // the lines of the stored mips are padded to 4 bytes, like nvtt's pitch alignment
+        const int lineSize = redOnly ? (int)gpu::Texture::evalPaddedSize(width) : width * 4;
+        const gpu::Byte* data = bits;
+        if (redOnly || swapRedBlue) {
+            bytes.resize(lineSize * height);
+            gpu::Byte* dstBits = bytes.data();
+            kernels::forEachRowTile(height, [&](int firstRow, int endRow) {
+                for (int y = firstRow; y < endRow; ++y) {
+                    auto src = reinterpret_cast<const uint32_t*>(bits + y * bytesPerLine);
+                    if (redOnly) {
+                        kernels::extractRed(src, dstBits + y * lineSize, width);
+                    } else {
+                        kernels::swapRedBlue(src, reinterpret_cast<uint32_t*>(dstBits + y * lineSize), width);
+                    }
+                }
+            });
+            data = dstBits;
+        }
+
+        if (face >= 0) {
+            texture->assignStoredMipFace(level, face, lineSize * height, data);
+        } else {
+            texture->assignStoredMip(level, lineSize * height, data);
+        }
+    }
+
+    return true;
+}
+
+// Generates the mips of each image, one for a 2D texture or the faces of a cube map starting at firstFace,
+// and compresses them as independent jobs per level and face, with the biggest levels split in strips of block rows.
+static void compressMips(gpu::Texture* texture, const std::vector<QImage>& images, int firstFace) {
+    auto mipFormat = texture->getStoredMipFormat();
+    {
+        nvtt::InputOptions inputOptions;
+        nvtt::CompressionOptions compressionOptions;
+        if (!setupCompression(mipFormat, inputOptions, compressionOptions)) {
+            qCWarning(imagelogging) << "Unknown mip format";
+            Q_UNREACHABLE();
+            return;
+        }
+    }
+
+    // normal maps are filtered linearly and renormalized
+    const bool isNormalMap = (mipFormat == gpu::Element::VEC2NU8_XY || mipFormat == gpu::Element::COLOR_COMPRESSED_XY);
+
+    // a list keeps the jobs in place while the ones already submitted run
+    std::list<MipCompressionJob> jobs;
+    QList<QFuture<void>> futures;
+    auto& pool = getCompressionThreadPool();
+
+    for (size_t i = 0; i < images.size(); ++i) {
+        QImage mip = images[i];
+        const uint16 numMips = gpu::Texture::evalMaxNumMips(gpu::Vec3u(mip.width(), mip.height(), 1));
+        for (uint16 level = 0; level < numMips; ++level) {
+            if (level > 0) {
+                mip = downsampleImage(mip, !isNormalMap);
+                if (isNormalMap) {
+                    uchar* bits = mip.bits();
+                    const int bytesPerLine = mip.bytesPerLine();
+                    const int width = mip.width();
+                    kernels::forEachRowTile(mip.height(), [&](int firstRow, int endRow) {
+                        for (int y = firstRow; y < endRow; ++y) {
+                            kernels::normalizeNormals(reinterpret_cast<uint32_t*>(bits + y * bytesPerLine), width);
+                        }
+                    });
+                }
+            }
+
+            for (int firstRow = 0; firstRow < mip.height(); firstRow += COMPRESSION_STRIP_ROWS) {
+                jobs.emplace_back();
+                auto& job = jobs.back();
+                job.image = mip;
+                job.firstRow = firstRow;
+                job.numRows = std::min(COMPRESSION_STRIP_ROWS, mip.height() - firstRow);
+                job.level = level;
+                job.face = (firstFace < 0) ? -1 : firstFace + (int)i;
+                job.queuedTime = usecTimestampNow();
+
+                // start on the first levels while the next ones are generated
+                auto jobPointer = &job;
+                futures.push_back(QtConcurrent::run(&pool, [jobPointer, mipFormat] {
+                    compressMipJob(*jobPointer, mipFormat);
+                }));
+            }
+        }
+    }
+
+    for (auto& future : futures) {
+        future.waitForFinished();
+    }
+
+    // the strips of a level are consecutive, and concatenate into whole rows of blocks
+    auto it = jobs.begin();
+    while (it != jobs.end()) {
+        const uint16 level = it->level;
+        const int face = it->face;
+        QByteArray data = it->output;
+        for (++it; it != jobs.end() && it->level == level && it->face == face; ++it) {
+            data.append(it->output);
+        }
+
+        if (face >= 0) {
+            texture->assignStoredMipFace(level, face, data.size(), reinterpret_cast<const gpu::Byte*>(data.constData()));
+        } else {
+            texture->assignStoredMip(level, data.size(), reinterpret_cast<const gpu::Byte*>(data.constData()));
+        }
+    }
+}
+
+void generateMips(gpu::Texture* texture, QImage& image, int face = -1) {
+#if CPU_MIPMAPS
+    PROFILE_RANGE_EX(resource_parse, "generateMips", 0xff00ffff, 0, { { "source", QString::fromStdString(texture->source()) } });
+
+    if (image.format() != QImage::Format_ARGB32) {
+        image = image.convertToFormat(QImage::Format_ARGB32);
+    }
+
+    if (generateUncompressedMips(texture, image, face)) {
+        return;
+    }
+
+    compressMips(texture, { image }, face);
+#else
+    Q_UNUSED(image);
+    Q_UNUSED(face);
+    texture->autoGenerateMips(-1);
+#endif
+}
+
+void generateCubeMips(gpu::Texture* texture, std::vector<QImage>& faces) {
+#if CPU_MIPMAPS
+    PROFILE_RANGE_EX(resource_parse, "generateCubeMips", 0xff00ffff, 0, { { "source", QString::fromStdString(texture->source()) } });
+
+    for (auto& face : faces) {
+        if (face.format() != QImage::Format_ARGB32) {
+            face = face.convertToFormat(QImage::Format_ARGB32);
+        }
+    }
+
+    if (generateUncompressedMips(texture, faces[0], 0)) {
+        for (uint8 face = 1; face < faces.size(); ++face) {
+            generateUncompressedMips(texture, faces[face], face);
+        }
+        return;
+    }
+
+    // all the faces are compressed at once
+    compressMips(texture, faces, 0);
 #else
+    Q_UNUSED(faces);
     texture->autoGenerateMips(-1);
 #endif
 }
 
 void processTextureAlpha(const QImage& srcImage, bool& validAlpha, bool& alphaAsMask) {
     PROFILE_RANGE(resource_parse, "processTextureAlpha");
-    validAlpha = false;
-    alphaAsMask = true;
-    const uint8 OPAQUE_ALPHA = 255;
-    const uint8 TRANSPARENT_ALPHA = 0;
 
     // Figure out if we can use a mask for alpha or not
-    int numOpaques = 0;
-    int numTranslucents = 0;
-    const int NUM_PIXELS = srcImage.width() * srcImage.height();
+    std::atomic<int> numOpaques { 0 };
+    std::atomic<int> numTranslucents { 0 };
+    const int width = srcImage.width();
+    const int NUM_PIXELS = width * srcImage.height();
     const int MAX_TRANSLUCENT_PIXELS_FOR_ALPHAMASK = (int)(0.05f * (float)(NUM_PIXELS));
-    const QRgb* data = reinterpret_cast<const QRgb*>(srcImage.constBits());
-    for (int i = 0; i < NUM_PIXELS; ++i) {
-        auto alpha = qAlpha(data[i]);
-        if (alpha == OPAQUE_ALPHA) {
-            numOpaques++;
-        } else if (alpha != TRANSPARENT_ALPHA) {
-            if (++numTranslucents > MAX_TRANSLUCENT_PIXELS_FOR_ALPHAMASK) {
-                alphaAsMask = false;
-                break;
+    const uchar* bits = srcImage.constBits();
+    const int bytesPerLine = srcImage.bytesPerLine();
+
+    kernels::forEachRowTile(srcImage.height(), [&](int firstRow, int endRow) {
+        for (int y = firstRow; y < endRow; ++y) {
+            // stop as soon as any tile has seen too many translucent pixels for a mask
+            if (numTranslucents > MAX_TRANSLUCENT_PIXELS_FOR_ALPHAMASK) {
+                return;
             }
+
+            int rowOpaques;
+            int rowTranslucents;
+            kernels::countAlpha(reinterpret_cast<const uint32_t*>(bits + y * bytesPerLine), width, rowOpaques, rowTranslucents);
+            numOpaques += rowOpaques;
+            numTranslucents += rowTranslucents;
         }
-    }
+    });
+
+    alphaAsMask = (numTranslucents <= MAX_TRANSLUCENT_PIXELS_FOR_ALPHAMASK);
     validAlpha = (numOpaques != NUM_PIXELS);
 }
 
-gpu::TexturePointer TextureUsage::process2DTextureColorFromImage(const QImage& srcImage, const std::string& srcImageName, bool isStrict) {
+gpu::TexturePointer TextureUsage::process2DTextureColorFromImage(const QImage& srcImage, const std::string& srcImageName, bool isStrict, bool compress) {
     PROFILE_RANGE(resource_parse, "process2DTextureColorFromImage");
     QImage image = processSourceImage(srcImage, false);
     bool validAlpha = image.hasAlphaChannel();
@@ -500,7 +684,7 @@ gpu::TexturePointer TextureUsage::process2DTextureColorFromImage(const QImage& s
     if ((image.width() > 0) && (image.height() > 0)) {
         gpu::Element formatMip;
         gpu::Element formatGPU;
-        if (isColorTexturesCompressionEnabled()) {
+        if (compress) {
             if (validAlpha) {
                 // NOTE: This disables BC1a compression because it was producing odd artifacts on text textures
                 // for the tutorial. Instead we use BC3 (which is larger) but doesn't produce the same artifacts).
@@ -535,77 +719,36 @@ gpu::TexturePointer TextureUsage::process2DTextureColorFromImage(const QImage& s
     return theTexture;
 }
 
-int clampPixelCoordinate(int coordinate, int maxCoordinate) {
-    return coordinate - ((int)(coordinate < 0) * coordinate) + ((int)(coordinate > maxCoordinate) * (maxCoordinate - coordinate));
-}
-
-const int RGBA_MAX = 255;
-
-// transform -1 - 1 to 0 - 255 (from sobel value to rgb)
-double mapComponent(double sobelValue) {
-    const double factor = RGBA_MAX / 2.0;
-    return (sobelValue + 1.0) * factor;
-}
-
 QImage processBumpMap(QImage& image) {
+    PROFILE_RANGE(resource_parse, "processBumpMap");
     if (image.format() != QImage::Format_Grayscale8) {
         image = image.convertToFormat(QImage::Format_Grayscale8);
     }
 
     // PR 5540 by AlessandroSigna integrated here as a specialized TextureLoader for bumpmaps
     // The conversion is done using the Sobel Filter to calculate the derivatives from the grayscale image
-    const double pStrength = 2.0;
-    int width = image.width();
-    int height = image.height();
+    const int width = image.width();
+    const int height = image.height();
+    const uchar* srcBits = image.constBits();
+    const int srcBytesPerLine = image.bytesPerLine();
 
     QImage result(width, height, QImage::Format_ARGB32);
-
-    for (int i = 0; i < width; i++) {
-        const int iNextClamped = clampPixelCoordinate(i + 1, width - 1);
-        const int iPrevClamped = clampPixelCoordinate(i - 1, width - 1);
-
-        for (int j = 0; j < height; j++) {
-            const int jNextClamped = clampPixelCoordinate(j + 1, height - 1);
-            const int jPrevClamped = clampPixelCoordinate(j - 1, height - 1);
-
-            // surrounding pixels
-            const QRgb topLeft = image.pixel(iPrevClamped, jPrevClamped);
-            const QRgb top = image.pixel(iPrevClamped, j);
-            const QRgb topRight = image.pixel(iPrevClamped, jNextClamped);
-            const QRgb right = image.pixel(i, jNextClamped);
-            const QRgb bottomRight = image.pixel(iNextClamped, jNextClamped);
-            const QRgb bottom = image.pixel(iNextClamped, j);
-            const QRgb bottomLeft = image.pixel(iNextClamped, jPrevClamped);
-            const QRgb left = image.pixel(i, jPrevClamped);
-
-            // take their gray intensities
-            // since it's a grayscale image, the value of each component RGB is the same
-            const double tl = qRed(topLeft);
-            const double t = qRed(top);
-            const double tr = qRed(topRight);
-            const double r = qRed(right);
-            const double br = qRed(bottomRight);
-            const double b = qRed(bottom);
-            const double bl = qRed(bottomLeft);
-            const double l = qRed(left);
-
-            // apply the sobel filter
-            const double dX = (tr + pStrength * r + br) - (tl + pStrength * l + bl);
-            const double dY = (bl + pStrength * b + br) - (tl + pStrength * t + tr);
-            const double dZ = RGBA_MAX / pStrength;
-
-            glm::vec3 v(dX, dY, dZ);
-            glm::normalize(v);
-
-            // convert to rgb from the value obtained computing the filter
-            QRgb qRgbValue = qRgba(mapComponent(v.z), mapComponent(v.y), mapComponent(v.x), 1.0);
-            result.setPixel(i, j, qRgbValue);
+    uchar* dstBits = result.bits();
+    const int dstBytesPerLine = result.bytesPerLine();
+
+    kernels::forEachRowTile(height, [&](int firstRow, int endRow) {
+        for (int y = firstRow; y < endRow; ++y) {
+            const uchar* above = srcBits + std::max(y - 1, 0) * srcBytesPerLine;
+            const uchar* row = srcBits + y * srcBytesPerLine;
+            const uchar* below = srcBits + std::min(y + 1, height - 1) * srcBytesPerLine;
+            kernels::bumpToNormalRow(above, row, below, reinterpret_cast<uint32_t*>(dstBits + y * dstBytesPerLine), width);
         }
-    }
+    });
 
     return result;
 }
-gpu::TexturePointer TextureUsage::process2DTextureNormalMapFromImage(const QImage& srcImage, const std::string& srcImageName, bool isBumpMap) {
+
+gpu::TexturePointer TextureUsage::process2DTextureNormalMapFromImage(const QImage& srcImage, const std::string& srcImageName, bool isBumpMap, bool compress) {
     PROFILE_RANGE(resource_parse, "process2DTextureNormalMapFromImage");
     QImage image = processSourceImage(srcImage, false);
 
@@ -622,7 +765,7 @@ gpu::TexturePointer TextureUsage::process2DTextureNormalMapFromImage(const QImag
     if ((image.width() > 0) && (image.height() > 0)) {
         gpu::Element formatMip = gpu::Element::VEC2NU8_XY;
         gpu::Element formatGPU = gpu::Element::VEC2NU8_XY;
-        if (isNormalTexturesCompressionEnabled()) {
+        if (compress) {
             formatMip = gpu::Element::COLOR_COMPRESSED_XY;
             formatGPU = gpu::Element::COLOR_COMPRESSED_XY;
         }
@@ -636,7 +779,7 @@ gpu::TexturePointer TextureUsage::process2DTextureNormalMapFromImage(const QImag
     return theTexture;
 }
 
-gpu::TexturePointer TextureUsage::process2DTextureGrayscaleFromImage(const QImage& srcImage, const std::string& srcImageName, bool isInvertedPixels) {
+gpu::TexturePointer TextureUsage::process2DTextureGrayscaleFromImage(const QImage& srcImage, const std::string& srcImageName, bool isInvertedPixels, bool compress) {
     PROFILE_RANGE(resource_parse, "process2DTextureGrayscaleFromImage");
     QImage image = processSourceImage(srcImage, false);
 
@@ -653,7 +796,7 @@ gpu::TexturePointer TextureUsage::process2DTextureGrayscaleFromImage(const QImag
     if ((image.width() > 0) && (image.height() > 0)) {
         gpu::Element formatMip;
         gpu::Element formatGPU;
-        if (isGrayscaleTexturesCompressionEnabled()) {
+        if (compress) {
             formatMip = gpu::Element::COLOR_COMPRESSED_RED;
             formatGPU = gpu::Element::COLOR_COMPRESSED_RED;
         } else {
@@ -926,7 +1069,7 @@ const CubeLayout CubeLayout::CUBEMAP_LAYOUTS[] = {
 };
 const int CubeLayout::NUM_CUBEMAP_LAYOUTS = sizeof(CubeLayout::CUBEMAP_LAYOUTS) / sizeof(CubeLayout);
 
-gpu::TexturePointer TextureUsage::processCubeTextureColorFromImage(const QImage& srcImage, const std::string& srcImageName, bool generateIrradiance) {
+gpu::TexturePointer TextureUsage::processCubeTextureColorFromImage(const QImage& srcImage, const std::string& srcImageName, bool generateIrradiance, bool compress) {
     PROFILE_RANGE(resource_parse, "processCubeTextureColorFromImage");
 
     gpu::TexturePointer theTexture = nullptr;
@@ -938,7 +1081,7 @@ gpu::TexturePointer TextureUsage::processCubeTextureColorFromImage(const QImage&
 
         gpu::Element formatMip;
         gpu::Element formatGPU;
-        if (isCubeTexturesCompressionEnabled()) {
+        if (compress) {
             formatMip = gpu::Element::COLOR_COMPRESSED_SRGBA_HIGH;
             formatGPU = gpu::Element::COLOR_COMPRESSED_SRGBA_HIGH;
         } else {
@@ -984,9 +1127,7 @@ gpu::TexturePointer TextureUsage::processCubeTextureColorFromImage(const QImage&
             theTexture->setSource(srcImageName);
             theTexture->setStoredMipFormat(formatMip);
 
-            for (uint8 face = 0; face < faces.size(); ++face) {
-                generateMips(theTexture.get(), faces[face], face);
-            }
+            generateCubeMips(theTexture.get(), faces);
 
             // Generate irradiance while we are at it
             if (generateIrradiance) {
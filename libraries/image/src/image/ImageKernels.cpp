@@ -0,0 +1,389 @@
+//
+//  ImageKernels.cpp
+//  image/src/image
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "ImageKernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include <QtConcurrent/QtConcurrentMap>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#include <emmintrin.h>
+#include <CPUDetect.h>
+#endif
+
+namespace image {
+namespace kernels {
+
+// the weight of the center row or column of the Sobel filter, which also sets how flat the normals are
+static const float SOBEL_STRENGTH = 2.0f;
+static const float NORMAL_Z = 255.0f / SOBEL_STRENGTH;
+
+// maps a normal component from [-1, 1] to [0, 255], rounding to nearest
+static const float NORMAL_SCALE = 127.5f;
+static const float NORMAL_BIAS = 128.0f;
+
+static const int ROWS_PER_TILE = 64;
+
+//
+// Reference implementations, also used for the pixels the vectorized versions leave over
+//
+
+static inline uint32_t bumpToNormalPixel(const uint8_t* above, const uint8_t* row, const uint8_t* below, int x, int width) {
+    const int left = std::max(x - 1, 0);
+    const int right = std::min(x + 1, width - 1);
+
+    const float dX = (float)(above[right] + 2 * row[right] + below[right]) - (float)(above[left] + 2 * row[left] + below[left]);
+    const float dY = (float)(below[left] + 2 * below[x] + below[right]) - (float)(above[left] + 2 * above[x] + above[right]);
+
+    // rows go down the image while y goes up in tangent space
+    const float nX = -dX;
+    const float nY = dY;
+    const float scale = NORMAL_SCALE / sqrtf(nX * nX + nY * nY + NORMAL_Z * NORMAL_Z);
+
+    const uint32_t red = (uint32_t)(nX * scale + NORMAL_BIAS);
+    const uint32_t green = (uint32_t)(nY * scale + NORMAL_BIAS);
+    const uint32_t blue = (uint32_t)(NORMAL_Z * scale + NORMAL_BIAS);
+    return 0xff000000 | (red << 16) | (green << 8) | blue;
+}
+
+static inline uint32_t swapRedBluePixel(uint32_t pixel) {
+    return (pixel & 0xff00ff00) | ((pixel >> 16) & 0xff) | ((pixel & 0xff) << 16);
+}
+
+class GammaTables {
+public:
+    GammaTables() {
+        const float GAMMA = 2.2f;
+        for (int i = 0; i < 256; ++i) {
+            toLinear[i] = (uint16_t)(powf(i / 255.0f, GAMMA) * 65535.0f + 0.5f);
+        }
+        for (int i = 0; i < 65536; ++i) {
+            fromLinear[i] = (uint8_t)(powf(i / 65535.0f, 1.0f / GAMMA) * 255.0f + 0.5f);
+        }
+    }
+
+    uint16_t toLinear[256];
+    uint8_t fromLinear[65536];
+};
+
+static const GammaTables& getGammaTables() {
+    static const GammaTables tables;
+    return tables;
+}
+
+static inline uint32_t averagePixels(uint32_t p0, uint32_t p1, uint32_t p2, uint32_t p3) {
+    uint32_t result = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+        uint32_t sum = ((p0 >> shift) & 0xff) + ((p1 >> shift) & 0xff) + ((p2 >> shift) & 0xff) + ((p3 >> shift) & 0xff);
+        result |= ((sum + 2) >> 2) << shift;
+    }
+    return result;
+}
+
+static inline uint32_t averagePixelsGamma(uint32_t p0, uint32_t p1, uint32_t p2, uint32_t p3, const GammaTables& tables) {
+    uint32_t result = (((p0 >> 24) + (p1 >> 24) + (p2 >> 24) + (p3 >> 24) + 2) >> 2) << 24;
+    for (int shift = 0; shift < 24; shift += 8) {
+        uint32_t sum = tables.toLinear[(p0 >> shift) & 0xff] + tables.toLinear[(p1 >> shift) & 0xff] +
+            tables.toLinear[(p2 >> shift) & 0xff] + tables.toLinear[(p3 >> shift) & 0xff];
+        result |= (uint32_t)tables.fromLinear[(sum + 2) >> 2] << shift;
+    }
+    return result;
+}
+
+//
+// Vectorized implementations, which process as many pixels as suits them and return how many they did
+//
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+
+static int countAlpha_SSE2(const uint32_t* pixels, int count, int& numOpaques, int& numTransparents) {
+    const __m128i OPAQUE_ALPHA = _mm_set1_epi32(0xff);
+    const __m128i TRANSPARENT_ALPHA = _mm_setzero_si128();
+
+    // the comparisons give -1 per matching pixel
+    __m128i opaques = _mm_setzero_si128();
+    __m128i transparents = _mm_setzero_si128();
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i alpha = _mm_srli_epi32(_mm_loadu_si128((const __m128i*)&pixels[i]), 24);
+        opaques = _mm_sub_epi32(opaques, _mm_cmpeq_epi32(alpha, OPAQUE_ALPHA));
+        transparents = _mm_sub_epi32(transparents, _mm_cmpeq_epi32(alpha, TRANSPARENT_ALPHA));
+    }
+
+    int32_t opaqueLanes[4];
+    int32_t transparentLanes[4];
+    _mm_storeu_si128((__m128i*)opaqueLanes, opaques);
+    _mm_storeu_si128((__m128i*)transparentLanes, transparents);
+    numOpaques += opaqueLanes[0] + opaqueLanes[1] + opaqueLanes[2] + opaqueLanes[3];
+    numTransparents += transparentLanes[0] + transparentLanes[1] + transparentLanes[2] + transparentLanes[3];
+
+    return i;
+}
+
+static int swapRedBlue_SSE2(const uint32_t* src, uint32_t* dst, int count) {
+    const __m128i GREEN_ALPHA = _mm_set1_epi32((int)0xff00ff00);
+    const __m128i LOW_BYTE = _mm_set1_epi32(0xff);
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i pixels = _mm_loadu_si128((const __m128i*)&src[i]);
+        __m128i red = _mm_and_si128(_mm_srli_epi32(pixels, 16), LOW_BYTE);
+        __m128i blue = _mm_slli_epi32(_mm_and_si128(pixels, LOW_BYTE), 16);
+        pixels = _mm_or_si128(_mm_and_si128(pixels, GREEN_ALPHA), _mm_or_si128(red, blue));
+        _mm_storeu_si128((__m128i*)&dst[i], pixels);
+    }
+    return i;
+}
+
+static int extractRed_SSE2(const uint32_t* src, uint8_t* dst, int count) {
+    const __m128i LOW_BYTE = _mm_set1_epi32(0xff);
+
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m128i red0 = _mm_and_si128(_mm_srli_epi32(_mm_loadu_si128((const __m128i*)&src[i]), 16), LOW_BYTE);
+        __m128i red1 = _mm_and_si128(_mm_srli_epi32(_mm_loadu_si128((const __m128i*)&src[i + 4]), 16), LOW_BYTE);
+        __m128i red2 = _mm_and_si128(_mm_srli_epi32(_mm_loadu_si128((const __m128i*)&src[i + 8]), 16), LOW_BYTE);
+        __m128i red3 = _mm_and_si128(_mm_srli_epi32(_mm_loadu_si128((const __m128i*)&src[i + 12]), 16), LOW_BYTE);
+
+        // the values fit a byte, so the saturating packs just narrow them
+        __m128i red01 = _mm_packs_epi32(red0, red1);
+        __m128i red23 = _mm_packs_epi32(red2, red3);
+        _mm_storeu_si128((__m128i*)&dst[i], _mm_packus_epi16(red01, red23));
+    }
+    return i;
+}
+
+static inline __m128 load4_SSE2(const uint8_t* src) {
+    int32_t bytes;
+    memcpy(&bytes, src, sizeof(bytes));
+    __m128i values = _mm_unpacklo_epi8(_mm_cvtsi32_si128(bytes), _mm_setzero_si128());
+    return _mm_cvtepi32_ps(_mm_unpacklo_epi16(values, _mm_setzero_si128()));
+}
+
+// above, row and below point at the first pixel that has a left neighbour, and count stops before the last one
+static int bumpToNormalInterior_SSE2(const uint8_t* above, const uint8_t* row, const uint8_t* below, uint32_t* normals, int count) {
+    const __m128 TWO = _mm_set1_ps(2.0f);
+    const __m128 NORMAL_Z_SQUARED = _mm_set1_ps(NORMAL_Z * NORMAL_Z);
+    const __m128 SCALE = _mm_set1_ps(NORMAL_SCALE);
+    const __m128 BIAS = _mm_set1_ps(NORMAL_BIAS);
+    const __m128i ALPHA = _mm_set1_epi32((int)0xff000000);
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 topLeft = load4_SSE2(above + i - 1);
+        __m128 top = load4_SSE2(above + i);
+        __m128 topRight = load4_SSE2(above + i + 1);
+        __m128 left = load4_SSE2(row + i - 1);
+        __m128 right = load4_SSE2(row + i + 1);
+        __m128 bottomLeft = load4_SSE2(below + i - 1);
+        __m128 bottom = load4_SSE2(below + i);
+        __m128 bottomRight = load4_SSE2(below + i + 1);
+
+        __m128 dX = _mm_sub_ps(_mm_add_ps(_mm_add_ps(topRight, _mm_mul_ps(TWO, right)), bottomRight),
+                               _mm_add_ps(_mm_add_ps(topLeft, _mm_mul_ps(TWO, left)), bottomLeft));
+        __m128 dY = _mm_sub_ps(_mm_add_ps(_mm_add_ps(bottomLeft, _mm_mul_ps(TWO, bottom)), bottomRight),
+                               _mm_add_ps(_mm_add_ps(topLeft, _mm_mul_ps(TWO, top)), topRight));
+
+        __m128 nX = _mm_sub_ps(_mm_setzero_ps(), dX);
+        __m128 nY = dY;
+        __m128 lengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nX, nX), _mm_mul_ps(nY, nY)), NORMAL_Z_SQUARED);
+        __m128 scale = _mm_div_ps(SCALE, _mm_sqrt_ps(lengthSquared));
+
+        __m128i red = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(nX, scale), BIAS));
+        __m128i green = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(nY, scale), BIAS));
+        __m128i blue = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(NORMAL_Z), scale), BIAS));
+
+        __m128i pixels = _mm_or_si128(_mm_or_si128(_mm_slli_epi32(red, 16), _mm_slli_epi32(green, 8)), _mm_or_si128(blue, ALPHA));
+        _mm_storeu_si128((__m128i*)&normals[i], pixels);
+    }
+    return i;
+}
+
+static int downsampleRows_SSE2(const uint32_t* row0, const uint32_t* row1, uint32_t* dst, int dstWidth) {
+    const __m128i ROUNDING = _mm_set1_epi16(2);
+    const __m128i ZERO = _mm_setzero_si128();
+
+    int i = 0;
+    for (; i + 2 <= dstWidth; i += 2) {
+        // two 2x2 blocks, widened to 16 bits per channel
+        __m128i top = _mm_loadu_si128((const __m128i*)&row0[2 * i]);
+        __m128i bottom = _mm_loadu_si128((const __m128i*)&row1[2 * i]);
+        __m128i sumLow = _mm_add_epi16(_mm_unpacklo_epi8(top, ZERO), _mm_unpacklo_epi8(bottom, ZERO));
+        __m128i sumHigh = _mm_add_epi16(_mm_unpackhi_epi8(top, ZERO), _mm_unpackhi_epi8(bottom, ZERO));
+
+        // add the left and right columns of each block
+        __m128i sumFirst = _mm_add_epi16(sumLow, _mm_srli_si128(sumLow, 8));
+        __m128i sumSecond = _mm_add_epi16(sumHigh, _mm_srli_si128(sumHigh, 8));
+        __m128i sums = _mm_unpacklo_epi64(sumFirst, sumSecond);
+
+        __m128i averages = _mm_srli_epi16(_mm_add_epi16(sums, ROUNDING), 2);
+        _mm_storel_epi64((__m128i*)&dst[i], _mm_packus_epi16(averages, ZERO));
+    }
+    return i;
+}
+
+int countAlpha_AVX2(const uint32_t* pixels, int count, int& numOpaques, int& numTransparents);
+int swapRedBlue_AVX2(const uint32_t* src, uint32_t* dst, int count);
+int bumpToNormalInterior_AVX2(const uint8_t* above, const uint8_t* row, const uint8_t* below, uint32_t* normals, int count);
+
+static int countAlphaSIMD(const uint32_t* pixels, int count, int& numOpaques, int& numTransparents) {
+    static auto f = cpuSupportsAVX2() ? countAlpha_AVX2 : countAlpha_SSE2;
+    return (*f)(pixels, count, numOpaques, numTransparents);  // dispatch
+}
+
+static int swapRedBlueSIMD(const uint32_t* src, uint32_t* dst, int count) {
+    static auto f = cpuSupportsAVX2() ? swapRedBlue_AVX2 : swapRedBlue_SSE2;
+    return (*f)(src, dst, count);  // dispatch
+}
+
+static int extractRedSIMD(const uint32_t* src, uint8_t* dst, int count) {
+    return extractRed_SSE2(src, dst, count);
+}
+
+static int bumpToNormalInteriorSIMD(const uint8_t* above, const uint8_t* row, const uint8_t* below, uint32_t* normals, int count) {
+    static auto f = cpuSupportsAVX2() ? bumpToNormalInterior_AVX2 : bumpToNormalInterior_SSE2;
+    return (*f)(above, row, below, normals, count);  // dispatch
+}
+
+static int downsampleRowsSIMD(const uint32_t* row0, const uint32_t* row1, uint32_t* dst, int dstWidth) {
+    return downsampleRows_SSE2(row0, row1, dst, dstWidth);
+}
+
+#else   // portable code only
+
+static int countAlphaSIMD(const uint32_t*, int, int&, int&) {
+    return 0;
+}
+
+static int swapRedBlueSIMD(const uint32_t*, uint32_t*, int) {
+    return 0;
+}
+
+static int extractRedSIMD(const uint32_t*, uint8_t*, int) {
+    return 0;
+}
+
+static int bumpToNormalInteriorSIMD(const uint8_t*, const uint8_t*, const uint8_t*, uint32_t*, int) {
+    return 0;
+}
+
+static int downsampleRowsSIMD(const uint32_t*, const uint32_t*, uint32_t*, int) {
+    return 0;
+}
+
+#endif
+
+void countAlpha(const uint32_t* pixels, int count, int& numOpaques, int& numTranslucents) {
+    numOpaques = 0;
+    int numTransparents = 0;
+
+    int i = countAlphaSIMD(pixels, count, numOpaques, numTransparents);
+    for (; i < count; ++i) {
+        uint32_t alpha = pixels[i] >> 24;
+        numOpaques += (alpha == 0xff);
+        numTransparents += (alpha == 0);
+    }
+    numTranslucents = count - numOpaques - numTransparents;
+}
+
+void bumpToNormalRow(const uint8_t* above, const uint8_t* row, const uint8_t* below, uint32_t* normals, int width) {
+    if (width <= 0) {
+        return;
+    }
+    normals[0] = bumpToNormalPixel(above, row, below, 0, width);
+    if (width == 1) {
+        return;
+    }
+
+    int interior = width - 2;
+    int x = 1 + bumpToNormalInteriorSIMD(above + 1, row + 1, below + 1, normals + 1, interior);
+    for (; x < width; ++x) {
+        normals[x] = bumpToNormalPixel(above, row, below, x, width);
+    }
+}
+
+void swapRedBlue(const uint32_t* src, uint32_t* dst, int count) {
+    int i = swapRedBlueSIMD(src, dst, count);
+    for (; i < count; ++i) {
+        dst[i] = swapRedBluePixel(src[i]);
+    }
+}
+
+void extractRed(const uint32_t* src, uint8_t* dst, int count) {
+    int i = extractRedSIMD(src, dst, count);
+    for (; i < count; ++i) {
+        dst[i] = (uint8_t)(src[i] >> 16);
+    }
+}
+
+void downsampleRows(const uint32_t* row0, const uint32_t* row1, uint32_t* dst, int srcWidth, bool gammaCorrect) {
+    const int dstWidth = std::max(srcWidth / 2, 1);
+
+    if (gammaCorrect) {
+        const GammaTables& tables = getGammaTables();
+        for (int x = 0; x < dstWidth; ++x) {
+            const int left = std::min(2 * x, srcWidth - 1);
+            const int right = std::min(2 * x + 1, srcWidth - 1);
+            dst[x] = averagePixelsGamma(row0[left], row0[right], row1[left], row1[right], tables);
+        }
+        return;
+    }
+
+    int x = downsampleRowsSIMD(row0, row1, dst, dstWidth);
+    for (; x < dstWidth; ++x) {
+        const int left = std::min(2 * x, srcWidth - 1);
+        const int right = std::min(2 * x + 1, srcWidth - 1);
+        dst[x] = averagePixels(row0[left], row0[right], row1[left], row1[right]);
+    }
+}
+
+void normalizeNormals(uint32_t* pixels, int count) {
+    for (int i = 0; i < count; ++i) {
+        const uint32_t pixel = pixels[i];
+        const float x = ((pixel >> 16) & 0xff) / NORMAL_SCALE - 1.0f;
+        const float y = ((pixel >> 8) & 0xff) / NORMAL_SCALE - 1.0f;
+        const float z = (pixel & 0xff) / NORMAL_SCALE - 1.0f;
+        const float lengthSquared = x * x + y * y + z * z;
+        if (lengthSquared == 0.0f) {
+            continue;
+        }
+
+        const float scale = NORMAL_SCALE / sqrtf(lengthSquared);
+        const uint32_t red = (uint32_t)(x * scale + NORMAL_BIAS);
+        const uint32_t green = (uint32_t)(y * scale + NORMAL_BIAS);
+        const uint32_t blue = (uint32_t)(z * scale + NORMAL_BIAS);
+        pixels[i] = (pixel & 0xff000000) | (red << 16) | (green << 8) | blue;
+    }
+}
+
+void forEachRowTile(int height, const std::function<void(int firstRow, int endRow)>& function) {
+    if (height <= ROWS_PER_TILE) {
+        function(0, height);
+        return;
+    }
+
+    std::vector<std::pair<int, int>> tiles;
+    tiles.reserve((height + ROWS_PER_TILE - 1) / ROWS_PER_TILE);
+    for (int firstRow = 0; firstRow < height; firstRow += ROWS_PER_TILE) {
+        tiles.emplace_back(firstRow, std::min(firstRow + ROWS_PER_TILE, height));
+    }
+
+    QtConcurrent::blockingMap(tiles, [&function](const std::pair<int, int>& tile) {
+        function(tile.first, tile.second);
+    });
+}
+
+} // namespace kernels
+} // namespace image
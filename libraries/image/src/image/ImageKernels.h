@@ -0,0 +1,54 @@
+//
+//  ImageKernels.h
+//  image/src/image
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_image_ImageKernels_h
+#define hifi_image_ImageKernels_h
+
+#include <cstdint>
+#include <functional>
+
+//
+// Kernels used to process textures, working on raw scanlines of 32 bit ARGB (QImage::Format_ARGB32) pixels,
+// which are stored as B, G, R, A bytes.
+// On x86 they are dispatched at runtime to SSE2 or AVX2 implementations.
+//
+
+namespace image {
+namespace kernels {
+
+/// Counts the opaque (alpha of 255) and translucent (alpha neither 0 nor 255) pixels of a row
+void countAlpha(const uint32_t* pixels, int count, int& numOpaques, int& numTranslucents);
+
+/// Computes the normals of a row of a grayscale height map with a Sobel filter, as ARGB pixels
+/// holding the normal in tangent space, x right and y up, mapped from [-1, 1] to [0, 255].
+/// The rows above and below are clamped to the image by the caller.
+void bumpToNormalRow(const uint8_t* above, const uint8_t* row, const uint8_t* below, uint32_t* normals, int width);
+
+/// Swaps the red and blue channels of a row, converting between BGRA and RGBA. src and dst may be the same.
+void swapRedBlue(const uint32_t* src, uint32_t* dst, int count);
+
+/// Copies the red channel of a row
+void extractRed(const uint32_t* src, uint8_t* dst, int count);
+
+/// Averages the 2x2 blocks of two rows into a row of max(srcWidth / 2, 1) pixels, like a box filtered mip.
+/// When gammaCorrect is set the color channels are averaged in linear space, assuming a 2.2 gamma.
+/// The alpha channel is always averaged as is.
+void downsampleRows(const uint32_t* row0, const uint32_t* row1, uint32_t* dst, int srcWidth, bool gammaCorrect);
+
+/// Rescales the normals stored in the red, green and blue channels of a row, as made by bumpToNormalRow, back to unit length
+void normalizeNormals(uint32_t* pixels, int count);
+
+/// Calls function(firstRow, endRow) on tiles of rows covering [0, height), in parallel for large images
+void forEachRowTile(int height, const std::function<void(int firstRow, int endRow)>& function);
+
+} // namespace kernels
+} // namespace image
+
+#endif // hifi_image_ImageKernels_h
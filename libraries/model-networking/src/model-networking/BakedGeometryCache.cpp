@@ -0,0 +1,39 @@
+//
+//  BakedGeometryCache.cpp
+//  libraries/model-networking/src
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "BakedGeometryCache.h"
+
+#include <SettingHandle.h>
+#include <FBXSerializer.h>
+
+using File = cache::File;
+
+// The version of the serialized geometry is part of the cache version, so that any change to it wipes the cache
+const int BakedGeometryCache::CURRENT_VERSION = (0x01 << 16) | FBX_SERIALIZATION_VERSION;
+const int BakedGeometryCache::INVALID_VERSION = 0x00;
+const char* BakedGeometryCache::SETTING_VERSION_NAME = "hifi.geometry.cache_version";
+
+BakedGeometryCache::BakedGeometryCache(const std::string& dir, const std::string& ext) :
+    FileCache(dir, ext) { }
+
+void BakedGeometryCache::initialize() {
+    FileCache::initialize();
+    Setting::Handle<int> cacheVersionHandle(SETTING_VERSION_NAME, INVALID_VERSION);
+    auto cacheVersion = cacheVersionHandle.get();
+    if (cacheVersion != CURRENT_VERSION) {
+        wipe();
+        cacheVersionHandle.set(CURRENT_VERSION);
+    }
+}
+
+std::unique_ptr<File> BakedGeometryCache::createFile(Metadata&& metadata, const std::string& filepath) {
+    qCInfo(file_cache) << "Wrote baked geometry" << metadata.key.c_str();
+    return FileCache::createFile(std::move(metadata), filepath);
+}
@@ -0,0 +1,36 @@
+//
+//  BakedGeometryCache.h
+//  libraries/model-networking/src
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_BakedGeometryCache_h
+#define hifi_BakedGeometryCache_h
+
+#include <shared/FileCache.h>
+
+// Geometries extracted from models on previous loads, serialized with serializeFBXGeometry.
+// Keyed by a hash of the model content and of everything else the extraction depends on.
+class BakedGeometryCache : public cache::FileCache {
+    Q_OBJECT
+
+public:
+    // Whenever a change is made to the serialized format for the geometry cache that isn't backward compatible,
+    // this value should be incremented.  This will force the geometry cache to be wiped
+    static const int CURRENT_VERSION;
+    static const int INVALID_VERSION;
+    static const char* SETTING_VERSION_NAME;
+
+    BakedGeometryCache(const std::string& dir, const std::string& ext);
+
+    void initialize() override;
+
+protected:
+    std::unique_ptr<cache::File> createFile(Metadata&& metadata, const std::string& filepath) override final;
+};
+
+#endif // hifi_BakedGeometryCache_h
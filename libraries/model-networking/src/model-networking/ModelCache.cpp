@@ -13,11 +13,16 @@
 #include <Finally.h>
 #include <FSTReader.h>
 #include "FBXReader.h"
+#include "FBXSerializer.h"
 #include "OBJReader.h"
 
 #include <gpu/Batch.h>
 #include <gpu/Stream.h>
 
+#include <QCryptographicHash>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
 #include <QThreadPool>
 
 #include <Gzip.h>
@@ -28,6 +33,9 @@
 
 Q_LOGGING_CATEGORY(trace_resource_parse_geometry, "trace.resource.parse.geometry")
 
+const std::string ModelCache::BAKED_GEOMETRY_DIRNAME { "geometry_cache" };
+const std::string ModelCache::BAKED_GEOMETRY_EXT { "geom" };
+
 class GeometryReader;
 
 class GeometryExtra {
@@ -141,6 +149,11 @@ public:
     virtual void run() override;
 
 private:
+    FBXGeometry::Pointer extractGeometry() const;
+    std::string getBakedGeometryKey() const;
+    FBXGeometry::Pointer readBakedGeometry(const std::string& key) const;
+    void writeBakedGeometry(const std::string& key, const FBXGeometry& geometry) const;
+
     QWeakPointer<Resource> _resource;
     QUrl _url;
     QVariantHash _mapping;
@@ -148,6 +161,86 @@ private:
     bool _combineParts;
 };
 
+FBXGeometry::Pointer GeometryReader::extractGeometry() const {
+    FBXGeometry::Pointer fbxGeometry;
+
+    if (_url.path().toLower().endsWith(".fbx")) {
+        fbxGeometry.reset(readFBX(_data, _mapping, _url.path()));
+        if (fbxGeometry->meshes.size() == 0 && fbxGeometry->joints.size() == 0) {
+            throw QString("empty geometry, possibly due to an unsupported FBX version");
+        }
+    } else if (_url.path().toLower().endsWith(".obj")) {
+        fbxGeometry.reset(OBJReader().readOBJ(_data, _mapping, _combineParts, _url));
+    } else if (_url.path().toLower().endsWith(".obj.gz")) {
+        QByteArray uncompressedData;
+        if (gunzip(_data, uncompressedData)){
+            fbxGeometry.reset(OBJReader().readOBJ(uncompressedData, _mapping, _combineParts, _url));
+        } else {
+            throw QString("failed to decompress .obj.gz" );
+        }
+    } else {
+        throw QString("unsupported format");
+    }
+
+    return fbxGeometry;
+}
+
+std::string GeometryReader::getBakedGeometryKey() const {
+    // the extracted geometry depends on the mapping and the url (which textures are resolved against) as well
+    // as on the model itself
+    QCryptographicHash hasher(QCryptographicHash::Md5);
+    hasher.addData(_data);
+    hasher.addData(_url.toString().toUtf8());
+    hasher.addData(QJsonDocument(QJsonObject::fromVariantHash(_mapping)).toJson(QJsonDocument::Compact));
+    hasher.addData(_combineParts ? "1" : "0");
+    return hasher.result().toHex().toStdString();
+}
+
+FBXGeometry::Pointer GeometryReader::readBakedGeometry(const std::string& key) const {
+    FBXGeometry::Pointer fbxGeometry;
+
+    auto modelCache = DependencyManager::get<ModelCache>();
+    if (!modelCache) {
+        return fbxGeometry;
+    }
+
+    // holding on to the cache file keeps it from being evicted while we read it
+    auto file = modelCache->_bakedGeometryCache->getFile(key);
+    if (!file) {
+        return fbxGeometry;
+    }
+
+    PROFILE_RANGE_EX(resource_parse_geometry, "readBakedGeometry", 0xFF00FF00, 0);
+    QFile bakedFile(QString::fromStdString(file->getFilepath()));
+    if (bakedFile.open(QIODevice::ReadOnly)) {
+        auto size = bakedFile.size();
+        auto mapped = bakedFile.map(0, size);
+        if (mapped) {
+            auto data = QByteArray::fromRawData(reinterpret_cast<const char*>(mapped), size);
+            fbxGeometry.reset(unserializeFBXGeometry(data, _url.path()));
+            bakedFile.unmap(mapped);
+        }
+    }
+
+    if (!fbxGeometry) {
+        qCWarning(modelnetworking) << "Invalid baked geometry for" << _url << "under hash" << key.c_str() << ", recreating...";
+    }
+    return fbxGeometry;
+}
+
+void GeometryReader::writeBakedGeometry(const std::string& key, const FBXGeometry& geometry) const {
+    auto modelCache = DependencyManager::get<ModelCache>();
+    if (!modelCache) {
+        return;
+    }
+
+    auto data = serializeFBXGeometry(geometry);
+    if (data.isEmpty() || !modelCache->_bakedGeometryCache->writeFile(data.constData(),
+            cache::FileCache::Metadata(key, data.size()), true)) {
+        qCWarning(modelnetworking) << _url << "geometry cache failed";
+    }
+}
+
 void GeometryReader::run() {
     DependencyManager::get<StatTracker>()->decrementStat("PendingProcessing");
     CounterStat counter("Processing");
@@ -176,25 +269,12 @@ void GeometryReader::run() {
 			(_url.path().toLower().endsWith(".fbx") || 
 			_url.path().toLower().endsWith(".obj") || 
 			_url.path().toLower().endsWith(".obj.gz"))) {
-            FBXGeometry::Pointer fbxGeometry;
-
-            if (_url.path().toLower().endsWith(".fbx")) {
-                fbxGeometry.reset(readFBX(_data, _mapping, _url.path()));
-                if (fbxGeometry->meshes.size() == 0 && fbxGeometry->joints.size() == 0) {
-                    throw QString("empty geometry, possibly due to an unsupported FBX version");
-                }
-            } else if (_url.path().toLower().endsWith(".obj")) {
-                fbxGeometry.reset(OBJReader().readOBJ(_data, _mapping, _combineParts, _url));
-			} else if (_url.path().toLower().endsWith(".obj.gz")) {
-				QByteArray uncompressedData;
-				if (gunzip(_data, uncompressedData)){
-					fbxGeometry.reset(OBJReader().readOBJ(uncompressedData, _mapping, _combineParts, _url));
-				} else {
-					throw QString("failed to decompress .obj.gz" );
-				}
-
-			} else {
-                throw QString("unsupported format");
+            // models we extracted before are restored from the baked geometry cache instead of being parsed again
+            auto bakedGeometryKey = getBakedGeometryKey();
+            FBXGeometry::Pointer fbxGeometry = readBakedGeometry(bakedGeometryKey);
+            if (!fbxGeometry) {
+                fbxGeometry = extractGeometry();
+                writeBakedGeometry(bakedGeometryKey, *fbxGeometry);
             }
 
             // Ensure the resource has not been deleted
@@ -274,6 +354,7 @@ void GeometryDefinitionResource::setGeometryDefinition(FBXGeometry::Pointer fbxG
 }
 
 ModelCache::ModelCache() {
+    _bakedGeometryCache->initialize();
     const qint64 GEOMETRY_DEFAULT_UNUSED_MAX_SIZE = DEFAULT_UNUSED_MAX_SIZE;
     setUnusedResourceCacheSize(GEOMETRY_DEFAULT_UNUSED_MAX_SIZE);
     setObjectName("ModelCache");
@@ -20,6 +20,7 @@
 
 #include "FBXReader.h"
 #include "TextureCache.h"
+#include "BakedGeometryCache.h"
 
 // Alias instead of derive to avoid copying
 
@@ -152,8 +153,16 @@ protected:
                                                     const void* extra) override;
 
 private:
+    friend class GeometryReader;
+
     ModelCache();
     virtual ~ModelCache() = default;
+
+    static const std::string BAKED_GEOMETRY_DIRNAME;
+    static const std::string BAKED_GEOMETRY_EXT;
+
+    std::shared_ptr<cache::FileCache> _bakedGeometryCache {
+        std::make_shared<BakedGeometryCache>(BAKED_GEOMETRY_DIRNAME, BAKED_GEOMETRY_EXT) };
 };
 
 class NetworkMaterial : public model::Material {
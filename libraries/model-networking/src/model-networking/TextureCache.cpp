@@ -37,8 +37,12 @@
 #include <NumericalConstants.h>
 #include <shared/NsightHelpers.h>
 
+#include <AssetClient.h>
+#include <AssetResourceRequest.h>
 #include <Finally.h>
+#include <MappingRequest.h>
 #include <Profile.h>
+#include <ResourceManager.h>
 
 #include "NetworkLogging.h"
 #include "ModelNetworkingLogging.h"
@@ -350,7 +354,12 @@ private:
 };
 
 NetworkTexture::~NetworkTexture() {
-    if (_ktxHeaderRequest || _ktxMipRequest) {
+    if (_ktxHeaderRequest || _ktxMipRequest || _bakedTextureRequest) {
+        if (_bakedTextureRequest) {
+            _bakedTextureRequest->disconnect(this);
+            _bakedTextureRequest->deleteLater();
+            _bakedTextureRequest = nullptr;
+        }
         if (_ktxHeaderRequest) {
             _ktxHeaderRequest->disconnect(this);
             _ktxHeaderRequest->deleteLater();
@@ -368,10 +377,21 @@ NetworkTexture::~NetworkTexture() {
 const uint16_t NetworkTexture::NULL_MIP_LEVEL = std::numeric_limits<uint16_t>::max();
 void NetworkTexture::makeRequest() {
     if (!_sourceIsKTX) {
+        // images on the asset-server may have been baked into a KTX, look for it before downloading the image
+        if (!_bakedTextureLookedUp && canUseBakedTexture()) {
+            requestBakedTexture();
+            return;
+        }
+
         Resource::makeRequest();
         return;
     }
 
+    if (_bakedUrl.isValid()) {
+        // init() points the active url back at the image, keep loading from the baked texture
+        _activeUrl = _bakedUrl;
+    }
+
     // We special-handle ktx requests to run 2 concurrent requests right off the bat
     PROFILE_ASYNC_BEGIN(resource, "Resource:" + getType(), QString::number(_requestID), { { "url", _url.toString() }, { "activeURL", _activeUrl.toString() } });
 
@@ -420,6 +440,55 @@ void NetworkTexture::makeRequest() {
 
 }
 
+bool NetworkTexture::canUseBakedTexture() const {
+    // only look the texture up when the asset-server said it bakes them, the lookup delays the load otherwise
+    if (_activeUrl.scheme() != URL_SCHEME_ATP ||
+            !DependencyManager::get<AssetClient>()->serverHasCapability(AssetServerCapability::HasBakedTextures)) {
+        return false;
+    }
+
+    // textures are baked the way clients process color maps at full size, with the default compression settings
+    switch (_type) {
+        case image::TextureUsage::DEFAULT_TEXTURE:
+        case image::TextureUsage::ALBEDO_TEXTURE:
+        case image::TextureUsage::EMISSIVE_TEXTURE:
+        case image::TextureUsage::LIGHTMAP_TEXTURE:
+            return _maxNumPixels == ABSOLUTE_MAX_TEXTURE_NUM_PIXELS && !image::isColorTexturesCompressionEnabled();
+        default:
+            return false;
+    }
+}
+
+void NetworkTexture::requestBakedTexture() {
+    _bakedTextureLookedUp = true;
+
+    // the asset-server finds the image by path or by hash, without the extension of atp:<hash>.<ext> urls
+    auto pathOrHash = _activeUrl.path();
+    if (AssetResourceRequest::urlIsAssetHash(_activeUrl)) {
+        pathOrHash = pathOrHash.split(".", QString::SkipEmptyParts).value(0);
+    }
+
+    _bakedTextureRequest = DependencyManager::get<AssetClient>()->createGetBakedTextureRequest(pathOrHash);
+
+    connect(_bakedTextureRequest, &GetBakedTextureRequest::finished, this, [this](GetBakedTextureRequest* request) {
+        _bakedTextureRequest = nullptr;
+        request->deleteLater();
+
+        if (request->getError() == MappingRequest::NoError) {
+            qCDebug(networking).noquote() << "Loading" << _url.toDisplayString() << "from its baked texture" << request->getHash();
+
+            _bakedUrl = QUrl(URL_SCHEME_ATP + ":" + request->getHash() + ".ktx");
+            _sourceIsKTX = true;
+            _ktxResourceState = PENDING_INITIAL_LOAD;
+        }
+
+        // we still hold our request slot, carry on with either the baked texture or the image
+        makeRequest();
+    });
+
+    _bakedTextureRequest->start();
+}
+
 void NetworkTexture::startRequestForNextMipLevel() {
     auto self = _self.lock();
     if (!self) {
@@ -518,6 +587,17 @@ void NetworkTexture::ktxInitialDataRequestFinished() {
         _ktxHeaderData = _ktxHeaderRequest->getData();
         _ktxHighMipData = _ktxMipRequest->getData();
         handleFinishedInitialLoad();
+    } else if (_bakedUrl.isValid() && result != ResourceRequest::Timeout && result != ResourceRequest::ServerUnavailable) {
+        // the baked texture went away, fall back to the image it was baked from
+        qCDebug(networking).noquote() << "Failed to load the baked texture of" << _url.toDisplayString() << "- loading the image";
+
+        _bakedUrl = QUrl();
+        _sourceIsKTX = false;
+        _ktxResourceState = PENDING_INITIAL_LOAD;
+        _url.setFragment(QString());
+        _activeUrl = _url;
+
+        QMetaObject::invokeMethod(this, "attemptRequest", Qt::QueuedConnection);
     } else {
         if (handleFailedRequest(result)) {
             _ktxResourceState = PENDING_INITIAL_LOAD;
@@ -801,7 +881,7 @@ void NetworkTexture::loadContent(const QByteArray& content) {
 }
 
 void NetworkTexture::refresh() {
-    if ((_ktxHeaderRequest || _ktxMipRequest) && !_loaded && !_failedToLoad) {
+    if ((_ktxHeaderRequest || _ktxMipRequest || _bakedTextureRequest) && !_loaded && !_failedToLoad) {
         return;
     }
     if (_ktxHeaderRequest || _ktxMipRequest) {
@@ -818,6 +898,11 @@ void NetworkTexture::refresh() {
         TextureCache::requestCompleted(_self);
     }
 
+    // the baked texture may have changed along with the image, look it up again
+    _bakedTextureLookedUp = false;
+    _bakedUrl = QUrl();
+    _sourceIsKTX = _url.path().endsWith(".ktx");
+
     _ktxResourceState = PENDING_INITIAL_LOAD;
     Resource::refresh();
 }
@@ -31,6 +31,8 @@ namespace gpu {
 class Batch;
 }
 
+class GetBakedTextureRequest;
+
 /// A simple object wrapper for an OpenGL texture.
 class Texture {
 public:
@@ -83,6 +85,10 @@ protected:
     void startMipRangeRequest(uint16_t low, uint16_t high);
     void handleFinishedInitialLoad();
 
+    /// Returns true if the asset-server may have baked this texture into a KTX we can load instead of the image
+    bool canUseBakedTexture() const;
+    void requestBakedTexture();
+
 private:
     friend class KTXReader;
     friend class ImageReader;
@@ -102,6 +108,12 @@ private:
     bool _sourceIsKTX { false };
     KTXResourceState _ktxResourceState { PENDING_INITIAL_LOAD };
 
+    // The KTX the asset-server baked from the image, looked up once before the image is requested.
+    // When found, the texture is loaded from it like any KTX source.
+    bool _bakedTextureLookedUp { false };
+    GetBakedTextureRequest* _bakedTextureRequest { nullptr };
+    QUrl _bakedUrl;
+
     // The current mips that are currently being requested w/ _ktxMipRequest
     std::pair<uint16_t, uint16_t> _ktxMipLevelRangeInFlight{ NULL_MIP_LEVEL, NULL_MIP_LEVEL };
 
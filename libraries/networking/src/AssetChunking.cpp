@@ -0,0 +1,89 @@
+//
+//  AssetChunking.cpp
+//  libraries/networking/src
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "AssetChunking.h"
+
+#include <array>
+
+#include "AssetUtils.h"
+
+using GearTable = std::array<uint64_t, 256>;
+
+static const GearTable& gearTable() {
+    // The table only needs to be random looking and identical everywhere, since chunk boundaries must agree
+    // between clients and servers. Fill it from a fixed seed with splitmix64.
+    static const GearTable TABLE = [] {
+        GearTable table;
+        uint64_t state = 0x2545F4914F6CDD1DULL;
+        for (auto& entry : table) {
+            state += 0x9E3779B97F4A7C15ULL;
+            uint64_t z = state;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            entry = z ^ (z >> 31);
+        }
+        return table;
+    }();
+    return TABLE;
+}
+
+// Normalized chunking: a harder mask (more bits) before the average size and an easier one after it
+// pulls the chunk sizes towards the average. The masks use the high bits of the hash, which have seen the
+// most bytes of the rolling window.
+static const uint64_t MASK_BEFORE_AVERAGE = 0xFFFFC00000000000ULL; // 18 bits
+static const uint64_t MASK_AFTER_AVERAGE = 0xFFFC000000000000ULL; // 14 bits
+
+int64_t findChunkBoundary(const char* data, int64_t size) {
+    if (size <= MIN_ASSET_CHUNK_SIZE) {
+        return size;
+    }
+
+    const auto& table = gearTable();
+    auto bytes = reinterpret_cast<const uint8_t*>(data);
+
+    auto end = std::min(size, MAX_ASSET_CHUNK_SIZE);
+    auto average = std::min(end, AVERAGE_ASSET_CHUNK_SIZE);
+
+    uint64_t hash = 0;
+    int64_t i = MIN_ASSET_CHUNK_SIZE;
+
+    for (; i < average; ++i) {
+        hash = (hash << 1) + table[bytes[i]];
+        if (!(hash & MASK_BEFORE_AVERAGE)) {
+            return i + 1;
+        }
+    }
+
+    for (; i < end; ++i) {
+        hash = (hash << 1) + table[bytes[i]];
+        if (!(hash & MASK_AFTER_AVERAGE)) {
+            return i + 1;
+        }
+    }
+
+    return end;
+}
+
+AssetChunkList chunkData(const QByteArray& data) {
+    AssetChunkList chunks;
+    chunks.reserve(data.size() / AVERAGE_ASSET_CHUNK_SIZE + 1);
+
+    int64_t offset = 0;
+    while (offset < data.size()) {
+        auto chunkSize = findChunkBoundary(data.constData() + offset, data.size() - offset);
+
+        auto chunkData = QByteArray::fromRawData(data.constData() + offset, chunkSize);
+        chunks.push_back({ offset, chunkSize, hashData(chunkData) });
+
+        offset += chunkSize;
+    }
+
+    return chunks;
+}
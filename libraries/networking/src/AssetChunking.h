@@ -0,0 +1,45 @@
+//
+//  AssetChunking.h
+//  libraries/networking/src
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_AssetChunking_h
+#define hifi_AssetChunking_h
+
+#include <cstdint>
+#include <vector>
+
+#include <QtCore/QByteArray>
+
+// Content-defined chunking of assets, used to only transfer and store the parts of an asset
+// that the asset-server doesn't already have.
+// Chunk boundaries are found with a rolling gear hash (FastCDC style normalized chunking), so an edit in
+// one part of an asset only changes the chunks around the edit and the following chunks re-synchronize.
+
+struct AssetChunk {
+    int64_t offset;
+    int64_t size;
+    QByteArray hash; // SHA-256 of the chunk data
+};
+
+using AssetChunkList = std::vector<AssetChunk>;
+
+const int64_t MIN_ASSET_CHUNK_SIZE = 16 * 1024;
+const int64_t AVERAGE_ASSET_CHUNK_SIZE = 64 * 1024;
+const int64_t MAX_ASSET_CHUNK_SIZE = 256 * 1024;
+
+// assets smaller than this are always uploaded whole, there is little to gain from chunking them
+const int64_t MIN_CHUNKED_UPLOAD_SIZE = 1024 * 1024;
+
+/// Returns the size of the first chunk of `data`, which is at most MAX_ASSET_CHUNK_SIZE
+int64_t findChunkBoundary(const char* data, int64_t size);
+
+/// Splits `data` in content-defined chunks and hashes them
+AssetChunkList chunkData(const QByteArray& data);
+
+#endif // hifi_AssetChunking_h
@@ -14,13 +14,16 @@
 #include <cstdint>
 
 #include <QtCore/QBuffer>
+#include <QtCore/QRunnable>
 #include <QtCore/QStandardPaths>
 #include <QtCore/QThread>
+#include <QtCore/QThreadPool>
 #include <QtScript/QScriptEngine>
 #include <QtNetwork/QNetworkDiskCache>
 
 #include <shared/GlobalAppProperties.h>
 
+#include "AssetChunking.h"
 #include "AssetRequest.h"
 #include "AssetUpload.h"
 #include "AssetUtils.h"
@@ -33,6 +36,26 @@
 
 MessageID AssetClient::_currentID = 0;
 
+static int messageIDMetaTypeId = qRegisterMetaType<MessageID>("MessageID");
+
+// Splits an upload into chunks and hashes them, which takes a while for large assets, away from the AssetClient thread
+class UploadChunker : public QRunnable {
+public:
+    UploadChunker(AssetClient* assetClient, MessageID messageID, std::shared_ptr<AssetClient::ChunkedUploadData> upload) :
+        _assetClient(assetClient), _messageID(messageID), _upload(upload) {}
+
+    void run() override {
+        // the upload is only read back by the AssetClient once it handles the queued call
+        _upload->chunks = chunkData(_upload->data);
+        QMetaObject::invokeMethod(_assetClient, "handleUploadChunked", Qt::QueuedConnection, Q_ARG(MessageID, _messageID));
+    }
+
+private:
+    AssetClient* _assetClient;
+    MessageID _messageID;
+    std::shared_ptr<AssetClient::ChunkedUploadData> _upload;
+};
+
 AssetClient::AssetClient() {
     _cacheDir = qApp->property(hifi::properties::APP_LOCAL_DATA_PATH).toString();
     setCustomDeleter([](Dependency* dependency){
@@ -46,7 +69,9 @@ AssetClient::AssetClient() {
     packetReceiver.registerListener(PacketType::AssetGetInfoReply, this, "handleAssetGetInfoReply");
     packetReceiver.registerListener(PacketType::AssetGetReply, this, "handleAssetGetReply", true);
     packetReceiver.registerListener(PacketType::AssetUploadReply, this, "handleAssetUploadReply");
+    packetReceiver.registerListener(PacketType::AssetChunkQueryReply, this, "handleAssetChunkQueryReply");
 
+    connect(nodeList.data(), &LimitedNodeList::nodeActivated, this, &AssetClient::handleNodeActivated);
     connect(nodeList.data(), &LimitedNodeList::nodeKilled, this, &AssetClient::handleNodeKilled);
     connect(nodeList.data(), &LimitedNodeList::clientConnectionToNodeReset,
             this, &AssetClient::handleNodeClientConnectionReset);
@@ -153,6 +178,14 @@ GetMappingRequest* AssetClient::createGetMappingRequest(const AssetPath& path) {
     return request;
 }
 
+GetBakedTextureRequest* AssetClient::createGetBakedTextureRequest(const QString& pathOrHash) {
+    auto request = new GetBakedTextureRequest(pathOrHash);
+
+    request->moveToThread(thread());
+
+    return request;
+}
+
 GetAllMappingsRequest* AssetClient::createGetAllMappingsRequest() {
     auto request = new GetAllMappingsRequest();
 
@@ -226,7 +259,14 @@ MessageID AssetClient::getAsset(const QString& hash, DataOffset start, DataOffse
 
         auto messageID = ++_currentID;
 
-        auto payloadSize = sizeof(messageID) + SHA256_HASH_LENGTH + sizeof(start) + sizeof(end);
+        ByteRange byteRange;
+        byteRange.fromInclusive = start;
+        byteRange.toExclusive = end;
+
+        // a compressed variant is the whole asset, so it can only be accepted for requests without a byte range
+        uint8_t flags = byteRange.isSet() ? 0 : AcceptGzipEncoding;
+
+        auto payloadSize = sizeof(messageID) + SHA256_HASH_LENGTH + sizeof(start) + sizeof(end) + sizeof(flags);
         auto packet = NLPacket::create(PacketType::AssetGet, payloadSize, true);
 
         qCDebug(asset_client) << "Requesting data from" << start << "to" << end << "of" << hash << "from asset-server.";
@@ -237,6 +277,7 @@ MessageID AssetClient::getAsset(const QString& hash, DataOffset start, DataOffse
 
         packet->writePrimitive(start);
         packet->writePrimitive(end);
+        packet->writePrimitive(flags);
 
         if (nodeList->sendPacket(std::move(packet), *assetServer) != -1) {
             _pendingRequests[assetServer][messageID] = { QSharedPointer<ReceivedMessage>(), callback, progressCallback };
@@ -245,7 +286,7 @@ MessageID AssetClient::getAsset(const QString& hash, DataOffset start, DataOffse
         }
     }
 
-    callback(false, AssetServerError::NoError, QByteArray());
+    callback(false, AssetServerError::NoError, QByteArray(), AssetEncoding::Identity);
     return INVALID_MESSAGE_ID;
 }
 
@@ -323,8 +364,10 @@ void AssetClient::handleAssetGetReply(QSharedPointer<ReceivedMessage> message, S
     AssetServerError error;
     message->readHeadPrimitive(&error);
 
+    AssetEncoding encoding { AssetEncoding::Identity };
     DataOffset length = 0;
     if (!error) {
+        message->readHeadPrimitive(&encoding);
         message->readHeadPrimitive(&length);
     } else {
         qCWarning(asset_client) << "Failure getting asset: " << error;
@@ -351,6 +394,7 @@ void AssetClient::handleAssetGetReply(QSharedPointer<ReceivedMessage> message, S
 
     // Store message in case we need to disconnect from it later.
     callbacks.message = message;
+    callbacks.encoding = encoding;
 
 
     auto weakNode = senderNode.toWeakRef();
@@ -365,9 +409,9 @@ void AssetClient::handleAssetGetReply(QSharedPointer<ReceivedMessage> message, S
         disconnect(message.data(), nullptr, this, nullptr);
 
         if (length != message->getBytesLeftToRead()) {
-            callbacks.completeCallback(false, error, QByteArray());
+            callbacks.completeCallback(false, error, QByteArray(), encoding);
         } else {
-            callbacks.completeCallback(true, error, message->readAll());
+            callbacks.completeCallback(true, error, message->readAll(), encoding);
         }
 
 
@@ -436,9 +480,9 @@ void AssetClient::handleCompleteCallback(const QWeakPointer<Node>& node, Message
     }
 
     if (message->failed() || length != message->getBytesLeftToRead()) {
-        callbacks.completeCallback(false, AssetServerError::NoError, QByteArray());
+        callbacks.completeCallback(false, AssetServerError::NoError, QByteArray(), callbacks.encoding);
     } else {
-        callbacks.completeCallback(true, AssetServerError::NoError, message->readAll());
+        callbacks.completeCallback(true, AssetServerError::NoError, message->readAll(), callbacks.encoding);
     }
 
     // We should never get to this point without the associated senderNode and messageID
@@ -585,6 +629,54 @@ MessageID AssetClient::renameAssetMapping(const AssetPath& oldPath, const AssetP
     return INVALID_MESSAGE_ID;
 }
 
+MessageID AssetClient::getBakedTextureMapping(const QString& pathOrHash, MappingOperationCallback callback) {
+    Q_ASSERT(QThread::currentThread() == thread());
+
+    auto nodeList = DependencyManager::get<NodeList>();
+    SharedNodePointer assetServer = nodeList->soloNodeOfType(NodeType::AssetServer);
+
+    if (assetServer) {
+        auto packetList = NLPacketList::create(PacketType::AssetMappingOperation, QByteArray(), true, true);
+
+        auto messageID = ++_currentID;
+        packetList->writePrimitive(messageID);
+
+        packetList->writePrimitive(AssetMappingOperationType::GetBakedTexture);
+
+        packetList->writeString(pathOrHash);
+
+        if (nodeList->sendPacketList(std::move(packetList), *assetServer) != -1) {
+            _pendingMappingRequests[assetServer][messageID] = callback;
+
+            return messageID;
+        }
+    }
+
+    callback(false, AssetServerError::NoError, QSharedPointer<ReceivedMessage>());
+    return INVALID_MESSAGE_ID;
+}
+
+MessageID AssetClient::getServerCapabilities(const SharedNodePointer& assetServer, MappingOperationCallback callback) {
+    Q_ASSERT(QThread::currentThread() == thread());
+
+    auto nodeList = DependencyManager::get<NodeList>();
+    auto packetList = NLPacketList::create(PacketType::AssetMappingOperation, QByteArray(), true, true);
+
+    auto messageID = ++_currentID;
+    packetList->writePrimitive(messageID);
+
+    packetList->writePrimitive(AssetMappingOperationType::GetServerCapabilities);
+
+    if (nodeList->sendPacketList(std::move(packetList), *assetServer) != -1) {
+        _pendingMappingRequests[assetServer][messageID] = callback;
+
+        return messageID;
+    }
+
+    callback(false, AssetServerError::NoError, QSharedPointer<ReceivedMessage>());
+    return INVALID_MESSAGE_ID;
+}
+
 bool AssetClient::cancelMappingRequest(MessageID id) {
     Q_ASSERT(QThread::currentThread() == thread());
 
@@ -639,7 +731,16 @@ bool AssetClient::cancelUploadAssetRequest(MessageID id) {
             return true;
         }
     }
-    return false;
+
+    // the upload might still be waiting to hear which chunks the asset-server is missing
+    for (auto& kv : _pendingChunkQueries) {
+        if (kv.second.erase(id)) {
+            return true;
+        }
+    }
+
+    // or still be split into chunks, which is left to finish
+    return _pendingChunkings.erase(id) > 0;
 }
 
 MessageID AssetClient::uploadAsset(const QByteArray& data, UploadResultCallback callback) {
@@ -649,16 +750,20 @@ MessageID AssetClient::uploadAsset(const QByteArray& data, UploadResultCallback
     SharedNodePointer assetServer = nodeList->soloNodeOfType(NodeType::AssetServer);
 
     if (assetServer) {
-        auto packetList = NLPacketList::create(PacketType::AssetUpload, QByteArray(), true, true);
-
         auto messageID = ++_currentID;
-        packetList->writePrimitive(messageID);
 
-        uint64_t size = data.length();
-        packetList->writePrimitive(size);
-        packetList->write(data.constData(), size);
+        if (data.size() >= MIN_CHUNKED_UPLOAD_SIZE && serverHasCapability(AssetServerCapability::CanUploadChunks)) {
+            // large assets are often new revisions of something already uploaded,
+            // so first ask the asset-server which of their chunks it is missing, once they are known
+            auto upload = std::make_shared<ChunkedUploadData>();
+            upload->data = data;
+            upload->callback = callback;
+            _pendingChunkings[messageID] = upload;
 
-        if (nodeList->sendPacketList(std::move(packetList), *assetServer) != -1) {
+            QThreadPool::globalInstance()->start(new UploadChunker(this, messageID, upload));
+
+            return messageID;
+        } else if (sendAssetUpload(assetServer, messageID, data)) {
             _pendingUploads[assetServer][messageID] = callback;
 
             return messageID;
@@ -669,6 +774,145 @@ MessageID AssetClient::uploadAsset(const QByteArray& data, UploadResultCallback
     return INVALID_MESSAGE_ID;
 }
 
+bool AssetClient::sendAssetUpload(const SharedNodePointer& assetServer, MessageID messageID, const QByteArray& data) {
+    auto nodeList = DependencyManager::get<NodeList>();
+    auto packetList = NLPacketList::create(PacketType::AssetUpload, QByteArray(), true, true);
+
+    packetList->writePrimitive(messageID);
+
+    uint64_t size = data.length();
+    packetList->writePrimitive(size);
+    packetList->write(data.constData(), size);
+
+    return nodeList->sendPacketList(std::move(packetList), *assetServer) != -1;
+}
+
+bool AssetClient::sendChunkedAssetUpload(const SharedNodePointer& assetServer, MessageID messageID,
+                                         const ChunkedUploadData& upload, const QSet<uint32_t>& missingChunks) {
+    auto nodeList = DependencyManager::get<NodeList>();
+    auto packetList = NLPacketList::create(PacketType::AssetChunkedUpload, QByteArray(), true, true);
+
+    packetList->writePrimitive(messageID);
+
+    uint64_t size = upload.data.length();
+    packetList->writePrimitive(size);
+
+    uint32_t numChunks = (uint32_t)upload.chunks.size();
+    packetList->writePrimitive(numChunks);
+
+    int64_t bytesSkipped = 0;
+
+    for (uint32_t i = 0; i < numChunks; ++i) {
+        const auto& chunk = upload.chunks[i];
+
+        packetList->write(chunk.hash);
+
+        uint32_t chunkSize = (uint32_t)chunk.size;
+        packetList->writePrimitive(chunkSize);
+
+        // only send the data of the chunks the asset-server doesn't already have
+        uint8_t hasData = missingChunks.contains(i);
+        packetList->writePrimitive(hasData);
+
+        if (hasData) {
+            packetList->write(upload.data.constData() + chunk.offset, chunk.size);
+        } else {
+            bytesSkipped += chunk.size;
+        }
+    }
+
+    qCDebug(asset_client) << "Uploading" << missingChunks.size() << "of" << numChunks << "chunks to asset-server,"
+        << bytesSkipped << "of" << size << "bytes were already there";
+
+    return nodeList->sendPacketList(std::move(packetList), *assetServer) != -1;
+}
+
+void AssetClient::handleUploadChunked(MessageID messageID) {
+    Q_ASSERT(QThread::currentThread() == thread());
+
+    auto it = _pendingChunkings.find(messageID);
+    if (it == _pendingChunkings.end()) {
+        // the upload was cancelled while it was being chunked
+        return;
+    }
+
+    auto upload = std::move(*it->second);
+    _pendingChunkings.erase(it);
+
+    auto nodeList = DependencyManager::get<NodeList>();
+    SharedNodePointer assetServer = nodeList->soloNodeOfType(NodeType::AssetServer);
+
+    if (assetServer) {
+        auto packetList = NLPacketList::create(PacketType::AssetChunkQuery, QByteArray(), true, true);
+        packetList->writePrimitive(messageID);
+
+        uint32_t numChunks = (uint32_t)upload.chunks.size();
+        packetList->writePrimitive(numChunks);
+        for (const auto& chunk : upload.chunks) {
+            packetList->write(chunk.hash);
+        }
+
+        if (nodeList->sendPacketList(std::move(packetList), *assetServer) != -1) {
+            _pendingChunkQueries[assetServer][messageID] = std::move(upload);
+            return;
+        }
+    }
+
+    upload.callback(false, AssetServerError::NoError, QString());
+}
+
+void AssetClient::handleAssetChunkQueryReply(QSharedPointer<ReceivedMessage> message, SharedNodePointer senderNode) {
+    Q_ASSERT(QThread::currentThread() == thread());
+
+    MessageID messageID;
+    message->readPrimitive(&messageID);
+
+    AssetServerError error;
+    message->readPrimitive(&error);
+
+    auto messageMapIt = _pendingChunkQueries.find(senderNode);
+    if (messageMapIt == _pendingChunkQueries.end()) {
+        return;
+    }
+
+    auto& messageCallbackMap = messageMapIt->second;
+    auto requestIt = messageCallbackMap.find(messageID);
+    if (requestIt == messageCallbackMap.end()) {
+        return;
+    }
+
+    auto upload = std::move(requestIt->second);
+    messageCallbackMap.erase(requestIt);
+
+    bool sent = false;
+
+    if (error == AssetServerError::NoError) {
+        uint32_t numMissingChunks { 0 };
+        message->readPrimitive(&numMissingChunks);
+
+        QSet<uint32_t> missingChunks;
+        for (uint32_t i = 0; i < numMissingChunks && message->getBytesLeftToRead() >= (qint64)sizeof(uint32_t); ++i) {
+            uint32_t chunkIndex;
+            message->readPrimitive(&chunkIndex);
+            missingChunks << chunkIndex;
+        }
+
+        sent = sendChunkedAssetUpload(senderNode, messageID, upload, missingChunks);
+    } else if (error == AssetServerError::ChunkedUploadsDisabled) {
+        // this asset-server only stores whole assets, upload it the regular way
+        sent = sendAssetUpload(senderNode, messageID, upload.data);
+    } else {
+        upload.callback(true, error, QString());
+        return;
+    }
+
+    if (sent) {
+        _pendingUploads[senderNode][messageID] = upload.callback;
+    } else {
+        upload.callback(false, AssetServerError::NoError, QString());
+    }
+}
+
 void AssetClient::handleAssetUploadReply(QSharedPointer<ReceivedMessage> message, SharedNodePointer senderNode) {
     Q_ASSERT(QThread::currentThread() == thread());
 
@@ -709,6 +953,30 @@ void AssetClient::handleAssetUploadReply(QSharedPointer<ReceivedMessage> message
     }
 }
 
+void AssetClient::handleNodeActivated(SharedNodePointer node) {
+    Q_ASSERT(QThread::currentThread() == thread());
+
+    if (node->getType() != NodeType::AssetServer) {
+        return;
+    }
+
+    // the optional features cost a round trip when the asset-server doesn't have them, so ask once which it has
+    QWeakPointer<Node> weakNode = node;
+    getServerCapabilities(node, [this, weakNode](bool responseReceived, AssetServerError error,
+                                                 QSharedPointer<ReceivedMessage> message) {
+        auto assetServer = weakNode.lock();
+        if (!responseReceived || error != AssetServerError::NoError || !assetServer ||
+                assetServer != DependencyManager::get<NodeList>()->soloNodeOfType(NodeType::AssetServer)) {
+            return;
+        }
+
+        uint32_t capabilities { 0 };
+        message->readPrimitive(&capabilities);
+        _serverCapabilities = capabilities;
+        qCDebug(asset_client) << "Asset-server capabilities:" << capabilities;
+    });
+}
+
 void AssetClient::handleNodeKilled(SharedNodePointer node) {
     Q_ASSERT(QThread::currentThread() == thread());
 
@@ -716,6 +984,8 @@ void AssetClient::handleNodeKilled(SharedNodePointer node) {
         return;
     }
 
+    _serverCapabilities = 0;
+
     forceFailureOfPendingRequests(node);
 
     {
@@ -727,6 +997,15 @@ void AssetClient::handleNodeKilled(SharedNodePointer node) {
             messageMapIt->second.clear();
         }
     }
+    {
+        auto messageMapIt = _pendingChunkQueries.find(node);
+        if (messageMapIt != _pendingChunkQueries.end()) {
+            for (const auto& value : messageMapIt->second) {
+                value.second.callback(false, AssetServerError::NoError, "");
+            }
+            messageMapIt->second.clear();
+        }
+    }
 }
 
 void AssetClient::handleNodeClientConnectionReset(SharedNodePointer node) {
@@ -754,7 +1033,7 @@ void AssetClient::forceFailureOfPendingRequests(SharedNodePointer node) {
                     disconnect(message.data(), nullptr, this, nullptr);
                 }
 
-                value.second.completeCallback(false, AssetServerError::NoError, QByteArray());
+                value.second.completeCallback(false, AssetServerError::NoError, QByteArray(), AssetEncoding::Identity);
             }
             messageMapIt->second.clear();
         }
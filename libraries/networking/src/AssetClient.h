@@ -16,10 +16,13 @@
 #include <QtQml/QJSEngine>
 #include <QString>
 
+#include <atomic>
 #include <map>
+#include <memory>
 
 #include <DependencyManager.h>
 
+#include "AssetChunking.h"
 #include "AssetUtils.h"
 #include "ByteRange.h"
 #include "ClientServerUtils.h"
@@ -32,6 +35,7 @@ class SetMappingRequest;
 class GetAllMappingsRequest;
 class DeleteMappingsRequest;
 class RenameMappingRequest;
+class GetBakedTextureRequest;
 class AssetRequest;
 class AssetUpload;
 
@@ -41,7 +45,8 @@ struct AssetInfo {
 };
 
 using MappingOperationCallback = std::function<void(bool responseReceived, AssetServerError serverError, QSharedPointer<ReceivedMessage> message)>;
-using ReceivedAssetCallback = std::function<void(bool responseReceived, AssetServerError serverError, const QByteArray& data)>;
+using ReceivedAssetCallback = std::function<void(bool responseReceived, AssetServerError serverError,
+                                                 const QByteArray& data, AssetEncoding encoding)>;
 using GetInfoCallback = std::function<void(bool responseReceived, AssetServerError serverError, AssetInfo info)>;
 using UploadResultCallback = std::function<void(bool responseReceived, AssetServerError serverError, const QString& hash)>;
 using ProgressCallback = std::function<void(qint64 totalReceived, qint64 total)>;
@@ -56,10 +61,15 @@ public:
     Q_INVOKABLE DeleteMappingsRequest* createDeleteMappingsRequest(const AssetPathList& paths);
     Q_INVOKABLE SetMappingRequest* createSetMappingRequest(const AssetPath& path, const AssetHash& hash);
     Q_INVOKABLE RenameMappingRequest* createRenameMappingRequest(const AssetPath& oldPath, const AssetPath& newPath);
+    Q_INVOKABLE GetBakedTextureRequest* createGetBakedTextureRequest(const QString& pathOrHash);
     Q_INVOKABLE AssetRequest* createRequest(const AssetHash& hash, const ByteRange& byteRange = ByteRange());
     Q_INVOKABLE AssetUpload* createUpload(const QString& filename);
     Q_INVOKABLE AssetUpload* createUpload(const QByteArray& data);
 
+    /// Whether the asset-server we are connected to is known to have the capability, thread safe.
+    /// No capability is known until the asset-server replied to the query sent when it activated.
+    bool serverHasCapability(AssetServerCapability capability) const { return (_serverCapabilities & capability) != 0; }
+
 public slots:
     void init();
 
@@ -71,7 +81,10 @@ private slots:
     void handleAssetGetInfoReply(QSharedPointer<ReceivedMessage> message, SharedNodePointer senderNode);
     void handleAssetGetReply(QSharedPointer<ReceivedMessage> message, SharedNodePointer senderNode);
     void handleAssetUploadReply(QSharedPointer<ReceivedMessage> message, SharedNodePointer senderNode);
+    void handleAssetChunkQueryReply(QSharedPointer<ReceivedMessage> message, SharedNodePointer senderNode);
+    void handleUploadChunked(MessageID messageID);
 
+    void handleNodeActivated(SharedNodePointer node);
     void handleNodeKilled(SharedNodePointer node);
     void handleNodeClientConnectionReset(SharedNodePointer node);
 
@@ -81,6 +94,8 @@ private:
     MessageID setAssetMapping(const QString& path, const AssetHash& hash, MappingOperationCallback callback);
     MessageID deleteAssetMappings(const AssetPathList& paths, MappingOperationCallback callback);
     MessageID renameAssetMapping(const AssetPath& oldPath, const AssetPath& newPath, MappingOperationCallback callback);
+    MessageID getBakedTextureMapping(const QString& pathOrHash, MappingOperationCallback callback);
+    MessageID getServerCapabilities(const SharedNodePointer& assetServer, MappingOperationCallback callback);
 
     MessageID getAssetInfo(const QString& hash, GetInfoCallback callback);
     MessageID getAsset(const QString& hash, DataOffset start, DataOffset end,
@@ -101,16 +116,33 @@ private:
         QSharedPointer<ReceivedMessage> message;
         ReceivedAssetCallback completeCallback;
         ProgressCallback progressCallback;
+        AssetEncoding encoding { AssetEncoding::Identity };
+    };
+
+    struct ChunkedUploadData {
+        QByteArray data;
+        AssetChunkList chunks;
+        UploadResultCallback callback;
     };
 
+    bool sendAssetUpload(const SharedNodePointer& assetServer, MessageID messageID, const QByteArray& data);
+    bool sendChunkedAssetUpload(const SharedNodePointer& assetServer, MessageID messageID,
+                                const ChunkedUploadData& upload, const QSet<uint32_t>& missingChunks);
+
     static MessageID _currentID;
     std::unordered_map<SharedNodePointer, std::unordered_map<MessageID, MappingOperationCallback>> _pendingMappingRequests;
     std::unordered_map<SharedNodePointer, std::unordered_map<MessageID, GetAssetRequestData>> _pendingRequests;
     std::unordered_map<SharedNodePointer, std::unordered_map<MessageID, GetInfoCallback>> _pendingInfoRequests;
     std::unordered_map<SharedNodePointer, std::unordered_map<MessageID, UploadResultCallback>> _pendingUploads;
+    std::unordered_map<SharedNodePointer, std::unordered_map<MessageID, ChunkedUploadData>> _pendingChunkQueries;
+
+    // uploads being split into chunks on the global thread pool, not tied to an asset-server until their query is sent
+    std::unordered_map<MessageID, std::shared_ptr<ChunkedUploadData>> _pendingChunkings;
 
     QString _cacheDir;
 
+    std::atomic<uint32_t> _serverCapabilities { 0 };
+
     friend class AssetRequest;
     friend class AssetUpload;
     friend class MappingRequest;
@@ -119,6 +151,8 @@ private:
     friend class SetMappingRequest;
     friend class DeleteMappingsRequest;
     friend class RenameMappingRequest;
+    friend class GetBakedTextureRequest;
+    friend class UploadChunker;
 };
 
 #endif
@@ -15,6 +15,7 @@
 
 #include <QtCore/QThread>
 
+#include <Gzip.h>
 #include <StatTracker.h>
 #include <Trace.h>
 
@@ -80,7 +81,8 @@ void AssetRequest::start() {
     auto hash = _hash;
 
     _assetRequestID = assetClient->getAsset(_hash, _byteRange.fromInclusive, _byteRange.toExclusive,
-        [this, that, hash](bool responseReceived, AssetServerError serverError, const QByteArray& data) {
+        [this, that, hash](bool responseReceived, AssetServerError serverError, const QByteArray& receivedData,
+                           AssetEncoding encoding) {
 
         if (!that) {
             qCWarning(asset_client) << "Got reply for dead asset request " << hash << "- error code" << _error;
@@ -104,7 +106,15 @@ void AssetRequest::start() {
                     break;
             }
         } else {
-            if (!_byteRange.isSet() && hashData(data).toHex() != _hash) {
+            QByteArray data = receivedData;
+
+            // the asset-server sends the gzipped variant of whole assets when it has one
+            if (encoding == AssetEncoding::Gzip && !gunzip(receivedData, data)) {
+                qCWarning(asset_client) << "Failed to decompress asset" << _hash;
+                _error = UnknownError;
+            }
+
+            if (_error == NoError && !_byteRange.isSet() && hashData(data).toHex() != _hash) {
                 // the hash of the received data does not match what we expect, so we return an error
                 _error = HashVerificationFailed;
             }
@@ -96,6 +96,7 @@ void AssetUpload::start() {
                     _error = PermissionDenied;
                     break;
                 case AssetServerError::FileOperationFailed:
+                case AssetServerError::ChunkedUploadsDisabled:
                     _error = ServerFileError;
                     break;
                 default:
@@ -41,7 +41,20 @@ enum AssetServerError : uint8_t {
     AssetTooLarge,
     PermissionDenied,
     MappingOperationFailed,
-    FileOperationFailed
+    FileOperationFailed,
+    ChunkedUploadsDisabled
+};
+
+// flags sent along with an AssetGet request
+enum AssetGetFlag : uint8_t {
+    // the asset-server may reply with a gzipped variant of the asset, only ever used for whole asset requests
+    AcceptGzipEncoding = 1 << 0
+};
+
+// how the data of an AssetGetReply is encoded
+enum class AssetEncoding : uint8_t {
+    Identity = 0,
+    Gzip
 };
 
 enum AssetMappingOperationType : uint8_t {
@@ -49,7 +62,15 @@ enum AssetMappingOperationType : uint8_t {
     GetAll,
     Set,
     Delete,
-    Rename
+    Rename,
+    GetBakedTexture,
+    GetServerCapabilities
+};
+
+// the optional features of an asset-server, replied to a GetServerCapabilities mapping operation
+enum AssetServerCapability : uint32_t {
+    HasBakedTextures = 1 << 0,
+    CanUploadChunks = 1 << 1
 };
 
 QUrl getATPUrl(const QString& hash);
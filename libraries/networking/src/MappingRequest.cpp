@@ -257,3 +257,44 @@ void RenameMappingRequest::doStart() {
         emit finished(this);
     });
 }
+
+GetBakedTextureRequest::GetBakedTextureRequest(const QString& pathOrHash) : _pathOrHash(pathOrHash.trimmed()) {
+};
+
+void GetBakedTextureRequest::doStart() {
+
+    // short circuit the request if it is neither a valid path nor a valid hash
+    if (!isValidFilePath(_pathOrHash) && !isValidHash(_pathOrHash)) {
+        _error = MappingRequest::InvalidPath;
+        emit finished(this);
+        return;
+    }
+
+    auto assetClient = DependencyManager::get<AssetClient>();
+
+    _mappingRequestID = assetClient->getBakedTextureMapping(_pathOrHash,
+            [this, assetClient](bool responseReceived, AssetServerError error, QSharedPointer<ReceivedMessage> message) {
+
+        _mappingRequestID = INVALID_MESSAGE_ID;
+        if (!responseReceived) {
+            _error = NetworkError;
+        } else {
+            switch (error) {
+                case AssetServerError::NoError:
+                    _error = NoError;
+                    break;
+                case AssetServerError::AssetNotFound:
+                    _error = NotFound;
+                    break;
+                default:
+                    _error = UnknownError;
+                    break;
+            }
+        }
+
+        if (!_error) {
+            _hash = message->read(SHA256_HASH_LENGTH).toHex();
+        }
+        emit finished(this);
+    });
+};
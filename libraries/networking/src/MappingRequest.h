@@ -111,6 +111,24 @@ private:
     AssetPath _newPath;
 };
 
+// Looks up the KTX texture the asset-server baked from the image at a path or hash
+class GetBakedTextureRequest : public MappingRequest {
+    Q_OBJECT
+public:
+    GetBakedTextureRequest(const QString& pathOrHash);
+
+    AssetHash getHash() const { return _hash;  }
+
+signals:
+    void finished(GetBakedTextureRequest* thisRequest);
+
+private:
+    virtual void doStart() override;
+
+    QString _pathOrHash;
+    AssetHash _hash;
+};
+
 class GetAllMappingsRequest : public MappingRequest {
     Q_OBJECT
 public:
@@ -14,6 +14,7 @@
 #include <stdint.h>
 
 #include "NodeList.h"
+#include "NumericalConstants.h"
 #include "PacketSender.h"
 #include "SharedUtil.h"
 
@@ -60,6 +61,12 @@ void PacketSender::queuePacketForSending(const SharedNodePointer& destinationNod
     _hasPackets.wakeAll();
 }
 
+void PacketSender::wakeUp() {
+    // under the mutex, so the wake up can't slip in between getMaxWaitForPacketsUsecs() and the wait
+    QMutexLocker locker(&_waitingOnPacketsMutex);
+    _hasPackets.wakeAll();
+}
+
 void PacketSender::setPacketsPerSecond(int packetsPerSecond) {
     _packetsPerSecond = std::max(MINIMUM_PACKETS_PER_SECOND, packetsPerSecond);
 }
@@ -118,9 +125,14 @@ bool PacketSender::threadedProcess() {
 
     // if threaded and we haven't slept? We want to wait for our consumer to signal us with new packets
     if (!hasSlept) {
-        // wait till we have packets
+        // wait till we have packets, or till our subclass has something to do
         _waitingOnPacketsMutex.lock();
-        _hasPackets.wait(&_waitingOnPacketsMutex);
+        quint64 maxWaitUsecs = getMaxWaitForPacketsUsecs();
+        if (maxWaitUsecs > 0) {
+            _hasPackets.wait(&_waitingOnPacketsMutex, (unsigned long)std::max(maxWaitUsecs / USECS_PER_MSEC, (quint64)1));
+        } else {
+            _hasPackets.wait(&_waitingOnPacketsMutex);
+        }
         _waitingOnPacketsMutex.unlock();
     }
 
@@ -93,6 +93,13 @@ public:
 signals:
     void packetSent(quint64);
 protected:
+    /// In threaded mode, how long to wait for new packets before process() is called again, 0 to wait for as long as it
+    /// takes. Called with the waiting mutex locked.
+    virtual quint64 getMaxWaitForPacketsUsecs() { return 0; }
+
+    /// In threaded mode, wakes up the thread waiting for packets, so it calls getMaxWaitForPacketsUsecs() again
+    void wakeUp();
+
     int _packetsPerSecond;
     int _usecsPerProcessCallHint;
     quint64 _lastProcessCallTime;
@@ -22,6 +22,7 @@ static const int HEAD_DATA_SIZE = 512;
 ReceivedMessage::ReceivedMessage(const NLPacketList& packetList)
     : _data(packetList.getMessage()),
       _headData(_data.mid(0, HEAD_DATA_SIZE)),
+      _size(_data.size()),
       _numPackets(packetList.getNumPackets()),
       _sourceID(packetList.getSourceID()),
       _packetType(packetList.getType()),
@@ -33,6 +34,7 @@ ReceivedMessage::ReceivedMessage(const NLPacketList& packetList)
 ReceivedMessage::ReceivedMessage(NLPacket& packet)
     : _data(packet.readAll()),
       _headData(_data.mid(0, HEAD_DATA_SIZE)),
+      _size(_data.size()),
       _numPackets(1),
       _sourceID(packet.getSourceID()),
       _packetType(packet.getType()),
@@ -46,6 +48,7 @@ ReceivedMessage::ReceivedMessage(QByteArray byteArray, PacketType packetType, Pa
                 const HifiSockAddr& senderSockAddr, QUuid sourceID) :
     _data(byteArray),
     _headData(_data.mid(0, HEAD_DATA_SIZE)),
+    _size(_data.size()),
     _numPackets(1),
     _sourceID(sourceID),
     _packetType(packetType),
@@ -57,8 +60,12 @@ ReceivedMessage::ReceivedMessage(QByteArray byteArray, PacketType packetType, Pa
 }
 
 void ReceivedMessage::setFailed() {
-    _failed = true;
-    _isComplete = true;
+    {
+        std::lock_guard<std::mutex> lock(_dataMutex);
+        _failed = true;
+        _isComplete = true;
+    }
+
     emit completed();
 }
 
@@ -71,14 +78,25 @@ void ReceivedMessage::appendPacket(NLPacket& packet) {
 
     ++_numPackets;
 
-    _data.append(packet.getPayload(), packet.getPayloadSize());
+    bool isLastPacket = packet.getPacketPosition() == NLPacket::PacketPosition::LAST;
+
+    {
+        std::lock_guard<std::mutex> lock(_dataMutex);
+        if (!_isDiscardingData) {
+            _data.append(packet.getPayload(), packet.getPayloadSize());
+        }
+        _size += packet.getPayloadSize();
+
+        if (isLastPacket) {
+            _isComplete = true;
+        }
+    }
 
     if (_numPackets % EMIT_PROGRESS_EVERY_X_PACKETS == 0) {
         emit progress(getSize());
     }
 
-    if (packet.getPacketPosition() == NLPacket::PacketPosition::LAST) {
-        _isComplete = true;
+    if (isLastPacket) {
         emit completed();
     }
 }
@@ -135,6 +153,26 @@ QByteArray ReceivedMessage::readWithoutCopy(qint64 size) {
     return data;
 }
 
+QByteArray ReceivedMessage::takeReceivedData() {
+    std::lock_guard<std::mutex> lock(_dataMutex);
+
+    QByteArray data = _data.mid(_position);
+
+    // release what was taken so that the message does not keep growing in memory
+    _data.clear();
+    _position = 0;
+
+    return data;
+}
+
+void ReceivedMessage::discardReceivedData() {
+    std::lock_guard<std::mutex> lock(_dataMutex);
+
+    _isDiscardingData = true;
+    _data.clear();
+    _position = 0;
+}
+
 void ReceivedMessage::onComplete() {
     _isComplete = true;
     emit completed();
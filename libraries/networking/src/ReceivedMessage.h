@@ -16,6 +16,7 @@
 #include <QObject>
 
 #include <atomic>
+#include <mutex>
 
 #include "NLPacketList.h"
 
@@ -48,7 +49,8 @@ public:
     // Get the number of packets that were used to send this message
     qint64 getNumPackets() const { return _numPackets; }
 
-    qint64 getSize() const { return _data.size(); }
+    // the size received so far, including the data taken by a streaming consumer
+    qint64 getSize() const { return _size; }
 
     qint64 getBytesLeftToRead() const { return _data.size() -  _position; }
 
@@ -74,6 +76,16 @@ public:
     // exceed that of the ReceivedMessage.
     QByteArray readWithoutCopy(qint64 size);
 
+    // Streaming access for listeners registered with deliverPending that consume a message while it is still
+    // being received, as its progress and completed signals are emitted. Returns the data past the read position
+    // received so far, possibly none, and releases it from the message. Once data has been taken the other read
+    // methods, other than readHead, should not be used on this message.
+    QByteArray takeReceivedData();
+
+    // For streaming consumers that gave up on the message: releases its data and drops the payload of the packets
+    // still to come, so that a message nobody reads doesn't keep growing until it completes.
+    void discardReceivedData();
+
     template<typename T> qint64 peekPrimitive(T* data);
     template<typename T> qint64 readPrimitive(T* data);
 
@@ -89,6 +101,7 @@ private slots:
 private:
     QByteArray _data;
     QByteArray _headData;
+    std::atomic<qint64> _size { 0 };
 
     std::atomic<qint64> _position { 0 };
     std::atomic<qint64> _numPackets { 0 };
@@ -100,6 +113,10 @@ private:
 
     std::atomic<bool> _isComplete { true };  
     std::atomic<bool> _failed { false };
+    bool _isDiscardingData { false };
+
+    // guards _data against appendPacket while a streaming consumer takes data from another thread
+    std::mutex _dataMutex;
 };
 
 Q_DECLARE_METATYPE(ReceivedMessage*)
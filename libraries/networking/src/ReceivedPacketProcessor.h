@@ -62,6 +62,10 @@ protected:
     /// \param QByteArray& the packet to be processed
     virtual void processPacket(QSharedPointer<ReceivedMessage> message, SharedNodePointer sendingNode) = 0;
 
+    /// Processes the packets dequeued together, in the order they were received. The default calls processPacket() and
+    /// midProcess() for each of them, override it to process the packets as a batch.
+    virtual void processPackets(std::list<NodeSharedReceivedMessagePair>& packets);
+
     /// Implements generic processing behavior for this thread.
     virtual bool process() override;
 
@@ -11,13 +11,16 @@
 
 #include "ResourceCache.h"
 
+#include <algorithm>
 #include <cfloat>
 #include <cmath>
+#include <limits>
 #include <assert.h>
 
 #include <QThread>
 #include <QTimer>
 
+#include <NumericalConstants.h>
 #include <SharedUtil.h>
 #include <shared/QtHelpers.h>
 #include <Trace.h>
@@ -32,24 +35,181 @@
                            (((x) > (max)) ? (max) :\
                                             (x)))
 
-void ResourceCacheSharedItems::appendActiveRequest(QWeakPointer<Resource> resource) {
+// local files are quick to load, but shouldn't take all the threads of the resource loading pools either
+static const int DEFAULT_FILE_REQUEST_LIMIT = 10;
+
+static const int UNUSED_RESOURCES_TRIM_INTERVAL_MSECS = 1000;
+
+// resources that load instantly still cost something to rebuild
+static const float MIN_RELOAD_COST_USECS = (float)USECS_PER_MSEC;
+
+// The caches register themselves here rather than with the shared items, which may not exist yet when they are created,
+// so that unused resources can be evicted across all of them.
+static std::mutex cachesMutex;
+static std::vector<ResourceCache*> caches;
+
+static qint64 getTotalUnusedResourcesSize() {
+    std::lock_guard<std::mutex> lock(cachesMutex);
+
+    qint64 size = 0;
+    for (auto cache : caches) {
+        size += cache->getSizeCachedResources();
+    }
+    return size;
+}
+
+ResourceCacheSharedItems::ResourceCacheSharedItems() {
+    for (int i = 0; i < NumProtocols; ++i) {
+        _activeRequests[i] = 0;
+        _protocolRequestLimits[i] = std::numeric_limits<int>::max();
+    }
+    _protocolRequestLimits[File] = DEFAULT_FILE_REQUEST_LIMIT;
+}
+
+ResourceCacheSharedItems::~ResourceCacheSharedItems() {
+    Lock lock(_trimmerMutex);
+    if (_trimmerThread) {
+        _trimmerThread->quit();
+        _trimmerThread->wait();
+        delete _trimmerTimer;
+        delete _trimmerThread;
+    }
+}
+
+ResourceCacheSharedItems::Protocol ResourceCacheSharedItems::getProtocol(const QUrl& url) {
+    auto scheme = url.scheme();
+    if (scheme == URL_SCHEME_FILE) {
+        return File;
+    } else if (scheme == URL_SCHEME_ATP) {
+        return ATP;
+    }
+    return HTTP;
+}
+
+bool ResourceCacheSharedItems::hasSlotFor(Protocol protocol, int requestLimit) const {
+    if (_activeRequests[protocol] >= _protocolRequestLimits[protocol]) {
+        return false;
+    }
+    return protocol == File || _activeNetworkRequests < requestLimit;
+}
+
+void ResourceCacheSharedItems::takeSlot(const QSharedPointer<Resource>& resource, Protocol protocol) {
+    LoadingRequest request;
+    request.resource = resource;
+    request.protocol = protocol;
+    _loadingRequests.append(request);
+
+    ++_activeRequests[protocol];
+    if (protocol != File) {
+        ++_activeNetworkRequests;
+    }
+}
+
+bool ResourceCacheSharedItems::startOrQueueRequest(QSharedPointer<Resource> resource, int requestLimit) {
+    auto protocol = getProtocol(resource->getURL());
+    auto priority = resource->getLoadPriority();
+
     Lock lock(_mutex);
-    _loadingRequests.append(resource);
+
+    // a resource asking again while queued, to retry, keeps its place
+    auto& pendingRequests = _pendingRequests[protocol];
+    if (!pendingRequests.contains(resource.data()) && hasSlotFor(protocol, requestLimit)) {
+        takeSlot(resource, protocol);
+        return true;
+    }
+
+    pendingRequests.push(resource, priority, usecTimestampNow());
+    resource->_isPendingRequest = true;
+    return false;
 }
 
-void ResourceCacheSharedItems::appendPendingRequest(QWeakPointer<Resource> resource) {
+QSharedPointer<Resource> ResourceCacheSharedItems::takeHighestPendingRequest(int requestLimit) {
     Lock lock(_mutex);
-    _pendingRequests.append(resource);
+
+    // local files go first, then the highest priority request of the protocols that have room for one
+    int highestProtocol = -1;
+    float highestPriority = -FLT_MAX;
+
+    for (int protocol = 0; protocol < NumProtocols; ++protocol) {
+        if (!hasSlotFor((Protocol)protocol, requestLimit)) {
+            continue;
+        }
+
+        float priority;
+        if (_pendingRequests[protocol].top(&priority) && (highestProtocol < 0 || priority > highestPriority)) {
+            highestProtocol = protocol;
+            highestPriority = priority;
+
+            if (protocol == File) {
+                break;
+            }
+        }
+    }
+
+    if (highestProtocol < 0) {
+        return QSharedPointer<Resource>();
+    }
+
+    uint64_t queuedTime = 0;
+    auto resource = _pendingRequests[highestProtocol].pop(&queuedTime);
+    resource->_isPendingRequest = false;
+
+    auto waitUsecs = usecTimestampNow() - queuedTime;
+    auto& stats = _queueStats[highestProtocol];
+    ++stats.dequeuedRequests;
+    stats.totalWaitUsecs += waitUsecs;
+    stats.maxWaitUsecs = std::max(stats.maxWaitUsecs, waitUsecs);
+
+    takeSlot(resource, (Protocol)highestProtocol);
+    return resource;
+}
+
+void ResourceCacheSharedItems::removeRequest(QWeakPointer<Resource> resource) {
+    Lock lock(_mutex);
+
+    // resource can only be removed if it still has a ref-count, as
+    // QWeakPointer has no operator== implementation for two weak ptrs, so
+    // manually loop in case resource has been freed.
+    // Freed resources keep their slot until they complete, from their destructor.
+    for (int i = 0; i < _loadingRequests.size(); ++i) {
+        const auto& request = _loadingRequests.at(i);
+        if (request.resource.data() == resource.data()) {
+            --_activeRequests[request.protocol];
+            if (request.protocol != File) {
+                --_activeNetworkRequests;
+            }
+            _loadingRequests.removeAt(i);
+            break;
+        }
+    }
+}
+
+void ResourceCacheSharedItems::updatePendingRequestPriority(const Resource* resource, float priority) {
+    Lock lock(_mutex);
+
+    for (auto& pendingRequests : _pendingRequests) {
+        if (pendingRequests.update(resource, priority)) {
+            break;
+        }
+    }
+}
+
+void ResourceCacheSharedItems::removePendingRequest(const Resource* resource) {
+    Lock lock(_mutex);
+
+    for (auto& pendingRequests : _pendingRequests) {
+        if (pendingRequests.remove(resource)) {
+            break;
+        }
+    }
 }
 
 QList<QSharedPointer<Resource>> ResourceCacheSharedItems::getPendingRequests() {
     QList<QSharedPointer<Resource>> result;
     Lock lock(_mutex);
 
-    foreach(QSharedPointer<Resource> resource, _pendingRequests) {
-        if (resource) {
-            result.append(resource);
-        }
+    for (const auto& pendingRequests : _pendingRequests) {
+        result.append(pendingRequests.getResources());
     }
 
     return result;
@@ -57,14 +217,20 @@ QList<QSharedPointer<Resource>> ResourceCacheSharedItems::getPendingRequests() {
 
 uint32_t ResourceCacheSharedItems::getPendingRequestsCount() const {
     Lock lock(_mutex);
-    return _pendingRequests.size();
+
+    uint32_t count = 0;
+    for (const auto& pendingRequests : _pendingRequests) {
+        count += (uint32_t)pendingRequests.size();
+    }
+    return count;
 }
 
 QList<QSharedPointer<Resource>> ResourceCacheSharedItems::getLoadingRequests() {
     QList<QSharedPointer<Resource>> result;
     Lock lock(_mutex);
 
-    foreach(QSharedPointer<Resource> resource, _loadingRequests) {
+    for (const auto& request : _loadingRequests) {
+        auto resource = request.resource.lock();
         if (resource) {
             result.append(resource);
         }
@@ -78,57 +244,111 @@ uint32_t ResourceCacheSharedItems::getLoadingRequestsCount() const {
     return _loadingRequests.size();
 }
 
-void ResourceCacheSharedItems::removeRequest(QWeakPointer<Resource> resource) {
+void ResourceCacheSharedItems::setProtocolRequestLimit(Protocol protocol, int limit) {
     Lock lock(_mutex);
+    _protocolRequestLimits[protocol] = limit;
+}
 
-    // resource can only be removed if it still has a ref-count, as
-    // QWeakPointer has no operator== implementation for two weak ptrs, so
-    // manually loop in case resource has been freed.
-    for (int i = 0; i < _loadingRequests.size();) {
-        auto request = _loadingRequests.at(i);
-        // Clear our resource and any freed resources
-        if (!request || request.data() == resource.data()) {
-            _loadingRequests.removeAt(i);
-            continue;
-        }
-        i++;
-    }
+int ResourceCacheSharedItems::getProtocolRequestLimit(Protocol protocol) const {
+    Lock lock(_mutex);
+    return _protocolRequestLimits[protocol];
 }
 
-QSharedPointer<Resource> ResourceCacheSharedItems::getHighestPendingRequest() {
-    // look for the highest priority pending request
-    int highestIndex = -1;
-    float highestPriority = -FLT_MAX;
-    QSharedPointer<Resource> highestResource;
+ResourceCacheSharedItems::QueueStats ResourceCacheSharedItems::getQueueStats(Protocol protocol) const {
     Lock lock(_mutex);
+    return _queueStats[protocol];
+}
 
-    bool currentHighestIsFile = false;
+void ResourceCacheSharedItems::setUnusedResourcesBudget(qint64 budget) {
+    _unusedResourcesBudget = budget;
+    if (budget > 0) {
+        startTrimmer();
+        checkUnusedResourcesBudget();
+    }
+}
 
-    for (int i = 0; i < _pendingRequests.size();) {
-        // Clear any freed resources
-        auto resource = _pendingRequests.at(i).lock();
-        if (!resource) {
-            _pendingRequests.removeAt(i);
-            continue;
-        }
+void ResourceCacheSharedItems::setProcessMemoryLimit(qint64 limit) {
+    _processMemoryLimit = limit;
+    if (limit > 0) {
+        startTrimmer();
+    }
+}
 
-        // Check load priority
-        float priority = resource->getLoadPriority();
-        bool isFile = resource->getURL().scheme() == URL_SCHEME_FILE;
-        if (priority >= highestPriority && (isFile || !currentHighestIsFile)) {
-            highestPriority = priority;
-            highestIndex = i;
-            highestResource = resource;
-            currentHighestIsFile = isFile;
-        }
-        i++;
+void ResourceCacheSharedItems::checkUnusedResourcesBudget() {
+    qint64 budget = _unusedResourcesBudget;
+    if (budget <= 0 || getTotalUnusedResourcesSize() <= budget) {
+        return;
     }
 
-    if (highestIndex >= 0) {
-        _pendingRequests.takeAt(highestIndex);
+    Lock lock(_trimmerMutex);
+    if (_trimmerTimer) {
+        // don't wait for the next tick
+        QTimer::singleShot(0, _trimmerTimer, [this] { trimUnusedResources(); });
     }
+}
 
-    return highestResource;
+void ResourceCacheSharedItems::startTrimmer() {
+    Lock lock(_trimmerMutex);
+    if (_trimmerThread) {
+        return;
+    }
+
+    _trimmerThread = new QThread();
+    _trimmerThread->setObjectName("ResourceCache Trimmer");
+
+    _trimmerTimer = new QTimer();
+    _trimmerTimer->setInterval(UNUSED_RESOURCES_TRIM_INTERVAL_MSECS);
+    _trimmerTimer->moveToThread(_trimmerThread);
+    QObject::connect(_trimmerTimer, &QTimer::timeout, _trimmerTimer, [this] { trimUnusedResources(); });
+    QObject::connect(_trimmerThread, &QThread::started, _trimmerTimer, static_cast<void(QTimer::*)()>(&QTimer::start));
+
+    _trimmerThread->start(QThread::LowPriority);
+}
+
+void ResourceCacheSharedItems::trimUnusedResources() {
+    qint64 budget = _unusedResourcesBudget;
+    qint64 memoryLimit = _processMemoryLimit;
+
+    std::lock_guard<std::mutex> lock(cachesMutex);
+
+    qint64 unusedSize = 0;
+    for (auto cache : caches) {
+        unusedSize += cache->getSizeCachedResources();
+    }
+
+    // Freed memory only shows in the process size once the evicted resources are deleted on their own thread,
+    // so each pass frees no more than the current excess and leaves the rest to the next one.
+    qint64 excess = budget > 0 ? unusedSize - budget : 0;
+    MemoryInfo memoryInfo;
+    if (memoryLimit > 0 && getMemoryInfo(memoryInfo)) {
+        excess = std::max(excess, (qint64)memoryInfo.processUsedMemoryBytes - memoryLimit);
+    }
+
+    if (excess <= 0 || unusedSize == 0) {
+        return;
+    }
+
+    PROFILE_RANGE(resource, "TrimUnusedResources");
+
+    std::vector<ResourceCache::EvictionCandidate> candidates;
+    auto now = usecTimestampNow();
+    for (auto cache : caches) {
+        cache->appendEvictionCandidates(candidates, now);
+    }
+    ResourceCache::sortEvictionCandidates(candidates);
+
+    for (const auto& candidate : candidates) {
+        if (excess <= 0) {
+            break;
+        }
+        if (candidate.cache->evictUnusedResource(candidate.lruKey)) {
+            excess -= candidate.bytes;
+        }
+    }
+
+    for (auto cache : caches) {
+        cache->resetResourceCounters();
+    }
 }
 
 ScriptableResource::ScriptableResource(const QUrl& url) :
@@ -218,6 +438,11 @@ ScriptableResource* ResourceCache::prefetch(const QUrl& url, void* extra) {
 }
 
 ResourceCache::ResourceCache(QObject* parent) : QObject(parent) {
+    {
+        std::lock_guard<std::mutex> lock(cachesMutex);
+        caches.push_back(this);
+    }
+
     auto nodeList = DependencyManager::get<NodeList>();
     if (nodeList) {
         auto& domainHandler = nodeList->getDomainHandler();
@@ -227,6 +452,11 @@ ResourceCache::ResourceCache(QObject* parent) : QObject(parent) {
 }
 
 ResourceCache::~ResourceCache() {
+    {
+        std::lock_guard<std::mutex> lock(cachesMutex);
+        caches.erase(std::remove(caches.begin(), caches.end(), this), caches.end());
+    }
+
     clearUnusedResources();
 }
 
@@ -329,14 +559,85 @@ void ResourceCache::setRequestLimit(int limit) {
     }
 }
 
+void ResourceCache::setRequestLimit(ResourceCacheSharedItems::Protocol protocol, int limit) {
+    DependencyManager::get<ResourceCacheSharedItems>()->setProtocolRequestLimit(protocol, limit);
+
+    while (attemptHighestPriorityRequest()) {
+        // fill the spots a higher limit opens up
+    }
+}
+
+int ResourceCache::getRequestLimit(ResourceCacheSharedItems::Protocol protocol) {
+    return DependencyManager::get<ResourceCacheSharedItems>()->getProtocolRequestLimit(protocol);
+}
+
+int ResourceCache::getRequestsActive() {
+    return DependencyManager::get<ResourceCacheSharedItems>()->getLoadingRequestsCount();
+}
+
+QVariantMap ResourceCache::getRequestQueueStats() {
+    static const char* PROTOCOL_NAMES[ResourceCacheSharedItems::NumProtocols] = { "file", "atp", "http" };
+
+    auto sharedItems = DependencyManager::get<ResourceCacheSharedItems>();
+
+    QVariantMap result;
+    for (int i = 0; i < ResourceCacheSharedItems::NumProtocols; ++i) {
+        auto stats = sharedItems->getQueueStats((ResourceCacheSharedItems::Protocol)i);
+
+        QVariantMap protocolStats;
+        protocolStats["dequeued"] = (qulonglong)stats.dequeuedRequests;
+        protocolStats["averageWaitMsecs"] = stats.dequeuedRequests > 0 ?
+            (double)stats.totalWaitUsecs / stats.dequeuedRequests / USECS_PER_MSEC : 0.0;
+        protocolStats["maxWaitMsecs"] = (double)stats.maxWaitUsecs / USECS_PER_MSEC;
+        result[PROTOCOL_NAMES[i]] = protocolStats;
+    }
+    return result;
+}
+
+void ResourceCache::setUnusedResourcesBudget(qint64 budget) {
+    auto sharedItems = DependencyManager::get<ResourceCacheSharedItems>();
+    sharedItems->setUnusedResourcesBudget(clamp(budget, MIN_UNUSED_MAX_SIZE, MAX_UNUSED_MAX_SIZE));
+}
+
+qint64 ResourceCache::getUnusedResourcesBudget() {
+    return DependencyManager::get<ResourceCacheSharedItems>()->getUnusedResourcesBudget();
+}
+
+void ResourceCache::setProcessMemoryLimit(qint64 limit) {
+    DependencyManager::get<ResourceCacheSharedItems>()->setProcessMemoryLimit(std::max(limit, (qint64)0));
+}
+
+qint64 ResourceCache::getProcessMemoryLimit() {
+    return DependencyManager::get<ResourceCacheSharedItems>()->getProcessMemoryLimit();
+}
+
+QVariantMap ResourceCache::getCacheUsage() {
+    QVariantMap result;
+    std::lock_guard<std::mutex> lock(cachesMutex);
+
+    for (auto cache : caches) {
+        QVariantMap usage;
+        usage["numTotal"] = (qulonglong)cache->getNumTotalResources();
+        usage["numCached"] = (qulonglong)cache->getNumCachedResources();
+        usage["sizeTotal"] = (qulonglong)cache->getSizeTotalResources();
+        usage["sizeCached"] = (qulonglong)cache->getSizeCachedResources();
+        usage["maxSizeCached"] = cache->getUnusedResourceCacheSize();
+        result[cache->metaObject()->className()] = usage;
+    }
+    return result;
+}
+
 QSharedPointer<Resource> ResourceCache::getResource(const QUrl& url, const QUrl& fallback, void* extra) {
     QSharedPointer<Resource> resource;
     {
+        // take the resource off the unused list while it is still registered, so the trimmer thread can't evict it in between
         QReadLocker locker(&_resourcesLock);
         resource = _resources.value(url).lock();
+        if (resource) {
+            removeUnusedResource(resource);
+        }
     }
     if (resource) {
-        removeUnusedResource(resource);
         return resource;
     }
 
@@ -386,12 +687,20 @@ void ResourceCache::addUnusedResource(const QSharedPointer<Resource>& resource)
     reserveUnusedResource(resource->getBytes());
     
     resource->setLRUKey(++_lastLRUKey);
+    resource->_lastUsedTime = usecTimestampNow();
     _unusedResourcesSize += resource->getBytes();
 
     resetResourceCounters();
 
-    QWriteLocker locker(&_unusedResourcesLock);
-    _unusedResources.insert(resource->getLRUKey(), resource);
+    {
+        QWriteLocker locker(&_unusedResourcesLock);
+        _unusedResources.insert(resource->getLRUKey(), resource);
+    }
+
+    auto sharedItems = DependencyManager::get<ResourceCacheSharedItems>();
+    if (sharedItems) {
+        sharedItems->checkUnusedResourcesBudget();
+    }
 }
 
 void ResourceCache::removeUnusedResource(const QSharedPointer<Resource>& resource) {
@@ -405,22 +714,76 @@ void ResourceCache::removeUnusedResource(const QSharedPointer<Resource>& resourc
     }
 }
 
-void ResourceCache::reserveUnusedResource(qint64 resourceSize) {
-    QWriteLocker locker(&_unusedResourcesLock);
-    while (!_unusedResources.empty() &&
-           _unusedResourcesSize + resourceSize > _unusedResourcesMaxSize) {
-        // unload the oldest resource
-        QMap<int, QSharedPointer<Resource> >::iterator it = _unusedResources.begin();
-        
-        it.value()->setCache(nullptr);
-        auto size = it.value()->getBytes();
+float ResourceCache::getEvictionScore(const Resource& resource, uint64_t now) {
+    // keep what is slow to load for its size, and was used recently
+    float reloadCost = std::max((float)resource._loadDurationUsecs, MIN_RELOAD_COST_USECS);
+    float idleSeconds = now > resource._lastUsedTime ? (float)(now - resource._lastUsedTime) / USECS_PER_SECOND : 0.0f;
+    return reloadCost / std::max(resource.getBytes(), (qint64)1) / (1.0f + idleSeconds);
+}
 
-        locker.unlock();
-        removeResource(it.value()->getURL(), size);
-        locker.relock();
+void ResourceCache::sortEvictionCandidates(std::vector<EvictionCandidate>& candidates) {
+    std::sort(candidates.begin(), candidates.end(), [](const EvictionCandidate& a, const EvictionCandidate& b) {
+        return a.score < b.score || (a.score == b.score && a.lruKey < b.lruKey);
+    });
+}
 
-        _unusedResourcesSize -= size;
+void ResourceCache::appendEvictionCandidates(std::vector<EvictionCandidate>& candidates, uint64_t now) {
+    QReadLocker locker(&_unusedResourcesLock);
+
+    candidates.reserve(candidates.size() + _unusedResources.size());
+    for (auto it = _unusedResources.cbegin(); it != _unusedResources.cend(); ++it) {
+        EvictionCandidate candidate;
+        candidate.cache = this;
+        candidate.lruKey = it.key();
+        candidate.bytes = it.value()->getBytes();
+        candidate.score = getEvictionScore(*it.value(), now);
+        candidates.push_back(candidate);
+    }
+}
+
+bool ResourceCache::evictUnusedResource(int lruKey) {
+    // hold on to the resource until we are out of the locks, as dropping it may add others to the unused list
+    QSharedPointer<Resource> resource;
+    {
+        // may be called from the trimmer thread: getResource revives resources under the resources lock,
+        // so hold it with the unused resources lock until the resource is unregistered
+        QWriteLocker resourcesLocker(&_resourcesLock);
+        QWriteLocker unusedResourcesLocker(&_unusedResourcesLock);
+        auto it = _unusedResources.find(lruKey);
+        if (it == _unusedResources.end()) {
+            // it was used again since
+            return false;
+        }
+
+        resource = it.value();
         _unusedResources.erase(it);
+
+        resource->setCache(nullptr);
+        auto size = resource->getBytes();
+        _unusedResourcesSize -= size;
+        _totalResourcesSize -= size;
+        if (_resources.value(resource->getURL()) == resource) {
+            _resources.remove(resource->getURL());
+        }
+    }
+    return true;
+}
+
+void ResourceCache::reserveUnusedResource(qint64 resourceSize) {
+    if (_unusedResourcesSize + resourceSize <= _unusedResourcesMaxSize) {
+        return;
+    }
+
+    // unload the resources that are the cheapest to load again first
+    std::vector<EvictionCandidate> candidates;
+    appendEvictionCandidates(candidates, usecTimestampNow());
+    sortEvictionCandidates(candidates);
+
+    for (const auto& candidate : candidates) {
+        if (_unusedResourcesSize + resourceSize <= _unusedResourcesMaxSize) {
+            break;
+        }
+        evictUnusedResource(candidate.lruKey);
     }
 }
 
@@ -481,16 +844,15 @@ int ResourceCache::getLoadingRequestCount() {
 bool ResourceCache::attemptRequest(QSharedPointer<Resource> resource) {
     Q_ASSERT(!resource.isNull());
 
-
     auto sharedItems = DependencyManager::get<ResourceCacheSharedItems>();
-    if (_requestsActive >= _requestLimit) {
+    if (!sharedItems->startOrQueueRequest(resource, _requestLimit)) {
         // wait until a slot becomes available
-        sharedItems->appendPendingRequest(resource);
         return false;
     }
-    
-    ++_requestsActive;
-    sharedItems->appendActiveRequest(resource);
+
+    if (resource->_requestStartTime == 0) {
+        resource->_requestStartTime = usecTimestampNow();
+    }
     resource->makeRequest();
     return true;
 }
@@ -499,20 +861,25 @@ void ResourceCache::requestCompleted(QWeakPointer<Resource> resource) {
     auto sharedItems = DependencyManager::get<ResourceCacheSharedItems>();
 
     sharedItems->removeRequest(resource);
-    --_requestsActive;
 
     attemptHighestPriorityRequest();
 }
 
 bool ResourceCache::attemptHighestPriorityRequest() {
     auto sharedItems = DependencyManager::get<ResourceCacheSharedItems>();
-    auto resource = sharedItems->getHighestPendingRequest();
-    return (resource && attemptRequest(resource));
+    auto resource = sharedItems->takeHighestPendingRequest(_requestLimit);
+    if (resource) {
+        if (resource->_requestStartTime == 0) {
+            resource->_requestStartTime = usecTimestampNow();
+        }
+        resource->makeRequest();
+        return true;
+    }
+    return false;
 }
 
 const int DEFAULT_REQUEST_LIMIT = 10;
 int ResourceCache::_requestLimit = DEFAULT_REQUEST_LIMIT;
-int ResourceCache::_requestsActive = 0;
 
 static int requestID = 0;
 
@@ -524,6 +891,13 @@ Resource::Resource(const QUrl& url) :
 }
 
 Resource::~Resource() {
+    if (_isPendingRequest) {
+        auto sharedItems = DependencyManager::get<ResourceCacheSharedItems>();
+        if (sharedItems) {
+            sharedItems->removePendingRequest(this);
+        }
+    }
+
     if (_request) {
         _request->disconnect(this);
         _request->deleteLater();
@@ -541,6 +915,7 @@ void Resource::ensureLoading() {
 void Resource::setLoadPriority(const QPointer<QObject>& owner, float priority) {
     if (!(_failedToLoad)) {
         _loadPriorities.insert(owner, priority);
+        updatePendingRequestPriority();
     }
 }
 
@@ -552,11 +927,19 @@ void Resource::setLoadPriorities(const QHash<QPointer<QObject>, float>& prioriti
             it != priorities.constEnd(); it++) {
         _loadPriorities.insert(it.key(), it.value());
     }
+    updatePendingRequestPriority();
 }
 
 void Resource::clearLoadPriority(const QPointer<QObject>& owner) {
     if (!(_failedToLoad)) {
         _loadPriorities.remove(owner);
+        updatePendingRequestPriority();
+    }
+}
+
+void Resource::updatePendingRequestPriority() {
+    if (_isPendingRequest) {
+        DependencyManager::get<ResourceCacheSharedItems>()->updatePendingRequestPriority(this, getLoadPriority());
     }
 }
 
@@ -589,6 +972,7 @@ void Resource::refresh() {
     }
     
     init();
+    _requestStartTime = _loadDurationUsecs = 0;
     ensureLoading();
     emit onRefresh();
 }
@@ -651,6 +1035,9 @@ void Resource::finishedLoading(bool success) {
         qCDebug(networking).noquote() << "Finished loading:" << _url.toDisplayString();
         _loadPriorities.clear();
         _loaded = true;
+        if (_requestStartTime > 0 && _loadDurationUsecs == 0) {
+            _loadDurationUsecs = usecTimestampNow() - _requestStartTime;
+        }
     } else {
         qCDebug(networking).noquote() << "Failed to load:" << _url.toDisplayString();
         _failedToLoad = true;
@@ -14,6 +14,7 @@
 
 #include <atomic>
 #include <mutex>
+#include <vector>
 
 #include <QtCore/QHash>
 #include <QtCore/QList>
@@ -33,13 +34,16 @@
 #include <DependencyManager.h>
 
 #include "ResourceManager.h"
+#include "ResourceRequestQueue.h"
 
 Q_DECLARE_METATYPE(size_t)
 
 class QNetworkReply;
+class QThread;
 class QTimer;
 
 class Resource;
+class ResourceCache;
 
 static const qint64 BYTES_PER_MEGABYTES = 1024 * 1024;
 static const qint64 BYTES_PER_GIGABYTES = 1024 * BYTES_PER_MEGABYTES;
@@ -66,21 +70,89 @@ class ResourceCacheSharedItems : public Dependency  {
     using Lock = std::unique_lock<Mutex>;
 
 public:
-    void appendPendingRequest(QWeakPointer<Resource> newRequest);
-    void appendActiveRequest(QWeakPointer<Resource> newRequest);
+    // Requests are scheduled with a separate budget per protocol. Local files don't count towards the request limit,
+    // network requests count towards both the limit and the budget of their protocol.
+    enum Protocol {
+        File = 0,
+        ATP,
+        HTTP, // and any other scheme
+        NumProtocols
+    };
+
+    // how long requests waited in the queue before they got a slot
+    struct QueueStats {
+        uint64_t dequeuedRequests { 0 };
+        uint64_t totalWaitUsecs { 0 };
+        uint64_t maxWaitUsecs { 0 };
+    };
+
+    static Protocol getProtocol(const QUrl& url);
+
+    /// Takes a request slot for the resource if its budgets allow it, otherwise queues it by priority.
+    /// Returns true if a slot was taken, in which case the caller makes the request.
+    bool startOrQueueRequest(QSharedPointer<Resource> resource, int requestLimit);
+
+    /// Dequeues the highest priority resource that a slot can be taken for, and takes it
+    QSharedPointer<Resource> takeHighestPendingRequest(int requestLimit);
+
+    /// Releases the slot of a request that is done
     void removeRequest(QWeakPointer<Resource> doneRequest);
+
+    void updatePendingRequestPriority(const Resource* resource, float priority);
+    void removePendingRequest(const Resource* resource);
+
     QList<QSharedPointer<Resource>> getPendingRequests();
     uint32_t getPendingRequestsCount() const;
     QList<QSharedPointer<Resource>> getLoadingRequests();
-    QSharedPointer<Resource> getHighestPendingRequest();
     uint32_t getLoadingRequestsCount() const;
 
+    void setProtocolRequestLimit(Protocol protocol, int limit);
+    int getProtocolRequestLimit(Protocol protocol) const;
+    QueueStats getQueueStats(Protocol protocol) const;
+
+    /// Sets the size all the caches together can keep in unused resources, on top of their own limits (0 to disable)
+    void setUnusedResourcesBudget(qint64 budget);
+    qint64 getUnusedResourcesBudget() const { return _unusedResourcesBudget; }
+
+    /// Sets the memory the process should stay under by evicting unused resources (0 to disable)
+    void setProcessMemoryLimit(qint64 limit);
+    qint64 getProcessMemoryLimit() const { return _processMemoryLimit; }
+
+    /// Wakes the trimmer up if the caches went over the unused resources budget
+    void checkUnusedResourcesBudget();
+
+    virtual ~ResourceCacheSharedItems();
+
 private:
-    ResourceCacheSharedItems() = default;
+    ResourceCacheSharedItems();
+
+    void startTrimmer();
+    void trimUnusedResources();
+
+    struct LoadingRequest {
+        QWeakPointer<Resource> resource;
+        Protocol protocol;
+    };
+
+    bool hasSlotFor(Protocol protocol, int requestLimit) const;
+    void takeSlot(const QSharedPointer<Resource>& resource, Protocol protocol);
 
     mutable Mutex _mutex;
-    QList<QWeakPointer<Resource>> _pendingRequests;
-    QList<QWeakPointer<Resource>> _loadingRequests;
+    ResourceRequestQueue _pendingRequests[NumProtocols];
+    QList<LoadingRequest> _loadingRequests;
+
+    int _activeRequests[NumProtocols];
+    int _activeNetworkRequests { 0 };
+    int _protocolRequestLimits[NumProtocols];
+    QueueStats _queueStats[NumProtocols];
+
+    std::atomic<qint64> _unusedResourcesBudget { 0 };
+    std::atomic<qint64> _processMemoryLimit { 0 };
+
+    // trims the unused resources of all the caches in the background, started once a budget or limit is set
+    Mutex _trimmerMutex;
+    QThread* _trimmerThread { nullptr };
+    QTimer* _trimmerTimer { nullptr };
 };
 
 /// Wrapper to expose resources to JS/QML
@@ -233,11 +305,29 @@ public:
     static void setRequestLimit(int limit);
     static int getRequestLimit() { return _requestLimit; }
 
-    static int getRequestsActive() { return _requestsActive; }
+    /// Sets how many requests of a protocol can be active at once, within the request limit for network protocols
+    static void setRequestLimit(ResourceCacheSharedItems::Protocol protocol, int limit);
+    static int getRequestLimit(ResourceCacheSharedItems::Protocol protocol);
+
+    static int getRequestsActive();
+
+    /// Returns the number of requests that waited for a slot and how long they waited, per protocol
+    static QVariantMap getRequestQueueStats();
     
     void setUnusedResourceCacheSize(qint64 unusedResourcesMaxSize);
     qint64 getUnusedResourceCacheSize() const { return _unusedResourcesMaxSize; }
 
+    /// Sets the size all the caches together can keep in unused resources (0 to only use the size of each cache)
+    static void setUnusedResourcesBudget(qint64 budget);
+    static qint64 getUnusedResourcesBudget();
+
+    /// Sets the memory the process should stay under by evicting unused resources (0 to disable)
+    static void setProcessMemoryLimit(qint64 limit);
+    static qint64 getProcessMemoryLimit();
+
+    /// Returns the resource counts and sizes of every cache, by cache name
+    static QVariantMap getCacheUsage();
+
     static QList<QSharedPointer<Resource>> getLoadingRequests();
 
     static int getPendingRequestCount();
@@ -308,13 +398,27 @@ protected:
 
 private:
     friend class Resource;
+    friend class ResourceCacheSharedItems;
+
+    // an unused resource that can be evicted, the lower the score the sooner
+    struct EvictionCandidate {
+        ResourceCache* cache;
+        int lruKey;
+        qint64 bytes;
+        float score;
+    };
+
+    static float getEvictionScore(const Resource& resource, uint64_t now);
+    static void sortEvictionCandidates(std::vector<EvictionCandidate>& candidates);
+
+    void appendEvictionCandidates(std::vector<EvictionCandidate>& candidates, uint64_t now);
+    bool evictUnusedResource(int lruKey);
 
     void reserveUnusedResource(qint64 resourceSize);
     void resetResourceCounters();
     void removeResource(const QUrl& url, qint64 size = 0);
 
     static int _requestLimit;
-    static int _requestsActive;
 
     // Resources
     QHash<QUrl, QWeakPointer<Resource>> _resources;
@@ -479,9 +583,13 @@ public slots:
 
 private:
     friend class ResourceCache;
+    friend class ResourceCacheSharedItems;
     friend class ScriptableResource;
     
     void setLRUKey(int lruKey) { _lruKey = lruKey; }
+
+    // lets the request queue know about priority changes while we wait for a request slot
+    void updatePendingRequestPriority();
     
     void retry();
     void reinsert();
@@ -495,6 +603,14 @@ private:
     static const int MAX_ATTEMPTS = 8;
     unsigned int _attemptsRemaining { MAX_ATTEMPTS };
     bool _isInScript{ false };
+
+    // what it takes to load the resource again, and when it was last used, to pick which unused resources to evict
+    uint64_t _requestStartTime { 0 };
+    uint64_t _loadDurationUsecs { 0 };
+    uint64_t _lastUsedTime { 0 };
+
+    // set by ResourceCacheSharedItems while we are queued for a request slot
+    std::atomic<bool> _isPendingRequest { false };
 };
 
 uint qHash(const QPointer<QObject>& value, uint seed = 0);
@@ -0,0 +1,173 @@
+//
+//  ResourceRequestQueue.cpp
+//  libraries/networking/src
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "ResourceRequestQueue.h"
+
+#include "ResourceCache.h"
+
+bool ResourceRequestQueue::push(const QSharedPointer<Resource>& resource, float priority, uint64_t queuedTime) {
+    auto it = _indices.find(resource.data());
+    if (it != _indices.end()) {
+        if (_heap[it->second].resource.lock() == resource) {
+            update(resource.data(), priority);
+            return false;
+        }
+
+        // a freed resource that was never dequeued, at the address of the new one
+        removeAt(it->second);
+    }
+
+    Entry entry;
+    entry.key = resource.data();
+    entry.resource = resource;
+    entry.priority = priority;
+    entry.sequence = _nextSequence++;
+    entry.queuedTime = queuedTime;
+
+    _heap.push_back(Entry());
+    place(_heap.size() - 1, std::move(entry));
+    siftUp(_heap.size() - 1);
+    return true;
+}
+
+bool ResourceRequestQueue::update(const Resource* resource, float priority) {
+    auto it = _indices.find(resource);
+    if (it == _indices.end()) {
+        return false;
+    }
+
+    auto index = it->second;
+    auto oldPriority = _heap[index].priority;
+    _heap[index].priority = priority;
+
+    if (priority > oldPriority) {
+        siftUp(index);
+    } else if (priority < oldPriority) {
+        siftDown(index);
+    }
+    return true;
+}
+
+bool ResourceRequestQueue::remove(const Resource* resource) {
+    auto it = _indices.find(resource);
+    if (it == _indices.end()) {
+        return false;
+    }
+
+    removeAt(it->second);
+    return true;
+}
+
+QSharedPointer<Resource> ResourceRequestQueue::top(float* priority) {
+    while (!_heap.empty()) {
+        auto resource = _heap.front().resource.lock();
+        if (!resource) {
+            removeAt(0);
+            continue;
+        }
+
+        auto currentPriority = resource->getLoadPriority();
+        if (currentPriority != _heap.front().priority) {
+            update(resource.data(), currentPriority);
+            continue;
+        }
+
+        if (priority) {
+            *priority = currentPriority;
+        }
+        return resource;
+    }
+
+    return QSharedPointer<Resource>();
+}
+
+QSharedPointer<Resource> ResourceRequestQueue::pop(uint64_t* queuedTime) {
+    auto resource = top();
+    if (resource) {
+        if (queuedTime) {
+            *queuedTime = _heap.front().queuedTime;
+        }
+        removeAt(0);
+    }
+    return resource;
+}
+
+QList<QSharedPointer<Resource>> ResourceRequestQueue::getResources() const {
+    QList<QSharedPointer<Resource>> result;
+    result.reserve((int)_heap.size());
+
+    for (const auto& entry : _heap) {
+        auto resource = entry.resource.lock();
+        if (resource) {
+            result.append(resource);
+        }
+    }
+    return result;
+}
+
+void ResourceRequestQueue::removeAt(size_t index) {
+    _indices.erase(_heap[index].key);
+
+    auto lastIndex = _heap.size() - 1;
+    if (index != lastIndex) {
+        place(index, std::move(_heap[lastIndex]));
+        _heap.pop_back();
+
+        if (index > 0 && isBefore(_heap[index], _heap[(index - 1) / 2])) {
+            siftUp(index);
+        } else {
+            siftDown(index);
+        }
+    } else {
+        _heap.pop_back();
+    }
+}
+
+void ResourceRequestQueue::siftUp(size_t index) {
+    Entry entry = std::move(_heap[index]);
+
+    while (index > 0) {
+        auto parent = (index - 1) / 2;
+        if (!isBefore(entry, _heap[parent])) {
+            break;
+        }
+        place(index, std::move(_heap[parent]));
+        index = parent;
+    }
+
+    place(index, std::move(entry));
+}
+
+void ResourceRequestQueue::siftDown(size_t index) {
+    Entry entry = std::move(_heap[index]);
+    auto size = _heap.size();
+
+    while (true) {
+        auto child = 2 * index + 1;
+        if (child >= size) {
+            break;
+        }
+        if (child + 1 < size && isBefore(_heap[child + 1], _heap[child])) {
+            ++child;
+        }
+        if (!isBefore(_heap[child], entry)) {
+            break;
+        }
+        place(index, std::move(_heap[child]));
+        index = child;
+    }
+
+    place(index, std::move(entry));
+}
+
+void ResourceRequestQueue::place(size_t index, Entry&& entry) {
+    _indices[entry.key] = index;
+    _heap[index] = std::move(entry);
+}
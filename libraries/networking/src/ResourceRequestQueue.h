@@ -0,0 +1,78 @@
+//
+//  ResourceRequestQueue.h
+//  libraries/networking/src
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_ResourceRequestQueue_h
+#define hifi_ResourceRequestQueue_h
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <QtCore/QList>
+#include <QtCore/QSharedPointer>
+#include <QtCore/QWeakPointer>
+
+class Resource;
+
+// A priority queue of the resources waiting for a request slot, indexed by resource so that the priority
+// of a queued resource can be changed, or the resource removed, in logarithmic time.
+// Resources of equal priority are dequeued in the order they were queued.
+// Not thread safe, ResourceCacheSharedItems guards it with its mutex.
+class ResourceRequestQueue {
+public:
+    /// Queues the resource, or updates its priority if it is already queued. Returns true if it was newly queued.
+    bool push(const QSharedPointer<Resource>& resource, float priority, uint64_t queuedTime);
+
+    /// Changes the priority of a queued resource. Returns false if the resource isn't queued.
+    bool update(const Resource* resource, float priority);
+
+    /// Removes a queued resource. Returns false if the resource isn't queued.
+    bool remove(const Resource* resource);
+
+    bool contains(const Resource* resource) const { return _indices.find(resource) != _indices.end(); }
+
+    /// Returns the highest priority resource that is still alive, without dequeuing it.
+    /// The priority of the top resources is read again from them, as their owners may have gone away since it was set,
+    /// and the resources that were freed while queued are dropped along the way.
+    QSharedPointer<Resource> top(float* priority = nullptr);
+
+    /// Dequeues the highest priority resource that is still alive, and the time it was queued at
+    QSharedPointer<Resource> pop(uint64_t* queuedTime = nullptr);
+
+    size_t size() const { return _heap.size(); }
+    bool isEmpty() const { return _heap.empty(); }
+
+    QList<QSharedPointer<Resource>> getResources() const;
+
+private:
+    struct Entry {
+        const Resource* key;
+        QWeakPointer<Resource> resource;
+        float priority;
+        uint64_t sequence;
+        uint64_t queuedTime;
+    };
+
+    // true if a should be dequeued before b
+    static bool isBefore(const Entry& a, const Entry& b) {
+        return a.priority > b.priority || (a.priority == b.priority && a.sequence < b.sequence);
+    }
+
+    void removeAt(size_t index);
+    void siftUp(size_t index);
+    void siftDown(size_t index);
+    void place(size_t index, Entry&& entry);
+
+    std::vector<Entry> _heap;
+    std::unordered_map<const Resource*, size_t> _indices;
+    uint64_t _nextSequence { 0 };
+};
+
+#endif // hifi_ResourceRequestQueue_h
@@ -8,8 +8,29 @@
 
 #include "ResourceScriptingInterface.h"
 
+#include "ResourceCache.h"
 #include "ResourceManager.h"
 
 void ResourceScriptingInterface::overrideUrlPrefix(const QString& prefix, const QString& replacement) {
     DependencyManager::get<ResourceManager>()->setUrlPrefixOverride(prefix, replacement);
 }
+
+QVariantMap ResourceScriptingInterface::getCacheUsage() {
+    return ResourceCache::getCacheUsage();
+}
+
+void ResourceScriptingInterface::setUnusedResourcesBudget(qint64 budget) {
+    ResourceCache::setUnusedResourcesBudget(budget);
+}
+
+qint64 ResourceScriptingInterface::getUnusedResourcesBudget() {
+    return ResourceCache::getUnusedResourcesBudget();
+}
+
+void ResourceScriptingInterface::setProcessMemoryLimit(qint64 limit) {
+    ResourceCache::setProcessMemoryLimit(limit);
+}
+
+qint64 ResourceScriptingInterface::getProcessMemoryLimit() {
+    return ResourceCache::getProcessMemoryLimit();
+}
@@ -14,6 +14,7 @@
 #define hifi_networking_ResourceScriptingInterface_h
 
 #include <QtCore/QObject>
+#include <QtCore/QVariantMap>
 
 #include <DependencyManager.h>
 
@@ -25,6 +26,17 @@ public:
     Q_INVOKABLE void restoreUrlPrefix(const QString& prefix) {
         overrideUrlPrefix(prefix, "");
     }
+
+    // resource counts and sizes (numTotal, numCached, sizeTotal, sizeCached, maxSizeCached) by cache name
+    Q_INVOKABLE QVariantMap getCacheUsage();
+
+    // size in bytes that all caches together can keep in unused resources, 0 for no shared budget
+    Q_INVOKABLE void setUnusedResourcesBudget(qint64 budget);
+    Q_INVOKABLE qint64 getUnusedResourcesBudget();
+
+    // memory in bytes the process should stay under by evicting unused resources, 0 for no limit
+    Q_INVOKABLE void setProcessMemoryLimit(qint64 limit);
+    Q_INVOKABLE qint64 getProcessMemoryLimit();
 };
 
 
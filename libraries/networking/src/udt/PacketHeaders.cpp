@@ -43,9 +43,14 @@ PacketVersion versionForPacketType(PacketType packetType) {
         case PacketType::ICEServerHeartbeat:
             return 18; // ICE Server Heartbeat signing
         case PacketType::AssetGetInfo:
-        case PacketType::AssetGet:
         case PacketType::AssetUpload:
             return static_cast<PacketVersion>(AssetServerPacketVersion::RangeRequestSupport);
+        case PacketType::AssetGet:
+        case PacketType::AssetGetReply:
+            return static_cast<PacketVersion>(AssetServerPacketVersion::CompressedVariants);
+        case PacketType::AssetMappingOperation:
+        case PacketType::AssetMappingOperationReply:
+            return static_cast<PacketVersion>(AssetServerPacketVersion::ServerCapabilities);
         case PacketType::NodeIgnoreRequest:
             return 18; // Introduction of node ignore request (which replaced an unused packet tpye)
 
@@ -122,6 +122,9 @@ public:
         ReplicatedKillAvatar,
         ReplicatedBulkAvatarData,
         OctreeFileReplacementFromUrl,
+        AssetChunkQuery,
+        AssetChunkQueryReply,
+        AssetChunkedUpload,
         NUM_PACKET_TYPE
     };
 
@@ -269,7 +272,10 @@ enum class EntityQueryPacketVersion: PacketVersion {
 
 enum class AssetServerPacketVersion: PacketVersion {
     VegasCongestionControl = 19,
-    RangeRequestSupport
+    RangeRequestSupport,
+    CompressedVariants,
+    BakedTextures,
+    ServerCapabilities
 };
 
 enum class AvatarMixerPacketVersion : PacketVersion {
@@ -194,6 +194,15 @@ public:
     {}
 };
 
+/// An edit message decoded and validated by Octree::prepareEditPacketData(), waiting to be applied to the tree
+class OctreePreparedEdit {
+public:
+    virtual ~OctreePreparedEdit() {}
+
+    int processedBytes { 0 };
+};
+using OctreePreparedEditPointer = std::unique_ptr<OctreePreparedEdit>;
+
 class Octree : public QObject, public std::enable_shared_from_this<Octree>, public ReadWriteLockable {
     Q_OBJECT
 public:
@@ -214,6 +223,15 @@ public:
     virtual int processEditPacketData(ReceivedMessage& message, const unsigned char* editData, int maxLength,
                                       const SharedNodePointer& sourceNode) { return 0; }
 
+    // Implement these to let the OctreeServer decode and validate inbound edit packets on several threads at once and
+    // without the tree lock, then apply them in order under the write lock. prepareEditPacketData() returns null for the
+    // edits that can only be handled by processEditPacketData().
+    virtual OctreePreparedEditPointer prepareEditPacketData(ReceivedMessage& message, const unsigned char* editData,
+                                                            int maxLength, const SharedNodePointer& sourceNode) {
+        return OctreePreparedEditPointer();
+    }
+    virtual void applyPreparedEdit(OctreePreparedEdit& edit, const SharedNodePointer& sourceNode) { }
+
     virtual bool recurseChildrenWithData() const { return true; }
     virtual bool rootElementHasData() const { return false; }
     virtual int minimumRequiredRootDataBytes() const { return 0; }
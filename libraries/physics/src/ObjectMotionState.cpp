@@ -24,6 +24,12 @@ const float ACTIVATION_LINEAR_VELOCITY_DELTA = 0.01f;
 const float ACTIVATION_GRAVITY_DELTA = 0.1f;
 const float ACTIVATION_ANGULAR_VELOCITY_DELTA = 0.03f;
 
+// these thresholds determine what changes (body-->object) are worth pushing out of the simulation
+const float SYNC_POSITION_DELTA = 0.0001f;
+const float SYNC_ALIGNMENT_DOT = 0.9999999f;
+const float SYNC_LINEAR_VELOCITY_DELTA = 0.001f;
+const float SYNC_ANGULAR_VELOCITY_DELTA = 0.001f;
+
 
 // origin of physics simulation in world-frame
 glm::vec3 _worldOffset(0.0f);
@@ -188,10 +194,37 @@ void ObjectMotionState::setRigidBody(btRigidBody* body) {
             _body->setUserPointer(this);
             assert(_body->getCollisionShape() == _shape);
         }
+        _wasSyncedActive = false;
         updateCCDConfiguration();
     }
 }
 
+bool ObjectMotionState::hasSyncedStateChanged(const btTransform& worldTrans) const {
+    assert(_body);
+    float delta = (worldTrans.getOrigin() - glmToBullet(_syncedPosition)).length2();
+    if (delta > SYNC_POSITION_DELTA * SYNC_POSITION_DELTA) {
+        return true;
+    }
+    float alignmentDot = fabsf(worldTrans.getRotation().dot(glmToBullet(_syncedRotation)));
+    if (alignmentDot < SYNC_ALIGNMENT_DOT) {
+        return true;
+    }
+    delta = (_body->getLinearVelocity() - glmToBullet(_syncedLinearVelocity)).length2();
+    if (delta > SYNC_LINEAR_VELOCITY_DELTA * SYNC_LINEAR_VELOCITY_DELTA) {
+        return true;
+    }
+    delta = (_body->getAngularVelocity() - glmToBullet(_syncedAngularVelocity)).length2();
+    return delta > SYNC_ANGULAR_VELOCITY_DELTA * SYNC_ANGULAR_VELOCITY_DELTA;
+}
+
+void ObjectMotionState::setSyncedState(const btTransform& worldTrans) {
+    assert(_body);
+    _syncedPosition = bulletToGLM(worldTrans.getOrigin());
+    _syncedRotation = bulletToGLM(worldTrans.getRotation());
+    _syncedLinearVelocity = bulletToGLM(_body->getLinearVelocity());
+    _syncedAngularVelocity = bulletToGLM(_body->getAngularVelocity());
+}
+
 void ObjectMotionState::setShape(const btCollisionShape* shape) {
     if (_shape != shape) {
         if (_shape) {
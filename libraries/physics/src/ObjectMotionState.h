@@ -149,6 +149,13 @@ public:
     virtual bool isLocallyOwned() const { return false; }
     virtual bool shouldBeLocallyOwned() const { return false; }
 
+    // ThreadSafeDynamicsWorld only pushes the state of an active body out of the simulation when it differs enough
+    // from the state it pushed last, so that the bodies coming to rest cost nothing until they fall asleep
+    bool hasSyncedStateChanged(const btTransform& worldTrans) const;
+    void setSyncedState(const btTransform& worldTrans);
+    bool wasSyncedActive() const { return _wasSyncedActive; }
+    void setSyncedActive(bool active) { _wasSyncedActive = active; }
+
     friend class PhysicsEngine;
 
 protected:
@@ -169,6 +176,13 @@ protected:
 
     uint32_t _lastKinematicStep;
     bool _hasInternalKinematicChanges { false };
+
+    // the state of the body last pushed out of the simulation
+    glm::vec3 _syncedPosition { 0.0f };
+    glm::quat _syncedRotation;
+    glm::vec3 _syncedLinearVelocity { 0.0f };
+    glm::vec3 _syncedAngularVelocity { 0.0f };
+    bool _wasSyncedActive { false };
 };
 
 using SetOfMotionStates = QSet<ObjectMotionState*>;
@@ -61,6 +61,7 @@ void PhysicalEntitySimulation::removeEntityInternal(EntityItemPointer entity) {
         EntitySimulation::removeEntityInternal(entity);
         QMutexLocker lock(&_mutex);
         _entitiesToAddToPhysics.remove(entity);
+        _shapeInfosOfWaitingEntities.remove(entity);
 
         EntityMotionState* motionState = static_cast<EntityMotionState*>(entity->getPhysicsInfo());
         if (motionState) {
@@ -92,6 +93,10 @@ void PhysicalEntitySimulation::changeEntityInternal(EntityItemPointer entity) {
     // queue incoming changes: from external sources (script, EntityServer, etc) to physics engine
     QMutexLocker lock(&_mutex);
     assert(entity);
+
+    // the change may be to its shape, which is computed again if it is still waiting for it
+    _shapeInfosOfWaitingEntities.remove(entity);
+
     EntityMotionState* motionState = static_cast<EntityMotionState*>(entity->getPhysicsInfo());
     if (motionState) {
         if (!entity->shouldBePhysical()) {
@@ -148,6 +153,7 @@ void PhysicalEntitySimulation::clearEntitiesInternal() {
     _entitiesToRemoveFromPhysics.clear();
     _entitiesToRelease.clear();
     _entitiesToAddToPhysics.clear();
+    _shapeInfosOfWaitingEntities.clear();
     _pendingChanges.clear();
     _outgoingChanges.clear();
 }
@@ -167,6 +173,7 @@ void PhysicalEntitySimulation::getObjectsToRemoveFromPhysics(VectorOfMotionState
     for (auto entity: _entitiesToRemoveFromPhysics) {
         // make sure it isn't on any side lists
         _entitiesToAddToPhysics.remove(entity);
+        _shapeInfosOfWaitingEntities.remove(entity);
 
         EntityMotionState* motionState = static_cast<EntityMotionState*>(entity->getPhysicsInfo());
         if (motionState) {
@@ -207,27 +214,37 @@ void PhysicalEntitySimulation::getObjectsToAddToPhysics(VectorOfMotionStates& re
         EntityItemPointer entity = (*entityItr);
         assert(!entity->getPhysicsInfo());
         if (entity->isDead()) {
+            _shapeInfosOfWaitingEntities.remove(entity);
             prepareEntityForDelete(entity);
             entityItr = _entitiesToAddToPhysics.erase(entityItr);
         } else if (!entity->shouldBePhysical()) {
             // this entity should no longer be on the internal _entitiesToAddToPhysics
+            _shapeInfosOfWaitingEntities.remove(entity);
             entityItr = _entitiesToAddToPhysics.erase(entityItr);
             if (entity->isMovingRelativeToParent()) {
                 _simpleKinematicEntities.insert(entity);
             }
         } else if (entity->isReadyToComputeShape()) {
-            ShapeInfo shapeInfo;
-            entity->computeShapeInfo(shapeInfo);
-            int numPoints = shapeInfo.getLargestSubshapePointCount();
-            if (shapeInfo.getType() == SHAPE_TYPE_COMPOUND) {
-                if (numPoints > MAX_HULL_POINTS) {
-                    qWarning() << "convex hull with" << numPoints
-                        << "points for entity" << entity->getName()
-                        << "at" << entity->getPosition() << " will be reduced";
-                }
+            // the expensive shapes are built on another thread, the entity waits here until its shape is ready
+            // and keeps the ShapeInfo it asked for, so that it isn't computed and hashed again every frame
+            auto shapeInfoItr = _shapeInfosOfWaitingEntities.find(entity);
+            if (shapeInfoItr == _shapeInfosOfWaitingEntities.end()) {
+                ShapeInfo shapeInfo;
+                entity->computeShapeInfo(shapeInfo);
+                shapeInfoItr = _shapeInfosOfWaitingEntities.insert(entity, shapeInfo);
             }
-            btCollisionShape* shape = const_cast<btCollisionShape*>(ObjectMotionState::getShapeManager()->getShape(shapeInfo));
+            const ShapeInfo& shapeInfo = shapeInfoItr.value();
+            btCollisionShape* shape = const_cast<btCollisionShape*>(ObjectMotionState::getShapeManager()->getShapeAsync(shapeInfo));
             if (shape) {
+                int numPoints = shapeInfo.getLargestSubshapePointCount();
+                if (shapeInfo.getType() == SHAPE_TYPE_COMPOUND) {
+                    if (numPoints > MAX_HULL_POINTS) {
+                        qWarning() << "convex hull with" << numPoints
+                            << "points for entity" << entity->getName()
+                            << "at" << entity->getPosition() << " will be reduced";
+                    }
+                }
+                _shapeInfosOfWaitingEntities.erase(shapeInfoItr);
                 EntityMotionState* motionState = new EntityMotionState(shape, entity);
                 entity->setPhysicsInfo(static_cast<void*>(motionState));
                 _physicalObjects.insert(motionState);
@@ -241,6 +258,8 @@ void PhysicalEntitySimulation::getObjectsToAddToPhysics(VectorOfMotionStates& re
             ++entityItr;
         }
     }
+    // the entities still waiting asked for their shapes again above, drop the shapes built for the others
+    ObjectMotionState::getShapeManager()->collectUnclaimedShapes();
 }
 
 void PhysicalEntitySimulation::setObjectsToChange(const VectorOfMotionStates& objectsToChange) {
@@ -67,6 +67,10 @@ private:
     SetOfEntities _entitiesToRelease;
     SetOfEntities _entitiesToAddToPhysics;
 
+    // the shapes asked for by the entities waiting for them to be built, which keep their hash,
+    // dropped whenever the entity changes
+    QHash<EntityItemPointer, ShapeInfo> _shapeInfosOfWaitingEntities;
+
     SetOfEntityMotionStates _pendingChanges; // EntityMotionStates already in PhysicsEngine that need their physics changed
     SetOfEntityMotionStates _outgoingChanges; // EntityMotionStates for which we may need to send updates to entity-server
 
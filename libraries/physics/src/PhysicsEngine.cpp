@@ -44,6 +44,7 @@ void PhysicsEngine::init() {
         _broadphaseFilter = new btDbvtBroadphase();
         _constraintSolver = new btSequentialImpulseConstraintSolver;
         _dynamicsWorld = new ThreadSafeDynamicsWorld(_collisionDispatcher, _broadphaseFilter, _constraintSolver, _collisionConfig);
+        _dynamicsWorld->setNumSolverThreads(_numSolverThreads);
 
         _ghostPairCallback = new btGhostPairCallback();
         _dynamicsWorld->getPairCache()->setInternalGhostPairCallback(_ghostPairCallback);
@@ -61,6 +62,13 @@ void PhysicsEngine::init() {
     }
 }
 
+void PhysicsEngine::setNumSolverThreads(int numThreads) {
+    _numSolverThreads = numThreads;
+    if (_dynamicsWorld) {
+        _dynamicsWorld->setNumSolverThreads(numThreads);
+    }
+}
+
 uint32_t PhysicsEngine::getNumSubsteps() {
     return _numSubsteps;
 }
@@ -86,6 +86,9 @@ public:
 
     void dumpNextStats() { _dumpNextStats = true; }
 
+    /// \param numThreads the number of threads solving the independent simulation islands at once
+    void setNumSolverThreads(int numThreads);
+
     EntityDynamicPointer getDynamicByID(const QUuid& dynamicID) const;
     bool addDynamic(EntityDynamicPointer dynamic);
     void removeDynamic(const QUuid dynamicID);
@@ -123,6 +126,7 @@ private:
 
     uint32_t _numContactFrames = 0;
     uint32_t _numSubsteps;
+    int _numSolverThreads = 1;
 
     bool _dumpNextStats = false;
     bool _hasOutgoingChanges = false;
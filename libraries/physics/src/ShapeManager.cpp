@@ -10,16 +10,39 @@
 //
 
 #include <QDebug>
+#include <QtConcurrent/QtConcurrentRun>
 
 #include <glm/gtx/norm.hpp>
 
 #include "ShapeFactory.h"
 #include "ShapeManager.h"
 
+// the shapes worth building on another thread
+static bool isExpensiveToBuild(const ShapeInfo& info) {
+    switch (info.getType()) {
+        case SHAPE_TYPE_COMPOUND:
+        case SHAPE_TYPE_SIMPLE_HULL:
+        case SHAPE_TYPE_SIMPLE_COMPOUND:
+        case SHAPE_TYPE_STATIC_MESH:
+            return true;
+        default:
+            return false;
+    }
+}
+
 ShapeManager::ShapeManager() {
 }
 
 ShapeManager::~ShapeManager() {
+    int numPendingShapes = _pendingShapes.size();
+    for (int i = 0; i < numPendingShapes; ++i) {
+        const btCollisionShape* shape = _pendingShapes.getAtIndex(i)->future.result();
+        if (shape) {
+            ShapeFactory::deleteShape(shape);
+        }
+    }
+    _pendingShapes.clear();
+
     int numShapes = _shapeMap.size();
     for (int i = 0; i < numShapes; ++i) {
         ShapeReference* shapeRef = _shapeMap.getAtIndex(i);
@@ -38,17 +61,65 @@ const btCollisionShape* ShapeManager::getShape(const ShapeInfo& info) {
         shapeRef->refCount++;
         return shapeRef->shape;
     }
-    const btCollisionShape* shape = ShapeFactory::createShapeFromInfo(info);
+    const btCollisionShape* shape;
+    auto pendingShape = _pendingShapes.find(key);
+    if (pendingShape) {
+        // it is already being built, wait for it
+        shape = pendingShape->future.result();
+        _pendingShapes.remove(key);
+    } else {
+        shape = ShapeFactory::createShapeFromInfo(info);
+    }
     if (shape) {
-        ShapeReference newRef;
-        newRef.refCount = 1;
-        newRef.shape = shape;
-        newRef.key = key;
-        _shapeMap.insert(key, newRef);
+        addShape(key, shape);
+    }
+    return shape;
+}
+
+const btCollisionShape* ShapeManager::getShapeAsync(const ShapeInfo& info) {
+    if (info.getType() == SHAPE_TYPE_NONE) {
+        return nullptr;
+    }
+    if (!isExpensiveToBuild(info)) {
+        return getShape(info);
+    }
+    DoubleHashKey key = info.getHash();
+    ShapeReference* shapeRef = _shapeMap.find(key);
+    if (shapeRef) {
+        shapeRef->refCount++;
+        return shapeRef->shape;
+    }
+    auto pendingShape = _pendingShapes.find(key);
+    if (!pendingShape) {
+        PendingShape newPendingShape;
+        newPendingShape.key = key;
+        newPendingShape.future = QtConcurrent::run([info]() {
+            return ShapeFactory::createShapeFromInfo(info);
+        });
+        _pendingShapes.insert(key, newPendingShape);
+        return nullptr;
+    }
+    pendingShape->isClaimed = true;
+    if (!pendingShape->future.isFinished()) {
+        return nullptr;
+    }
+    const btCollisionShape* shape = pendingShape->future.result();
+    _pendingShapes.remove(key);
+    if (shape) {
+        addShape(key, shape);
     }
     return shape;
 }
 
+// private helper method
+void ShapeManager::addShape(const DoubleHashKey& key, const btCollisionShape* shape) {
+    ShapeReference newRef;
+    newRef.refCount = 1;
+    newRef.shape = shape;
+    newRef.key = key;
+    _shapeMap.insert(key, newRef);
+}
+
 // private helper method
 bool ShapeManager::releaseShapeByKey(const DoubleHashKey& key) {
     ShapeReference* shapeRef = _shapeMap.find(key);
@@ -98,6 +169,27 @@ void ShapeManager::collectGarbage() {
     _pendingGarbage.clear();
 }
 
+void ShapeManager::collectUnclaimedShapes() {
+    // the entities that asked for a shape may have been deleted or changed shape while it was built
+    btAlignedObjectArray<DoubleHashKey> unclaimedKeys;
+    int numPendingShapes = _pendingShapes.size();
+    for (int i = 0; i < numPendingShapes; ++i) {
+        PendingShape* pendingShape = _pendingShapes.getAtIndex(i);
+        if (!pendingShape->isClaimed && pendingShape->future.isFinished()) {
+            unclaimedKeys.push_back(pendingShape->key);
+        }
+        pendingShape->isClaimed = false;
+    }
+    int numUnclaimedShapes = unclaimedKeys.size();
+    for (int i = 0; i < numUnclaimedShapes; ++i) {
+        const btCollisionShape* shape = _pendingShapes.find(unclaimedKeys[i])->future.result();
+        if (shape) {
+            ShapeFactory::deleteShape(shape);
+        }
+        _pendingShapes.remove(unclaimedKeys[i]);
+    }
+}
+
 int ShapeManager::getNumReferences(const ShapeInfo& info) const {
     DoubleHashKey key = info.getHash();
     const ShapeReference* shapeRef = _shapeMap.find(key);
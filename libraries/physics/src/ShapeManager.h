@@ -15,6 +15,8 @@
 #include <btBulletDynamicsCommon.h>
 #include <LinearMath/btHashMap.h>
 
+#include <QtCore/QFuture>
+
 #include <ShapeInfo.h>
 
 #include "DoubleHashKey.h"
@@ -28,20 +30,30 @@ public:
     /// \return pointer to shape
     const btCollisionShape* getShape(const ShapeInfo& info);
 
+    /// \return pointer to shape, or nullptr while it is built on another thread, for the shapes that are expensive to build:
+    /// call again later to get it
+    const btCollisionShape* getShapeAsync(const ShapeInfo& info);
+
     /// \return true if shape was found and released
     bool releaseShape(const btCollisionShape* shape);
 
     /// delete shapes that have zero references
     void collectGarbage();
 
+    /// delete the shapes built on other threads that no one asked for since the previous call:
+    /// call it once every round of getShapeAsync() calls
+    void collectUnclaimedShapes();
+
     // validation methods
     int getNumShapes() const { return _shapeMap.size(); }
+    int getNumPendingShapes() const { return _pendingShapes.size(); }
     int getNumReferences(const ShapeInfo& info) const;
     int getNumReferences(const btCollisionShape* shape) const;
     bool hasShape(const btCollisionShape* shape) const;
 
 private:
     bool releaseShapeByKey(const DoubleHashKey& key);
+    void addShape(const DoubleHashKey& key, const btCollisionShape* shape);
 
     class ShapeReference {
     public:
@@ -53,6 +65,16 @@ private:
 
     btHashMap<DoubleHashKey, ShapeReference> _shapeMap;
     btAlignedObjectArray<DoubleHashKey> _pendingGarbage;
+
+    class PendingShape {
+    public:
+        QFuture<const btCollisionShape*> future;
+        DoubleHashKey key;
+        bool isClaimed { true }; // asked for since the previous collectUnclaimedShapes()
+    };
+
+    // the shapes being built on other threads
+    btHashMap<DoubleHashKey, PendingShape> _pendingShapes;
 };
 
 #endif // hifi_ShapeManager_h
@@ -15,10 +15,51 @@
  * Copied and modified from btDiscreteDynamicsWorld.cpp by AndrewMeadows on 2014.11.12.
  * */
 
+#include <algorithm>
+#include <numeric>
+#include <unordered_map>
+
+#include <QtConcurrent/QtConcurrentMap>
+
+#include <BulletCollision/CollisionDispatch/btSimulationIslandManager.h>
+#include <BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolver.h>
 #include <LinearMath/btQuickprof.h>
 
 #include "ThreadSafeDynamicsWorld.h"
 
+// Solves a batch of islands in three steps. The setup and the finish go through Bullet's profiler, which isn't thread
+// safe, so they run on the simulation thread, and only the iterations in between run on the workers.
+class ThreadSafeDynamicsWorld::IslandSolver : public btSequentialImpulseConstraintSolver {
+public:
+    void setup(IslandBatch& batch, const btContactSolverInfo& info, btIDebugDraw* debugDrawer) {
+        solveGroupCacheFriendlySetup(batch.bodies.data(), (int)batch.bodies.size(),
+                                     batch.manifolds.data(), (int)batch.manifolds.size(),
+                                     batch.constraints.data(), (int)batch.constraints.size(), info, debugDrawer);
+    }
+
+    // same as solveGroupCacheFriendlyIterations(), without the profiling
+    void iterate(IslandBatch& batch, const btContactSolverInfo& info, btIDebugDraw* debugDrawer) {
+        btCollisionObject** bodies = batch.bodies.data();
+        btPersistentManifold** manifolds = batch.manifolds.data();
+        btTypedConstraint** constraints = batch.constraints.data();
+        int numBodies = (int)batch.bodies.size();
+        int numManifolds = (int)batch.manifolds.size();
+        int numConstraints = (int)batch.constraints.size();
+
+        solveGroupCacheFriendlySplitImpulseIterations(bodies, numBodies, manifolds, numManifolds,
+                                                      constraints, numConstraints, info, debugDrawer);
+        int maxIterations = btMax(m_maxOverrideNumSolverIterations, info.m_numIterations);
+        for (int iteration = 0; iteration < maxIterations; ++iteration) {
+            solveSingleIteration(iteration, bodies, numBodies, manifolds, numManifolds,
+                                 constraints, numConstraints, info, debugDrawer);
+        }
+    }
+
+    void finish(IslandBatch& batch, const btContactSolverInfo& info) {
+        solveGroupCacheFriendlyFinish(batch.bodies.data(), (int)batch.bodies.size(), info);
+    }
+};
+
 ThreadSafeDynamicsWorld::ThreadSafeDynamicsWorld(
         btDispatcher* dispatcher,
         btBroadphaseInterface* pairCache,
@@ -27,6 +68,13 @@ ThreadSafeDynamicsWorld::ThreadSafeDynamicsWorld(
     :   btDiscreteDynamicsWorld(dispatcher, pairCache, constraintSolver, collisionConfiguration) {
 }
 
+ThreadSafeDynamicsWorld::~ThreadSafeDynamicsWorld() {
+}
+
+void ThreadSafeDynamicsWorld::setNumSolverThreads(int numThreads) {
+    _numSolverThreads = std::max(numThreads, 1);
+}
+
 int ThreadSafeDynamicsWorld::stepSimulationWithSubstepCallback(btScalar timeStep, int maxSubSteps,
                                                                btScalar fixedTimeStep, SubStepCallback onSubStep) {
     BT_PROFILE("stepSimulationWithSubstepCallback");
@@ -91,70 +139,81 @@ int ThreadSafeDynamicsWorld::stepSimulationWithSubstepCallback(btScalar timeStep
 }
 
 // call this instead of non-virtual btDiscreteDynamicsWorld::synchronizeSingleMotionState()
-void ThreadSafeDynamicsWorld::synchronizeMotionState(btRigidBody* body) {
+// returns true if the body is worth reporting as changed
+bool ThreadSafeDynamicsWorld::synchronizeMotionState(btRigidBody* body, bool force) {
     btAssert(body);
     if (body->getMotionState() && !body->isStaticObject()) {
-        //we need to call the update at least once, even for sleeping objects
-        //otherwise the 'graphics' transform never updates properly
-        ///@todo: add 'dirty' flag
-        //if (body->getActivationState() != ISLAND_SLEEPING)
-        {
-            if (body->isKinematicObject()) {
-                ObjectMotionState* objectMotionState = static_cast<ObjectMotionState*>(body->getMotionState());
-                if (objectMotionState->hasInternalKinematicChanges()) {
-                    objectMotionState->clearInternalKinematicChanges();
-                    body->getMotionState()->setWorldTransform(body->getWorldTransform());
-                }
-                return;
+        ObjectMotionState* objectMotionState = static_cast<ObjectMotionState*>(body->getMotionState());
+        if (body->isKinematicObject()) {
+            if (objectMotionState->hasInternalKinematicChanges()) {
+                objectMotionState->clearInternalKinematicChanges();
+                body->getMotionState()->setWorldTransform(body->getWorldTransform());
             }
-            btTransform interpolatedTransform;
+            return true;
+        }
+        btTransform interpolatedTransform;
+        if (body->isActive()) {
             btTransformUtil::integrateTransform(body->getInterpolationWorldTransform(),
                 body->getInterpolationLinearVelocity(),body->getInterpolationAngularVelocity(),
                 (m_latencyMotionStateInterpolation && m_fixedTimeStep) ? m_localTime - m_fixedTimeStep : m_localTime*body->getHitFraction(),
                 interpolatedTransform);
+        } else {
+            // a body that fell asleep stays exactly where the simulation left it, with the velocities it had then
+            interpolatedTransform = body->getWorldTransform();
+        }
+        if (force || objectMotionState->hasSyncedStateChanged(interpolatedTransform)) {
             body->getMotionState()->setWorldTransform(interpolatedTransform);
+            objectMotionState->setSyncedState(interpolatedTransform);
+            return true;
         }
     }
+    return false;
 }
 
 void ThreadSafeDynamicsWorld::synchronizeMotionStates() {
     BT_PROFILE("synchronizeMotionStates");
     _changedMotionStates.clear();
+    _deactivatedStates.clear();
 
     // NOTE: m_synchronizeAllMotionStates is 'false' by default for optimization.
     // See PhysicsEngine::init() where we call _dynamicsWorld->setForceUpdateAllAabbs(false)
     if (m_synchronizeAllMotionStates) {
         //iterate  over all collision objects
+        _changedMotionStates.reserve(m_collisionObjects.size());
         for (int i=0;i<m_collisionObjects.size();i++) {
             btCollisionObject* colObj = m_collisionObjects[i];
             btRigidBody* body = btRigidBody::upcast(colObj);
             if (body && body->getMotionState()) {
-                synchronizeMotionState(body);
+                synchronizeMotionState(body, true);
                 _changedMotionStates.push_back(static_cast<ObjectMotionState*>(body->getMotionState()));
             }
         }
     } else  {
-        //iterate over all active rigid bodies
-        // TODO? if this becomes a performance bottleneck we could derive our own SimulationIslandManager
-        // that remembers a list of objects deactivated last step
-        _activeStates.clear();
-        _deactivatedStates.clear();
+        // Journal only the bodies that changed: the ones that woke up, the ones that moved beyond the thresholds of
+        // ObjectMotionState::hasSyncedStateChanged() since they were last synchronized, and the ones that fell asleep,
+        // which get their exact resting transform. A sleeping body costs a single test per step.
+        // The journal keeps its capacity from step to step so it is only reallocated when the world grows.
+        _changedMotionStates.reserve(m_nonStaticRigidBodies.size());
         for (int i=0;i<m_nonStaticRigidBodies.size();i++) {
             btRigidBody* body = m_nonStaticRigidBodies[i];
             ObjectMotionState* motionState = static_cast<ObjectMotionState*>(body->getMotionState());
             if (motionState) {
                 if (body->isActive()) {
-                    synchronizeMotionState(body);
-                    _changedMotionStates.push_back(motionState);
-                    _activeStates.insert(motionState);
-                } else if (_lastActiveStates.find(motionState) != _lastActiveStates.end()) {
+                    bool justActivated = !motionState->wasSyncedActive();
+                    motionState->setSyncedActive(true);
+                    if (synchronizeMotionState(body, justActivated)) {
+                        _changedMotionStates.push_back(motionState);
+                    }
+                } else if (motionState->wasSyncedActive()) {
                     // this object was active last frame but is no longer
+                    motionState->setSyncedActive(false);
+                    synchronizeMotionState(body, true);
+                    _changedMotionStates.push_back(motionState);
                     _deactivatedStates.push_back(motionState);
                 }
             }
         }
     }
-    _activeStates.swap(_lastActiveStates);
 }
 
 void ThreadSafeDynamicsWorld::saveKinematicState(btScalar timeStep) {
@@ -178,3 +237,208 @@ void ThreadSafeDynamicsWorld::saveKinematicState(btScalar timeStep) {
 }
 
 
+
+// same as the one of btDiscreteDynamicsWorld.cpp
+static int getConstraintIslandId(const btTypedConstraint* constraint) {
+    const btCollisionObject& bodyA = constraint->getRigidBodyA();
+    const btCollisionObject& bodyB = constraint->getRigidBodyB();
+    return bodyA.getIslandTag() >= 0 ? bodyA.getIslandTag() : bodyB.getIslandTag();
+}
+
+void ThreadSafeDynamicsWorld::solveConstraints(btContactSolverInfo& solverInfo) {
+    if (_numSolverThreads <= 1) {
+        btDiscreteDynamicsWorld::solveConstraints(solverInfo);
+        return;
+    }
+    BT_PROFILE("solveConstraints");
+
+    collectIslands();
+    batchIslands();
+
+    for (auto& batch : _islandBatches) {
+        batch.solver->setup(batch, solverInfo, m_debugDrawer);
+    }
+    {
+        BT_PROFILE("solveIslands");
+        btIDebugDraw* debugDrawer = m_debugDrawer;
+        if (_islandBatches.size() > 1) {
+            QtConcurrent::blockingMap(_islandBatches, [&solverInfo, debugDrawer](IslandBatch& batch) {
+                batch.solver->iterate(batch, solverInfo, debugDrawer);
+            });
+        } else {
+            for (auto& batch : _islandBatches) {
+                batch.solver->iterate(batch, solverInfo, debugDrawer);
+            }
+        }
+    }
+    for (auto& batch : _islandBatches) {
+        batch.solver->finish(batch, solverInfo);
+    }
+}
+
+void ThreadSafeDynamicsWorld::collectIslands() {
+    BT_PROFILE("collectIslands");
+
+    // copies the awake islands, in the order of their ids
+    class IslandCollector : public btSimulationIslandManager::IslandCallback {
+    public:
+        IslandCollector(std::vector<Island>& islands) : _islands(islands) {}
+
+        virtual void processIsland(btCollisionObject** bodies, int numBodies, btPersistentManifold** manifolds,
+                                   int numManifolds, int islandId) override {
+            Island island;
+            island.id = islandId;
+            island.bodies.assign(bodies, bodies + numBodies);
+            island.manifolds.assign(manifolds, manifolds + numManifolds);
+            _islands.push_back(std::move(island));
+        }
+
+    private:
+        std::vector<Island>& _islands;
+    };
+
+    _islands.clear();
+    IslandCollector collector(_islands);
+    m_islandManager->buildAndProcessIslands(getCollisionWorld()->getDispatcher(), getCollisionWorld(), &collector);
+
+    // the constraints go with the island of their bodies, like btDiscreteDynamicsWorld::solveConstraints() sorts them,
+    // or all in the one island when the island manager doesn't split them
+    bool splitIslands = !(_islands.size() == 1 && _islands[0].id < 0);
+    std::unordered_map<int, size_t> islandIndices;
+    for (size_t i = 0; i < _islands.size(); ++i) {
+        islandIndices[_islands[i].id] = i;
+    }
+    for (int i = 0; i < m_constraints.size(); ++i) {
+        btTypedConstraint* constraint = m_constraints[i];
+        if (!splitIslands) {
+            _islands[0].constraints.push_back(constraint);
+            continue;
+        }
+        auto itr = islandIndices.find(getConstraintIslandId(constraint));
+        if (itr != islandIndices.end()) {
+            _islands[itr->second].constraints.push_back(constraint);
+        }
+    }
+
+    // The islands with neither contacts nor constraints have nothing to solve, but the solver still integrates the
+    // forces and gravity of their bodies, so these go together in a batch of their own.
+    _freeBodies.clear();
+    auto isFree = [](const Island& island) {
+        return island.manifolds.empty() && island.constraints.empty();
+    };
+    for (const auto& island : _islands) {
+        if (isFree(island)) {
+            _freeBodies.insert(_freeBodies.end(), island.bodies.begin(), island.bodies.end());
+        }
+    }
+    _islands.erase(std::remove_if(_islands.begin(), _islands.end(), isFree), _islands.end());
+}
+
+void ThreadSafeDynamicsWorld::batchIslands() {
+    BT_PROFILE("batchIslands");
+
+    // The kinematic bodies belong to no island, but the solver writes to them, so the islands that touch the same
+    // kinematic body are grouped, and each group is solved by a single solver.
+    std::vector<size_t> groupOf(_islands.size());
+    std::iota(groupOf.begin(), groupOf.end(), 0);
+    auto findGroup = [&groupOf](size_t island) {
+        while (groupOf[island] != island) {
+            groupOf[island] = groupOf[groupOf[island]];
+            island = groupOf[island];
+        }
+        return island;
+    };
+    std::unordered_map<const btCollisionObject*, size_t> sharedBodies;
+    auto shareBody = [&](const btCollisionObject* body, size_t island) {
+        if (body->getIslandTag() == _islands[island].id) {
+            return;
+        }
+        // the solver stands a single fixed body in for the static ones
+        const btRigidBody* rigidBody = btRigidBody::upcast(body);
+        if (!rigidBody || !(rigidBody->getInvMass() || rigidBody->isKinematicObject())) {
+            return;
+        }
+        auto result = sharedBodies.emplace(body, island);
+        if (!result.second) {
+            size_t groupA = findGroup(result.first->second);
+            size_t groupB = findGroup(island);
+            groupOf[std::max(groupA, groupB)] = std::min(groupA, groupB);
+        }
+    };
+    for (size_t i = 0; i < _islands.size(); ++i) {
+        for (auto manifold : _islands[i].manifolds) {
+            shareBody(static_cast<const btCollisionObject*>(manifold->getBody0()), i);
+            shareBody(static_cast<const btCollisionObject*>(manifold->getBody1()), i);
+        }
+        for (auto constraint : _islands[i].constraints) {
+            shareBody(&constraint->getRigidBodyA(), i);
+            shareBody(&constraint->getRigidBodyB(), i);
+        }
+    }
+
+    struct Group {
+        std::vector<size_t> islands;
+        size_t work;
+    };
+    std::vector<Group> groups;
+    std::unordered_map<size_t, size_t> groupIndices;
+    for (size_t i = 0; i < _islands.size(); ++i) {
+        const Island& island = _islands[i];
+        auto result = groupIndices.emplace(findGroup(i), groups.size());
+        if (result.second) {
+            Group group;
+            group.work = 0;
+            groups.push_back(group);
+        }
+        Group& group = groups[result.first->second];
+        group.islands.push_back(i);
+        group.work += island.bodies.size() + island.manifolds.size() + island.constraints.size();
+    }
+
+    // the largest groups go first, each to the batch with the least work so far
+    std::stable_sort(groups.begin(), groups.end(), [](const Group& a, const Group& b) {
+        return a.work > b.work;
+    });
+    size_t numBatches = std::min((size_t)_numSolverThreads, groups.size());
+    size_t numAllBatches = numBatches + (_freeBodies.empty() ? 0 : 1);
+    while (_islandSolvers.size() < numAllBatches) {
+        _islandSolvers.emplace_back(new IslandSolver());
+    }
+    std::vector<std::vector<size_t>> islandsOfBatch(numBatches);
+    _islandBatches.resize(numAllBatches);
+    for (size_t i = 0; i < numAllBatches; ++i) {
+        IslandBatch& batch = _islandBatches[i];
+        batch.solver = _islandSolvers[i].get();
+        batch.bodies.clear();
+        batch.manifolds.clear();
+        batch.constraints.clear();
+        batch.work = 0;
+    }
+    for (const auto& group : groups) {
+        size_t lightest = 0;
+        for (size_t i = 1; i < numBatches; ++i) {
+            if (_islandBatches[i].work < _islandBatches[lightest].work) {
+                lightest = i;
+            }
+        }
+        _islandBatches[lightest].work += group.work;
+        islandsOfBatch[lightest].insert(islandsOfBatch[lightest].end(), group.islands.begin(), group.islands.end());
+    }
+
+    for (size_t i = 0; i < numBatches; ++i) {
+        IslandBatch& batch = _islandBatches[i];
+        std::sort(islandsOfBatch[i].begin(), islandsOfBatch[i].end());
+        for (auto index : islandsOfBatch[i]) {
+            const Island& island = _islands[index];
+            batch.bodies.insert(batch.bodies.end(), island.bodies.begin(), island.bodies.end());
+            batch.manifolds.insert(batch.manifolds.end(), island.manifolds.begin(), island.manifolds.end());
+            batch.constraints.insert(batch.constraints.end(), island.constraints.begin(), island.constraints.end());
+        }
+    }
+
+    if (!_freeBodies.empty()) {
+        IslandBatch& batch = _islandBatches[numBatches];
+        batch.bodies = _freeBodies;
+        batch.work = _freeBodies.size();
+    }
+}
@@ -24,6 +24,8 @@
 #include "ObjectMotionState.h"
 
 #include <functional>
+#include <memory>
+#include <vector>
 
 using SubStepCallback = std::function<void()>;
 
@@ -36,6 +38,7 @@ public:
             btBroadphaseInterface* pairCache,
             btConstraintSolver* constraintSolver,
             btCollisionConfiguration* collisionConfiguration);
+    ~ThreadSafeDynamicsWorld();
 
     int stepSimulationWithSubstepCallback(btScalar timeStep, int maxSubSteps = 1,
                                           btScalar fixedTimeStep = btScalar(1.)/btScalar(60.),
@@ -53,14 +56,47 @@ public:
 
     void addChangedMotionState(ObjectMotionState* motionState) { _changedMotionStates.push_back(motionState); }
 
+    // The simulation islands that share no body can be solved at the same time. With more than one solver thread
+    // they are split into that many batches of similar size, and the batches are solved in parallel.
+    // The split only depends on the islands and on the number of threads, so the results are still deterministic.
+    void setNumSolverThreads(int numThreads);
+    int getNumSolverThreads() const { return _numSolverThreads; }
+
+protected:
+    virtual void solveConstraints(btContactSolverInfo& solverInfo) override;
+
 private:
+    class IslandSolver;
+
+    struct Island {
+        int id;
+        std::vector<btCollisionObject*> bodies;
+        std::vector<btPersistentManifold*> manifolds;
+        std::vector<btTypedConstraint*> constraints;
+    };
+
+    struct IslandBatch {
+        IslandSolver* solver;
+        std::vector<btCollisionObject*> bodies;
+        std::vector<btPersistentManifold*> manifolds;
+        std::vector<btTypedConstraint*> constraints;
+        size_t work;
+    };
+
+    void collectIslands();
+    void batchIslands();
+
     // call this instead of non-virtual btDiscreteDynamicsWorld::synchronizeSingleMotionState()
-    void synchronizeMotionState(btRigidBody* body);
+    bool synchronizeMotionState(btRigidBody* body, bool force);
 
     VectorOfMotionStates _changedMotionStates;
     VectorOfMotionStates _deactivatedStates;
-    SetOfMotionStates _activeStates;
-    SetOfMotionStates _lastActiveStates;
+
+    int _numSolverThreads { 1 };
+    std::vector<std::unique_ptr<IslandSolver>> _islandSolvers;
+    std::vector<Island> _islands;
+    std::vector<btCollisionObject*> _freeBodies; // the bodies of the islands with neither contacts nor constraints
+    std::vector<IslandBatch> _islandBatches;
 };
 
 #endif // hifi_ThreadSafeDynamicsWorld_h
@@ -175,6 +175,12 @@ ScriptEngine::ScriptEngine(Context context, const QString& scriptContents, const
         }
     }, Qt::DirectConnection);
 
+    _timerWheel.setDispatcher([this](const std::vector<QObject*>& timers) {
+        timersFired(timers);
+    });
+    // make sure the timers stop when the script does
+    connect(this, &ScriptEngine::scriptEnding, &_timerWheel, &ScriptTimerWheel::stop);
+
     setProcessEventsInterval(MSECS_PER_SECOND);
     if (isEntityServerScript()) {
         qCDebug(scriptengine) << "isEntityServerScript() -- limiting maxRetries to 1";
@@ -1163,7 +1169,8 @@ void ScriptEngine::run() {
     emit scriptEnding();
 
     if (entityScriptingInterface->getEntityPacketSender()->serversExist()) {
-        // release the queue of edit entity messages.
+        // release the queue of edit entity messages, including the ones still waiting to be coalesced.
+        entityScriptingInterface->getEntityPacketSender()->flushCoalescedEdits();
         entityScriptingInterface->getEntityPacketSender()->releaseQueuedMessages();
 
         // since we're in non-threaded mode, call process so that the packets are sent
@@ -1188,11 +1195,11 @@ void ScriptEngine::run() {
 // NOTE: This is private because it must be called on the same thread that created the timers, which is why
 // we want to only call it in our own run "shutdown" processing.
 void ScriptEngine::stopAllTimers() {
-    QMutableHashIterator<QTimer*, CallbackData> i(_timerFunctionMap);
+    QMutableHashIterator<QObject*, CallbackData> i(_timerFunctionMap);
     int j {0};
     while (i.hasNext()) {
         i.next();
-        QTimer* timer = i.key();
+        QObject* timer = i.key();
         qCDebug(scriptengine) << getFilename() << "stopAllTimers[" << j++ << "]";
         stopTimer(timer);
     }
@@ -1200,14 +1207,14 @@ void ScriptEngine::stopAllTimers() {
 
 void ScriptEngine::stopAllTimersForEntityScript(const EntityItemID& entityID) {
      // We could maintain a separate map of entityID => QTimer, but someone will have to prove to me that it's worth the complexity. -HRS
-    QVector<QTimer*> toDelete;
-    QMutableHashIterator<QTimer*, CallbackData> i(_timerFunctionMap);
+    QVector<QObject*> toDelete;
+    QMutableHashIterator<QObject*, CallbackData> i(_timerFunctionMap);
     while (i.hasNext()) {
         i.next();
         if (i.value().definingEntityIdentifier != entityID) {
             continue;
         }
-        QTimer* timer = i.key();
+        QObject* timer = i.key();
         toDelete << timer; // don't delete while we're iterating. save it.
     }
     for (auto timer:toDelete) { // now reap 'em
@@ -1263,7 +1270,8 @@ void ScriptEngine::updateMemoryCost(const qint64& deltaSize) {
     }
 }
 
-void ScriptEngine::timerFired() {
+// the timers that are due together are dispatched in one batch by _timerWheel
+void ScriptEngine::timersFired(const std::vector<QObject*>& timers) {
     {
         auto engine = DependencyManager::get<ScriptEngines>();
         if (!engine || engine->isStopped()) {
@@ -1272,49 +1280,50 @@ void ScriptEngine::timerFired() {
         }
     }
 
-    QTimer* callingTimer = reinterpret_cast<QTimer*>(sender());
-    CallbackData timerData = _timerFunctionMap.value(callingTimer);
+    PROFILE_RANGE(script, __FUNCTION__);
+    for (auto callingTimer : timers) {
+        // an earlier callback of the batch may have cleared this timer
+        auto itr = _timerFunctionMap.find(callingTimer);
+        if (itr == _timerFunctionMap.end()) {
+            continue;
+        }
+        CallbackData timerData = itr.value();
 
-    if (!callingTimer->isActive()) {
-        // this timer is done, we can kill it
-        _timerFunctionMap.remove(callingTimer);
-        delete callingTimer;
-    }
+        if (!_timerWheel.isActive(callingTimer)) {
+            // this timer is done, we can kill it
+            _timerFunctionMap.erase(itr);
+            _timerWheel.remove(callingTimer);
+        }
 
-    // call the associated JS function, if it exists
-    if (timerData.function.isValid()) {
-        PROFILE_RANGE(script, __FUNCTION__);
-        auto preTimer = p_high_resolution_clock::now();
-        callWithEnvironment(timerData.definingEntityIdentifier, timerData.definingSandboxURL, timerData.function, timerData.function, QScriptValueList());
-        auto postTimer = p_high_resolution_clock::now();
-        auto elapsed = (postTimer - preTimer);
-        _totalTimerExecution += std::chrono::duration_cast<std::chrono::microseconds>(elapsed);
-    } else {
-        qCWarning(scriptengine) << "timerFired -- invalid function" << timerData.function.toVariant().toString();
+        // call the associated JS function, if it exists
+        if (timerData.function.isValid()) {
+            auto preTimer = p_high_resolution_clock::now();
+            callWithEnvironment(timerData.definingEntityIdentifier, timerData.definingSandboxURL, timerData.function, timerData.function, QScriptValueList());
+            auto postTimer = p_high_resolution_clock::now();
+            auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(postTimer - preTimer);
+            _totalTimerExecution += elapsed;
+
+            // account the callback to the entity script that defined it, if it is still loaded
+            if (!timerData.definingEntityIdentifier.isInvalidID()) {
+                auto details = _entityScripts.find(timerData.definingEntityIdentifier);
+                if (details != _entityScripts.end()) {
+                    details->numTimerCalls++;
+                    details->timerExecution += elapsed;
+                }
+            }
+        } else {
+            qCWarning(scriptengine) << "timerFired -- invalid function" << timerData.function.toVariant().toString();
+        }
     }
 }
 
 QObject* ScriptEngine::setupTimerWithInterval(const QScriptValue& function, int intervalMS, bool isSingleShot) {
-    // create the timer, add it to the map, and start it
-    QTimer* newTimer = new QTimer(this);
-    newTimer->setSingleShot(isSingleShot);
-
-    // The default timer type is not very accurate below about 200ms http://doc.qt.io/qt-5/qt.html#TimerType-enum
-    static const int MIN_TIMEOUT_FOR_COARSE_TIMER = 200;
-    if (intervalMS < MIN_TIMEOUT_FOR_COARSE_TIMER) {
-        newTimer->setTimerType(Qt::PreciseTimer);
-    }
-
-    connect(newTimer, &QTimer::timeout, this, &ScriptEngine::timerFired);
-
-    // make sure the timer stops when the script does
-    connect(this, &ScriptEngine::scriptEnding, newTimer, &QTimer::stop);
-
+    // add a timer to the wheel, and map it to its function
+    QObject* newTimer = _timerWheel.add(intervalMS, isSingleShot);
 
     CallbackData timerData = { function, currentEntityIdentifier, currentSandboxURL };
     _timerFunctionMap.insert(newTimer, timerData);
 
-    newTimer->start(intervalMS);
     return newTimer;
 }
 
@@ -1336,11 +1345,10 @@ QObject* ScriptEngine::setTimeout(const QScriptValue& function, int timeoutMS) {
     return setupTimerWithInterval(function, timeoutMS, true);
 }
 
-void ScriptEngine::stopTimer(QTimer *timer) {
+void ScriptEngine::stopTimer(QObject* timer) {
     if (_timerFunctionMap.contains(timer)) {
-        timer->stop();
         _timerFunctionMap.remove(timer);
-        delete timer;
+        _timerWheel.remove(timer);
     } else {
         qCDebug(scriptengine) << "stopTimer -- not in _timerFunctionMap" << timer;
     }
@@ -1959,6 +1967,8 @@ QVariant ScriptEngine::cloneEntityScriptDetails(const EntityItemID& entityID) {
             map["status"] = EntityScriptStatus_::valueToKey(scriptDetails.status).toLower();
             map["errorInfo"] = scriptDetails.errorInfo;
             map["entityID"] = entityID.toString();
+            map["numTimerCalls"] = (qulonglong)scriptDetails.numTimerCalls;
+            map["timerExecutionUsecs"] = (qlonglong)scriptDetails.timerExecution.count();
 #ifdef DEBUG_ENTITY_STATES
             {
                 auto debug = QVariantMap();
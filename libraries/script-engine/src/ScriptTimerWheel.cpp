@@ -0,0 +1,155 @@
+//
+//  ScriptTimerWheel.cpp
+//  libraries/script-engine/src
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "ScriptTimerWheel.h"
+
+#include <algorithm>
+
+ScriptTimerWheel::ScriptTimerWheel(QObject* parent) :
+    QObject(parent),
+    _slots(NUM_SLOTS)
+{
+    _clock.start();
+    _wakeUpTimer.setSingleShot(true);
+    _wakeUpTimer.setTimerType(Qt::PreciseTimer);
+    connect(&_wakeUpTimer, &QTimer::timeout, this, &ScriptTimerWheel::wakeUp);
+}
+
+QObject* ScriptTimerWheel::add(int intervalMS, bool isSingleShot) {
+    QObject* handle = new QObject(this);
+    Timer& timer = _timers[handle];
+    timer.intervalMS = std::max(intervalMS, 0);
+    timer.dueMS = _clock.elapsed() + timer.intervalMS;
+    timer.isSingleShot = isSingleShot;
+    schedule(handle, timer);
+    wakeUpAt(timer.dueTick);
+    return handle;
+}
+
+bool ScriptTimerWheel::remove(QObject* timer) {
+    if (!_timers.remove(timer)) {
+        return false;
+    }
+    // the handle may be in the batch being dispatched, don't let a new timer reuse its address before the batch is done
+    timer->deleteLater();
+    if (_timers.isEmpty()) {
+        clearSlots();
+        stop();
+    }
+    return true;
+}
+
+bool ScriptTimerWheel::isActive(QObject* timer) const {
+    auto itr = _timers.find(timer);
+    return itr != _timers.end() && itr->dueTick != -1;
+}
+
+void ScriptTimerWheel::stop() {
+    _wakeUpTimer.stop();
+    _wakeUpTick = -1;
+}
+
+void ScriptTimerWheel::schedule(QObject* handle, Timer& timer) {
+    // due at the start of the first slot after the timeout, but never in a slot that was already processed
+    timer.dueTick = std::max((timer.dueMS + RESOLUTION_MS - 1) / RESOLUTION_MS, _lastTick + 1);
+    Slot& slot = _slots[timer.dueTick % NUM_SLOTS];
+    slot.entries.push_back({ handle, timer.dueTick });
+    slot.minDueTick = std::min(slot.minDueTick, timer.dueTick);
+}
+
+void ScriptTimerWheel::clearSlots() {
+    for (auto& slot : _slots) {
+        slot.entries.clear();
+        slot.minDueTick = INT64_MAX;
+    }
+}
+
+void ScriptTimerWheel::scheduleWakeUp() {
+    // the first slot of the coming revolution holding a timer due in it, else the closest timer of a later revolution
+    qint64 nextTick = INT64_MAX;
+    for (qint64 tick = _lastTick + 1; tick <= _lastTick + NUM_SLOTS; ++tick) {
+        qint64 minDueTick = _slots[tick % NUM_SLOTS].minDueTick;
+        if (minDueTick <= tick) {
+            nextTick = tick;
+            break;
+        }
+        nextTick = std::min(nextTick, minDueTick);
+    }
+    if (nextTick != INT64_MAX) {
+        wakeUpAt(nextTick);
+    }
+}
+
+void ScriptTimerWheel::wakeUpAt(qint64 tick) {
+    if (_wakeUpTick != -1 && _wakeUpTick <= tick) {
+        return;
+    }
+    _wakeUpTick = tick;
+    _wakeUpTimer.start((int)std::max(tick * RESOLUTION_MS - _clock.elapsed(), (qint64)0));
+}
+
+void ScriptTimerWheel::wakeUp() {
+    _wakeUpTick = -1;
+    qint64 nowMS = _clock.elapsed();
+    qint64 nowTick = nowMS / RESOLUTION_MS;
+
+    // collect the timers due in the slots passed since the last wake up, at most one revolution of them
+    std::vector<SlotEntry> dueEntries;
+    qint64 numTicks = std::min(nowTick - _lastTick, (qint64)NUM_SLOTS);
+    for (qint64 tick = nowTick - numTicks + 1; tick <= nowTick; ++tick) {
+        Slot& slot = _slots[tick % NUM_SLOTS];
+        if (slot.minDueTick > nowTick) {
+            continue;
+        }
+        qint64 minDueTick = INT64_MAX;
+        size_t numKept = 0;
+        for (auto& entry : slot.entries) {
+            if (entry.dueTick <= nowTick) {
+                // drop the entries of the timers that were removed or rescheduled since
+                auto itr = _timers.find(entry.timer);
+                if (itr != _timers.end() && itr->dueTick == entry.dueTick) {
+                    itr->dueTick = -1;
+                    dueEntries.push_back(entry);
+                }
+            } else {
+                minDueTick = std::min(minDueTick, entry.dueTick);
+                slot.entries[numKept++] = entry;
+            }
+        }
+        slot.entries.resize(numKept);
+        slot.minDueTick = minDueTick;
+    }
+    _lastTick = std::max(_lastTick, nowTick);
+
+    std::stable_sort(dueEntries.begin(), dueEntries.end(), [](const SlotEntry& a, const SlotEntry& b) {
+        return a.dueTick < b.dueTick;
+    });
+
+    // reschedule before dispatching, so the callbacks find the wheel in order and can remove or add timers
+    std::vector<QObject*> dueTimers;
+    dueTimers.reserve(dueEntries.size());
+    for (auto& entry : dueEntries) {
+        Timer& timer = _timers[entry.timer];
+        if (!timer.isSingleShot) {
+            timer.dueMS += timer.intervalMS;
+            if (timer.dueMS <= nowMS) {
+                // skip the timeouts that were missed
+                timer.dueMS = nowMS + timer.intervalMS;
+            }
+            schedule(entry.timer, timer);
+        }
+        dueTimers.push_back(entry.timer);
+    }
+    scheduleWakeUp();
+
+    if (!dueTimers.empty() && _dispatcher) {
+        _dispatcher(dueTimers);
+    }
+}
@@ -0,0 +1,92 @@
+//
+//  ScriptTimerWheel.h
+//  libraries/script-engine/src
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_ScriptTimerWheel_h
+#define hifi_ScriptTimerWheel_h
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QHash>
+#include <QtCore/QObject>
+#include <QtCore/QTimer>
+
+// The timers of a ScriptEngine, kept on a hashed timing wheel driven by a single QTimer instead of a QTimer each.
+// Time is cut into slots of RESOLUTION_MS, a timer is due at the start of the first slot after its timeout, and all
+// the timers due by the time the wheel wakes up are handed to the dispatcher in one batch, in the order they were due.
+// Repeating timers are rescheduled from the slot they were due in, so they don't drift, but skip the slots they
+// missed rather than firing several times in a row.
+// Like QTimer, a single shot timer is inactive once it fired, and stays known until it is removed.
+// Not thread safe, it must be used from the thread of its parent.
+class ScriptTimerWheel : public QObject {
+    Q_OBJECT
+public:
+    static const int RESOLUTION_MS = 4;
+    static const int NUM_SLOTS = 256;
+
+    using Dispatcher = std::function<void(const std::vector<QObject*>& timers)>;
+
+    ScriptTimerWheel(QObject* parent = nullptr);
+
+    void setDispatcher(Dispatcher dispatcher) { _dispatcher = dispatcher; }
+
+    /// Schedules a new timer, and returns its handle. The handle is owned by the wheel and deleted once it is removed.
+    QObject* add(int intervalMS, bool isSingleShot);
+
+    /// Returns false if the timer isn't known to the wheel
+    bool remove(QObject* timer);
+
+    bool contains(QObject* timer) const { return _timers.contains(timer); }
+    bool isActive(QObject* timer) const;
+    int size() const { return _timers.size(); }
+
+    QList<QObject*> getTimers() const { return _timers.keys(); }
+
+public slots:
+    /// Stops waking up until a timer is added again
+    void stop();
+
+private:
+    struct Timer {
+        int intervalMS;
+        qint64 dueMS;
+        qint64 dueTick; // -1 once a single shot timer fired
+        bool isSingleShot;
+    };
+
+    // timers stay in their slot when they are removed, and are dropped when the slot comes around
+    struct SlotEntry {
+        QObject* timer;
+        qint64 dueTick;
+    };
+
+    struct Slot {
+        std::vector<SlotEntry> entries;
+        qint64 minDueTick { INT64_MAX };
+    };
+
+    void schedule(QObject* handle, Timer& timer);
+    void clearSlots();
+    void scheduleWakeUp();
+    void wakeUpAt(qint64 tick);
+    void wakeUp();
+
+    QHash<QObject*, Timer> _timers;
+    std::vector<Slot> _slots;
+    qint64 _lastTick { 0 }; // the last tick whose slot was processed
+    qint64 _wakeUpTick { -1 }; // the tick the QTimer will fire at, or -1
+    QElapsedTimer _clock;
+    QTimer _wakeUpTimer { this };
+    Dispatcher _dispatcher;
+};
+
+#endif // hifi_ScriptTimerWheel_h
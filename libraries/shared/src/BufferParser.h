@@ -42,14 +42,13 @@ public:
         result.data3 = qFromBigEndian<quint16>(result.data3);
     }
 
-    template <typename T>
-    inline void readFlags(PropertyFlags<T>& result) {
+    template <typename T, int N>
+    inline void readFlags(PropertyFlags<T, N>& result) {
         _offset += result.decode(_data + _offset, remaining());
     }
 
     template<typename T>
     inline void readCompressedCount(T& result) {
-        // FIXME switch to a heapless implementation as soon as Brad provides it.
         ByteCountCoded<T> codec;
         _offset += codec.decode(reinterpret_cast<const char*>(_data + _offset), (int)remaining());
         result = codec.data;
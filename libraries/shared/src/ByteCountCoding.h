@@ -19,7 +19,13 @@
 #include <algorithm>
 #include <cassert>
 #include <climits>
+#include <cstdint>
 #include <limits>
+#include <type_traits>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 
 #include <QDebug>
 
@@ -30,7 +36,117 @@
 
 #include "NumericalConstants.h"
 
+// The byte count coded values and property flags are written as a header of N-1 set bits and a cleared one, N being
+// the length in bytes of the whole coding, followed by the bits of the value, least significant bit first.
+// The bits fill each byte from its most significant bit, so reversing the bits of every byte gives a little endian
+// bit stream, where the value is simply shifted past the header.
+namespace bytecount {
+
+inline int countLeadingZeros(uint64_t value) {
+    assert(value != 0);
+#ifdef _MSC_VER
+    unsigned long index;
+#if defined(_M_X64)
+    _BitScanReverse64(&index, value);
+    return 63 - (int)index;
+#else
+    if (value >> 32) {
+        _BitScanReverse(&index, (unsigned long)(value >> 32));
+        return 31 - (int)index;
+    }
+    _BitScanReverse(&index, (unsigned long)value);
+    return 63 - (int)index;
+#endif
+#else
+    return __builtin_clzll(value);
+#endif
+}
+
+inline int countTrailingZeros(uint64_t value) {
+    assert(value != 0);
+#ifdef _MSC_VER
+    unsigned long index;
+#if defined(_M_X64)
+    _BitScanForward64(&index, value);
+    return (int)index;
+#else
+    if ((uint32_t)value) {
+        _BitScanForward(&index, (unsigned long)value);
+        return (int)index;
+    }
+    _BitScanForward(&index, (unsigned long)(value >> 32));
+    return 32 + (int)index;
+#endif
+#else
+    return __builtin_ctzll(value);
+#endif
+}
+
+inline int popCount(uint64_t value) {
+#ifdef _MSC_VER
+    // __popcnt needs a CPU that has the instruction
+    value = value - ((value >> 1) & 0x5555555555555555ULL);
+    value = (value & 0x3333333333333333ULL) + ((value >> 2) & 0x3333333333333333ULL);
+    return (int)((((value + (value >> 4)) & 0x0F0F0F0F0F0F0F0FULL) * 0x0101010101010101ULL) >> 56);
+#else
+    return __builtin_popcountll(value);
+#endif
+}
+
+/// Returns the number of bits needed to hold the value, 0 for 0
+inline int bitLength(uint64_t value) {
+    return value ? 64 - countLeadingZeros(value) : 0;
+}
+
+inline uint64_t reverseBitsInBytes(uint64_t word) {
+    word = ((word >> 1) & 0x5555555555555555ULL) | ((word & 0x5555555555555555ULL) << 1);
+    word = ((word >> 2) & 0x3333333333333333ULL) | ((word & 0x3333333333333333ULL) << 2);
+    word = ((word >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((word & 0x0F0F0F0F0F0F0F0FULL) << 4);
+    return word;
+}
+
+/// Reads up to 8 coded bytes as a word of the bit stream
+inline uint64_t readStreamWord(const uint8_t* data, int size) {
+    uint64_t word = 0;
+    for (int i = 0, count = std::min(size, 8); i < count; ++i) {
+        word |= (uint64_t)data[i] << (i * BITS_IN_BYTE);
+    }
+    return reverseBitsInBytes(word);
+}
+
+/// Writes up to 8 bytes of a word of the bit stream
+inline void writeStreamWord(uint64_t word, uint8_t* data, int size) {
+    word = reverseBitsInBytes(word);
+    for (int i = 0, count = std::min(size, 8); i < count; ++i) {
+        data[i] = (uint8_t)(word >> (i * BITS_IN_BYTE));
+    }
+}
+
+/// Returns the length in bytes of the coding at data, read from its header, or 0 if the header doesn't end within size
+inline int decodeLength(const uint8_t* data, int size) {
+    int leadingOnes = 0;
+    for (int offset = 0; offset < size; offset += 8) {
+        int availableBits = std::min(size - offset, 8) * BITS_IN_BYTE;
+        uint64_t zeros = ~readStreamWord(data + offset, size - offset);
+        if (availableBits < 64) {
+            zeros &= (1ULL << availableBits) - 1;
+        }
+        if (zeros) {
+            return leadingOnes + countTrailingZeros(zeros) + 1;
+        }
+        leadingOnes += availableBits;
+    }
+    return 0;
+}
+
+}
+
+// the most bytes a 64 bit value takes once coded
+const int MAX_BYTE_COUNT_CODED_SIZE = 10;
+
 template<typename T> class ByteCountCoded {
+    static_assert(sizeof(T) <= sizeof(uint64_t), "ByteCountCoded only supports up to 64 bit values");
+
 public:
     T data;
     ByteCountCoded(T input = 0) : data(input) { 
@@ -40,7 +156,17 @@ public:
 
     ByteCountCoded(const QByteArray& fromEncoded) : data(0) { decode(fromEncoded); }
 
+    /// Returns the number of bytes the value takes once coded
+    /// BITS_IN_BYTE-1 because we need to code the number of bytes in the header
+    /// + 1 because we always take at least 1 byte, even if number of bits is less than a bytes worth
+    static int encodedSize(T value) { return (bytecount::bitLength(toBits(value)) / (BITS_IN_BYTE - 1)) + 1; }
+    int encodedSize() const { return encodedSize(data); }
+
     QByteArray encode() const;
+
+    /// Writes the coded value to the buffer and returns the number of bytes written, or 0 if it doesn't fit
+    int encode(uint8_t* buffer, int bufferSize) const;
+
     size_t decode(const QByteArray& fromEncoded);
     size_t decode(const char* encodedBuffer, int encodedSize);
 
@@ -50,6 +176,9 @@ public:
 
      operator QByteArray() const { return encode(); };
      operator T() const { return data; };
+
+private:
+    static uint64_t toBits(T value) { return (uint64_t)(typename std::make_unsigned<T>::type)value; }
 };
 
 template<typename T> inline QByteArray& operator<<(QByteArray& out, const ByteCountCoded<T>& value) {
@@ -62,57 +191,25 @@ template<typename T> inline QByteArray& operator>>(QByteArray& in, ByteCountCode
 }
 
 template<typename T> inline QByteArray ByteCountCoded<T>::encode() const {
-    QByteArray output;
-
-    int totalBits = sizeof(data) * BITS_IN_BYTE;
-    int valueBits = totalBits;
-    bool firstValueFound = false;
-    T temp = data;
-    T lastBitMask = (T)(1) << (totalBits - 1);
-
-    // determine the number of bits that the value takes
-    for (int bitAt = 0; bitAt < totalBits; bitAt++) {
-        T bitValue = (temp & lastBitMask) == lastBitMask;
-        if (!firstValueFound) {
-            if (bitValue == 0) {
-                valueBits--;
-            } else {
-                firstValueFound = true;
-            }
-        }
-        temp = temp << 1;
-    }
-    
-    // calculate the number of total bytes, including our header
-    // BITS_IN_BYTE-1 because we need to code the number of bytes in the header
-    // + 1 because we always take at least 1 byte, even if number of bits is less than a bytes worth
-    int numberOfBytes = (valueBits / (BITS_IN_BYTE - 1)) + 1; 
-
-    output.fill(0, numberOfBytes);
-
-    // next pack the number of header bits in, the first N-1 to be set to 1, the last to be set to 0
-    for(int i = 0; i < numberOfBytes; i++) {
-        int outputIndex = i;
-        T bitValue = (i < (numberOfBytes - 1)  ? 1 : 0);
-        char original = output.at(outputIndex / BITS_IN_BYTE);
-        int shiftBy = BITS_IN_BYTE - ((outputIndex % BITS_IN_BYTE) + 1);
-        char thisBit = ( bitValue << shiftBy);
-        output[i / BITS_IN_BYTE] = (original | thisBit);
+    QByteArray output(encodedSize(), Qt::Uninitialized);
+    encode(reinterpret_cast<uint8_t*>(output.data()), output.size());
+    return output;
+}
+
+template<typename T> inline int ByteCountCoded<T>::encode(uint8_t* buffer, int bufferSize) const {
+    uint64_t value = toBits(data);
+    int numberOfBytes = encodedSize();
+    if (numberOfBytes > bufferSize) {
+        return 0;
     }
 
-    // finally pack the the actual bits from the bit array
-    temp = data;
-    for(int i = numberOfBytes; i < (numberOfBytes + valueBits); i++) {
-        int outputIndex = i;
-        T bitValue = (temp & 1);
-        char original = output.at(outputIndex / BITS_IN_BYTE);
-        int shiftBy = BITS_IN_BYTE - ((outputIndex % BITS_IN_BYTE) + 1);
-        char thisBit = ( bitValue << shiftBy);
-        output[i / BITS_IN_BYTE] = (original | thisBit);
-
-        temp = temp >> 1;
+    // a 64 bit value takes at most 10 bytes, the first 8 hold the header and the low bits of the value
+    uint64_t header = (1ULL << (numberOfBytes - 1)) - 1;
+    bytecount::writeStreamWord(header | (value << numberOfBytes), buffer, numberOfBytes);
+    if (numberOfBytes > 8) {
+        bytecount::writeStreamWord(value >> (64 - numberOfBytes), buffer + 8, numberOfBytes - 8);
     }
-    return output;
+    return numberOfBytes;
 }
 
 template<typename T> inline size_t ByteCountCoded<T>::decode(const QByteArray& fromEncodedBytes) {
@@ -121,57 +218,33 @@ template<typename T> inline size_t ByteCountCoded<T>::decode(const QByteArray& f
 
 template<typename T> inline size_t ByteCountCoded<T>::decode(const char* encodedBuffer, int encodedSize) {
     data = 0; // reset data
-    size_t bytesConsumed = 0;
-    int bitCount = BITS_IN_BYTE * encodedSize;
-
-    int encodedByteCount = 1; // there is at least 1 byte (after the leadBits)
-    int leadBits = 1; // there is always at least 1 lead bit
-    bool inLeadBits = true;
-    int bitAt = 0;
-    int expectedBitCount; // unknown at this point
-    int lastValueBit = 0;
-    T bitValue = 1;
-    
-    for(int byte = 0; byte < encodedSize; byte++) {
-        char originalByte = encodedBuffer[byte];
-        bytesConsumed++;
-        unsigned char maskBit = 128; // LEFT MOST BIT set
-        for(int bit = 0; bit < BITS_IN_BYTE; bit++) {
-            bool bitIsSet = originalByte & maskBit;
-            
-            // Processing of the lead bits
-            if (inLeadBits) {
-                if (bitIsSet) {
-                    encodedByteCount++;
-                    leadBits++;
-                } else {
-                    inLeadBits = false; // once we hit our first 0, we know we're out of the lead bits
-                    expectedBitCount = (encodedByteCount * BITS_IN_BYTE) - leadBits;
-                    lastValueBit = expectedBitCount + bitAt;
-
-                    // check to see if the remainder of our buffer is sufficient
-                    if (expectedBitCount > (bitCount - leadBits)) {
-                        break;
-                    }
-                }
-            } else {
-                if (bitAt > lastValueBit) {
-                    break;
-                }
-                
-                if(bitIsSet) {
-                    data += bitValue;
-                }
-                bitValue *= 2;
-            }
-            bitAt++;
-            maskBit = maskBit >> 1;
-        }
-        if (!inLeadBits && bitAt > lastValueBit) {
+
+    auto bytes = reinterpret_cast<const uint8_t*>(encodedBuffer);
+    int numberOfBytes = bytecount::decodeLength(bytes, encodedSize);
+    if (numberOfBytes == 0 || numberOfBytes > encodedSize) {
+        // the buffer is too short for the value, skip what is left of it
+        return std::max(encodedSize, 0);
+    }
+
+    // the value starts right after the header, its bits past the width of T are dropped
+    uint64_t value = 0;
+    for (int offset = 0; offset < numberOfBytes; offset += 8) {
+        int shift = offset * BITS_IN_BYTE - numberOfBytes;
+        if (shift >= 64) {
             break;
+        } else if (shift <= -64) {
+            continue;
+        }
+
+        uint64_t word = bytecount::readStreamWord(bytes + offset, numberOfBytes - offset);
+        if (shift < 0) {
+            value |= word >> -shift;
+        } else {
+            value |= word << shift;
         }
     }
-    return bytesConsumed;
+    data = (T)value;
+
+    return numberOfBytes;
 }
 #endif // hifi_ByteCountCoding_h
-
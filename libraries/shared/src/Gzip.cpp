@@ -151,3 +151,70 @@ bool gzip(QByteArray source, QByteArray &destination, int compressionLevel) {
     deflateEnd(&strm);
     return status == Z_STREAM_END;
 }
+
+GzipCompressor::GzipCompressor(int compressionLevel) :
+    _stream(new z_stream())
+{
+    _stream->zalloc = Z_NULL;
+    _stream->zfree = Z_NULL;
+    _stream->opaque = Z_NULL;
+    _stream->next_in = Z_NULL;
+    _stream->avail_in = 0;
+
+    int status = deflateInit2(_stream.get(),
+                              qMax(Z_DEFAULT_COMPRESSION, qMin(9, compressionLevel)),
+                              Z_DEFLATED,
+                              GZIP_WINDOWS_BIT,
+                              DEFAULT_MEM_LEVEL,
+                              Z_DEFAULT_STRATEGY);
+    _isOpen = (status == Z_OK);
+}
+
+GzipCompressor::~GzipCompressor() {
+    if (_isOpen) {
+        deflateEnd(_stream.get());
+    }
+}
+
+bool GzipCompressor::addData(const QByteArray& data) {
+    return deflateData(data, Z_NO_FLUSH);
+}
+
+bool GzipCompressor::finish() {
+    return deflateData(QByteArray(), Z_FINISH);
+}
+
+bool GzipCompressor::deflateData(const QByteArray& data, int flush) {
+    if (!_isOpen) {
+        return false;
+    }
+
+    // deflate doesn't write to its input, older zlib headers just don't say so
+    _stream->next_in = (unsigned char*)data.constData();
+    _stream->avail_in = data.length();
+
+    int status;
+    for (;;) {
+        char out[GZIP_CHUNK_SIZE];
+        _stream->next_out = (unsigned char*)out;
+        _stream->avail_out = GZIP_CHUNK_SIZE;
+        status = deflate(_stream.get(), flush);
+        if (status == Z_STREAM_ERROR) {
+            break;
+        }
+        int available = (GZIP_CHUNK_SIZE - _stream->avail_out);
+        if (available > 0) {
+            _compressedData.append((char*)out, available);
+        }
+        if (_stream->avail_out != 0) {
+            break;
+        }
+    }
+
+    if (status == Z_STREAM_ERROR || flush == Z_FINISH) {
+        deflateEnd(_stream.get());
+        _isOpen = false;
+        return status == Z_STREAM_END;
+    }
+    return true;
+}
@@ -12,8 +12,12 @@
 #ifndef GZIP_H
 #define GZIP_H
 
+#include <memory>
+
 #include <QByteArray>
 
+struct z_stream_s;
+
 // The compression level must be Z_DEFAULT_COMPRESSION (-1), or between 0 and
 // 9: 1 gives best speed, 9 gives best compression, 0 gives no
 // compression at all (the input data is simply copied a block at a
@@ -24,4 +28,25 @@ bool gzip(QByteArray source, QByteArray &destination, int compressionLevel = -1)
 
 bool gunzip(QByteArray source, QByteArray &destination);
 
+// Gzips data handed in pieces, so that the source never has to be held whole.
+// Once a call failed, or the data was finished, no more data can be added.
+class GzipCompressor {
+public:
+    GzipCompressor(int compressionLevel = -1); // -1 is Z_DEFAULT_COMPRESSION
+    ~GzipCompressor();
+
+    bool addData(const QByteArray& data);
+    bool finish();
+
+    // the data compressed so far, complete once finish() succeeded
+    const QByteArray& getCompressedData() const { return _compressedData; }
+
+private:
+    bool deflateData(const QByteArray& data, int flush);
+
+    std::unique_ptr<z_stream_s> _stream;
+    QByteArray _compressedData;
+    bool _isOpen { false };
+};
+
 #endif
@@ -10,7 +10,6 @@
 //
 //
 // TODO:
-//   * consider adding iterator to enumerate the properties that have been set?
 //   * operator QSet<Enum> - this would be easiest way to handle enumeration
 //   * make encode(), QByteArray<< operator, and QByteArray operator const by moving calculation of encoded length to
 //     setFlag() and other calls
@@ -20,31 +19,38 @@
 #define hifi_PropertyFlags_h
 
 #include <algorithm>
+#include <array>
 #include <climits>
 
-#include <QBitArray>
 #include <QByteArray>
 
 #include "ByteCountCoding.h"
 #include "SharedLogging.h"
 
-template<typename Enum>class PropertyFlags {
+// the number of flags a set can hold when it isn't sized from its enum
+const int DEFAULT_PROPERTY_FLAGS_SIZE = 256;
+
+// A set of flags, stored in fixed size words so that it needs no allocation and can be combined a word at a time.
+// NumFlags should be one past the last value of the enum, flags past it can't be set and are dropped when decoded.
+template<typename Enum, int NumFlags = DEFAULT_PROPERTY_FLAGS_SIZE> class PropertyFlags {
+    static_assert(NumFlags > 0, "PropertyFlags needs room for at least one flag");
+
 public:
     typedef Enum enum_type;
     inline PropertyFlags() : 
-            _maxFlag(INT_MIN), _minFlag(INT_MAX), _trailingFlipped(false), _encodedLength(0) { };
+            _maxFlag(INT_MIN), _minFlag(INT_MAX), _trailingFlipped(false), _encodedLength(0) { _flags.fill(0); };
 
     inline PropertyFlags(const PropertyFlags& other) : 
             _flags(other._flags), _maxFlag(other._maxFlag), _minFlag(other._minFlag), 
             _trailingFlipped(other._trailingFlipped), _encodedLength(0) {}
 
     inline PropertyFlags(Enum flag) : 
-            _maxFlag(INT_MIN), _minFlag(INT_MAX), _trailingFlipped(false), _encodedLength(0) { setHasProperty(flag); }
+            _maxFlag(INT_MIN), _minFlag(INT_MAX), _trailingFlipped(false), _encodedLength(0) { _flags.fill(0); setHasProperty(flag); }
 
     inline PropertyFlags(const QByteArray& fromEncoded) : 
             _maxFlag(INT_MIN), _minFlag(INT_MAX), _trailingFlipped(false), _encodedLength(0) { decode(fromEncoded); }
 
-    void clear() { _flags.clear(); _maxFlag = INT_MIN; _minFlag = INT_MAX; _trailingFlipped = false; _encodedLength = 0; }
+    void clear() { _flags.fill(0); _maxFlag = INT_MIN; _minFlag = INT_MAX; _trailingFlipped = false; _encodedLength = 0; }
     bool isEmpty() const { return _maxFlag == INT_MIN && _minFlag == INT_MAX && _trailingFlipped == false && _encodedLength == 0; }
 
     Enum firstFlag() const { return (Enum)_minFlag; }
@@ -52,7 +58,21 @@ public:
     
     void setHasProperty(Enum flag, bool value = true);
     bool getHasProperty(Enum flag) const;
+
+    /// Calls function(Enum flag) for each flag that is set, in increasing order
+    template<typename F> void forEachFlag(F function) const;
+
+    /// Returns the number of flags that are set
+    int count() const;
+
+    /// Returns the number of bytes the flags take once encoded
+    int getEncodedSize() const { return _maxFlag < _minFlag ? 1 : (_maxFlag / (BITS_IN_BYTE - 1)) + 1; }
+
     QByteArray encode();
+
+    /// Writes the encoded flags to the buffer and returns the number of bytes written, or 0 if they don't fit
+    int encode(uint8_t* buffer, int bufferSize);
+
     size_t decode(const uint8_t* data, size_t length);
     size_t decode(const QByteArray& fromEncoded);
 
@@ -60,7 +80,7 @@ public:
 
     bool operator==(const PropertyFlags& other) const { return _flags == other._flags; }
     bool operator!=(const PropertyFlags& other) const { return _flags != other._flags; }
-    bool operator!() const { return _flags.size() == 0; }
+    bool operator!() const { return _maxFlag < 0; }
 
     PropertyFlags& operator=(const PropertyFlags& other);
 
@@ -109,25 +129,42 @@ public:
 
 
 private:
+    static const int BITS_PER_WORD = 64;
+    static const int BYTES_PER_WORD = BITS_PER_WORD / BITS_IN_BYTE;
+    static const int NUM_WORDS = (NumFlags + BITS_PER_WORD - 1) / BITS_PER_WORD;
+
+    // the flags are encoded after a header of one bit per encoded byte, so they can span one more word
+    static const int MAX_ENCODED_BYTES = ((NumFlags - 1) / (BITS_IN_BYTE - 1)) + 1;
+    static const int NUM_STREAM_WORDS = (MAX_ENCODED_BYTES * BITS_IN_BYTE + BITS_PER_WORD - 1) / BITS_PER_WORD;
+
+    bool testBit(int flag) const { return (_flags[flag / BITS_PER_WORD] >> (flag % BITS_PER_WORD)) & 1; }
+
+    // clears the bits past _maxFlag, the flags only ever hold bits up to it
+    void clearTrailingBits();
     void shrinkIfNeeded();
 
-    QBitArray _flags;
+    std::array<uint64_t, NUM_WORDS> _flags;
     int _maxFlag;
     int _minFlag;
     bool _trailingFlipped; /// are the trailing properties flipping in their state (e.g. assumed true, instead of false)
     int _encodedLength;
 };
 
-template<typename Enum> PropertyFlags<Enum>& operator<<(PropertyFlags<Enum>& out, const PropertyFlags<Enum>& other) {
+template<typename Enum, int N> PropertyFlags<Enum, N>& operator<<(PropertyFlags<Enum, N>& out, const PropertyFlags<Enum, N>& other) {
     return out <<= other;
 }
 
-template<typename Enum> PropertyFlags<Enum>& operator<<(PropertyFlags<Enum>& out, Enum flag) {
+template<typename Enum, int N> PropertyFlags<Enum, N>& operator<<(PropertyFlags<Enum, N>& out, Enum flag) {
     return out <<= flag;
 }
 
 
-template<typename Enum> inline void PropertyFlags<Enum>::setHasProperty(Enum flag, bool value) {
+template<typename Enum, int N> inline void PropertyFlags<Enum, N>::setHasProperty(Enum flag, bool value) {
+    if ((int)flag < 0 || (int)flag >= N) {
+        assert(!value);
+        return; // past the size of the flags, the only value these can have is the default
+    }
+
     // keep track of our min flag
     if (flag < _minFlag) {
         if (value) {
@@ -137,328 +174,351 @@ template<typename Enum> inline void PropertyFlags<Enum>::setHasProperty(Enum fla
     if (flag > _maxFlag) {
         if (value) {
             _maxFlag = flag;
-            _flags.resize(_maxFlag + 1);
         } else {
             return; // bail early, we're setting a flag outside of our current _maxFlag to false, which is already the default
         }
     }
-    _flags.setBit(flag, value);
+
+    uint64_t mask = 1ULL << (flag % BITS_PER_WORD);
+    if (value) {
+        _flags[flag / BITS_PER_WORD] |= mask;
+    } else {
+        _flags[flag / BITS_PER_WORD] &= ~mask;
+    }
     
     if (flag == _maxFlag && !value) {
         shrinkIfNeeded();
     }
 }
 
-template<typename Enum> inline bool PropertyFlags<Enum>::getHasProperty(Enum flag) const {
+template<typename Enum, int N> inline bool PropertyFlags<Enum, N>::getHasProperty(Enum flag) const {
     if (flag > _maxFlag) {
         return _trailingFlipped; // usually false
     }
-    return _flags.testBit(flag);
+    return (int)flag >= 0 && testBit(flag);
+}
+
+template<typename Enum, int N> template<typename F> inline void PropertyFlags<Enum, N>::forEachFlag(F function) const {
+    for (int word = 0; word < NUM_WORDS; ++word) {
+        for (uint64_t bits = _flags[word]; bits; bits &= bits - 1) {
+            function((Enum)(word * BITS_PER_WORD + bytecount::countTrailingZeros(bits)));
+        }
+    }
 }
 
-const int BITS_PER_BYTE = 8;
+template<typename Enum, int N> inline int PropertyFlags<Enum, N>::count() const {
+    int result = 0;
+    for (auto bits : _flags) {
+        result += bytecount::popCount(bits);
+    }
+    return result;
+}
 
-template<typename Enum> inline QByteArray PropertyFlags<Enum>::encode() {
-    QByteArray output;
-    
-    if (_maxFlag < _minFlag) {
-        output.fill(0, 1);
-        return output; // no flags... nothing to encode
+template<typename Enum, int N> inline QByteArray PropertyFlags<Enum, N>::encode() {
+    QByteArray output(getEncodedSize(), Qt::Uninitialized);
+    encode(reinterpret_cast<uint8_t*>(output.data()), output.size());
+    return output;
+}
+
+template<typename Enum, int N> inline int PropertyFlags<Enum, N>::encode(uint8_t* buffer, int bufferSize) {
+    int lengthInBytes = getEncodedSize();
+    if (lengthInBytes > bufferSize) {
+        return 0;
     }
 
-    // we should size the array to the correct size.
-    int lengthInBytes = (_maxFlag / (BITS_PER_BYTE - 1)) + 1;
+    if (_maxFlag < _minFlag) {
+        buffer[0] = 0;
+        return 1; // no flags... nothing to encode
+    }
 
-    output.fill(0, lengthInBytes);
+    // the header takes the first lengthInBytes bits of the stream, then come the flags up to _maxFlag
+    std::array<uint64_t, NUM_STREAM_WORDS> stream;
+    stream.fill(0);
+    for (int bit = 0; bit < lengthInBytes - 1; bit += BITS_PER_WORD) {
+        int ones = std::min(lengthInBytes - 1 - bit, BITS_PER_WORD);
+        stream[bit / BITS_PER_WORD] = ones < BITS_PER_WORD ? (1ULL << ones) - 1 : ~0ULL;
+    }
 
-    // next pack the number of header bits in, the first N-1 to be set to 1, the last to be set to 0
-    for(int i = 0; i < lengthInBytes; i++) {
-        int outputIndex = i;
-        int bitValue = (i < (lengthInBytes - 1)  ? 1 : 0);
-        char original = output.at(outputIndex / BITS_PER_BYTE);
-        int shiftBy = BITS_PER_BYTE - ((outputIndex % BITS_PER_BYTE) + 1);
-        char thisBit = ( bitValue << shiftBy);
-        output[i / BITS_PER_BYTE] = (original | thisBit);
+    int wordShift = lengthInBytes / BITS_PER_WORD;
+    int bitShift = lengthInBytes % BITS_PER_WORD;
+    for (int word = 0; word < NUM_WORDS && word + wordShift < NUM_STREAM_WORDS; ++word) {
+        stream[word + wordShift] |= _flags[word] << bitShift;
+        if (bitShift > 0 && word + wordShift + 1 < NUM_STREAM_WORDS) {
+            stream[word + wordShift + 1] |= _flags[word] >> (BITS_PER_WORD - bitShift);
+        }
     }
 
-    // finally pack the the actual bits from the bit array
-    for(int i = lengthInBytes; i < (lengthInBytes + _maxFlag + 1); i++) {
-        int flagIndex = i - lengthInBytes;
-        int outputIndex = i;
-        int bitValue = ( _flags[flagIndex]  ? 1 : 0);
-        char original = output.at(outputIndex / BITS_PER_BYTE);
-        int shiftBy = BITS_PER_BYTE - ((outputIndex % BITS_PER_BYTE) + 1);
-        char thisBit = ( bitValue << shiftBy);
-        output[i / BITS_PER_BYTE] = (original | thisBit);
+    for (int offset = 0; offset < lengthInBytes; offset += BYTES_PER_WORD) {
+        bytecount::writeStreamWord(stream[offset / BYTES_PER_WORD], buffer + offset, lengthInBytes - offset);
     }
     
     _encodedLength = lengthInBytes;
-    return output;
+    return lengthInBytes;
 }
 
-template<typename Enum> 
-inline size_t PropertyFlags<Enum>::decode(const uint8_t* data, size_t size) {
+template<typename Enum, int N>
+inline size_t PropertyFlags<Enum, N>::decode(const uint8_t* data, size_t size) {
     clear(); // we are cleared out!
 
-    size_t bytesConsumed = 0;
-    int bitCount = BITS_IN_BYTE * (int)size;
-
-    int encodedByteCount = 1; // there is at least 1 byte (after the leadBits)
-    int leadBits = 1; // there is always at least 1 lead bit
-    bool inLeadBits = true;
-    int bitAt = 0;
-    int expectedBitCount; // unknown at this point
-    int lastValueBit = 0;
-    for (unsigned int byte = 0; byte < size; byte++) {
-        char originalByte = data[byte];
-        bytesConsumed++;
-        unsigned char maskBit = 0x80; // LEFT MOST BIT set
-        for (int bit = 0; bit < BITS_IN_BYTE; bit++) {
-            bool bitIsSet = originalByte & maskBit;
-            // Processing of the lead bits
-            if (inLeadBits) {
-                if (bitIsSet) {
-                    encodedByteCount++;
-                    leadBits++;
-                } else {
-                    inLeadBits = false; // once we hit our first 0, we know we're out of the lead bits
-                    expectedBitCount = (encodedByteCount * BITS_IN_BYTE) - leadBits;
-                    lastValueBit = expectedBitCount + bitAt;
-
-                    // check to see if the remainder of our buffer is sufficient
-                    if (expectedBitCount > (bitCount - leadBits)) {
-                        break;
-                    }
-                }
-            } else {
-                if (bitAt > lastValueBit) {
-                    break;
-                }
-
-                if (bitIsSet) {
-                    setHasProperty(static_cast<Enum>(bitAt - leadBits), true);
-                }
-            }
-            bitAt++;
-            maskBit >>= 1;
+    int encodedSize = (int)std::min(size, (size_t)INT_MAX);
+    int lengthInBytes = bytecount::decodeLength(data, encodedSize);
+    if (lengthInBytes == 0 || lengthInBytes > encodedSize) {
+        // the buffer is too short for the flags, skip what is left of it
+        _encodedLength = encodedSize;
+        return encodedSize;
+    }
+
+    // the flags start right after the header, the ones past the size of the set are dropped
+    int headerWords = lengthInBytes / BITS_PER_WORD;
+    int bitShift = lengthInBytes % BITS_PER_WORD;
+    int streamBytes = std::min(lengthInBytes, (headerWords + NUM_WORDS + 1) * BYTES_PER_WORD);
+    for (int offset = headerWords * BYTES_PER_WORD; offset < streamBytes; offset += BYTES_PER_WORD) {
+        uint64_t word = bytecount::readStreamWord(data + offset, lengthInBytes - offset);
+        int index = offset / BYTES_PER_WORD - headerWords;
+        if (index < NUM_WORDS) {
+            _flags[index] |= word >> bitShift;
+        }
+        if (bitShift > 0 && index > 0 && index - 1 < NUM_WORDS) {
+            _flags[index - 1] |= word << (BITS_PER_WORD - bitShift);
         }
-        if (!inLeadBits && bitAt > lastValueBit) {
+    }
+    if (N % BITS_PER_WORD) {
+        _flags[NUM_WORDS - 1] &= (1ULL << (N % BITS_PER_WORD)) - 1;
+    }
+
+    for (int word = 0; word < NUM_WORDS; ++word) {
+        if (_flags[word]) {
+            _minFlag = word * BITS_PER_WORD + bytecount::countTrailingZeros(_flags[word]);
             break;
         }
     }
-    _encodedLength = (int)bytesConsumed;
-    return bytesConsumed;
+    for (int word = NUM_WORDS - 1; word >= 0; --word) {
+        if (_flags[word]) {
+            _maxFlag = word * BITS_PER_WORD + BITS_PER_WORD - 1 - bytecount::countLeadingZeros(_flags[word]);
+            break;
+        }
+    }
+
+    _encodedLength = lengthInBytes;
+    return lengthInBytes;
 }
 
-template<typename Enum> inline size_t PropertyFlags<Enum>::decode(const QByteArray& fromEncodedBytes) {
+template<typename Enum, int N> inline size_t PropertyFlags<Enum, N>::decode(const QByteArray& fromEncodedBytes) {
     return decode(reinterpret_cast<const uint8_t*>(fromEncodedBytes.data()), fromEncodedBytes.size());
 }
 
-template<typename Enum> inline void PropertyFlags<Enum>::debugDumpBits() {
+template<typename Enum, int N> inline void PropertyFlags<Enum, N>::debugDumpBits() {
     qCDebug(shared) << "_minFlag=" << _minFlag;
     qCDebug(shared) << "_maxFlag=" << _maxFlag;
     qCDebug(shared) << "_trailingFlipped=" << _trailingFlipped;
     QString bits;
-    for(int i = 0; i < _flags.size(); i++) {
-        bits += (_flags.at(i) ? "1" : "0");
+    for(int i = 0; i <= _maxFlag; i++) {
+        bits += (testBit(i) ? "1" : "0");
     }
     qCDebug(shared) << "bits:" << bits;
 }
 
 
-template<typename Enum> inline PropertyFlags<Enum>& PropertyFlags<Enum>::operator=(const PropertyFlags& other) {
+template<typename Enum, int N> inline PropertyFlags<Enum, N>& PropertyFlags<Enum, N>::operator=(const PropertyFlags& other) {
     _flags = other._flags; 
     _maxFlag = other._maxFlag; 
     _minFlag = other._minFlag; 
     return *this; 
 }
 
-template<typename Enum> inline PropertyFlags<Enum>& PropertyFlags<Enum>::operator|=(const PropertyFlags& other) {
-    _flags |= other._flags; 
+template<typename Enum, int N> inline PropertyFlags<Enum, N>& PropertyFlags<Enum, N>::operator|=(const PropertyFlags& other) {
+    for (int word = 0; word < NUM_WORDS; ++word) {
+        _flags[word] |= other._flags[word];
+    }
     _maxFlag = std::max(_maxFlag, other._maxFlag); 
     _minFlag = std::min(_minFlag, other._minFlag); 
     return *this; 
 }
 
-template<typename Enum> inline PropertyFlags<Enum>& PropertyFlags<Enum>::operator|=(Enum flag) {
-    PropertyFlags other(flag); 
-    _flags |= other._flags; 
-    _maxFlag = std::max(_maxFlag, other._maxFlag); 
-    _minFlag = std::min(_minFlag, other._minFlag); 
-    return *this; 
+template<typename Enum, int N> inline PropertyFlags<Enum, N>& PropertyFlags<Enum, N>::operator|=(Enum flag) {
+    return *this |= PropertyFlags(flag);
 }
 
-template<typename Enum> inline PropertyFlags<Enum>& PropertyFlags<Enum>::operator&=(const PropertyFlags& other) {
-    _flags &= other._flags; 
+template<typename Enum, int N> inline PropertyFlags<Enum, N>& PropertyFlags<Enum, N>::operator&=(const PropertyFlags& other) {
+    for (int word = 0; word < NUM_WORDS; ++word) {
+        _flags[word] &= other._flags[word];
+    }
     shrinkIfNeeded(); 
     return *this; 
 }
 
-template<typename Enum> inline PropertyFlags<Enum>& PropertyFlags<Enum>::operator&=(Enum flag) {
-    PropertyFlags other(flag); 
-    _flags &= other._flags; 
-    shrinkIfNeeded(); 
-    return *this; 
+template<typename Enum, int N> inline PropertyFlags<Enum, N>& PropertyFlags<Enum, N>::operator&=(Enum flag) {
+    return *this &= PropertyFlags(flag);
 }
 
-template<typename Enum> inline PropertyFlags<Enum>& PropertyFlags<Enum>::operator^=(const PropertyFlags& other) {
-    _flags ^= other._flags; 
+template<typename Enum, int N> inline PropertyFlags<Enum, N>& PropertyFlags<Enum, N>::operator^=(const PropertyFlags& other) {
+    for (int word = 0; word < NUM_WORDS; ++word) {
+        _flags[word] ^= other._flags[word];
+    }
+    clearTrailingBits();
     shrinkIfNeeded(); 
     return *this; 
 }
 
-template<typename Enum> inline PropertyFlags<Enum>& PropertyFlags<Enum>::operator^=(Enum flag) {
-    PropertyFlags other(flag); 
-    _flags ^= other._flags; 
-    shrinkIfNeeded(); 
-    return *this; 
+template<typename Enum, int N> inline PropertyFlags<Enum, N>& PropertyFlags<Enum, N>::operator^=(Enum flag) {
+    return *this ^= PropertyFlags(flag);
 }
 
-template<typename Enum> inline PropertyFlags<Enum>& PropertyFlags<Enum>::operator+=(const PropertyFlags& other) {
-    for(int flag = (int)other.firstFlag(); flag <= (int)other.lastFlag(); flag++) {
-        if (other.getHasProperty((Enum)flag)) {
-            setHasProperty((Enum)flag, true);
-        }
-    }
+template<typename Enum, int N> inline PropertyFlags<Enum, N>& PropertyFlags<Enum, N>::operator+=(const PropertyFlags& other) {
+    other.forEachFlag([this](Enum flag) {
+        setHasProperty(flag, true);
+    });
     return *this; 
 }
 
-template<typename Enum> inline PropertyFlags<Enum>& PropertyFlags<Enum>::operator+=(Enum flag) {
+template<typename Enum, int N> inline PropertyFlags<Enum, N>& PropertyFlags<Enum, N>::operator+=(Enum flag) {
     setHasProperty(flag, true);
     return *this; 
 }
 
-template<typename Enum> inline PropertyFlags<Enum>& PropertyFlags<Enum>::operator-=(const PropertyFlags& other) {
-    for(int flag = (int)other.firstFlag(); flag <= (int)other.lastFlag(); flag++) {
-        if (other.getHasProperty((Enum)flag)) {
-            setHasProperty((Enum)flag, false);
-        }
+template<typename Enum, int N> inline PropertyFlags<Enum, N>& PropertyFlags<Enum, N>::operator-=(const PropertyFlags& other) {
+    for (int word = 0; word < NUM_WORDS; ++word) {
+        _flags[word] &= ~other._flags[word];
+    }
+    if (_maxFlag >= 0 && !testBit(_maxFlag)) {
+        shrinkIfNeeded();
     }
     return *this;
 }
 
-template<typename Enum> inline PropertyFlags<Enum>& PropertyFlags<Enum>::operator-=(Enum flag) {
+template<typename Enum, int N> inline PropertyFlags<Enum, N>& PropertyFlags<Enum, N>::operator-=(Enum flag) {
     setHasProperty(flag, false);
     return *this; 
 }
 
-template<typename Enum> inline PropertyFlags<Enum>& PropertyFlags<Enum>::operator<<=(const PropertyFlags& other) {
-    for(int flag = (int)other.firstFlag(); flag <= (int)other.lastFlag(); flag++) {
-        if (other.getHasProperty((Enum)flag)) {
-            setHasProperty((Enum)flag, true);
-        }
-    }
-    return *this; 
+template<typename Enum, int N> inline PropertyFlags<Enum, N>& PropertyFlags<Enum, N>::operator<<=(const PropertyFlags& other) {
+    return *this += other;
 }
 
-template<typename Enum> inline PropertyFlags<Enum>& PropertyFlags<Enum>::operator<<=(Enum flag) {
+template<typename Enum, int N> inline PropertyFlags<Enum, N>& PropertyFlags<Enum, N>::operator<<=(Enum flag) {
     setHasProperty(flag, true);
     return *this; 
 }
 
-template<typename Enum> inline PropertyFlags<Enum> PropertyFlags<Enum>::operator|(const PropertyFlags& other) const {
+template<typename Enum, int N> inline PropertyFlags<Enum, N> PropertyFlags<Enum, N>::operator|(const PropertyFlags& other) const {
     PropertyFlags result(*this); 
     result |= other; 
     return result; 
 }
 
-template<typename Enum> inline PropertyFlags<Enum> PropertyFlags<Enum>::operator|(Enum flag) const {
+template<typename Enum, int N> inline PropertyFlags<Enum, N> PropertyFlags<Enum, N>::operator|(Enum flag) const {
     PropertyFlags result(*this); 
     PropertyFlags other(flag); 
     result |= other; 
     return result; 
 }
 
-template<typename Enum> inline PropertyFlags<Enum> PropertyFlags<Enum>::operator&(const PropertyFlags& other) const {
+template<typename Enum, int N> inline PropertyFlags<Enum, N> PropertyFlags<Enum, N>::operator&(const PropertyFlags& other) const {
     PropertyFlags result(*this); 
     result &= other; 
     return result; 
 }
 
-template<typename Enum> inline PropertyFlags<Enum> PropertyFlags<Enum>::operator&(Enum flag) const { 
+template<typename Enum, int N> inline PropertyFlags<Enum, N> PropertyFlags<Enum, N>::operator&(Enum flag) const { 
     PropertyFlags result(*this); 
     PropertyFlags other(flag); 
     result &= other; 
     return result; 
 }
 
-template<typename Enum> inline PropertyFlags<Enum> PropertyFlags<Enum>::operator^(const PropertyFlags& other) const {
+template<typename Enum, int N> inline PropertyFlags<Enum, N> PropertyFlags<Enum, N>::operator^(const PropertyFlags& other) const {
     PropertyFlags result(*this); 
     result ^= other; 
     return result; 
 }
 
-template<typename Enum> inline PropertyFlags<Enum> PropertyFlags<Enum>::operator^(Enum flag) const {
+template<typename Enum, int N> inline PropertyFlags<Enum, N> PropertyFlags<Enum, N>::operator^(Enum flag) const {
     PropertyFlags result(*this); 
     PropertyFlags other(flag); 
     result ^= other; 
     return result; 
 }
 
-template<typename Enum> inline PropertyFlags<Enum> PropertyFlags<Enum>::operator+(const PropertyFlags& other) const {
+template<typename Enum, int N> inline PropertyFlags<Enum, N> PropertyFlags<Enum, N>::operator+(const PropertyFlags& other) const {
     PropertyFlags result(*this); 
     result += other; 
     return result; 
 }
 
-template<typename Enum> inline PropertyFlags<Enum> PropertyFlags<Enum>::operator+(Enum flag) const { 
+template<typename Enum, int N> inline PropertyFlags<Enum, N> PropertyFlags<Enum, N>::operator+(Enum flag) const { 
     PropertyFlags result(*this); 
     result.setHasProperty(flag, true);
     return result; 
 }
 
-template<typename Enum> inline PropertyFlags<Enum> PropertyFlags<Enum>::operator-(const PropertyFlags& other) const {
+template<typename Enum, int N> inline PropertyFlags<Enum, N> PropertyFlags<Enum, N>::operator-(const PropertyFlags& other) const {
     PropertyFlags result(*this); 
     result -= other; 
     return result; 
 }
 
-template<typename Enum> inline PropertyFlags<Enum> PropertyFlags<Enum>::operator-(Enum flag) const { 
+template<typename Enum, int N> inline PropertyFlags<Enum, N> PropertyFlags<Enum, N>::operator-(Enum flag) const { 
     PropertyFlags result(*this); 
     result.setHasProperty(flag, false);
     return result; 
 }
 
-template<typename Enum> inline PropertyFlags<Enum> PropertyFlags<Enum>::operator<<(const PropertyFlags& other) const {
+template<typename Enum, int N> inline PropertyFlags<Enum, N> PropertyFlags<Enum, N>::operator<<(const PropertyFlags& other) const {
     PropertyFlags result(*this); 
     result <<= other; 
     return result; 
 }
 
-template<typename Enum> inline PropertyFlags<Enum> PropertyFlags<Enum>::operator<<(Enum flag) const { 
+template<typename Enum, int N> inline PropertyFlags<Enum, N> PropertyFlags<Enum, N>::operator<<(Enum flag) const { 
     PropertyFlags result(*this); 
     result.setHasProperty(flag, true);
     return result; 
 }
 
-template<typename Enum> inline PropertyFlags<Enum> PropertyFlags<Enum>::operator~() const { 
+template<typename Enum, int N> inline PropertyFlags<Enum, N> PropertyFlags<Enum, N>::operator~() const { 
     PropertyFlags result(*this); 
-    result._flags = ~_flags;
+    for (auto& word : result._flags) {
+        word = ~word;
+    }
+    result.clearTrailingBits();
     result._trailingFlipped = !_trailingFlipped;
     return result; 
 }
 
-template<typename Enum> inline void PropertyFlags<Enum>::shrinkIfNeeded() {
-    int maxFlagWas = _maxFlag;
-    while (_maxFlag >= 0) {
-        if (_flags.testBit(_maxFlag)) {
-            break;
+template<typename Enum, int N> inline void PropertyFlags<Enum, N>::clearTrailingBits() {
+    int bitCount = std::max(_maxFlag + 1, 0);
+    for (int word = 0; word < NUM_WORDS; ++word) {
+        int wordStart = word * BITS_PER_WORD;
+        if (bitCount <= wordStart) {
+            _flags[word] = 0;
+        } else if (bitCount < wordStart + BITS_PER_WORD) {
+            _flags[word] &= (1ULL << (bitCount - wordStart)) - 1;
         }
-        _maxFlag--;
     }
-    if (maxFlagWas != _maxFlag) {
-        _flags.resize(_maxFlag + 1);
+}
+
+template<typename Enum, int N> inline void PropertyFlags<Enum, N>::shrinkIfNeeded() {
+    if (_maxFlag < 0) {
+        return;
+    }
+
+    // the flags hold no bits past _maxFlag, so the highest bit that is set is the new max
+    for (int word = _maxFlag / BITS_PER_WORD; word >= 0; --word) {
+        if (_flags[word]) {
+            _maxFlag = word * BITS_PER_WORD + BITS_PER_WORD - 1 - bytecount::countLeadingZeros(_flags[word]);
+            return;
+        }
     }
+    _maxFlag = -1;
 }
 
-template<typename Enum> inline QByteArray& operator<<(QByteArray& out, PropertyFlags<Enum>& value) {
+template<typename Enum, int N> inline QByteArray& operator<<(QByteArray& out, PropertyFlags<Enum, N>& value) {
     return out = value;
 }
 
-template<typename Enum> inline QByteArray& operator>>(QByteArray& in, PropertyFlags<Enum>& value) {
+template<typename Enum, int N> inline QByteArray& operator>>(QByteArray& in, PropertyFlags<Enum, N>& value) {
     value.decode(in);
     return in;
 }
 
 #endif // hifi_PropertyFlags_h
-
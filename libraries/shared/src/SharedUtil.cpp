@@ -47,6 +47,7 @@ extern "C" FILE * __cdecl __iob_func(void) {
 #include <QtCore/QDebug>
 #include <QDateTime>
 #include <QElapsedTimer>
+#include <QFile>
 #include <QTimer>
 #include <QProcess>
 #include <QSysInfo>
@@ -883,6 +884,38 @@ bool getMemoryInfo(MemoryInfo& info) {
     info.processPeakUsedMemoryBytes = pmc.PeakPagefileUsage;
 
     return true;
+#elif defined(Q_OS_LINUX)
+    // the values of /proc/meminfo and /proc/self/status are in kB
+    static const uint64_t BYTES_PER_KILOBYTE = 1024;
+    auto readValues = [](const char* path, std::initializer_list<std::pair<const char*, uint64_t*>> values) {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            return false;
+        }
+
+        size_t found = 0;
+        for (auto line = file.readLine(); !line.isEmpty() && found < values.size(); line = file.readLine()) {
+            for (const auto& value : values) {
+                auto nameLength = strlen(value.first);
+                if (line.startsWith(value.first) && line.size() > (int)nameLength && line[(int)nameLength] == ':') {
+                    *value.second = line.mid((int)nameLength + 1).trimmed().split(' ').first().toULongLong() * BYTES_PER_KILOBYTE;
+                    ++found;
+                    break;
+                }
+            }
+        }
+        return found == values.size();
+    };
+
+    if (!readValues("/proc/meminfo", { { "MemTotal", &info.totalMemoryBytes }, { "MemAvailable", &info.availMemoryBytes } })) {
+        return false;
+    }
+    info.usedMemoryBytes = info.totalMemoryBytes - info.availMemoryBytes;
+
+    return readValues("/proc/self/status", {
+        { "VmRSS", &info.processUsedMemoryBytes },
+        { "VmHWM", &info.processPeakUsedMemoryBytes }
+    });
 #endif
 
     return false;
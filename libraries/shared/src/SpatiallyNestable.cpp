@@ -477,6 +477,40 @@ void SpatiallyNestable::setOrientation(const glm::quat& orientation) {
     #endif
 }
 
+void SpatiallyNestable::setPositionAndOrientation(const glm::vec3& position, const glm::quat& orientation, bool& success,
+                                                  bool tellPhysics) {
+    // guard against introducing NaN into the transform
+    if (isNaN(position) || isNaN(orientation)) {
+        success = false;
+        return;
+    }
+
+    bool changed = false;
+    Transform parentTransform = getParentTransform(success);
+    Transform myWorldTransform;
+    _transformLock.withWriteLock([&] {
+        Transform::mult(myWorldTransform, parentTransform, _transform);
+        bool translationChanged = myWorldTransform.getTranslation() != position;
+        bool rotationChanged = myWorldTransform.getRotation() != orientation;
+        if (translationChanged || rotationChanged) {
+            changed = true;
+            myWorldTransform.setTranslation(position);
+            myWorldTransform.setRotation(orientation);
+            Transform::inverseMult(_transform, parentTransform, myWorldTransform);
+            quint64 now = usecTimestampNow();
+            if (translationChanged) {
+                _translationChanged = now;
+            }
+            if (rotationChanged) {
+                _rotationChanged = now;
+            }
+        }
+    });
+    if (success && changed) {
+        locationChanged(tellPhysics);
+    }
+}
+
 glm::vec3 SpatiallyNestable::getVelocity(bool& success) const {
     glm::vec3 result;
     Transform parentTransform = getParentTransform(success);
@@ -85,6 +85,10 @@ public:
     virtual void setOrientation(const glm::quat& orientation, bool& success, bool tellPhysics = true);
     virtual void setOrientation(const glm::quat& orientation);
 
+    // same as setPosition() then setOrientation(), with a single lookup of the parent and a single locationChanged()
+    virtual void setPositionAndOrientation(const glm::vec3& position, const glm::quat& orientation, bool& success,
+                                           bool tellPhysics = true);
+
     // these are here because some older code uses rotation rather than orientation
     virtual const glm::quat getRotation() const { return getOrientation(); }
     virtual void setRotation(glm::quat orientation) { setOrientation(orientation); }
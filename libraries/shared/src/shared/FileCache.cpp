@@ -12,12 +12,15 @@
 #include "FileCache.h"
 
 
-#include <unordered_set>
-#include <queue>
+#include <algorithm>
 #include <cassert>
+#include <functional>
+#include <iterator>
 
+#include <QtCore/QDataStream>
 #include <QtCore/QDateTime>
 #include <QtCore/QDir>
+#include <QtCore/QDirIterator>
 #include <QtCore/QSaveFile>
 #include <QtCore/QStorageInfo>
 
@@ -40,6 +43,11 @@ using namespace cache;
 static const char DIR_SEP = '/';
 static const char EXT_SEP = '.';
 
+// The manifest lists the files of the cache as of its last shutdown, so that it doesn't have to scan the directory
+static const char* MANIFEST_FILENAME = "cache.manifest";
+static const quint32 MANIFEST_MAGIC = 0x4846434d; // "HFCM"
+static const quint32 MANIFEST_VERSION = 1;
+
 const size_t FileCache::DEFAULT_MAX_SIZE { GB_TO_BYTES(5) };
 const size_t FileCache::MAX_MAX_SIZE { GB_TO_BYTES(100) };
 const size_t FileCache::DEFAULT_MIN_FREE_STORAGE_SPACE { GB_TO_BYTES(1) };
@@ -65,13 +73,13 @@ std::string getCachePath(const std::string& dirname_str) {
 
 void FileCache::setMinFreeSize(size_t size) {
     _minFreeSpaceSize = size;
-    clean();
+    requestEviction();
     emit dirty();
 }
 
 void FileCache::setMaxSize(size_t maxSize) {
     _maxSize = std::min(maxSize, MAX_MAX_SIZE);
-    clean();
+    requestEviction();
     emit dirty();
 }
 
@@ -87,52 +95,64 @@ FileCache::~FileCache() {
 }
 
 void FileCache::initialize() {
-    Lock lock(_mutex);
-    if (_initialized) {
+    if (_initialized.exchange(true)) {
         qCWarning(file_cache) << "File cache already initialized";
         return;
     }
 
     QDir dir(_dirpath.c_str());
-
-    if (dir.exists()) {
-        auto nameFilters = QStringList(("*." + _ext).c_str());
-        auto filters = QDir::Filters(QDir::NoDotAndDotDot | QDir::Files);
-        auto sort = QDir::SortFlags(QDir::Time);
-        auto files = dir.entryList(nameFilters, filters, sort);
-
-        // load persisted files
-        foreach(QString filename, files) {
-            const Key key = filename.section('.', 0, 0).toStdString();
-            const std::string filepath = dir.filePath(filename).toStdString();
-            const size_t length = QFileInfo(filepath.c_str()).size();
-            addFile(Metadata(key, length), filepath);
-        }
-
-        qCDebug(file_cache, "[%s] Initialized %s", _dirname.c_str(), _dirpath.c_str());
-    } else {
+    if (!dir.exists()) {
         dir.mkpath(_dirpath.c_str());
         qCDebug(file_cache, "[%s] Created %s", _dirname.c_str(), _dirpath.c_str());
     }
 
-    _initialized = true;
+    // the persisted files are indexed in the background, until then getFile looks for them on disk
+    {
+        Lock lock(_workMutex);
+        _indexPending = true;
+    }
+    startWorker();
 }
 
 std::unique_ptr<File> FileCache::createFile(Metadata&& metadata, const std::string& filepath) {
     return std::unique_ptr<File>(new cache::File(std::move(metadata), filepath));
 }
 
-FilePointer FileCache::addFile(Metadata&& metadata, const std::string& filepath) {
+FilePointer FileCache::makeFile(Metadata&& metadata, const std::string& filepath) {
+    FilePointer file;
     File* rawFile = createFile(std::move(metadata), filepath).release();
-    FilePointer file(rawFile, std::bind(&File::deleter, rawFile));
-    if (file) {
-        _numTotalFiles += 1;
-        _totalFilesSize += file->getLength();
+    if (rawFile) {
+        file = FilePointer(rawFile, std::bind(&File::deleter, rawFile));
         file->_parent = shared_from_this();
         file->_locked = true;
-        emit dirty();
+    }
+    return file;
+}
 
-        _files[file->getKey()] = file;
+FilePointer FileCache::addFile(Shard& shard, Metadata&& metadata, const std::string& filepath) {
+    const Key key = metadata.key;
+    const size_t length = metadata.length;
+    FilePointer file = makeFile(std::move(metadata), filepath);
+    if (file) {
+        auto result = shard.entries.emplace(key, Entry());
+        Entry& entry = result.first->second;
+        if (!result.second) {
+            // the file was overwritten, a File still using it is persisted on release
+            _numTotalFiles -= 1;
+            _totalFilesSize -= entry.length;
+            if (!entry.activeFile) {
+                _numUnusedFiles -= 1;
+                _unusedFilesSize -= entry.length;
+            }
+        }
+        _numTotalFiles += 1;
+        _totalFilesSize += length;
+
+        entry.length = length;
+        entry.lastUsed = QDateTime::currentMSecsSinceEpoch();
+        entry.file = file;
+        entry.activeFile = file.get();
+        entry.verified = true;
     }
     return file;
 }
@@ -145,9 +165,6 @@ FilePointer FileCache::writeFile(const char* data, File::Metadata&& metadata, bo
         return file;
     }
 
-
-    Lock lock(_mutex);
-
     if (!_initialized) {
         qCWarning(file_cache) << "File cache used before initialization";
         return file;
@@ -155,15 +172,24 @@ FilePointer FileCache::writeFile(const char* data, File::Metadata&& metadata, bo
 
     std::string filepath = getFilepath(metadata.key);
 
+    // released after the lock, as releasing it locks the shard
+    FilePointer overwrittenFile;
+
+    // the shard stays locked while writing so that the file can't be ejected from under us
+    auto& shard = getShard(metadata.key);
+    Lock lock(shard.mutex);
+
     // if file already exists, return it
-    file = getFile(metadata.key);
+    file = lookupFile(shard, metadata.key);
     if (file) {
         if (!overwrite) {
             qCWarning(file_cache, "[%s] Attempted to overwrite %s", _dirname.c_str(), metadata.key.c_str());
+            lock.unlock();
+            file->touch();
             return file;
         } else {
             qCWarning(file_cache, "[%s] Overwriting %s", _dirname.c_str(), metadata.key.c_str());
-            file.reset();
+            overwrittenFile = std::move(file);
         }
     }
 
@@ -172,45 +198,81 @@ FilePointer FileCache::writeFile(const char* data, File::Metadata&& metadata, bo
         && saveFile.write(data, metadata.length) == static_cast<qint64>(metadata.length)
         && saveFile.commit()) {
 
-        file = addFile(std::move(metadata), filepath);
+        file = addFile(shard, std::move(metadata), filepath);
     } else {
         qCWarning(file_cache, "[%s] Failed to write %s", _dirname.c_str(), metadata.key.c_str());
     }
+    lock.unlock();
+
+    if (file) {
+        emit dirty();
+    }
     assert(!file || (file->_locked && file->_parent.lock()));
     return file;
 }
 
+FilePointer FileCache::lookupFile(Shard& shard, const Key& key) {
+    FilePointer file;
 
-FilePointer FileCache::getFile(const Key& key) {
-    Lock lock(_mutex);
+    const auto it = shard.entries.find(key);
+    if (it == shard.entries.end()) {
+        if (!_indexComplete) {
+            // not indexed yet, look for it on disk
+            std::string filepath = getFilepath(key);
+            QFileInfo info(filepath.c_str());
+            if (info.isFile()) {
+                file = addFile(shard, Metadata(key, info.size()), filepath);
+            }
+        }
+        return file;
+    }
 
+    Entry& entry = it->second;
+    file = entry.file.lock();
+    if (!file) {
+        std::string filepath = getFilepath(key);
+        if (!entry.verified && !QFileInfo(filepath.c_str()).isFile()) {
+            // removed from the disk since the manifest was written
+            eject(shard, it);
+            return file;
+        }
+
+        file = makeFile(Metadata(key, entry.length), filepath);
+        if (!file) {
+            return file;
+        }
+
+        // if it isn't active, it is cached - remove it from the cache
+        // (an active entry without a File is one being released, that the new File takes over)
+        if (!entry.activeFile) {
+            _numUnusedFiles -= 1;
+            _unusedFilesSize -= entry.length;
+        }
+        entry.file = file;
+        entry.activeFile = file.get();
+        entry.verified = true;
+    }
+    entry.lastUsed = QDateTime::currentMSecsSinceEpoch();
+    return file;
+}
+
+FilePointer FileCache::getFile(const Key& key) {
     FilePointer file;
     if (!_initialized) {
         qCWarning(file_cache) << "File cache used before initialization";
         return file;
     }
 
-    // check if file exists
-    const auto it = _files.find(key);
-    if (it != _files.cend()) {
-        file = it->second.lock();
-        if (file) {
-            file->touch();
-            // if it exists, it is active - remove it from the cache
-            if (_unusedFiles.erase(file)) {
-                assert(!file->_locked);
-                file->_locked = true;
-                _numUnusedFiles -= 1;
-                _unusedFilesSize -= file->getLength();
-            } else {
-                assert(file->_locked);
-            }
-            qCDebug(file_cache, "[%s] Found %s", _dirname.c_str(), key.c_str());
-            emit dirty();
-        } else {
-            // if not, remove the weak_ptr
-            _files.erase(it);
-        }
+    {
+        auto& shard = getShard(key);
+        Lock lock(shard.mutex);
+        file = lookupFile(shard, key);
+    }
+
+    if (file) {
+        file->touch();
+        qCDebug(file_cache, "[%s] Found %s", _dirname.c_str(), key.c_str());
+        emit dirty();
     }
 
     assert(!file || (file->_locked && file->_parent.lock()));
@@ -221,18 +283,8 @@ std::string FileCache::getFilepath(const Key& key) {
     return _dirpath + DIR_SEP + key + EXT_SEP + _ext;
 }
 
-// This is a non-public function that uses the mutex because it's 
-// essentially a public function specifically to a File object
-void FileCache::addUnusedFile(const FilePointer& file) {
-    assert(file->_locked);
-    file->_locked = false;
-    _files[file->getKey()] = file;
-    _unusedFiles.insert(file);
-    _numUnusedFiles += 1;
-    _unusedFilesSize += file->getLength();
-    clean();
-
-    emit dirty();
+std::string FileCache::getManifestPath() const {
+    return _dirpath + DIR_SEP + MANIFEST_FILENAME;
 }
 
 size_t FileCache::getOverbudgetAmount() const {
@@ -250,82 +302,307 @@ size_t FileCache::getOverbudgetAmount() const {
     return result;
 }
 
-namespace cache {
-    struct FilePointerComparator {
-        bool operator()(const FilePointer& a, const FilePointer& b) {
-            return a->_modified > b->_modified;
-        }
-    };
-}
-
-// Take file pointer by value to insure it doesn't get destructed during the "erase()" calls
-void FileCache::eject(FilePointer file) {
-    file->_locked = false;
-    const auto& length = file->getLength();
-    const auto& key = file->getKey();
+void FileCache::eject(Shard& shard, Entries::iterator it) {
+    const auto& key = it->first;
+    const auto& entry = it->second;
+    assert(!entry.activeFile);
 
-    if (0 != _files.erase(key)) {
-        _numTotalFiles -= 1;
-        _totalFilesSize -= length;
-    }
-    if (0 != _unusedFiles.erase(file)) {
-        _numUnusedFiles -= 1;
-        _unusedFilesSize -= length;
+    QFile file(getFilepath(key).c_str());
+    if (file.exists()) {
+        qCInfo(file_cache, "Unlinked %s", file.fileName().toStdString().c_str());
+        file.remove();
     }
+
+    _numTotalFiles -= 1;
+    _totalFilesSize -= entry.length;
+    _numUnusedFiles -= 1;
+    _unusedFilesSize -= entry.length;
+    shard.entries.erase(it);
 }
 
-void FileCache::clean() {
+bool FileCache::evictOverbudget() {
     size_t overbudgetAmount = getOverbudgetAmount();
 
     // Avoid sorting the unused files by LRU if we're not over budget / under free space
     if (0 == overbudgetAmount) {
-        return;
+        return false;
     }
 
-    using Queue = std::priority_queue<FilePointer, std::vector<FilePointer>, FilePointerComparator>;
-    Queue queue;
-    for (const auto& file : _unusedFiles) {
-        queue.push(file);
+    struct Candidate {
+        Key key;
+        int64_t lastUsed;
+    };
+    std::vector<Candidate> candidates;
+    candidates.reserve(_numUnusedFiles);
+    for (auto& shard : _shards) {
+        Lock lock(shard.mutex);
+        for (const auto& entry : shard.entries) {
+            if (!entry.second.activeFile) {
+                candidates.push_back({ entry.first, entry.second.lastUsed });
+            }
+        }
     }
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+        return a.lastUsed < b.lastUsed;
+    });
+
+    bool ejected = false;
+    for (const auto& candidate : candidates) {
+        if (0 == overbudgetAmount) {
+            break;
+        }
 
-    while (!queue.empty() && overbudgetAmount > 0) {
-        auto file = queue.top();
-        queue.pop();
-        eject(file);
-        auto length = file->getLength();
+        auto& shard = getShard(candidate.key);
+        Lock lock(shard.mutex);
+        auto it = shard.entries.find(candidate.key);
+        // skip the files that were used since they were collected
+        if (it == shard.entries.end() || it->second.activeFile || it->second.lastUsed != candidate.lastUsed) {
+            continue;
+        }
+        auto length = it->second.length;
+        eject(shard, it);
         overbudgetAmount -= std::min(length, overbudgetAmount);
+        ejected = true;
     }
+    return ejected;
 }
 
 void FileCache::wipe() {
-    Lock lock(_mutex);
-    while (!_unusedFiles.empty()) {
-        eject(*_unusedFiles.begin());
+    // the files that aren't indexed yet have to be wiped too
+    waitUntilIdle();
+
+    for (auto& shard : _shards) {
+        Lock lock(shard.mutex);
+        for (auto it = shard.entries.begin(); it != shard.entries.end();) {
+            auto next = std::next(it);
+            if (!it->second.activeFile) {
+                eject(shard, it);
+            }
+            it = next;
+        }
     }
+    emit dirty();
 }
 
 void FileCache::clear() {
-    Lock lock(_mutex);
+    stopWorker();
 
-    // Eliminate any overbudget files
-    clean();
+    if (!_initialized) {
+        return;
+    }
 
-    // Mark everything remaining as persisted while effectively ejecting from the cache
-    for (auto& file : _unusedFiles) {
-        file->_shouldPersist = true;
-        file->_parent.reset();
-        qCDebug(file_cache, "[%s] Persisting %s", _dirname.c_str(), file->getKey().c_str());
+    if (_indexComplete) {
+        // Eliminate any overbudget files
+        evictOverbudget();
+        // Persist the index of the remaining files, used or not, for the next session
+        saveManifest();
+    } else {
+        // the next session will have to scan the directory
+        QFile::remove(getManifestPath().c_str());
     }
-    _unusedFiles.clear();
 }
 
 void FileCache::releaseFile(File* file) {
-    Lock lock(_mutex);
-    if (file->_locked) {
-        addUnusedFile(FilePointer(file, std::bind(&File::deleter, file)));
+    auto& shard = getShard(file->getKey());
+    {
+        Lock lock(shard.mutex);
+        auto it = shard.entries.find(file->getKey());
+        if (it != shard.entries.end()) {
+            Entry& entry = it->second;
+            if (entry.activeFile == file) {
+                entry.activeFile = nullptr;
+                entry.file.reset();
+                _numUnusedFiles += 1;
+                _unusedFilesSize += entry.length;
+            }
+            // otherwise the file was overwritten or reopened while being released, either way it stays on disk
+            file->_shouldPersist = true;
+        }
+        file->_locked = false;
+    }
+
+    // unused files stay on disk until ejected, and are reopened by getFile
+    delete file;
+
+    requestEviction();
+    emit dirty();
+}
+
+bool FileCache::loadManifest() {
+    QFile file(getManifestPath().c_str());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    quint32 magic = 0;
+    quint32 version = 0;
+    stream >> magic >> version;
+
+    bool loaded = false;
+    if (stream.status() == QDataStream::Ok && magic == MANIFEST_MAGIC && version == MANIFEST_VERSION) {
+        while (!_stopping && !stream.atEnd()) {
+            QByteArray key;
+            quint64 length = 0;
+            qint64 lastUsed = 0;
+            stream >> key >> length >> lastUsed;
+            if (stream.status() != QDataStream::Ok) {
+                break;
+            }
+
+            // the entries are checked against the disk when first used
+            auto& shard = getShard(key.toStdString());
+            Lock lock(shard.mutex);
+            auto result = shard.entries.emplace(key.toStdString(), Entry());
+            if (result.second) {
+                Entry& entry = result.first->second;
+                entry.length = length;
+                entry.lastUsed = lastUsed;
+                _numTotalFiles += 1;
+                _totalFilesSize += length;
+                _numUnusedFiles += 1;
+                _unusedFilesSize += length;
+            }
+        }
+        loaded = !_stopping && stream.status() == QDataStream::Ok;
+    }
+
+    if (!loaded) {
+        qCWarning(file_cache, "[%s] Invalid manifest, scanning %s", _dirname.c_str(), _dirpath.c_str());
+    }
+
+    // The manifest is only valid until the files change, if this session doesn't end cleanly the next one rescans
+    file.remove();
+    return loaded;
+}
+
+void FileCache::saveManifest() {
+    QSaveFile file(getManifestPath().c_str());
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(file_cache, "[%s] Failed to write the manifest", _dirname.c_str());
+        return;
+    }
+
+    QDataStream stream(&file);
+    stream << MANIFEST_MAGIC << MANIFEST_VERSION;
+    size_t numFiles = 0;
+    for (auto& shard : _shards) {
+        Lock lock(shard.mutex);
+        for (const auto& entry : shard.entries) {
+            stream << QByteArray::fromStdString(entry.first) << (quint64)entry.second.length << (qint64)entry.second.lastUsed;
+        }
+        numFiles += shard.entries.size();
+    }
+
+    if (stream.status() != QDataStream::Ok || !file.commit()) {
+        qCWarning(file_cache, "[%s] Failed to write the manifest", _dirname.c_str());
+        return;
+    }
+    qCDebug(file_cache, "[%s] Persisted %d files", _dirname.c_str(), (int)numFiles);
+}
+
+void FileCache::indexDirectory() {
+    if (loadManifest()) {
+        qCDebug(file_cache, "[%s] Initialized %s from its manifest", _dirname.c_str(), _dirpath.c_str());
     } else {
-        delete file;
+        // load persisted files, the ones already indexed by getFile or the manifest are skipped
+        auto nameFilters = QStringList(("*." + _ext).c_str());
+        auto filters = QDir::Filters(QDir::NoDotAndDotDot | QDir::Files);
+        QDirIterator files(_dirpath.c_str(), nameFilters, filters);
+        while (!_stopping && files.hasNext()) {
+            files.next();
+            const QFileInfo info = files.fileInfo();
+            const Key key = info.fileName().section('.', 0, 0).toStdString();
+            const size_t length = info.size();
+            const int64_t lastUsed = info.lastRead().toMSecsSinceEpoch();
+
+            auto& shard = getShard(key);
+            Lock lock(shard.mutex);
+            auto result = shard.entries.emplace(key, Entry());
+            if (result.second) {
+                Entry& entry = result.first->second;
+                entry.length = length;
+                entry.lastUsed = lastUsed;
+                entry.verified = true;
+                _numTotalFiles += 1;
+                _totalFilesSize += length;
+                _numUnusedFiles += 1;
+                _unusedFilesSize += length;
+            }
+        }
+        qCDebug(file_cache, "[%s] Initialized %s", _dirname.c_str(), _dirpath.c_str());
+    }
+
+    if (!_stopping) {
+        _indexComplete = true;
+    }
+}
+
+void FileCache::startWorker() {
+    _worker = std::thread([this] {
+        runWorker();
+    });
+}
+
+void FileCache::stopWorker() {
+    if (!_worker.joinable()) {
+        return;
+    }
+    {
+        Lock lock(_workMutex);
+        _stopping = true;
+    }
+    _workCondition.notify_all();
+    _idleCondition.notify_all();
+    _worker.join();
+}
+
+void FileCache::runWorker() {
+    Lock lock(_workMutex);
+    while (!_stopping) {
+        if (!_indexPending && !_evictionPending) {
+            _working = false;
+            _idleCondition.notify_all();
+            _workCondition.wait(lock);
+            continue;
+        }
+
+        bool index = _indexPending;
+        _indexPending = false;
+        _evictionPending = false;
+        _working = true;
+        lock.unlock();
+
+        if (index) {
+            indexDirectory();
+            emit dirty();
+        }
+        // release requests are coalesced, so that the free space is checked once per batch of released files
+        if (!_stopping && evictOverbudget()) {
+            emit dirty();
+        }
+
+        lock.lock();
     }
+    _working = false;
+    _idleCondition.notify_all();
+}
+
+void FileCache::requestEviction() {
+    if (!_evictionPending.exchange(true)) {
+        Lock lock(_workMutex);
+        _workCondition.notify_one();
+    }
+}
+
+void FileCache::waitUntilIdle() {
+    if (!_worker.joinable()) {
+        return;
+    }
+    Lock lock(_workMutex);
+    _idleCondition.wait(lock, [this] {
+        return _stopping || (!_working && !_indexPending && !_evictionPending);
+    });
 }
 
 void File::deleter(File* file) {
@@ -344,8 +621,7 @@ void File::deleter(File* file) {
 File::File(Metadata&& metadata, const std::string& filepath) :
     _key(std::move(metadata.key)),
     _length(metadata.length),
-    _filepath(filepath),
-    _modified(QFileInfo(_filepath.c_str()).lastRead().toMSecsSinceEpoch()) {
+    _filepath(filepath) {
 }
 
 File::~File() {
@@ -357,7 +633,6 @@ File::~File() {
 }
 
 void File::touch() {
+    // keep the access time on disk, used to order the files when the directory is scanned
     utime(_filepath.c_str(), nullptr);
-    _modified = std::max<int64_t>(QFileInfo(_filepath.c_str()).lastRead().toMSecsSinceEpoch(), _modified);
 }
-
@@ -10,14 +10,16 @@
 #ifndef hifi_FileCache_h
 #define hifi_FileCache_h
 
+#include <array>
 #include <atomic>
+#include <condition_variable>
 #include <memory>
 #include <cstddef>
-#include <map>
-#include <unordered_set>
 #include <mutex>
 #include <string>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
 #include <QObject>
 #include <QLoggingCategory>
@@ -44,6 +46,7 @@ class FileCache : public QObject, public std::enable_shared_from_this<FileCache>
     static const size_t DEFAULT_MAX_SIZE;
     static const size_t MAX_MAX_SIZE;
     static const size_t DEFAULT_MIN_FREE_STORAGE_SPACE;
+    static const size_t NUM_SHARDS = 16;
 
     friend class ::FileCacheTests;
 
@@ -62,6 +65,7 @@ public:
     size_t getSizeCachedFiles() const { return _unusedFilesSize; }
 
     // Set the maximum amount of disk space to use on disk
+    // Unused entries over the budget are ejected in the background
     void setMaxSize(size_t maxCacheSize);
 
     // Set the minumum amount of free disk space to retain.  This supercedes the max size,
@@ -93,6 +97,8 @@ signals:
 
 public:
     /// must be called after construction to create the cache on the fs and restore persisted files
+    /// The index of the persisted files is restored from the manifest written on shutdown, or else built in the
+    /// background, files that are not indexed yet are looked up on disk when requested
     virtual void initialize();
 
     // Add file to the cache and return the cache entry.  
@@ -103,23 +109,52 @@ public:
     virtual std::unique_ptr<File> createFile(Metadata&& metadata, const std::string& filepath);
 
 private:
-    using Mutex = std::recursive_mutex;
+    using Mutex = std::mutex;
     using Lock = std::unique_lock<Mutex>;
-    using Map = std::unordered_map<Key, std::weak_ptr<File>>;
-    using Set = std::unordered_set<FilePointer>;
-    using KeySet = std::unordered_set<Key>;
 
     friend class File;
 
+    // A file of the cache, in use or not. Only the files in use have a File.
+    struct Entry {
+        size_t length { 0 };
+        int64_t lastUsed { 0 }; // msecs since epoch
+        std::weak_ptr<File> file;
+        const File* activeFile { nullptr }; // the File in use, compared but never dereferenced as it may be releasing
+        bool verified { false }; // whether the file was seen on disk, entries restored from the manifest aren't
+    };
+
+    // The index is split in shards, each with its own lock, so that threads loading different files don't contend
+    using Entries = std::unordered_map<Key, Entry>;
+    struct Shard {
+        Mutex mutex;
+        Entries entries;
+    };
+
     std::string getFilepath(const Key& key);
+    std::string getManifestPath() const;
+    Shard& getShard(const Key& key) { return _shards[std::hash<Key>()(key) % NUM_SHARDS]; }
+
+    // all of these expect the lock of the shard to be held
+    FilePointer lookupFile(Shard& shard, const Key& key);
+    FilePointer addFile(Shard& shard, Metadata&& metadata, const std::string& filepath);
+    FilePointer makeFile(Metadata&& metadata, const std::string& filepath);
+    // Remove an unused file from the cache and the disk
+    void eject(Shard& shard, Entries::iterator it);
 
-    FilePointer addFile(Metadata&& metadata, const std::string& filepath);
-    void addUnusedFile(const FilePointer& file);
     void releaseFile(File* file);
-    void clean();
     void clear();
-    // Remove a file from the cache
-    void eject(FilePointer file);
+
+    bool loadManifest();
+    void saveManifest();
+
+    // background work
+    void startWorker();
+    void stopWorker();
+    void runWorker();
+    void requestEviction();
+    void waitUntilIdle();
+    void indexDirectory();
+    bool evictOverbudget();
 
     size_t getOverbudgetAmount() const;
 
@@ -135,11 +170,19 @@ private:
     const std::string _ext;
     const std::string _dirname;
     const std::string _dirpath;
-    bool _initialized { false };
-
-    Mutex _mutex;
-    Map _files;
-    Set _unusedFiles;
+    std::atomic<bool> _initialized { false };
+    std::atomic<bool> _indexComplete { false };
+
+    std::array<Shard, NUM_SHARDS> _shards;
+
+    Mutex _workMutex;
+    std::condition_variable _workCondition;
+    std::condition_variable _idleCondition;
+    std::thread _worker;
+    bool _indexPending { false };
+    std::atomic<bool> _evictionPending { false };
+    bool _working { false };
+    std::atomic<bool> _stopping { false };
 };
 
 class File {
@@ -161,7 +204,6 @@ protected:
 
 private:
     friend class FileCache;
-    friend struct FilePointerComparator;
     friend class ::FileCacheTests;
 
     const Key _key;
@@ -170,7 +212,6 @@ private:
 
     void touch();
     FileCacheWeakPointer _parent;
-    int64_t _modified { 0 };
     bool _locked { false };
 
     bool _shouldPersist { false };
@@ -6,6 +6,10 @@ function filter(p) {
     - Block comments are ok, but not double-slash end-of-line-comments
     - Certain JavaScript functions are not available, like Math.sign(), as they are undefined in QT's non-conforming JS
     - HiFi's scripting interface is unavailable here. That means you can't call, for example, Users.*()
+    - Filters should only depend on the properties they are given: the server remembers which edits
+        a filter rejected or left unchanged, and answers the same edits again without calling it
+    - A filter can list the properties it looks at, e.g. filter.filteredProperties = ["position", "velocity"];
+        next to the function. The edits of existing entities that change none of them then skip the filter
     */
     /******************************************************/
     
@@ -16,8 +16,12 @@
 #include <QDir>
 #include <ByteCountCoding.h>
 
+#include <atomic>
+#include <thread>
+
 #include <ShapeEntityItem.h>
 #include <EntityItemProperties.h>
+#include <EntityTree.h>
 #include <Octree.h>
 #include <PathUtils.h>
 
@@ -135,6 +139,123 @@ void testPropertyFlags() {
     testPropertyFlags(0xFFFF);
 }
 
+const int NUM_QUERY_ENTITIES = 100000;
+const float QUERY_WORLD_SIZE = 1000.0f;
+const float QUERY_RADIUS = 10.0f;
+const int NUM_QUERY_THREADS = 4;
+const quint64 QUERY_BENCHMARK_USECS = 5 * USECS_PER_SECOND;
+
+glm::vec3 randomQueryPosition() {
+    return glm::vec3(randFloatInRange(0.0f, QUERY_WORLD_SIZE), randFloatInRange(0.0f, QUERY_WORLD_SIZE),
+                     randFloatInRange(0.0f, QUERY_WORLD_SIZE));
+}
+
+class FindInSphereArgs {
+public:
+    glm::vec3 position;
+    float radius;
+    QVector<EntityItemPointer> entities;
+};
+
+// the walk of the tree elements that EntityTree::findEntities() did before it had a query index
+bool findInSphereOperation(const OctreeElementPointer& element, void* extraData) {
+    FindInSphereArgs* args = static_cast<FindInSphereArgs*>(extraData);
+    glm::vec3 penetration;
+    if (element->getAACube().findSpherePenetration(args->position, args->radius, penetration)) {
+        EntityTreeElementPointer entityTreeElement = std::static_pointer_cast<EntityTreeElement>(element);
+        entityTreeElement->getEntities(args->position, args->radius, args->entities);
+        return true;
+    }
+    return false;
+}
+
+// runs sphere queries on several threads while another thread keeps moving entities, and reports the query rate and latency
+template <typename F>
+void benchmarkQueries(const char* name, EntityTreePointer tree, const QVector<EntityItemID>& entityIDs, F query) {
+    std::atomic<bool> done { false };
+    std::atomic<quint64> numQueries { 0 };
+    std::atomic<quint64> numFound { 0 };
+    std::atomic<quint64> totalQueryUsecs { 0 };
+    std::atomic<quint64> numEdits { 0 };
+
+    const quint64 EDITS_PER_UPDATE = 100;
+    std::thread editor([&] {
+        while (!done) {
+            EntityItemProperties properties;
+            properties.setPosition(randomQueryPosition());
+            tree->withWriteLock([&] {
+                tree->updateEntity(entityIDs[randIntInRange(0, entityIDs.size() - 1)], properties);
+            });
+            // publish the edits to the index like the frames of the entity server would
+            if (++numEdits % EDITS_PER_UPDATE == 0) {
+                tree->update(false);
+            }
+        }
+    });
+
+    std::vector<std::thread> readers;
+    for (int i = 0; i < NUM_QUERY_THREADS; ++i) {
+        readers.emplace_back([&] {
+            QVector<EntityItemPointer> entities;
+            while (!done) {
+                auto start = usecTimestampNow();
+                query(randomQueryPosition(), entities);
+                totalQueryUsecs += usecTimestampNow() - start;
+                numFound += entities.size();
+                ++numQueries;
+            }
+        });
+    }
+
+    auto start = usecTimestampNow();
+    while (usecTimestampNow() - start < QUERY_BENCHMARK_USECS) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    done = true;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    editor.join();
+
+    float seconds = (float)QUERY_BENCHMARK_USECS / (float)USECS_PER_SECOND;
+    qDebug() << name << ":" << (float)numQueries / seconds << "queries/s,"
+        << (float)totalQueryUsecs / (float)numQueries << "usecs/query,"
+        << (float)numFound / (float)numQueries << "entities/query,"
+        << (float)numEdits / seconds << "edits/s";
+}
+
+void benchmarkQueries() {
+    auto tree = std::make_shared<EntityTree>();
+    tree->setIsServer(true);
+    tree->createRootElement();
+
+    QVector<EntityItemID> entityIDs;
+    for (int i = 0; i < NUM_QUERY_ENTITIES; ++i) {
+        EntityItemProperties properties;
+        properties.setType(EntityTypes::Box);
+        properties.setPosition(randomQueryPosition());
+        properties.setDimensions(glm::vec3(randFloatInRange(0.1f, 2.0f)));
+        EntityItemID entityID(QUuid::createUuid());
+        tree->withWriteLock([&] {
+            tree->addEntity(entityID, properties);
+        });
+        entityIDs.push_back(entityID);
+    }
+    tree->update(false);
+
+    benchmarkQueries("Element walk", tree, entityIDs, [&](const glm::vec3& position, QVector<EntityItemPointer>& entities) {
+        FindInSphereArgs args { position, QUERY_RADIUS, QVector<EntityItemPointer>() };
+        tree->withReadLock([&] {
+            tree->recurseTreeWithOperation(findInSphereOperation, &args);
+        });
+        entities.swap(args.entities);
+    });
+
+    benchmarkQueries("Query index", tree, entityIDs, [&](const glm::vec3& position, QVector<EntityItemPointer>& entities) {
+        tree->findEntities(position, QUERY_RADIUS, entities);
+    });
+}
+
 int main(int argc, char** argv) {
     QCoreApplication app(argc, argv);
     {
@@ -165,6 +286,8 @@ int main(int argc, char** argv) {
     }
     float duration = (usecTimestampNow() - start);
     qDebug() << (duration / 1000.0f);
+
+    benchmarkQueries();
     return 0;
 }
 
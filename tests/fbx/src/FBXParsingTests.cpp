@@ -0,0 +1,273 @@
+//
+//  FBXParsingTests.cpp
+//  tests/fbx/src
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "FBXParsingTests.h"
+
+#include <cmath>
+#include <memory>
+
+#include <QtCore/QBuffer>
+#include <QtCore/QDir>
+#include <QtCore/QtEndian>
+
+#include <FBXReader.h>
+#include <NumericalConstants.h>
+#include <SharedUtil.h>
+
+QTEST_GUILESS_MAIN(FBXParsingTests)
+
+// set to a directory of .fbx files to benchmark the parser on real models
+static const char* BENCHMARK_MODELS_VARIABLE = "HIFI_FBX_BENCHMARK_MODELS";
+
+// Writes the binary FBX documents the tests parse
+class BinaryFBXWriter {
+public:
+    BinaryFBXWriter(quint32 version) : _has64BitPositions(version >= 7500) {
+        _data.append("Kaydara FBX Binary  ", 20);
+        _data.append('\0');
+        _data.append("\x1a\x00", 2);
+        append(version);
+    }
+
+    template<class T> void append(T value) {
+        value = qToLittleEndian(value);
+        _data.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    void beginNode(const QByteArray& name, const QByteArray& properties, quint32 propertyCount) {
+        _nodeStarts.push_back(_data.size());
+        if (_has64BitPositions) {
+            append<qint64>(0);
+            append<quint64>(propertyCount);
+            append<quint64>(properties.size());
+        } else {
+            append<qint32>(0);
+            append<quint32>(propertyCount);
+            append<quint32>(properties.size());
+        }
+        append<quint8>(name.size());
+        _data.append(name);
+        _data.append(properties);
+    }
+
+    void endNode(bool hasChildren) {
+        if (hasChildren) {
+            appendNullRecord();
+        }
+        auto start = _nodeStarts.back();
+        _nodeStarts.pop_back();
+
+        if (_has64BitPositions) {
+            qToLittleEndian<qint64>(_data.size(), reinterpret_cast<uchar*>(_data.data() + start));
+        } else {
+            qToLittleEndian<qint32>(_data.size(), reinterpret_cast<uchar*>(_data.data() + start));
+        }
+    }
+
+    QByteArray finish() {
+        appendNullRecord();
+        return _data;
+    }
+
+private:
+    void appendNullRecord() {
+        _data.append(QByteArray(_has64BitPositions ? 25 : 13, 0));
+    }
+
+    QByteArray _data;
+    std::vector<int> _nodeStarts;
+    bool _has64BitPositions;
+};
+
+static QByteArray intProperty(qint32 value) {
+    QByteArray property(1, 'I');
+    value = qToLittleEndian(value);
+    property.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    return property;
+}
+
+static QByteArray stringProperty(const QByteArray& value) {
+    QByteArray property(1, 'S');
+    quint32 length = qToLittleEndian<quint32>(value.size());
+    property.append(reinterpret_cast<const char*>(&length), sizeof(length));
+    property.append(value);
+    return property;
+}
+
+template<class T> static QByteArray arrayProperty(char type, const QVector<T>& values, bool deflate) {
+    QByteArray arrayData(reinterpret_cast<const char*>(values.constData()), values.size() * sizeof(T));
+    if (deflate) {
+        // qCompress prefixes the zlib stream with the uncompressed length, which FBX doesn't have
+        arrayData = qCompress(arrayData).mid(sizeof(quint32));
+    }
+
+    QByteArray property(1, type);
+    quint32 header[] = { qToLittleEndian<quint32>(values.size()), qToLittleEndian<quint32>(deflate ? 1 : 0),
+                         qToLittleEndian<quint32>(arrayData.size()) };
+    property.append(reinterpret_cast<const char*>(header), sizeof(header));
+    property.append(arrayData);
+    return property;
+}
+
+static QVector<double> makeVertices(int count) {
+    QVector<double> vertices;
+    vertices.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        vertices.push_back(std::sin(i * 0.01) * 100.0);
+    }
+    return vertices;
+}
+
+static QVector<qint32> makeIndices(int count) {
+    QVector<qint32> indices;
+    indices.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        // polygon ends are stored as negative indices
+        indices.push_back(i % 3 == 2 ? -(i + 1) : i);
+    }
+    return indices;
+}
+
+static QByteArray makeDocument(quint32 version, const QVector<double>& vertices, const QVector<qint32>& indices,
+                               int numGeometries = 1) {
+    BinaryFBXWriter writer(version);
+
+    writer.beginNode("FBXHeaderExtension", QByteArray(), 0);
+    writer.beginNode("FBXVersion", intProperty(version), 1);
+    writer.endNode(false);
+    writer.endNode(true);
+
+    writer.beginNode("Objects", QByteArray(), 0);
+    for (int i = 0; i < numGeometries; ++i) {
+        writer.beginNode("Geometry", intProperty(i) + stringProperty("Geometry::Cube") + stringProperty("Mesh"), 3);
+        writer.beginNode("Vertices", arrayProperty('d', vertices, true), 1);
+        writer.endNode(false);
+        writer.beginNode("PolygonVertexIndex", arrayProperty('i', indices, false), 1);
+        writer.endNode(false);
+        writer.endNode(true);
+    }
+    writer.endNode(true);
+
+    writer.beginNode("Takes", stringProperty("Take 001"), 1);
+    writer.beginNode("Take", arrayProperty('d', vertices, true), 1);
+    writer.endNode(false);
+    writer.endNode(true);
+
+    return writer.finish();
+}
+
+static FBXNode parseDocument(const QByteArray& document, bool skipUnusedSections = false) {
+    QBuffer buffer;
+    buffer.setData(document);
+    buffer.open(QIODevice::ReadOnly);
+    return FBXReader::parseFBX(&buffer, skipUnusedSections);
+}
+
+static void verifyDocument(const FBXNode& top, const QVector<double>& vertices, const QVector<qint32>& indices) {
+    QCOMPARE(top.children.size(), 3);
+    QCOMPARE(top.children.at(0).name, QByteArray("FBXHeaderExtension"));
+
+    const auto& geometry = top.children.at(1).children.at(0);
+    QCOMPARE(geometry.name, QByteArray("Geometry"));
+    QCOMPARE(geometry.properties.size(), 3);
+    QCOMPARE(geometry.properties.at(1).toByteArray(), QByteArray("Geometry::Cube"));
+    QCOMPARE(geometry.children.size(), 2);
+
+    QCOMPARE(FBXReader::getDoubleVector(geometry.children.at(0)), vertices);
+    QCOMPARE(FBXReader::getIntVector(geometry.children.at(1)), indices);
+}
+
+void FBXParsingTests::binaryNodesAndProperties() {
+    auto vertices = makeVertices(3000);
+    auto indices = makeIndices(900);
+
+    auto top = parseDocument(makeDocument(7400, vertices, indices));
+    verifyDocument(top, vertices, indices);
+    QCOMPARE(top.children.at(0).children.at(0).properties.at(0).toInt(), 7400);
+}
+
+void FBXParsingTests::binary2016Positions() {
+    auto vertices = makeVertices(3000);
+    auto indices = makeIndices(900);
+
+    auto top = parseDocument(makeDocument(7500, vertices, indices));
+    verifyDocument(top, vertices, indices);
+    QCOMPARE(top.children.at(0).children.at(0).properties.at(0).toInt(), 7500);
+}
+
+void FBXParsingTests::unusedSectionsAreSkipped() {
+    auto vertices = makeVertices(300);
+    auto indices = makeIndices(90);
+    auto document = makeDocument(7400, vertices, indices);
+
+    auto top = parseDocument(document, true);
+    QCOMPARE(top.children.size(), 2);
+    QCOMPARE(top.children.at(1).name, QByteArray("Objects"));
+    QCOMPARE(FBXReader::getDoubleVector(top.children.at(1).children.at(0).children.at(0)), vertices);
+
+    QCOMPARE(parseDocument(document, false).children.last().name, QByteArray("Takes"));
+}
+
+void FBXParsingTests::corruptArrayThrows() {
+    auto document = makeDocument(7400, makeVertices(3000), makeIndices(900));
+
+    // truncated in the middle of the vertices
+    QVERIFY_EXCEPTION_THROWN(parseDocument(document.left(document.size() / 2)), QString);
+
+    // garbage in the deflated data
+    auto corrupted = document;
+    auto verticesOffset = corrupted.indexOf("Vertices") + 8 + 1 + 3 * sizeof(quint32) + 2;
+    for (int i = 0; i < 64; ++i) {
+        corrupted[verticesOffset + i] = (char)0xff;
+    }
+    QVERIFY_EXCEPTION_THROWN(parseDocument(corrupted), QString);
+}
+
+void FBXParsingTests::benchmarkParsing() {
+    auto modelsDirectory = qgetenv(BENCHMARK_MODELS_VARIABLE);
+
+    if (modelsDirectory.isEmpty()) {
+        // 32 geometries with 64k vertices each, about 72MB of arrays once inflated
+        const int NUM_GEOMETRIES = 32;
+        const int NUM_COORDINATES = 3 * 64 * 1024;
+        auto document = makeDocument(7400, makeVertices(NUM_COORDINATES), makeIndices(NUM_COORDINATES), NUM_GEOMETRIES);
+
+        auto start = usecTimestampNow();
+        auto top = parseDocument(document, true);
+        auto duration = usecTimestampNow() - start;
+
+        QCOMPARE(top.children.at(1).children.size(), NUM_GEOMETRIES);
+        qDebug() << "Parsed a synthetic" << document.size() / BYTES_PER_KILOBYTE << "KB model in"
+            << (float)duration / USECS_PER_MSEC << "ms -" << BENCHMARK_MODELS_VARIABLE << "can point to real models";
+        return;
+    }
+
+    QDir directory { modelsDirectory };
+    for (const auto& fileInfo : directory.entryInfoList({ "*.fbx" }, QDir::Files)) {
+        QFile file { fileInfo.absoluteFilePath() };
+        QVERIFY(file.open(QIODevice::ReadOnly));
+
+        // the file gets memory mapped
+        auto start = usecTimestampNow();
+        auto top = FBXReader::parseFBX(&file, true);
+        auto parseDuration = usecTimestampNow() - start;
+
+        file.seek(0);
+        auto contents = file.readAll();
+
+        start = usecTimestampNow();
+        std::unique_ptr<FBXGeometry> geometry { readFBX(contents, QVariantHash(), fileInfo.fileName()) };
+        auto loadDuration = usecTimestampNow() - start;
+
+        QVERIFY(geometry);
+        qDebug() << fileInfo.fileName() << "-" << fileInfo.size() / BYTES_PER_KILOBYTE << "KB - parsed in"
+            << (float)parseDuration / USECS_PER_MSEC << "ms, loaded in" << (float)loadDuration / USECS_PER_MSEC << "ms";
+    }
+}
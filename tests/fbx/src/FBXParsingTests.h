@@ -0,0 +1,26 @@
+//
+//  FBXParsingTests.h
+//  tests/fbx/src
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_FBXParsingTests_h
+#define hifi_FBXParsingTests_h
+
+#include <QtTest/QtTest>
+
+class FBXParsingTests : public QObject {
+    Q_OBJECT
+private slots:
+    void binaryNodesAndProperties();
+    void binary2016Positions();
+    void unusedSectionsAreSkipped();
+    void corruptArrayThrows();
+    void benchmarkParsing();
+};
+
+#endif // hifi_FBXParsingTests_h
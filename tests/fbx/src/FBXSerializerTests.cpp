@@ -0,0 +1,166 @@
+//
+//  FBXSerializerTests.cpp
+//  tests/fbx/src
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "FBXSerializerTests.h"
+
+#include <memory>
+
+#include <FBXSerializer.h>
+
+QTEST_GUILESS_MAIN(FBXSerializerTests)
+
+static FBXGeometry makeGeometry() {
+    FBXGeometry geometry;
+    geometry.originalURL = "http://example.com/model.fbx";
+    geometry.applicationName = "test";
+    geometry.hasSkeletonJoints = true;
+
+    FBXJoint joint;
+    joint.isFree = false;
+    joint.parentIndex = -1;
+    joint.distanceToParent = 0.0f;
+    joint.translation = glm::vec3(1.0f, 2.0f, 3.0f);
+    joint.rotation = glm::quat(0.5f, 0.5f, 0.5f, 0.5f);
+    joint.bindTransform = glm::mat4(2.0f);
+    joint.name = "Hips";
+    joint.isSkeletonJoint = true;
+    joint.bindTransformFoundInCluster = true;
+    joint.hasGeometricOffset = false;
+    joint.shapeInfo.points = { glm::vec3(0.0f), glm::vec3(1.0f) };
+    joint.shapeInfo.dots = { 0.25f, 0.75f };
+    geometry.joints.append(joint);
+    geometry.jointIndices.insert(joint.name, 1);
+    geometry.rootJointIndex = 0;
+
+    FBXMesh mesh;
+    mesh.vertices = { glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f) };
+    mesh.normals = { glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, 1.0f) };
+    mesh.texCoords = { glm::vec2(0.0f), glm::vec2(1.0f, 0.0f), glm::vec2(0.0f, 1.0f) };
+    mesh.clusterIndices = { 0, 0, 0, 0 };
+    mesh.clusterWeights = { 255, 0, 0, 0 };
+    FBXMeshPart part;
+    part.triangleIndices = { 0, 1, 2 };
+    part.materialID = "material";
+    mesh.parts.append(part);
+    FBXCluster cluster;
+    cluster.jointIndex = 0;
+    cluster.inverseBindMatrix = glm::mat4(0.5f);
+    mesh.clusters.append(cluster);
+    mesh.meshExtents = Extents(glm::vec3(0.0f), glm::vec3(1.0f, 1.0f, 0.0f));
+    mesh.meshIndex = 0;
+    geometry.meshes.append(mesh);
+    geometry.meshExtents = mesh.meshExtents;
+
+    FBXMaterial material(glm::vec3(0.5f), glm::vec3(0.1f), glm::vec3(0.0f), 10.0f, 1.0f);
+    material.materialID = "material";
+    material.albedoTexture.name = "albedo";
+    material.albedoTexture.filename = "textures/albedo.png";
+    material.albedoTexture.transform.setTranslation(glm::vec3(0.5f, 0.0f, 0.0f));
+    geometry.materials.insert(material.materialID, material);
+
+    geometry.meshIndicesToModelNames.insert(0, "Body");
+    geometry.blendshapeChannelNames << "Blink";
+
+    return geometry;
+}
+
+void FBXSerializerTests::roundTrip() {
+    auto original = makeGeometry();
+
+    auto data = serializeFBXGeometry(original);
+    QVERIFY(!data.isEmpty());
+
+    std::unique_ptr<FBXGeometry> geometry(unserializeFBXGeometry(data, original.originalURL));
+    QVERIFY(geometry);
+
+    QCOMPARE(geometry->originalURL, original.originalURL);
+    QCOMPARE(geometry->applicationName, original.applicationName);
+    QCOMPARE(geometry->rootJointIndex, 0);
+    QCOMPARE(geometry->leftEyeJointIndex, -1);
+
+    QCOMPARE(geometry->joints.size(), 1);
+    const auto& joint = geometry->joints.at(0);
+    QCOMPARE(joint.name, QString("Hips"));
+    QVERIFY(joint.translation == original.joints.at(0).translation);
+    QVERIFY(joint.rotation == original.joints.at(0).rotation);
+    QVERIFY(joint.bindTransform == original.joints.at(0).bindTransform);
+    QVERIFY(joint.shapeInfo.points == original.joints.at(0).shapeInfo.points);
+    QVERIFY(joint.shapeInfo.dots == original.joints.at(0).shapeInfo.dots);
+    QCOMPARE(geometry->getJointIndex("Hips"), 0);
+
+    QCOMPARE(geometry->meshes.size(), 1);
+    const auto& mesh = geometry->meshes.at(0);
+    const auto& originalMesh = original.meshes.at(0);
+    QVERIFY(mesh.vertices == originalMesh.vertices);
+    QVERIFY(mesh.normals == originalMesh.normals);
+    QVERIFY(mesh.texCoords == originalMesh.texCoords);
+    QVERIFY(mesh.clusterIndices == originalMesh.clusterIndices);
+    QVERIFY(mesh.clusterWeights == originalMesh.clusterWeights);
+    QCOMPARE(mesh.parts.size(), 1);
+    QVERIFY(mesh.parts.at(0).triangleIndices == originalMesh.parts.at(0).triangleIndices);
+    QCOMPARE(mesh.parts.at(0).materialID, QString("material"));
+    QCOMPARE(mesh.clusters.size(), 1);
+    QVERIFY(mesh.clusters.at(0).inverseBindMatrix == originalMesh.clusters.at(0).inverseBindMatrix);
+    QVERIFY(mesh.meshExtents.maximum == originalMesh.meshExtents.maximum);
+
+    // the model mesh is rebuilt rather than stored
+    QVERIFY(mesh._mesh);
+    QCOMPARE((int)mesh._mesh->getNumVertices(), 3);
+
+    QCOMPARE(geometry->materials.size(), 1);
+    const auto& material = geometry->materials["material"];
+    QCOMPARE(material.albedoTexture.filename, QByteArray("textures/albedo.png"));
+    QVERIFY(material.albedoTexture.transform.getTranslation() == glm::vec3(0.5f, 0.0f, 0.0f));
+    QVERIFY(material.diffuseColor == glm::vec3(0.5f));
+
+    QCOMPARE(geometry->meshIndicesToModelNames.value(0), QString("Body"));
+    QCOMPARE(geometry->blendshapeChannelNames, original.blendshapeChannelNames);
+}
+
+void FBXSerializerTests::modelMaterialRoundTrip() {
+    auto original = makeGeometry();
+    auto& originalMaterial = original.materials["material"];
+    originalMaterial._material = std::make_shared<model::Material>();
+    originalMaterial._material->setAlbedo(glm::vec3(0.25f, 0.5f, 1.0f));
+    originalMaterial._material->setRoughness(0.3f);
+    originalMaterial._material->setMetallic(0.6f);
+    originalMaterial._material->setScattering(0.0f);
+    originalMaterial._material->setOpacity(0.5f);
+    originalMaterial._material->setUnlit(true);
+
+    std::unique_ptr<FBXGeometry> geometry(unserializeFBXGeometry(serializeFBXGeometry(original), original.originalURL));
+    QVERIFY(geometry);
+
+    const auto& modelMaterial = geometry->materials["material"]._material;
+    QVERIFY(modelMaterial);
+    QVERIFY(modelMaterial->getKey()._flags == originalMaterial._material->getKey()._flags);
+    QVERIFY(modelMaterial->getAlbedo(false) == originalMaterial._material->getAlbedo(false));
+    QCOMPARE(modelMaterial->getRoughness(), originalMaterial._material->getRoughness());
+    QCOMPARE(modelMaterial->getMetallic(), originalMaterial._material->getMetallic());
+    QCOMPARE(modelMaterial->getOpacity(), originalMaterial._material->getOpacity());
+}
+
+void FBXSerializerTests::truncatedDataFails() {
+    auto data = serializeFBXGeometry(makeGeometry());
+
+    for (int size : { 0, 4, 8, data.size() / 2, data.size() - 1 }) {
+        std::unique_ptr<FBXGeometry> geometry(unserializeFBXGeometry(data.left(size), "truncated"));
+        QVERIFY(!geometry);
+    }
+}
+
+void FBXSerializerTests::otherVersionFails() {
+    auto data = serializeFBXGeometry(makeGeometry());
+
+    // the version follows the 4 byte magic
+    data[7] = data[7] + 1;
+    std::unique_ptr<FBXGeometry> geometry(unserializeFBXGeometry(data, "other version"));
+    QVERIFY(!geometry);
+}
@@ -0,0 +1,25 @@
+//
+//  FBXSerializerTests.h
+//  tests/fbx/src
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_FBXSerializerTests_h
+#define hifi_FBXSerializerTests_h
+
+#include <QtTest/QtTest>
+
+class FBXSerializerTests : public QObject {
+    Q_OBJECT
+private slots:
+    void roundTrip();
+    void modelMaterialRoundTrip();
+    void truncatedDataFails();
+    void otherVersionFails();
+};
+
+#endif // hifi_FBXSerializerTests_h
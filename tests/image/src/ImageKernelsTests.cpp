@@ -0,0 +1,372 @@
+//
+//  ImageKernelsTests.cpp
+//  tests/image/src
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "ImageKernelsTests.h"
+
+#include <atomic>
+#include <cmath>
+#include <vector>
+
+#include <QtGui/QImage>
+
+#include <image/ImageKernels.h>
+#include <NumericalConstants.h>
+#include <SharedUtil.h>
+
+QTEST_GUILESS_MAIN(ImageKernelsTests)
+
+using namespace image;
+
+// widths around the vector sizes, so that every kernel has leftover pixels to finish
+static const std::vector<int> TEST_WIDTHS { 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 33, 100, 257 };
+
+static const int BENCHMARK_SIZE = 4096;
+
+static uint32_t randomPixel() {
+    // favor the alpha values the alpha scan looks for
+    uint32_t alpha;
+    switch (qrand() % 3) {
+        case 0: alpha = 0; break;
+        case 1: alpha = 255; break;
+        default: alpha = qrand() % 256; break;
+    }
+    return (alpha << 24) | ((qrand() & 0xfff) << 12) | (qrand() & 0xfff);
+}
+
+static std::vector<uint32_t> randomRow(int width) {
+    std::vector<uint32_t> row(width);
+    for (auto& pixel : row) {
+        pixel = randomPixel();
+    }
+    return row;
+}
+
+static std::vector<uint8_t> randomGrayRow(int width) {
+    std::vector<uint8_t> row(width);
+    for (auto& value : row) {
+        value = qrand() % 256;
+    }
+    return row;
+}
+
+static QImage randomImage(int width, int height) {
+    QImage image(width, height, QImage::Format_ARGB32);
+    for (int y = 0; y < height; ++y) {
+        auto row = reinterpret_cast<uint32_t*>(image.scanLine(y));
+        for (int x = 0; x < width; ++x) {
+            row[x] = randomPixel();
+        }
+    }
+    return image;
+}
+
+// the normal of the bump map processing before it used the kernels, with the channels it was meant to have
+static QRgb referenceNormal(const uint8_t* above, const uint8_t* row, const uint8_t* below, int x, int width) {
+    const double STRENGTH = 2.0;
+    const int left = std::max(x - 1, 0);
+    const int right = std::min(x + 1, width - 1);
+
+    const double dX = (above[right] + STRENGTH * row[right] + below[right]) - (above[left] + STRENGTH * row[left] + below[left]);
+    const double dY = (below[left] + STRENGTH * below[x] + below[right]) - (above[left] + STRENGTH * above[x] + above[right]);
+    const double dZ = 255.0 / STRENGTH;
+    const double length = sqrt(dX * dX + dY * dY + dZ * dZ);
+
+    auto toByte = [](double value) { return (int)((value + 1.0) * 127.5 + 0.5); };
+    return qRgba(toByte(-dX / length), toByte(dY / length), toByte(dZ / length), 255);
+}
+
+void ImageKernelsTests::initTestCase() {
+    qsrand(0x1d3a);
+}
+
+void ImageKernelsTests::alphaCounts() {
+    for (int width : TEST_WIDTHS) {
+        auto row = randomRow(width);
+
+        int expectedOpaques = 0;
+        int expectedTranslucents = 0;
+        for (auto pixel : row) {
+            auto alpha = qAlpha(pixel);
+            expectedOpaques += (alpha == 255);
+            expectedTranslucents += (alpha != 0 && alpha != 255);
+        }
+
+        int numOpaques;
+        int numTranslucents;
+        kernels::countAlpha(row.data(), width, numOpaques, numTranslucents);
+        QCOMPARE(numOpaques, expectedOpaques);
+        QCOMPARE(numTranslucents, expectedTranslucents);
+    }
+}
+
+void ImageKernelsTests::swapAndExtract() {
+    for (int width : TEST_WIDTHS) {
+        auto row = randomRow(width);
+
+        std::vector<uint32_t> swapped(width);
+        std::vector<uint8_t> red(width);
+        kernels::swapRedBlue(row.data(), swapped.data(), width);
+        kernels::extractRed(row.data(), red.data(), width);
+
+        for (int x = 0; x < width; ++x) {
+            QCOMPARE(swapped[x], (uint32_t)qRgba(qBlue(row[x]), qGreen(row[x]), qRed(row[x]), qAlpha(row[x])));
+            QCOMPARE((int)red[x], qRed(row[x]));
+        }
+
+        // in place
+        kernels::swapRedBlue(swapped.data(), swapped.data(), width);
+        for (int x = 0; x < width; ++x) {
+            QCOMPARE(swapped[x], row[x]);
+        }
+    }
+}
+
+void ImageKernelsTests::bumpToNormal() {
+    for (int width : TEST_WIDTHS) {
+        auto above = randomGrayRow(width);
+        auto row = randomGrayRow(width);
+        auto below = randomGrayRow(width);
+
+        std::vector<uint32_t> normals(width);
+        kernels::bumpToNormalRow(above.data(), row.data(), below.data(), normals.data(), width);
+
+        for (int x = 0; x < width; ++x) {
+            // single precision may round the other way
+            QRgb expected = referenceNormal(above.data(), row.data(), below.data(), x, width);
+            QVERIFY(abs(qRed(normals[x]) - qRed(expected)) <= 1);
+            QVERIFY(abs(qGreen(normals[x]) - qGreen(expected)) <= 1);
+            QVERIFY(abs(qBlue(normals[x]) - qBlue(expected)) <= 1);
+            QCOMPARE(qAlpha(normals[x]), 255);
+        }
+    }
+
+    // a flat height map points straight out of the surface
+    std::vector<uint8_t> flat(9, 100);
+    std::vector<uint32_t> normals(9);
+    kernels::bumpToNormalRow(flat.data(), flat.data(), flat.data(), normals.data(), 9);
+    for (auto normal : normals) {
+        QCOMPARE(normal, (uint32_t)qRgba(128, 128, 255, 255));
+    }
+
+    // heights rising to the right and down the image tilt the normal left and down
+    std::vector<uint8_t> above { 0, 10, 20, 30, 40, 50, 60, 70, 80 };
+    std::vector<uint8_t> row { 10, 20, 30, 40, 50, 60, 70, 80, 90 };
+    std::vector<uint8_t> below { 20, 30, 40, 50, 60, 70, 80, 90, 100 };
+    kernels::bumpToNormalRow(above.data(), row.data(), below.data(), normals.data(), 9);
+    QVERIFY(qRed(normals[4]) < 128);
+    QVERIFY(qGreen(normals[4]) > 128);
+}
+
+void ImageKernelsTests::downsample() {
+    for (int width : TEST_WIDTHS) {
+        auto row0 = randomRow(width);
+        auto row1 = randomRow(width);
+        const int dstWidth = std::max(width / 2, 1);
+
+        std::vector<uint32_t> linear(dstWidth);
+        kernels::downsampleRows(row0.data(), row1.data(), linear.data(), width, false);
+        for (int x = 0; x < dstWidth; ++x) {
+            const int left = std::min(2 * x, width - 1);
+            const int right = std::min(2 * x + 1, width - 1);
+            for (int shift = 0; shift < 32; shift += 8) {
+                uint32_t sum = ((row0[left] >> shift) & 0xff) + ((row0[right] >> shift) & 0xff) +
+                    ((row1[left] >> shift) & 0xff) + ((row1[right] >> shift) & 0xff);
+                QCOMPARE((linear[x] >> shift) & 0xff, (sum + 2) / 4);
+            }
+        }
+
+        std::vector<uint32_t> gamma(dstWidth);
+        kernels::downsampleRows(row0.data(), row1.data(), gamma.data(), width, true);
+        for (int x = 0; x < dstWidth; ++x) {
+            const int left = std::min(2 * x, width - 1);
+            const int right = std::min(2 * x + 1, width - 1);
+            auto toLinear = [](int value) { return pow(value / 255.0, 2.2); };
+            auto fromLinear = [](double value) { return (int)(pow(value, 1.0 / 2.2) * 255.0 + 0.5); };
+            for (int shift = 0; shift < 24; shift += 8) {
+                double sum = toLinear((row0[left] >> shift) & 0xff) + toLinear((row0[right] >> shift) & 0xff) +
+                    toLinear((row1[left] >> shift) & 0xff) + toLinear((row1[right] >> shift) & 0xff);
+                QVERIFY(abs((int)((gamma[x] >> shift) & 0xff) - fromLinear(sum / 4.0)) <= 1);
+            }
+            QCOMPARE(gamma[x] >> 24, linear[x] >> 24);
+        }
+    }
+
+    // uniform blocks keep their color either way
+    std::vector<uint32_t> uniform(8, qRgba(200, 30, 90, 128));
+    std::vector<uint32_t> result(4);
+    kernels::downsampleRows(uniform.data(), uniform.data(), result.data(), 8, true);
+    for (auto pixel : result) {
+        QCOMPARE(pixel, uniform[0]);
+    }
+}
+
+void ImageKernelsTests::rowTilesCoverImage() {
+    for (int height : { 0, 1, 63, 64, 65, 1000, BENCHMARK_SIZE }) {
+        std::vector<std::atomic<int>> visits(height);
+        for (auto& count : visits) {
+            count = 0;
+        }
+
+        kernels::forEachRowTile(height, [&](int firstRow, int endRow) {
+            for (int y = firstRow; y < endRow; ++y) {
+                ++visits[y];
+            }
+        });
+
+        for (auto& count : visits) {
+            QCOMPARE((int)count, 1);
+        }
+    }
+}
+
+void ImageKernelsTests::benchmark4K() {
+    QImage image = randomImage(BENCHMARK_SIZE, BENCHMARK_SIZE);
+    QImage bumpImage = image.convertToFormat(QImage::Format_Grayscale8);
+    const int width = image.width();
+    const int height = image.height();
+
+    auto report = [](const char* name, quint64 perPixelDuration, quint64 kernelDuration) {
+        qDebug() << name << "on" << BENCHMARK_SIZE << "x" << BENCHMARK_SIZE << "- per pixel:" << perPixelDuration / USECS_PER_MSEC
+            << "ms, kernels:" << kernelDuration / USECS_PER_MSEC << "ms";
+    };
+
+    {
+        auto start = usecTimestampNow();
+        int numOpaques = 0;
+        int numTranslucents = 0;
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                auto alpha = qAlpha(image.pixel(x, y));
+                numOpaques += (alpha == 255);
+                numTranslucents += (alpha != 0 && alpha != 255);
+            }
+        }
+        auto perPixelDuration = usecTimestampNow() - start;
+
+        start = usecTimestampNow();
+        std::atomic<int> kernelOpaques { 0 };
+        std::atomic<int> kernelTranslucents { 0 };
+        const uchar* bits = image.constBits();
+        kernels::forEachRowTile(height, [&](int firstRow, int endRow) {
+            for (int y = firstRow; y < endRow; ++y) {
+                int rowOpaques;
+                int rowTranslucents;
+                kernels::countAlpha(reinterpret_cast<const uint32_t*>(bits + y * image.bytesPerLine()), width, rowOpaques, rowTranslucents);
+                kernelOpaques += rowOpaques;
+                kernelTranslucents += rowTranslucents;
+            }
+        });
+        report("Alpha scan", perPixelDuration, usecTimestampNow() - start);
+
+        QCOMPARE((int)kernelOpaques, numOpaques);
+        QCOMPARE((int)kernelTranslucents, numTranslucents);
+    }
+
+    {
+        // column major with the Qt accessors, the way bump maps used to be processed
+        auto start = usecTimestampNow();
+        QImage perPixelResult(width, height, QImage::Format_ARGB32);
+        for (int x = 0; x < width; ++x) {
+            for (int y = 0; y < height; ++y) {
+                const int left = std::max(x - 1, 0);
+                const int right = std::min(x + 1, width - 1);
+                const int up = std::max(y - 1, 0);
+                const int down = std::min(y + 1, height - 1);
+                const double dX = (qRed(bumpImage.pixel(right, up)) + 2.0 * qRed(bumpImage.pixel(right, y)) + qRed(bumpImage.pixel(right, down)))
+                    - (qRed(bumpImage.pixel(left, up)) + 2.0 * qRed(bumpImage.pixel(left, y)) + qRed(bumpImage.pixel(left, down)));
+                const double dY = (qRed(bumpImage.pixel(left, down)) + 2.0 * qRed(bumpImage.pixel(x, down)) + qRed(bumpImage.pixel(right, down)))
+                    - (qRed(bumpImage.pixel(left, up)) + 2.0 * qRed(bumpImage.pixel(x, up)) + qRed(bumpImage.pixel(right, up)));
+                const double length = sqrt(dX * dX + dY * dY + 127.5 * 127.5);
+                perPixelResult.setPixel(x, y, qRgba((int)((-dX / length + 1.0) * 127.5), (int)((dY / length + 1.0) * 127.5),
+                                                    (int)((127.5 / length + 1.0) * 127.5), 255));
+            }
+        }
+        auto perPixelDuration = usecTimestampNow() - start;
+
+        start = usecTimestampNow();
+        QImage kernelResult(width, height, QImage::Format_ARGB32);
+        const uchar* srcBits = bumpImage.constBits();
+        uchar* dstBits = kernelResult.bits();
+        kernels::forEachRowTile(height, [&](int firstRow, int endRow) {
+            for (int y = firstRow; y < endRow; ++y) {
+                kernels::bumpToNormalRow(srcBits + std::max(y - 1, 0) * bumpImage.bytesPerLine(), srcBits + y * bumpImage.bytesPerLine(),
+                                         srcBits + std::min(y + 1, height - 1) * bumpImage.bytesPerLine(),
+                                         reinterpret_cast<uint32_t*>(dstBits + y * kernelResult.bytesPerLine()), width);
+            }
+        });
+        report("Bump to normal", perPixelDuration, usecTimestampNow() - start);
+    }
+
+    {
+        auto start = usecTimestampNow();
+        QImage perPixelResult = image.rgbSwapped();
+        auto perPixelDuration = usecTimestampNow() - start;
+
+        start = usecTimestampNow();
+        QImage kernelResult(width, height, QImage::Format_ARGB32);
+        uchar* dstBits = kernelResult.bits();
+        kernels::forEachRowTile(height, [&](int firstRow, int endRow) {
+            for (int y = firstRow; y < endRow; ++y) {
+                kernels::swapRedBlue(reinterpret_cast<const uint32_t*>(image.constScanLine(y)),
+                                     reinterpret_cast<uint32_t*>(dstBits + y * kernelResult.bytesPerLine()), width);
+            }
+        });
+        report("Red and blue swap (QImage::rgbSwapped)", perPixelDuration, usecTimestampNow() - start);
+
+        QCOMPARE(kernelResult, perPixelResult);
+    }
+
+    for (bool gammaCorrect : { false, true }) {
+        // one mip level
+        auto start = usecTimestampNow();
+        QImage perPixelResult(width / 2, height / 2, QImage::Format_ARGB32);
+        for (int y = 0; y < height / 2; ++y) {
+            for (int x = 0; x < width / 2; ++x) {
+                QRgb p0 = image.pixel(2 * x, 2 * y);
+                QRgb p1 = image.pixel(2 * x + 1, 2 * y);
+                QRgb p2 = image.pixel(2 * x, 2 * y + 1);
+                QRgb p3 = image.pixel(2 * x + 1, 2 * y + 1);
+                if (gammaCorrect) {
+                    auto average = [](int c0, int c1, int c2, int c3) {
+                        double sum = pow(c0 / 255.0, 2.2) + pow(c1 / 255.0, 2.2) + pow(c2 / 255.0, 2.2) + pow(c3 / 255.0, 2.2);
+                        return (int)(pow(sum / 4.0, 1.0 / 2.2) * 255.0 + 0.5);
+                    };
+                    perPixelResult.setPixel(x, y, qRgba(average(qRed(p0), qRed(p1), qRed(p2), qRed(p3)),
+                                                        average(qGreen(p0), qGreen(p1), qGreen(p2), qGreen(p3)),
+                                                        average(qBlue(p0), qBlue(p1), qBlue(p2), qBlue(p3)),
+                                                        (qAlpha(p0) + qAlpha(p1) + qAlpha(p2) + qAlpha(p3) + 2) / 4));
+                } else {
+                    perPixelResult.setPixel(x, y, qRgba((qRed(p0) + qRed(p1) + qRed(p2) + qRed(p3) + 2) / 4,
+                                                        (qGreen(p0) + qGreen(p1) + qGreen(p2) + qGreen(p3) + 2) / 4,
+                                                        (qBlue(p0) + qBlue(p1) + qBlue(p2) + qBlue(p3) + 2) / 4,
+                                                        (qAlpha(p0) + qAlpha(p1) + qAlpha(p2) + qAlpha(p3) + 2) / 4));
+                }
+            }
+        }
+        auto perPixelDuration = usecTimestampNow() - start;
+
+        start = usecTimestampNow();
+        QImage kernelResult(width / 2, height / 2, QImage::Format_ARGB32);
+        uchar* dstBits = kernelResult.bits();
+        kernels::forEachRowTile(height / 2, [&](int firstRow, int endRow) {
+            for (int y = firstRow; y < endRow; ++y) {
+                kernels::downsampleRows(reinterpret_cast<const uint32_t*>(image.constScanLine(2 * y)),
+                                        reinterpret_cast<const uint32_t*>(image.constScanLine(2 * y + 1)),
+                                        reinterpret_cast<uint32_t*>(dstBits + y * kernelResult.bytesPerLine()),
+                                        width, gammaCorrect);
+            }
+        });
+        report(gammaCorrect ? "Gamma correct mip" : "Linear mip", perPixelDuration, usecTimestampNow() - start);
+
+        if (!gammaCorrect) {
+            QCOMPARE(kernelResult, perPixelResult);
+        }
+    }
+}
@@ -0,0 +1,28 @@
+//
+//  ImageKernelsTests.h
+//  tests/image/src
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_ImageKernelsTests_h
+#define hifi_ImageKernelsTests_h
+
+#include <QtTest/QtTest>
+
+class ImageKernelsTests : public QObject {
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void alphaCounts();
+    void swapAndExtract();
+    void bumpToNormal();
+    void downsample();
+    void rowTilesCoverImage();
+    void benchmark4K();
+};
+
+#endif // hifi_ImageKernelsTests_h
@@ -0,0 +1,95 @@
+//
+//  AssetChunkingTests.cpp
+//  tests/networking/src
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "AssetChunkingTests.h"
+
+#include <random>
+
+#include <AssetChunking.h>
+#include <AssetUtils.h>
+
+QTEST_MAIN(AssetChunkingTests)
+
+static QByteArray randomData(int size, unsigned int seed) {
+    std::mt19937 generator { seed };
+    QByteArray data(size, Qt::Uninitialized);
+    for (auto& byte : data) {
+        byte = (char)generator();
+    }
+    return data;
+}
+
+void AssetChunkingTests::chunksCoverData() {
+    auto data = randomData(8 * 1024 * 1024, 1);
+    auto chunks = chunkData(data);
+
+    int64_t offset = 0;
+    for (const auto& chunk : chunks) {
+        QCOMPARE(chunk.offset, offset);
+        QCOMPARE(chunk.hash, hashData(data.mid(chunk.offset, chunk.size)));
+        offset += chunk.size;
+    }
+    QCOMPARE(offset, (int64_t)data.size());
+}
+
+void AssetChunkingTests::chunkSizesAreBounded() {
+    auto data = randomData(8 * 1024 * 1024, 2);
+    auto chunks = chunkData(data);
+
+    QVERIFY(chunks.size() > 1);
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        QVERIFY(chunks[i].size <= MAX_ASSET_CHUNK_SIZE);
+
+        // only the last chunk can be smaller than the minimum
+        if (i < chunks.size() - 1) {
+            QVERIFY(chunks[i].size >= MIN_ASSET_CHUNK_SIZE);
+        }
+    }
+
+    // a run of identical bytes settles on a rolling hash that misses the boundary mask, so it gets cut at the maximum size
+    QByteArray zeros((int)(3 * MAX_ASSET_CHUNK_SIZE), 0);
+    auto zeroChunks = chunkData(zeros);
+    QCOMPARE(zeroChunks.size(), (size_t)3);
+    QCOMPARE(zeroChunks[0].hash, zeroChunks[1].hash);
+}
+
+void AssetChunkingTests::chunksResynchronizeAfterInsert() {
+    auto data = randomData(8 * 1024 * 1024, 3);
+    auto editedData = data;
+    editedData.insert(1024 * 1024, randomData(1000, 4));
+
+    auto chunks = chunkData(data);
+    auto editedChunks = chunkData(editedData);
+
+    QSet<QByteArray> hashes;
+    for (const auto& chunk : chunks) {
+        hashes << chunk.hash;
+    }
+
+    int64_t sharedBytes = 0;
+    for (const auto& chunk : editedChunks) {
+        if (hashes.contains(chunk.hash)) {
+            sharedBytes += chunk.size;
+        }
+    }
+
+    // an insert should only invalidate the chunks around it
+    QVERIFY(data.size() - sharedBytes <= 2 * MAX_ASSET_CHUNK_SIZE);
+}
+
+void AssetChunkingTests::smallDataIsOneChunk() {
+    auto data = randomData(MIN_ASSET_CHUNK_SIZE, 5);
+    auto chunks = chunkData(data);
+
+    QCOMPARE(chunks.size(), (size_t)1);
+    QCOMPARE(chunks[0].size, (int64_t)data.size());
+
+    QVERIFY(chunkData(QByteArray()).empty());
+}
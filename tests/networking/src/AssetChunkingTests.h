@@ -0,0 +1,25 @@
+//
+//  AssetChunkingTests.h
+//  tests/networking/src
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_AssetChunkingTests_h
+#define hifi_AssetChunkingTests_h
+
+#include <QtTest/QtTest>
+
+class AssetChunkingTests : public QObject {
+    Q_OBJECT
+private slots:
+    void chunksCoverData();
+    void chunkSizesAreBounded();
+    void chunksResynchronizeAfterInsert();
+    void smallDataIsOneChunk();
+};
+
+#endif // hifi_AssetChunkingTests_h
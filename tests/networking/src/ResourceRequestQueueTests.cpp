@@ -0,0 +1,145 @@
+//
+//  ResourceRequestQueueTests.cpp
+//  tests/networking/src
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "ResourceRequestQueueTests.h"
+
+#include <cfloat>
+#include <random>
+
+#include <ResourceCache.h>
+#include <ResourceRequestQueue.h>
+
+QTEST_MAIN(ResourceRequestQueueTests)
+
+static QSharedPointer<Resource> makeResource(int index, QObject* owner, float priority) {
+    auto resource = QSharedPointer<Resource>::create(QUrl("atp:/resource" + QString::number(index)));
+    resource->setSelf(resource);
+    resource->setLoadPriority(owner, priority);
+    return resource;
+}
+
+void ResourceRequestQueueTests::ordersByPriorityThenArrival() {
+    QObject owner;
+    ResourceRequestQueue queue;
+
+    const float PRIORITIES[] = { 1.0f, 5.0f, 3.0f, 5.0f, -2.0f, 3.0f };
+    QList<QSharedPointer<Resource>> resources;
+    for (int i = 0; i < 6; ++i) {
+        resources << makeResource(i, &owner, PRIORITIES[i]);
+        QVERIFY(queue.push(resources.last(), PRIORITIES[i], i));
+    }
+
+    // queuing a resource again doesn't add it twice
+    QVERIFY(!queue.push(resources[0], PRIORITIES[0], 10));
+    QCOMPARE((int)queue.size(), 6);
+
+    const int EXPECTED_ORDER[] = { 1, 3, 2, 5, 0, 4 };
+    for (int index : EXPECTED_ORDER) {
+        uint64_t queuedTime = 0;
+        QCOMPARE(queue.pop(&queuedTime), resources[index]);
+        QCOMPARE(queuedTime, (uint64_t)index);
+    }
+    QVERIFY(queue.isEmpty());
+    QVERIFY(queue.pop().isNull());
+}
+
+void ResourceRequestQueueTests::updatesPriority() {
+    QObject owner;
+    ResourceRequestQueue queue;
+
+    QList<QSharedPointer<Resource>> resources;
+    for (int i = 0; i < 4; ++i) {
+        resources << makeResource(i, &owner, (float)i);
+        queue.push(resources.last(), (float)i, 0);
+    }
+
+    resources[0]->setLoadPriority(&owner, 10.0f);
+    QVERIFY(queue.update(resources[0].data(), 10.0f));
+    resources[3]->setLoadPriority(&owner, -1.0f);
+    QVERIFY(queue.update(resources[3].data(), -1.0f));
+
+    QCOMPARE(queue.pop(), resources[0]);
+    QCOMPARE(queue.pop(), resources[2]);
+    QCOMPARE(queue.pop(), resources[1]);
+    QCOMPARE(queue.pop(), resources[3]);
+
+    QVERIFY(!queue.update(resources[0].data(), 1.0f));
+}
+
+void ResourceRequestQueueTests::removesAndDropsFreedResources() {
+    QObject owner;
+    ResourceRequestQueue queue;
+
+    QList<QSharedPointer<Resource>> resources;
+    for (int i = 0; i < 5; ++i) {
+        resources << makeResource(i, &owner, (float)i);
+        queue.push(resources.last(), (float)i, 0);
+    }
+
+    QVERIFY(queue.remove(resources[2].data()));
+    QVERIFY(!queue.remove(resources[2].data()));
+    QVERIFY(!queue.contains(resources[2].data()));
+
+    // the highest priority resource goes away while queued
+    resources[4].reset();
+
+    QCOMPARE(queue.getResources().size(), 3);
+    QCOMPARE(queue.pop(), resources[3]);
+    QCOMPARE(queue.pop(), resources[1]);
+    QCOMPARE(queue.pop(), resources[0]);
+    QVERIFY(queue.isEmpty());
+}
+
+void ResourceRequestQueueTests::rereadsPriorityOfTop() {
+    QObject owner;
+    ResourceRequestQueue queue;
+
+    auto low = makeResource(0, &owner, 1.0f);
+    queue.push(low, 1.0f, 0);
+
+    // the only owner of the high priority resource goes away without telling the queue
+    auto highOwner = new QObject();
+    auto high = makeResource(1, highOwner, 10.0f);
+    queue.push(high, 10.0f, 0);
+    delete highOwner;
+
+    float priority = 0.0f;
+    QCOMPARE(queue.top(&priority), low);
+    QCOMPARE(priority, 1.0f);
+}
+
+void ResourceRequestQueueTests::benchmarkChurn() {
+    QObject owner;
+    std::mt19937 generator { 1 };
+    std::uniform_real_distribution<float> distribution { -100.0f, 100.0f };
+
+    const int NUM_RESOURCES = 10000;
+    QList<QSharedPointer<Resource>> resources;
+    QList<float> priorities;
+    for (int i = 0; i < NUM_RESOURCES; ++i) {
+        priorities << distribution(generator);
+        resources << makeResource(i, &owner, priorities.last());
+    }
+
+    QBENCHMARK {
+        ResourceRequestQueue queue;
+        for (int i = 0; i < NUM_RESOURCES; ++i) {
+            queue.push(resources[i], priorities[i], i);
+        }
+
+        // dequeue them all, the way slots free up while thousands of requests wait
+        float lastPriority = FLT_MAX;
+        while (!queue.isEmpty()) {
+            auto resource = queue.pop();
+            QVERIFY(resource->getLoadPriority() <= lastPriority);
+            lastPriority = resource->getLoadPriority();
+        }
+    }
+}
@@ -0,0 +1,26 @@
+//
+//  ResourceRequestQueueTests.h
+//  tests/networking/src
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_ResourceRequestQueueTests_h
+#define hifi_ResourceRequestQueueTests_h
+
+#include <QtTest/QtTest>
+
+class ResourceRequestQueueTests : public QObject {
+    Q_OBJECT
+private slots:
+    void ordersByPriorityThenArrival();
+    void updatesPriority();
+    void removesAndDropsFreedResources();
+    void rereadsPriorityOfTop();
+    void benchmarkChurn();
+};
+
+#endif // hifi_ResourceRequestQueueTests_h
@@ -0,0 +1,169 @@
+//
+//  EntityEditCoalescerTests.cpp
+//  tests/octree/src
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "EntityEditCoalescerTests.h"
+
+#include <vector>
+
+#include <AddressManager.h>
+#include <DependencyManager.h>
+#include <EntityEditCoalescer.h>
+#include <EntityEditPacketSender.h>
+#include <NodeList.h>
+
+QTEST_MAIN(EntityEditCoalescerTests)
+
+struct SentEdit {
+    EntityItemID entityItemID;
+    EntityItemProperties properties;
+};
+
+// records what the coalescer sends, as EntityEditPacketSender would queue it
+class EditRecorder {
+public:
+    void add(const EntityItemID& entityItemID, const EntityItemProperties& properties) {
+        _coalescer.addEdit(entityItemID, properties, ++_now, getSender());
+    }
+
+    const std::vector<SentEdit>& flush() {
+        _coalescer.flush(getSender());
+        return _sent;
+    }
+
+private:
+    EntityEditCoalescer::Sender getSender() {
+        return [this](const EntityItemID& entityItemID, const EntityItemProperties& properties) {
+            _sent.push_back({ entityItemID, properties });
+        };
+    }
+
+    EntityEditCoalescer _coalescer;
+    std::vector<SentEdit> _sent;
+    quint64 _now { 0 };
+};
+
+// the last edit sent to the entity that changed the property
+template <typename Changed>
+static const SentEdit* findLastEdit(const std::vector<SentEdit>& sent, const EntityItemID& entityItemID, Changed changed) {
+    const SentEdit* last = nullptr;
+    for (const auto& edit : sent) {
+        if (edit.entityItemID == entityItemID && changed(edit.properties)) {
+            last = &edit;
+        }
+    }
+    return last;
+}
+
+void EntityEditCoalescerTests::testMergesEdits() {
+    EntityItemID entityItemID(QUuid::createUuid());
+    EditRecorder recorder;
+
+    EntityItemProperties first;
+    first.setPosition(glm::vec3(1.0f, 2.0f, 3.0f));
+    first.setVelocity(glm::vec3(1.0f, 0.0f, 0.0f));
+    recorder.add(entityItemID, first);
+
+    EntityItemProperties second;
+    second.setPosition(glm::vec3(4.0f, 5.0f, 6.0f));
+    recorder.add(entityItemID, second);
+
+    const auto& sent = recorder.flush();
+    QCOMPARE(sent.size(), (size_t)1);
+    QCOMPARE(sent[0].properties.getPosition(), glm::vec3(4.0f, 5.0f, 6.0f));
+    QVERIFY(sent[0].properties.velocityChanged());
+    QCOMPARE(sent[0].properties.getVelocity(), glm::vec3(1.0f, 0.0f, 0.0f));
+}
+
+void EntityEditCoalescerTests::testKeepsLaterSimulationOwner() {
+    EntityItemID entityItemID(QUuid::createUuid());
+    QUuid sessionID = QUuid::createUuid();
+    EditRecorder recorder;
+
+    EntityItemProperties move;
+    move.setPosition(glm::vec3(1.0f, 2.0f, 3.0f));
+    recorder.add(entityItemID, move);
+
+    // a claim of the simulation ownership, and its release within the same interval
+    EntityItemProperties claim;
+    claim.setSimulationOwner(sessionID, 128);
+    claim.setVelocity(glm::vec3(1.0f, 0.0f, 0.0f));
+    recorder.add(entityItemID, claim);
+
+    EntityItemProperties release;
+    release.clearSimulationOwner();
+    recorder.add(entityItemID, release);
+
+    const auto& sent = recorder.flush();
+    QCOMPARE(sent.size(), (size_t)3);
+    const SentEdit* lastOwnerEdit = findLastEdit(sent, entityItemID, [](const EntityItemProperties& properties) {
+        return properties.simulationOwnerChanged();
+    });
+    QVERIFY(lastOwnerEdit);
+    QVERIFY(lastOwnerEdit->properties.getSimulationOwner().isNull());
+
+    // the edits are sent in order, none of them lost
+    QCOMPARE(sent[0].properties.getPosition(), glm::vec3(1.0f, 2.0f, 3.0f));
+    QCOMPARE(sent[1].properties.getSimulationOwner().getID(), sessionID);
+    QCOMPARE(sent[1].properties.getVelocity(), glm::vec3(1.0f, 0.0f, 0.0f));
+}
+
+void EntityEditCoalescerTests::testKeepsLaterServerScripts() {
+    EntityItemID entityItemID(QUuid::createUuid());
+    EntityItemID otherID(QUuid::createUuid());
+    EditRecorder recorder;
+
+    EntityItemProperties move;
+    move.setPosition(glm::vec3(1.0f, 2.0f, 3.0f));
+    recorder.add(otherID, move);
+
+    EntityItemProperties first;
+    first.setServerScripts("http://example.com/first.js");
+    recorder.add(entityItemID, first);
+
+    EntityItemProperties second;
+    second.setServerScripts("http://example.com/second.js");
+    recorder.add(entityItemID, second);
+
+    const auto& sent = recorder.flush();
+    QCOMPARE(sent.size(), (size_t)3);
+    QCOMPARE(sent[0].entityItemID, otherID);
+    const SentEdit* lastScriptsEdit = findLastEdit(sent, entityItemID, [](const EntityItemProperties& properties) {
+        return properties.serverScriptsChanged();
+    });
+    QVERIFY(lastScriptsEdit);
+    QCOMPARE(lastScriptsEdit->properties.getServerScripts(), QString("http://example.com/second.js"));
+}
+
+void EntityEditCoalescerTests::testThreadedSenderQueuesLoneEdit() {
+    DependencyManager::set<AddressManager>();
+    DependencyManager::set<NodeList>(NodeType::Agent, 0);
+
+    // a threaded sender waits for packets, a lone coalesced edit mustn't wait for some other packet to wake it up
+    const quint64 COALESCING_INTERVAL = 10 * USECS_PER_MSEC;
+    EntityEditPacketSender sender;
+    sender.setEditCoalescingInterval(COALESCING_INTERVAL);
+    sender.initialize(true);
+    QTest::qWait(10);
+
+    EntityItemProperties move;
+    move.setPosition(glm::vec3(1.0f, 2.0f, 3.0f));
+    sender.queueEditEntityMessage(PacketType::EntityEdit, EntityTreePointer(), EntityItemID(QUuid::createUuid()), move);
+    QVERIFY(sender.hasCoalescedEdits());
+
+    const int MAX_WAIT_MSECS = 1000;
+    for (int i = 0; i < MAX_WAIT_MSECS && sender.hasCoalescedEdits(); ++i) {
+        QTest::qWait(1);
+    }
+    QVERIFY(!sender.hasCoalescedEdits());
+
+    sender.terminate();
+    DependencyManager::destroy<NodeList>();
+    DependencyManager::destroy<AddressManager>();
+}
@@ -0,0 +1,26 @@
+//
+//  EntityEditCoalescerTests.h
+//  tests/octree/src
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_EntityEditCoalescerTests_h
+#define hifi_EntityEditCoalescerTests_h
+
+#include <QtTest/QtTest>
+
+class EntityEditCoalescerTests : public QObject {
+    Q_OBJECT
+
+private slots:
+    void testMergesEdits();
+    void testKeepsLaterSimulationOwner();
+    void testKeepsLaterServerScripts();
+    void testThreadedSenderQueuesLoneEdit();
+};
+
+#endif // hifi_EntityEditCoalescerTests_h
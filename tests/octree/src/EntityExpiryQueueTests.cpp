@@ -0,0 +1,143 @@
+//
+//  EntityExpiryQueueTests.cpp
+//  tests/octree/src
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "EntityExpiryQueueTests.h"
+
+#include <algorithm>
+#include <random>
+#include <unordered_map>
+
+#include <EntityExpiryQueue.h>
+#include <NumericalConstants.h>
+#include <ShapeEntityItem.h>
+
+QTEST_MAIN(EntityExpiryQueueTests)
+
+static EntityItemPointer makeEntity() {
+    return std::make_shared<ShapeEntityItem>(EntityItemID(QUuid::createUuid()));
+}
+
+void EntityExpiryQueueTests::testOrder() {
+    EntityExpiryQueue queue;
+    QCOMPARE(queue.getNextExpiry(), EntityExpiryQueue::NEVER);
+    QVERIFY(!queue.pop());
+
+    std::mt19937 generator(17);
+    std::uniform_int_distribution<quint64> expiries(0, 1000);
+    for (int i = 0; i < 1000; ++i) {
+        QVERIFY(queue.set(makeEntity(), expiries(generator)));
+    }
+    QCOMPARE(queue.size(), (size_t)1000);
+
+    quint64 lastExpiry = 0;
+    while (!queue.isEmpty()) {
+        auto expiry = queue.getNextExpiry();
+        QVERIFY(expiry >= lastExpiry);
+        QVERIFY(queue.pop());
+        lastExpiry = expiry;
+    }
+    QCOMPARE(queue.getNextExpiry(), EntityExpiryQueue::NEVER);
+}
+
+void EntityExpiryQueueTests::testSetAndRemove() {
+    EntityExpiryQueue queue;
+    auto first = makeEntity();
+    auto second = makeEntity();
+    auto third = makeEntity();
+    queue.set(first, 100);
+    queue.set(second, 200);
+    queue.set(third, 300);
+
+    // a longer lifetime
+    QVERIFY(!queue.set(first, 400));
+    QCOMPARE(queue.size(), (size_t)3);
+    QCOMPARE(queue.getNextExpiry(), (quint64)200);
+
+    // a shorter lifetime
+    queue.set(third, 50);
+    QCOMPARE(queue.getNextExpiry(), (quint64)50);
+
+    // a lifetime removed
+    QVERIFY(queue.remove(third.get()));
+    QVERIFY(!queue.remove(third.get()));
+    QVERIFY(!queue.contains(third.get()));
+    QCOMPARE(queue.size(), (size_t)2);
+
+    QCOMPARE(queue.pop(), second);
+    QCOMPARE(queue.pop(), first);
+    QVERIFY(queue.isEmpty());
+}
+
+// Spawns short-lived entities every frame, edits the lifetime of some of the live ones, and checks that the entities
+// dequeued as expired are exactly the ones whose expiry passed
+void EntityExpiryQueueTests::testChurn() {
+    const int NUM_ENTITIES = 100000;
+    const int NUM_SPAWNED_PER_FRAME = 500;
+    const int NUM_EDITED_PER_FRAME = 100;
+    const quint64 FRAME_USECS = 10 * USECS_PER_MSEC;
+    const quint64 MAX_LIFETIME_USECS = 500 * USECS_PER_MSEC;
+
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<quint64> lifetimes(1, MAX_LIFETIME_USECS);
+
+    EntityExpiryQueue queue;
+    std::unordered_map<const EntityItem*, quint64> expiries;
+    std::vector<EntityItemPointer> liveEntities;
+    int numSpawned = 0;
+    int numExpired = 0;
+    quint64 now = 0;
+
+    while (numSpawned < NUM_ENTITIES || !queue.isEmpty()) {
+        now += FRAME_USECS;
+
+        for (int i = 0; i < NUM_SPAWNED_PER_FRAME && numSpawned < NUM_ENTITIES; ++i, ++numSpawned) {
+            auto entity = makeEntity();
+            auto expiry = now + lifetimes(generator);
+            queue.set(entity, expiry);
+            expiries[entity.get()] = expiry;
+            liveEntities.push_back(entity);
+        }
+
+        // until the last ones are spawned, as the edits would otherwise keep the last few alive forever
+        if (numSpawned < NUM_ENTITIES) {
+            std::uniform_int_distribution<size_t> indices(0, liveEntities.size() - 1);
+            for (int i = 0; i < NUM_EDITED_PER_FRAME; ++i) {
+                auto& entity = liveEntities[indices(generator)];
+                if (queue.contains(entity.get())) {
+                    auto expiry = now + lifetimes(generator);
+                    queue.set(entity, expiry);
+                    expiries[entity.get()] = expiry;
+                }
+            }
+        }
+
+        while (queue.getNextExpiry() < now) {
+            auto entity = queue.pop();
+            auto it = expiries.find(entity.get());
+            QVERIFY(it != expiries.end());
+            QVERIFY(it->second < now);
+            expiries.erase(it);
+            ++numExpired;
+        }
+
+        // none of the remaining entities has expired
+        QCOMPARE(queue.size(), expiries.size());
+        for (const auto& expiry : expiries) {
+            QVERIFY(expiry.second >= now);
+        }
+
+        liveEntities.erase(std::remove_if(liveEntities.begin(), liveEntities.end(), [&](const EntityItemPointer& entity) {
+            return !queue.contains(entity.get());
+        }), liveEntities.end());
+    }
+
+    QCOMPARE(numExpired, NUM_ENTITIES);
+    QVERIFY(liveEntities.empty());
+}
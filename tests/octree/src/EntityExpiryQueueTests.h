@@ -0,0 +1,25 @@
+//
+//  EntityExpiryQueueTests.h
+//  tests/octree/src
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_EntityExpiryQueueTests_h
+#define hifi_EntityExpiryQueueTests_h
+
+#include <QtTest/QtTest>
+
+class EntityExpiryQueueTests : public QObject {
+    Q_OBJECT
+
+private slots:
+    void testOrder();
+    void testSetAndRemove();
+    void testChurn();
+};
+
+#endif // hifi_EntityExpiryQueueTests_h
@@ -0,0 +1,126 @@
+//
+//  EntityQueryIndexTests.cpp
+//  tests/octree/src
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "EntityQueryIndexTests.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <random>
+
+#include <EntityQueryIndex.h>
+#include <ShapeEntityItem.h>
+
+QTEST_MAIN(EntityQueryIndexTests)
+
+static EntityItemPointer makeEntity(const EntityItemID& id, const glm::vec3& position) {
+    auto entity = std::make_shared<ShapeEntityItem>(id);
+    entity->setPosition(position);
+    entity->setDimensions(glm::vec3(1.0f));
+    return entity;
+}
+
+static bool contains(const QVector<EntityItemPointer>& entities, const EntityItemPointer& entity) {
+    return std::find(entities.begin(), entities.end(), entity) != entities.end();
+}
+
+void EntityQueryIndexTests::testRemoveAndAddAgain() {
+    EntityQueryIndex index;
+    EntityItemID id(QUuid::createUuid());
+    glm::vec3 position(10.0f, 0.0f, 0.0f);
+
+    auto first = makeEntity(id, position);
+    index.addEntity(first);
+    index.publish();
+    QVector<EntityItemPointer> found;
+    index.findEntities(position, 1.0f, found);
+    QVERIFY(contains(found, first));
+
+    // deleted and added again with the same ID before the next publish
+    index.removeEntity(id);
+    first.reset();
+    auto second = makeEntity(id, position);
+    index.addEntity(second);
+    index.publish();
+    QCOMPARE(index.getNumEntities(), (size_t)1);
+
+    index.findEntities(position, 1.0f, found);
+    QCOMPARE(found.size(), 1);
+    QVERIFY(contains(found, second));
+
+    index.findEntities(AABox(position - glm::vec3(1.0f), 2.0f), found);
+    QVERIFY(contains(found, second));
+
+    float distance = FLT_MAX;
+    bool hit = false;
+    index.findRayCandidates(glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f), distance,
+                            [&](const EntityItemPointer& entity, float& bestDistance) {
+        hit |= entity == second;
+    });
+    QVERIFY(hit);
+}
+
+void EntityQueryIndexTests::testPublishesMoves() {
+    // enough entities to span several chunks of the snapshot arrays, moved a few at a time like in the frames of a server
+    const int NUM_ENTITIES = 3000;
+    const float WORLD_SIZE = 100.0f;
+    std::mt19937 generator(17);
+    std::uniform_real_distribution<float> coordinates(0.0f, WORLD_SIZE);
+    auto randomPosition = [&] {
+        return glm::vec3(coordinates(generator), coordinates(generator), coordinates(generator));
+    };
+
+    EntityQueryIndex index;
+    std::vector<EntityItemPointer> entities;
+    for (int i = 0; i < NUM_ENTITIES; ++i) {
+        entities.push_back(makeEntity(EntityItemID(QUuid::createUuid()), randomPosition()));
+        index.addEntity(entities.back());
+    }
+    index.publish();
+
+    // the changes are only seen once they are published
+    auto moved = entities.front();
+    glm::vec3 oldPosition = moved->getPosition();
+    glm::vec3 newPosition(WORLD_SIZE * 2.0f);
+    moved->setPosition(newPosition);
+    index.updateEntity(moved);
+    QVector<EntityItemPointer> found;
+    index.findEntities(newPosition, 1.0f, found);
+    QVERIFY(!contains(found, moved));
+    index.publish();
+    index.findEntities(newPosition, 1.0f, found);
+    QVERIFY(contains(found, moved));
+    index.findEntities(oldPosition, 0.1f, found);
+    QVERIFY(!contains(found, moved));
+
+    const int NUM_FRAMES = 50;
+    const int MOVES_PER_FRAME = 20;
+    const float QUERY_RADIUS = 10.0f;
+    std::uniform_int_distribution<int> indices(0, NUM_ENTITIES - 1);
+    for (int frame = 0; frame < NUM_FRAMES; ++frame) {
+        for (int i = 0; i < MOVES_PER_FRAME; ++i) {
+            auto entity = entities[indices(generator)];
+            entity->setPosition(randomPosition());
+            index.updateEntity(entity);
+        }
+        index.publish();
+
+        // the index finds what the boxes of the entities say it should
+        glm::vec3 center = randomPosition();
+        index.findEntities(center, QUERY_RADIUS, found);
+        for (const auto& entity : entities) {
+            bool success;
+            AABox box = entity->getAABox(success);
+            QVERIFY(success);
+            glm::vec3 closest = glm::clamp(center, box.getMinimumPoint(), box.getMaximumPoint());
+            bool touches = glm::distance(closest, center) <= QUERY_RADIUS;
+            QCOMPARE(contains(found, entity), touches);
+        }
+    }
+}
@@ -0,0 +1,24 @@
+//
+//  EntityQueryIndexTests.h
+//  tests/octree/src
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_EntityQueryIndexTests_h
+#define hifi_EntityQueryIndexTests_h
+
+#include <QtTest/QtTest>
+
+class EntityQueryIndexTests : public QObject {
+    Q_OBJECT
+
+private slots:
+    void testRemoveAndAddAgain();
+    void testPublishesMoves();
+};
+
+#endif // hifi_EntityQueryIndexTests_h
@@ -0,0 +1,245 @@
+//
+//  IslandSolverTests.cpp
+//  tests/physics/src
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "IslandSolverTests.h"
+
+#include <vector>
+
+#include <btBulletDynamicsCommon.h>
+
+#include <ThreadSafeDynamicsWorld.h>
+
+// Add additional qtest functionality (the include order is important!)
+#include "BulletTestUtils.h"
+#include "../QTestExtensions.h"
+
+QTEST_MAIN(IslandSolverTests)
+
+const btScalar FIXED_SUBSTEP = 1.0f / 60.0f;
+const btScalar BOX_HALF_EXTENT = 0.5f;
+const btScalar STACK_SPACING = 4.0f;
+
+// a headless world of stacks of boxes standing on a static ground, one island per stack
+class StackWorld {
+public:
+    StackWorld(int numSolverThreads) {
+        _collisionConfig = new btDefaultCollisionConfiguration();
+        _dispatcher = new btCollisionDispatcher(_collisionConfig);
+        _broadphase = new btDbvtBroadphase();
+        _solver = new btSequentialImpulseConstraintSolver();
+        _world = new ThreadSafeDynamicsWorld(_dispatcher, _broadphase, _solver, _collisionConfig);
+        _world->setGravity(btVector3(0.0f, -9.8f, 0.0f));
+        _world->setNumSolverThreads(numSolverThreads);
+
+        _groundShape = new btStaticPlaneShape(btVector3(0.0f, 1.0f, 0.0f), 0.0f);
+        _boxShape = new btBoxShape(btVector3(BOX_HALF_EXTENT, BOX_HALF_EXTENT, BOX_HALF_EXTENT));
+        addBody(_groundShape, 0.0f, btVector3(0.0f, 0.0f, 0.0f));
+    }
+
+    ~StackWorld() {
+        for (auto body : _bodies) {
+            _world->removeRigidBody(body);
+            delete body;
+        }
+        for (auto shape : _slabShapes) {
+            delete shape;
+        }
+        delete _boxShape;
+        delete _groundShape;
+        delete _world;
+        delete _solver;
+        delete _broadphase;
+        delete _dispatcher;
+        delete _collisionConfig;
+    }
+
+    // the stacks are laid on a square grid, their bottom box resting on the ground at baseHeight
+    void addStacks(int numStacks, int height, btScalar baseHeight = 0.0f) {
+        int side = (int)ceilf(sqrtf((float)numStacks));
+        for (int i = 0; i < numStacks; ++i) {
+            btScalar x = (btScalar)(i % side) * STACK_SPACING;
+            btScalar z = (btScalar)(i / side) * STACK_SPACING;
+            for (int j = 0; j < height; ++j) {
+                // a little gap between the boxes, so that they settle instead of starting interpenetrated
+                btScalar y = baseHeight + BOX_HALF_EXTENT + (btScalar)j * (2.0f * BOX_HALF_EXTENT + 0.01f);
+                btRigidBody* box = addBody(_boxShape, 1.0f, btVector3(x, y, z));
+                box->setActivationState(DISABLE_DEACTIVATION);
+                _boxes.push_back(box);
+            }
+        }
+    }
+
+    // a box far from everything else, alone in its island
+    btRigidBody* addFreeBox(const btVector3& position, const btVector3& velocity) {
+        btRigidBody* box = addBody(_boxShape, 1.0f, position);
+        box->setLinearVelocity(velocity);
+        box->setActivationState(DISABLE_DEACTIVATION);
+        _boxes.push_back(box);
+        return box;
+    }
+
+    btRigidBody* addKinematicSlab(const btVector3& halfExtents, const btVector3& position) {
+        btCollisionShape* shape = new btBoxShape(halfExtents);
+        _slabShapes.push_back(shape);
+        btRigidBody* slab = addBody(shape, 0.0f, position);
+        slab->setCollisionFlags(slab->getCollisionFlags() | btCollisionObject::CF_KINEMATIC_OBJECT);
+        slab->setActivationState(DISABLE_DEACTIVATION);
+        return slab;
+    }
+
+    void step(int numSteps) {
+        for (int i = 0; i < numSteps; ++i) {
+            _world->stepSimulationWithSubstepCallback(FIXED_SUBSTEP, 1, FIXED_SUBSTEP);
+        }
+    }
+
+    const std::vector<btRigidBody*>& getBoxes() const { return _boxes; }
+
+private:
+    btRigidBody* addBody(btCollisionShape* shape, btScalar mass, const btVector3& position) {
+        btVector3 inertia(0.0f, 0.0f, 0.0f);
+        if (mass > 0.0f) {
+            shape->calculateLocalInertia(mass, inertia);
+        }
+        btRigidBody* body = new btRigidBody(mass, nullptr, shape, inertia);
+        body->setWorldTransform(btTransform(btQuaternion::getIdentity(), position));
+        _world->addRigidBody(body);
+        _bodies.push_back(body);
+        return body;
+    }
+
+    btDefaultCollisionConfiguration* _collisionConfig;
+    btCollisionDispatcher* _dispatcher;
+    btBroadphaseInterface* _broadphase;
+    btSequentialImpulseConstraintSolver* _solver;
+    ThreadSafeDynamicsWorld* _world;
+    btCollisionShape* _groundShape;
+    btCollisionShape* _boxShape;
+    std::vector<btCollisionShape*> _slabShapes;
+    std::vector<btRigidBody*> _bodies;
+    std::vector<btRigidBody*> _boxes;
+};
+
+const int NUM_TEST_STACKS = 16;
+const int TEST_STACK_HEIGHT = 5;
+const int NUM_TEST_STEPS = 120;
+const int NUM_TEST_SOLVER_THREADS = 4;
+
+void IslandSolverTests::testParallelMatchesSerial() {
+    StackWorld serialWorld(1);
+    StackWorld parallelWorld(NUM_TEST_SOLVER_THREADS);
+    serialWorld.addStacks(NUM_TEST_STACKS, TEST_STACK_HEIGHT);
+    parallelWorld.addStacks(NUM_TEST_STACKS, TEST_STACK_HEIGHT);
+    serialWorld.step(NUM_TEST_STEPS);
+    parallelWorld.step(NUM_TEST_STEPS);
+
+    // the stacks have settled the same way, even if the solvers didn't iterate exactly alike
+    const btScalar acceptableError = 0.01f;
+    const auto& serialBoxes = serialWorld.getBoxes();
+    const auto& parallelBoxes = parallelWorld.getBoxes();
+    QCOMPARE(parallelBoxes.size(), serialBoxes.size());
+    for (size_t i = 0; i < serialBoxes.size(); ++i) {
+        QCOMPARE_WITH_ABS_ERROR(parallelBoxes[i]->getWorldTransform().getOrigin(),
+                                serialBoxes[i]->getWorldTransform().getOrigin(), acceptableError);
+    }
+}
+
+void IslandSolverTests::testParallelIsDeterministic() {
+    StackWorld worldA(NUM_TEST_SOLVER_THREADS);
+    StackWorld worldB(NUM_TEST_SOLVER_THREADS);
+    worldA.addStacks(NUM_TEST_STACKS, TEST_STACK_HEIGHT);
+    worldB.addStacks(NUM_TEST_STACKS, TEST_STACK_HEIGHT);
+
+    // knock the stacks over so that there is something to diverge
+    for (auto world : { &worldA, &worldB }) {
+        const auto& boxes = world->getBoxes();
+        for (size_t i = 0; i < boxes.size(); i += TEST_STACK_HEIGHT) {
+            boxes[i]->setLinearVelocity(btVector3(3.0f, 0.0f, 1.0f));
+        }
+    }
+    worldA.step(NUM_TEST_STEPS);
+    worldB.step(NUM_TEST_STEPS);
+
+    const auto& boxesA = worldA.getBoxes();
+    const auto& boxesB = worldB.getBoxes();
+    for (size_t i = 0; i < boxesA.size(); ++i) {
+        const btVector3& positionA = boxesA[i]->getWorldTransform().getOrigin();
+        const btVector3& positionB = boxesB[i]->getWorldTransform().getOrigin();
+        QCOMPARE(positionA.getX(), positionB.getX());
+        QCOMPARE(positionA.getY(), positionB.getY());
+        QCOMPARE(positionA.getZ(), positionB.getZ());
+    }
+}
+
+void IslandSolverTests::testKinematicSharedByIslands() {
+    // two stacks standing on the same kinematic slab are two islands, that must be solved together
+    StackWorld world(NUM_TEST_SOLVER_THREADS);
+    const btScalar slabHalfHeight = 0.1f;
+    const btScalar slabTop = 1.0f + slabHalfHeight;
+    world.addKinematicSlab(btVector3(STACK_SPACING, slabHalfHeight, 1.0f), btVector3(0.5f * STACK_SPACING, 1.0f, 0.0f));
+    world.addStacks(2, TEST_STACK_HEIGHT, slabTop);
+    world.step(NUM_TEST_STEPS);
+
+    for (auto box : world.getBoxes()) {
+        QVERIFY(box->getWorldTransform().getOrigin().getY() > slabTop);
+    }
+}
+
+void IslandSolverTests::testFreeBodiesMatchSerial() {
+    // the bodies touching nothing are still integrated when the islands are solved in parallel
+    StackWorld serialWorld(1);
+    StackWorld parallelWorld(NUM_TEST_SOLVER_THREADS);
+    const int numFallingSteps = 30;
+    const btVector3 fallingPosition(-100.0f, 100.0f, 0.0f);
+    const btVector3 thrownPosition(-200.0f, 100.0f, 0.0f);
+    const btVector3 thrownVelocity(5.0f, 5.0f, 0.0f);
+    for (auto world : { &serialWorld, &parallelWorld }) {
+        world->addStacks(NUM_TEST_STACKS, TEST_STACK_HEIGHT);
+        world->addFreeBox(fallingPosition, btVector3(0.0f, 0.0f, 0.0f));
+        world->addFreeBox(thrownPosition, thrownVelocity);
+    }
+    serialWorld.step(numFallingSteps);
+    parallelWorld.step(numFallingSteps);
+
+    const btScalar acceptableError = 0.0001f;
+    const auto& serialBoxes = serialWorld.getBoxes();
+    const auto& parallelBoxes = parallelWorld.getBoxes();
+    for (size_t i = serialBoxes.size() - 2; i < serialBoxes.size(); ++i) {
+        QCOMPARE_WITH_ABS_ERROR(parallelBoxes[i]->getLinearVelocity(), serialBoxes[i]->getLinearVelocity(), acceptableError);
+        QCOMPARE_WITH_ABS_ERROR(parallelBoxes[i]->getWorldTransform().getOrigin(),
+                                serialBoxes[i]->getWorldTransform().getOrigin(), acceptableError);
+    }
+
+    // and they did accelerate
+    btScalar expectedFallSpeed = 9.8f * FIXED_SUBSTEP * (btScalar)numFallingSteps;
+    QCOMPARE_WITH_ABS_ERROR(parallelBoxes[serialBoxes.size() - 2]->getLinearVelocity().getY(), -expectedFallSpeed, 0.01f);
+}
+
+const int NUM_BENCHMARK_STACKS = 400;
+const int BENCHMARK_STACK_HEIGHT = 10;
+const int NUM_BENCHMARK_STEPS = 10;
+
+void IslandSolverTests::benchmarkSerialStacks() {
+    StackWorld world(1);
+    world.addStacks(NUM_BENCHMARK_STACKS, BENCHMARK_STACK_HEIGHT);
+    world.step(NUM_TEST_STEPS);
+    QBENCHMARK {
+        world.step(NUM_BENCHMARK_STEPS);
+    }
+}
+
+void IslandSolverTests::benchmarkParallelStacks() {
+    StackWorld world(QThread::idealThreadCount());
+    world.addStacks(NUM_BENCHMARK_STACKS, BENCHMARK_STACK_HEIGHT);
+    world.step(NUM_TEST_STEPS);
+    QBENCHMARK {
+        world.step(NUM_BENCHMARK_STEPS);
+    }
+}
@@ -0,0 +1,28 @@
+//
+//  IslandSolverTests.h
+//  tests/physics/src
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_IslandSolverTests_h
+#define hifi_IslandSolverTests_h
+
+#include <QtTest/QtTest>
+
+class IslandSolverTests : public QObject {
+    Q_OBJECT
+
+private slots:
+    void testParallelMatchesSerial();
+    void testParallelIsDeterministic();
+    void testKinematicSharedByIslands();
+    void testFreeBodiesMatchSerial();
+    void benchmarkSerialStacks();
+    void benchmarkParallelStacks();
+};
+
+#endif // hifi_IslandSolverTests_h
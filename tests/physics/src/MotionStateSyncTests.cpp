@@ -0,0 +1,218 @@
+//
+//  MotionStateSyncTests.cpp
+//  tests/physics/src
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "MotionStateSyncTests.h"
+
+#include <btBulletDynamicsCommon.h>
+
+#include <NumericalConstants.h>
+#include <ObjectMotionState.h>
+#include <PhysicsCollisionGroups.h>
+#include <ThreadSafeDynamicsWorld.h>
+
+// Add additional qtest functionality (the include order is important!)
+#include "BulletTestUtils.h"
+#include "../QTestExtensions.h"
+
+QTEST_MAIN(MotionStateSyncTests)
+
+const btScalar FIXED_SUBSTEP = 1.0f / 60.0f;
+const btScalar BOX_HALF_EXTENT = 0.5f;
+
+// a slow drift, above the thresholds of the sync but below the ones of the deactivation
+const btVector3 DRIFT_VELOCITY { 0.05f, 0.0f, 0.0f };
+
+// the steps it takes a body at rest to fall asleep, with a margin
+const int MAX_STEPS_TO_SLEEP = 5 * 60;
+
+// a motion state that only records what the world pushes to it
+class TestMotionState : public ObjectMotionState {
+public:
+    TestMotionState(const btCollisionShape* shape) : ObjectMotionState(shape) {
+        _type = MOTIONSTATE_TYPE_ENTITY;
+        _motionType = MOTION_TYPE_DYNAMIC;
+    }
+
+    ~TestMotionState() {
+        // the shape isn't owned by a ShapeManager
+        _shape = nullptr;
+    }
+
+    void setBody(btRigidBody* body) { setRigidBody(body); }
+
+    void getWorldTransform(btTransform& worldTrans) const override { worldTrans = _transform; }
+    void setWorldTransform(const btTransform& worldTrans) override {
+        _transform = worldTrans;
+        ++_numSyncs;
+    }
+
+    const btTransform& getTransform() const { return _transform; }
+    int getNumSyncs() const { return _numSyncs; }
+
+    uint32_t getIncomingDirtyFlags() override { return 0; }
+    void clearIncomingDirtyFlags() override { }
+    PhysicsMotionType computePhysicsMotionType() const override { return MOTION_TYPE_DYNAMIC; }
+    bool isMoving() const override { return false; }
+
+    float getObjectRestitution() const override { return 0.5f; }
+    float getObjectFriction() const override { return 0.5f; }
+    float getObjectLinearDamping() const override { return 0.0f; }
+    float getObjectAngularDamping() const override { return 0.0f; }
+
+    glm::vec3 getObjectPosition() const override { return bulletToGLM(_transform.getOrigin()); }
+    glm::quat getObjectRotation() const override { return bulletToGLM(_transform.getRotation()); }
+    glm::vec3 getObjectLinearVelocity() const override { return glm::vec3(0.0f); }
+    glm::vec3 getObjectAngularVelocity() const override { return glm::vec3(0.0f); }
+    glm::vec3 getObjectGravity() const override { return glm::vec3(0.0f); }
+
+    const QUuid getObjectID() const override { return QUuid(); }
+    QUuid getSimulatorID() const override { return QUuid(); }
+
+    void computeCollisionGroupAndMask(int16_t& group, int16_t& mask) const override {
+        group = BULLET_COLLISION_GROUP_DYNAMIC;
+        mask = BULLET_COLLISION_MASK_DYNAMIC;
+    }
+
+protected:
+    bool isReadyToComputeShape() const override { return true; }
+    const btCollisionShape* computeNewShape() override { return _shape; }
+
+private:
+    btTransform _transform { btTransform::getIdentity() };
+    int _numSyncs { 0 };
+};
+
+// a headless world without gravity, with a single box synchronized the way PhysicsEngine does it
+class SyncWorld {
+public:
+    SyncWorld(const btVector3& velocity) :
+        _boxShape(btVector3(BOX_HALF_EXTENT, BOX_HALF_EXTENT, BOX_HALF_EXTENT)),
+        _motionState(&_boxShape)
+    {
+        _collisionConfig = new btDefaultCollisionConfiguration();
+        _dispatcher = new btCollisionDispatcher(_collisionConfig);
+        _broadphase = new btDbvtBroadphase();
+        _solver = new btSequentialImpulseConstraintSolver();
+        _world = new ThreadSafeDynamicsWorld(_dispatcher, _broadphase, _solver, _collisionConfig);
+        _world->setGravity(btVector3(0.0f, 0.0f, 0.0f));
+
+        const btScalar mass = 1.0f;
+        btVector3 inertia;
+        _boxShape.calculateLocalInertia(mass, inertia);
+        _body = new btRigidBody(mass, &_motionState, &_boxShape, inertia);
+        _motionState.setBody(_body);
+        _body->setLinearVelocity(velocity);
+        _world->addRigidBody(_body);
+    }
+
+    ~SyncWorld() {
+        _world->removeRigidBody(_body);
+        _motionState.setBody(nullptr);
+        delete _body;
+        delete _world;
+        delete _solver;
+        delete _broadphase;
+        delete _dispatcher;
+        delete _collisionConfig;
+    }
+
+    void step() {
+        _world->stepSimulationWithSubstepCallback(FIXED_SUBSTEP, 1, FIXED_SUBSTEP);
+        _world->synchronizeMotionStates();
+    }
+
+    // steps until the box falls asleep, returns false if it doesn't
+    bool stepUntilAsleep() {
+        for (int i = 0; i < MAX_STEPS_TO_SLEEP; ++i) {
+            step();
+            if (!_body->isActive()) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool wasJournaled() { return _world->getChangedMotionStates().contains(&_motionState); }
+    bool wasDeactivated() { return _world->getDeactivatedMotionStates().contains(&_motionState); }
+
+    btRigidBody* getBody() const { return _body; }
+    const TestMotionState& getMotionState() const { return _motionState; }
+
+private:
+    btBoxShape _boxShape;
+    TestMotionState _motionState;
+    btRigidBody* _body;
+
+    btDefaultCollisionConfiguration* _collisionConfig;
+    btCollisionDispatcher* _dispatcher;
+    btBroadphaseInterface* _broadphase;
+    btSequentialImpulseConstraintSolver* _solver;
+    ThreadSafeDynamicsWorld* _world;
+};
+
+void MotionStateSyncTests::testRestingAwakeBodyIsSkipped() {
+    SyncWorld world(btVector3(0.0f, 0.0f, 0.0f));
+
+    // a new body is pushed out once
+    world.step();
+    QVERIFY(world.wasJournaled());
+    QCOMPARE(world.getMotionState().getNumSyncs(), 1);
+
+    // then it isn't while it rests, even though it has a while to go before it falls asleep
+    for (int i = 0; i < 60; ++i) {
+        world.step();
+        QVERIFY(world.getBody()->isActive());
+        QVERIFY(!world.wasJournaled());
+    }
+    QCOMPARE(world.getMotionState().getNumSyncs(), 1);
+}
+
+void MotionStateSyncTests::testSleepingBodyIsJournaledOnce() {
+    SyncWorld world(DRIFT_VELOCITY);
+
+    // a drifting body is pushed out every step
+    for (int i = 0; i < 10; ++i) {
+        world.step();
+        QVERIFY(world.wasJournaled());
+    }
+
+    QVERIFY(world.stepUntilAsleep());
+    QVERIFY(world.wasJournaled());
+    QVERIFY(world.wasDeactivated());
+
+    // with the transform it stopped at, not the one of the step before
+    const btTransform& restingTransform = world.getBody()->getWorldTransform();
+    QCOMPARE_WITH_ABS_ERROR(world.getMotionState().getTransform().getOrigin(), restingTransform.getOrigin(), EPSILON);
+    int numSyncs = world.getMotionState().getNumSyncs();
+
+    for (int i = 0; i < 60; ++i) {
+        world.step();
+        QVERIFY(!world.getBody()->isActive());
+        QVERIFY(!world.wasJournaled());
+        QVERIFY(!world.wasDeactivated());
+    }
+    QCOMPARE(world.getMotionState().getNumSyncs(), numSyncs);
+}
+
+void MotionStateSyncTests::testWakingBodyIsJournaled() {
+    SyncWorld world(DRIFT_VELOCITY);
+    QVERIFY(world.stepUntilAsleep());
+    world.step();
+    QVERIFY(!world.wasJournaled());
+    int numSyncs = world.getMotionState().getNumSyncs();
+
+    // woken up without a push big enough for the thresholds of the sync
+    world.getBody()->activate();
+    world.step();
+    QVERIFY(world.getBody()->isActive());
+    QVERIFY(world.wasJournaled());
+    QVERIFY(!world.wasDeactivated());
+    QCOMPARE(world.getMotionState().getNumSyncs(), numSyncs + 1);
+}
@@ -0,0 +1,25 @@
+//
+//  MotionStateSyncTests.h
+//  tests/physics/src
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_MotionStateSyncTests_h
+#define hifi_MotionStateSyncTests_h
+
+#include <QtTest/QtTest>
+
+class MotionStateSyncTests : public QObject {
+    Q_OBJECT
+
+private slots:
+    void testRestingAwakeBodyIsSkipped();
+    void testSleepingBodyIsJournaledOnce();
+    void testWakingBodyIsJournaled();
+};
+
+#endif // hifi_MotionStateSyncTests_h
@@ -10,6 +10,7 @@
 //
 
 #include <iostream>
+#include <ShapeFactory.h>
 #include <ShapeManager.h>
 #include <StreamUtils.h>
 #include <Extents.h>
@@ -185,7 +186,7 @@ void ShapeManagerTests::addCapsuleShape() {
     */
 }
 
-void ShapeManagerTests::addCompoundShape() {
+static ShapeInfo makeCompoundShapeInfo(int numHulls) {
     // initialize some points for generating tetrahedral convex hulls
     QVector<glm::vec3> tetrahedron;
     tetrahedron.push_back(glm::vec3(1.0f, 1.0f, 1.0f));
@@ -196,7 +197,6 @@ void ShapeManagerTests::addCompoundShape() {
 
     // compute the points of the hulls
     ShapeInfo::PointCollection pointCollection;
-    int numHulls = 5;
     glm::vec3 offsetNormal(1.0f, 0.0f, 0.0f);
     Extents extents;
     for (int i = 0; i < numHulls; ++i) {
@@ -216,6 +216,12 @@ void ShapeManagerTests::addCompoundShape() {
     glm::vec3 halfExtents = 0.5f * (extents.maximum - extents.minimum);
     info.setParams(SHAPE_TYPE_COMPOUND, halfExtents);
     info.setPointCollection(pointCollection);
+    return info;
+}
+
+void ShapeManagerTests::addCompoundShape() {
+    int numHulls = 5;
+    ShapeInfo info = makeCompoundShapeInfo(numHulls);
 
     // create the shape
     ShapeManager shapeManager;
@@ -243,3 +249,77 @@ void ShapeManagerTests::addCompoundShape() {
     QCOMPARE(shapeManager.getNumShapes(), 0);
     QCOMPARE(shapeManager.getNumReferences(info), 0);
 }
+
+void ShapeManagerTests::addCompoundShapeAsync() {
+    int numHulls = 5;
+    ShapeInfo info = makeCompoundShapeInfo(numHulls);
+
+    // the first request starts building the shape on another thread
+    ShapeManager shapeManager;
+    const btCollisionShape* shape = shapeManager.getShapeAsync(info);
+    QVERIFY(shape == nullptr);
+    QCOMPARE(shapeManager.getNumPendingShapes(), 1);
+    QCOMPARE(shapeManager.getNumShapes(), 0);
+
+    // which is picked up by one of the next requests
+    const int MAX_NUM_REQUESTS = 1000;
+    for (int i = 0; i < MAX_NUM_REQUESTS && !shape; ++i) {
+        QTest::qWait(1);
+        shape = shapeManager.getShapeAsync(info);
+    }
+    QVERIFY(shape != nullptr);
+    QCOMPARE(shape->getShapeType(), (int)COMPOUND_SHAPE_PROXYTYPE);
+    QCOMPARE(static_cast<const btCompoundShape*>(shape)->getNumChildShapes(), numHulls);
+    QCOMPARE(shapeManager.getNumPendingShapes(), 0);
+    QCOMPARE(shapeManager.getNumShapes(), 1);
+    QCOMPARE(shapeManager.getNumReferences(info), 1);
+
+    // the shapes that are cheap to build are returned right away
+    ShapeInfo boxInfo;
+    boxInfo.setBox(glm::vec3(1.0f, 2.0f, 3.0f));
+    const btCollisionShape* box = shapeManager.getShapeAsync(boxInfo);
+    QVERIFY(box != nullptr);
+    QCOMPARE(shapeManager.getNumPendingShapes(), 0);
+    QCOMPARE(shapeManager.getNumShapes(), 2);
+
+    shapeManager.releaseShape(shape);
+    shapeManager.releaseShape(box);
+    shapeManager.collectGarbage();
+    QCOMPARE(shapeManager.getNumShapes(), 0);
+}
+
+void ShapeManagerTests::collectUnclaimedShapes() {
+    int numHulls = 5;
+    ShapeInfo info = makeCompoundShapeInfo(numHulls);
+
+    // a shape that is asked for again is kept until it is picked up
+    ShapeManager shapeManager;
+    const btCollisionShape* shape = shapeManager.getShapeAsync(info);
+    QVERIFY(shape == nullptr);
+    const int MAX_NUM_REQUESTS = 1000;
+    for (int i = 0; i < MAX_NUM_REQUESTS && !shape; ++i) {
+        QTest::qWait(1);
+        shapeManager.collectUnclaimedShapes();
+        shape = shapeManager.getShapeAsync(info);
+    }
+    QVERIFY(shape != nullptr);
+    QCOMPARE(shapeManager.getNumShapes(), 1);
+    shapeManager.releaseShape(shape);
+    shapeManager.collectGarbage();
+
+    // a shape that no one asks for anymore is dropped once it is built
+    shape = shapeManager.getShapeAsync(info);
+    QVERIFY(shape == nullptr);
+    QCOMPARE(shapeManager.getNumPendingShapes(), 1);
+    for (int i = 0; i < MAX_NUM_REQUESTS && shapeManager.getNumPendingShapes() > 0; ++i) {
+        QTest::qWait(1);
+        shapeManager.collectUnclaimedShapes();
+    }
+    QCOMPARE(shapeManager.getNumPendingShapes(), 0);
+    QCOMPARE(shapeManager.getNumShapes(), 0);
+
+    // and built again if it is asked for later
+    shape = shapeManager.getShapeAsync(info);
+    QVERIFY(shape == nullptr);
+    QCOMPARE(shapeManager.getNumPendingShapes(), 1);
+}
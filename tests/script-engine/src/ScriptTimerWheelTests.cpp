@@ -0,0 +1,214 @@
+//
+//  ScriptTimerWheelTests.cpp
+//  tests/script-engine/src
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "ScriptTimerWheelTests.h"
+
+#include <functional>
+#include <vector>
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QPointer>
+#include <QtCore/QThread>
+
+#include <ScriptTimerWheel.h>
+
+QTEST_MAIN(ScriptTimerWheelTests)
+
+static const int REVOLUTION_MS = ScriptTimerWheel::RESOLUTION_MS * ScriptTimerWheel::NUM_SLOTS;
+
+// the dispatcher of ScriptEngine, which drops the single shot timers that fired and skips the timers removed meanwhile
+static void dispatch(ScriptTimerWheel& wheel, const std::vector<QObject*>& timers,
+                     const std::function<void(QObject*)>& callback) {
+    for (auto timer : timers) {
+        if (!wheel.contains(timer)) {
+            continue;
+        }
+        if (!wheel.isActive(timer)) {
+            wheel.remove(timer);
+        }
+        callback(timer);
+    }
+}
+
+void ScriptTimerWheelTests::testLongerThanRevolution() {
+    ScriptTimerWheel wheel;
+    QElapsedTimer clock;
+    clock.start();
+
+    const int SINGLE_SHOT_MS = REVOLUTION_MS + REVOLUTION_MS / 2;
+    const int INTERVAL_MS = REVOLUTION_MS + REVOLUTION_MS / 4;
+
+    std::vector<qint64> singleShotFires;
+    std::vector<qint64> intervalFires;
+    QObject* singleShot = wheel.add(SINGLE_SHOT_MS, true);
+    QObject* interval = wheel.add(INTERVAL_MS, false);
+    wheel.setDispatcher([&](const std::vector<QObject*>& timers) {
+        dispatch(wheel, timers, [&](QObject* timer) {
+            if (timer == singleShot) {
+                singleShotFires.push_back(clock.elapsed());
+            } else if (timer == interval) {
+                intervalFires.push_back(clock.elapsed());
+            }
+        });
+    });
+
+    // the slots of both timers come around once before they are due
+    QTRY_VERIFY_WITH_TIMEOUT(intervalFires.size() >= 2, 2 * INTERVAL_MS + 1000);
+    wheel.remove(interval);
+
+    QCOMPARE(singleShotFires.size(), (size_t)1);
+    QVERIFY(singleShotFires[0] >= SINGLE_SHOT_MS - 1);
+    QVERIFY(!wheel.contains(singleShot));
+
+    QVERIFY(intervalFires[0] >= INTERVAL_MS - 1);
+    QVERIFY(intervalFires[1] >= 2 * INTERVAL_MS - 1);
+    QVERIFY(intervalFires[1] - intervalFires[0] >= INTERVAL_MS - ScriptTimerWheel::RESOLUTION_MS);
+    QCOMPARE(wheel.size(), 0);
+}
+
+void ScriptTimerWheelTests::testBatchOrder() {
+    ScriptTimerWheel wheel;
+    std::vector<std::vector<QObject*>> batches;
+    wheel.setDispatcher([&](const std::vector<QObject*>& timers) {
+        batches.push_back(timers);
+    });
+
+    QObject* late = wheel.add(30, true);
+    QObject* early = wheel.add(10, true);
+    QObject* middle = wheel.add(20, true);
+    QObject* middleAddedLater = wheel.add(20, true);
+
+    // all of them are due by the time the wheel gets to wake up
+    QThread::msleep(50);
+    QTRY_VERIFY_WITH_TIMEOUT(!batches.empty(), 1000);
+
+    QCOMPARE(batches.size(), (size_t)1);
+    const std::vector<QObject*> expected { early, middle, middleAddedLater, late };
+    QVERIFY(batches[0] == expected);
+    for (auto timer : expected) {
+        QVERIFY(!wheel.isActive(timer));
+        QVERIFY(wheel.remove(timer));
+    }
+}
+
+void ScriptTimerWheelTests::testRemoveDuringBatch() {
+    ScriptTimerWheel wheel;
+    const int INTERVAL_MS = 10;
+
+    QObject* first = wheel.add(INTERVAL_MS, false);
+    QObject* second = wheel.add(INTERVAL_MS, false);
+    QObject* unrelated = wheel.add(INTERVAL_MS, false);
+    QPointer<QObject> firstPointer = first;
+    QPointer<QObject> secondPointer = second;
+
+    int numFirstFires = 0;
+    int numSecondFires = 0;
+    int numUnrelatedFires = 0;
+    bool handlesValidInBatch = true;
+    wheel.setDispatcher([&](const std::vector<QObject*>& timers) {
+        dispatch(wheel, timers, [&](QObject* timer) {
+            if (timer == first) {
+                ++numFirstFires;
+                // a timer clearing itself and another one of the same batch
+                QVERIFY(wheel.remove(first));
+                QVERIFY(wheel.remove(second));
+                QVERIFY(!wheel.contains(first));
+                // the handles are only deleted once the batch is done
+                handlesValidInBatch &= !firstPointer.isNull() && !secondPointer.isNull();
+            } else if (timer == second) {
+                ++numSecondFires;
+            } else if (timer == unrelated) {
+                ++numUnrelatedFires;
+            }
+        });
+    });
+
+    // wait for both to have been due a few times over
+    QThread::msleep(INTERVAL_MS / 2);
+    QTRY_VERIFY_WITH_TIMEOUT(numUnrelatedFires >= 5, 1000);
+
+    QCOMPARE(numFirstFires, 1);
+    QCOMPARE(numSecondFires, 0);
+    QVERIFY(handlesValidInBatch);
+    QTRY_VERIFY(firstPointer.isNull() && secondPointer.isNull());
+    QCOMPARE(wheel.size(), 1);
+    QVERIFY(wheel.remove(unrelated));
+}
+
+void ScriptTimerWheelTests::testHandleReuse() {
+    ScriptTimerWheel wheel;
+    const int INTERVAL_MS = 50;
+
+    std::vector<QObject*> fired;
+    wheel.setDispatcher([&](const std::vector<QObject*>& timers) {
+        dispatch(wheel, timers, [&](QObject* timer) {
+            fired.push_back(timer);
+        });
+    });
+
+    // keeps the wheel from being cleared, so that the slot entries of the removed timers stay around
+    QObject* keepAlive = wheel.add(10 * INTERVAL_MS, true);
+
+    // a removed timer isn't deleted right away, a timer added after it never gets its address meanwhile
+    QObject* removed = wheel.add(INTERVAL_MS, false);
+    QVERIFY(wheel.remove(removed));
+    QObject* added = wheel.add(2 * INTERVAL_MS, true);
+    QVERIFY(added != removed);
+    QVERIFY(wheel.remove(added));
+
+    // once the removed timers are deleted their address may be reused, but their slot entries must not fire the new
+    // timers, which are due at other times
+    QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+    std::vector<QObject*> reused;
+    for (int i = 0; i < 10; ++i) {
+        reused.push_back(wheel.add(6 * INTERVAL_MS, true));
+    }
+
+    QTest::qWait(2 * INTERVAL_MS + INTERVAL_MS / 2);
+    QVERIFY(fired.empty());
+    for (auto timer : reused) {
+        QVERIFY(wheel.isActive(timer));
+    }
+
+    QTRY_COMPARE_WITH_TIMEOUT(fired.size(), reused.size(), 1000);
+    QVERIFY(fired == reused);
+    QCOMPARE(wheel.size(), 1);
+    QVERIFY(wheel.remove(keepAlive));
+}
+
+void ScriptTimerWheelTests::testSkipMissedIntervals() {
+    ScriptTimerWheel wheel;
+    const int INTERVAL_MS = 10;
+    const int BLOCKED_MS = 10 * INTERVAL_MS;
+
+    QElapsedTimer clock;
+    clock.start();
+    std::vector<qint64> fires;
+    QObject* interval = wheel.add(INTERVAL_MS, false);
+    wheel.setDispatcher([&](const std::vector<QObject*>& timers) {
+        dispatch(wheel, timers, [&](QObject* timer) {
+            if (timer == interval) {
+                fires.push_back(clock.elapsed());
+                if (fires.size() == 1) {
+                    // the first callback runs late, past several intervals
+                    QThread::msleep(BLOCKED_MS);
+                }
+            }
+        });
+    });
+
+    QTRY_VERIFY_WITH_TIMEOUT(fires.size() >= 4, 1000);
+    QVERIFY(wheel.remove(interval));
+
+    // the timer fires once for all the intervals it missed, then keeps its interval from there instead of catching up
+    QVERIFY(fires[1] - fires[0] >= BLOCKED_MS);
+    QVERIFY(fires[2] - fires[1] >= INTERVAL_MS - ScriptTimerWheel::RESOLUTION_MS);
+    QVERIFY(fires[3] - fires[2] >= INTERVAL_MS - ScriptTimerWheel::RESOLUTION_MS);
+}
@@ -10,7 +10,7 @@
 
 #include "FileCacheTests.h"
 
-#include <shared/FileCache.h>
+#include <thread>
 
 QTEST_GUILESS_MAIN(FileCacheTests)
 
@@ -20,6 +20,10 @@ using namespace cache;
 static const size_t MAX_UNUSED_SIZE { 1024 * 1024 * 10 };
 static const QByteArray TEST_DATA { 1024 * 1024, '0' };
 
+static const int NUM_BENCHMARK_FILES { 10000 };
+static const int NUM_BENCHMARK_THREADS { 8 };
+static const QByteArray BENCHMARK_DATA { 1024, '0' };
+
 static std::string getFileKey(int i) {
     return QString(QByteArray { 1, (char)i }.toHex()).toStdString();
 }
@@ -33,10 +37,16 @@ size_t FileCacheTests::getCacheDirectorySize() const {
     return result;
 }
 
-FileCachePointer makeFileCache(QString& location) {
+static std::string getBenchmarkFileKey(int i) {
+    return QString::number(i).toStdString();
+}
+
+FileCachePointer FileCacheTests::makeFileCache(const QString& location) {
     auto result = std::make_shared<FileCache>(location.toStdString(), "tmp");
     result->initialize();
     result->setMaxSize(MAX_UNUSED_SIZE);
+    // wait for the persisted files to be indexed, and the ones over budget to be ejected
+    result->waitUntilIdle();
     return result;
 }
 
@@ -60,6 +70,7 @@ void FileCacheTests::testUnusedFiles() {
         QCOMPARE(cache->getNumTotalFiles(), (size_t)100);
         // Release the in-use files
         inUseFiles.clear();
+        cache->waitUntilIdle();
         QCOMPARE(cache->getNumCachedFiles(), (size_t)10);
         QCOMPARE(cache->getNumTotalFiles(), (size_t)10);
         QVERIFY(getCacheDirectorySize() <= MAX_UNUSED_SIZE);
@@ -110,6 +121,7 @@ void FileCacheTests::testUnusedFiles() {
         QCOMPARE(cache->getNumCachedFiles(), (size_t)0);
         QCOMPARE(cache->getNumTotalFiles(), (size_t)10);
         inUseFiles.clear();
+        cache->waitUntilIdle();
         QCOMPARE(cache->getNumCachedFiles(), (size_t)10);
         QCOMPARE(cache->getNumTotalFiles(), (size_t)10);
     }
@@ -130,6 +142,7 @@ void FileCacheTests::testFreeSpacePreservation() {
     auto cache = makeFileCache(_testDir.path());
     // Setting the min free space causes it to eject the oldest files that cause the cache to exceed the minimum space
     cache->setMinFreeSize(targetFreeSpace);
+    cache->waitUntilIdle();
     QCOMPARE(cache->getNumCachedFiles(), (size_t)5);
     QCOMPARE(cache->getNumTotalFiles(), (size_t)5);
     QVERIFY(getFreeSpace() >= targetFreeSpace);
@@ -157,6 +170,64 @@ void FileCacheTests::testWipe() {
 }
 
 
+void FileCacheTests::benchmarkOpen_data() {
+    QTest::addColumn<bool>("fromManifest");
+    QTest::newRow("manifest") << true;
+    QTest::newRow("scan") << false;
+}
+
+void FileCacheTests::benchmarkOpen() {
+    QFETCH(bool, fromManifest);
+
+    if (QDir(_benchmarkDir.path()).entryList({ "*.tmp" }).isEmpty()) {
+        auto cache = makeFileCache(_benchmarkDir.path());
+        for (int i = 0; i < NUM_BENCHMARK_FILES; ++i) {
+            cache->writeFile(BENCHMARK_DATA.data(), FileCache::Metadata(getBenchmarkFileKey(i), BENCHMARK_DATA.size()));
+        }
+    }
+
+    QBENCHMARK {
+        auto cache = std::make_shared<FileCache>(_benchmarkDir.path().toStdString(), "tmp");
+        if (!fromManifest) {
+            QFile::remove(cache->getManifestPath().c_str());
+        }
+        cache->initialize();
+        cache->waitUntilIdle();
+        QCOMPARE(cache->getNumTotalFiles(), (size_t)NUM_BENCHMARK_FILES);
+    }
+}
+
+void FileCacheTests::benchmarkLookup() {
+    auto cache = makeFileCache(_benchmarkDir.path());
+
+    QBENCHMARK {
+        std::vector<std::thread> threads;
+        for (int i = 0; i < NUM_BENCHMARK_THREADS; ++i) {
+            threads.emplace_back([&, i] {
+                for (int j = i; j < NUM_BENCHMARK_FILES; j += NUM_BENCHMARK_THREADS) {
+                    auto file = cache->getFile(getBenchmarkFileKey(j));
+                    Q_ASSERT(file);
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+    QCOMPARE(cache->getNumCachedFiles(), (size_t)NUM_BENCHMARK_FILES);
+}
+
+void FileCacheTests::benchmarkEvict() {
+    auto cache = makeFileCache(_benchmarkDir.path());
+    QCOMPARE(cache->getNumCachedFiles(), (size_t)NUM_BENCHMARK_FILES);
+
+    QBENCHMARK_ONCE {
+        cache->setMaxSize(0);
+        cache->waitUntilIdle();
+    }
+    QCOMPARE(cache->getNumTotalFiles(), (size_t)0);
+}
+
 void FileCacheTests::cleanupTestCase() {
 }
 
@@ -13,6 +13,8 @@
 #include <QtTest/QtTest>
 #include <QtCore/QTemporaryDir>
 
+#include <shared/FileCache.h>
+
 class FileCacheTests : public QObject {
     Q_OBJECT
 private slots:
@@ -21,11 +23,17 @@ private slots:
     void testFreeSpacePreservation();
     void cleanupTestCase();
     void testWipe();
+    void benchmarkOpen_data();
+    void benchmarkOpen();
+    void benchmarkLookup();
+    void benchmarkEvict();
 
 private:
+    cache::FileCachePointer makeFileCache(const QString& location);
     size_t getFreeSpace() const;
     size_t getCacheDirectorySize() const;
     QTemporaryDir _testDir;
+    QTemporaryDir _benchmarkDir;
 };
 
 #endif // hifi_ResourceTests_h
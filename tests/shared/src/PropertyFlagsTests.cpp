@@ -0,0 +1,297 @@
+//
+//  PropertyFlagsTests.cpp
+//  tests/shared/src
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "PropertyFlagsTests.h"
+
+#include <random>
+#include <vector>
+
+#include <ByteCountCoding.h>
+#include <PropertyFlags.h>
+
+QTEST_MAIN(PropertyFlagsTests)
+
+enum TestProperty {
+    TEST_PROP_FIRST = 0,
+    TEST_PROP_AFTER_LAST = 190
+};
+
+typedef PropertyFlags<TestProperty, TEST_PROP_AFTER_LAST> TestPropertyFlags;
+
+// Writes the coding one bit at a time, the way the codecs used to:
+// a header of numberOfBytes - 1 set bits and a cleared one, then the value bits, each byte filled from its top bit.
+static QByteArray referenceEncode(const std::vector<bool>& valueBits, int numberOfBytes) {
+    QByteArray output(numberOfBytes, 0);
+    auto setBit = [&](int bit) {
+        output[bit / BITS_IN_BYTE] = output[bit / BITS_IN_BYTE] | (char)(0x80 >> (bit % BITS_IN_BYTE));
+    };
+
+    for (int i = 0; i < numberOfBytes - 1; ++i) {
+        setBit(i);
+    }
+    for (int i = 0; i < (int)valueBits.size(); ++i) {
+        if (valueBits[i]) {
+            setBit(numberOfBytes + i);
+        }
+    }
+    return output;
+}
+
+static QByteArray referenceEncode(quint64 value) {
+    std::vector<bool> bits;
+    for (quint64 remaining = value; remaining; remaining >>= 1) {
+        bits.push_back(remaining & 1);
+    }
+    return referenceEncode(bits, (int)bits.size() / (BITS_IN_BYTE - 1) + 1);
+}
+
+static QByteArray referenceEncode(const TestPropertyFlags& flags) {
+    int maxFlag = flags.lastFlag();
+    if (maxFlag < flags.firstFlag()) {
+        return QByteArray(1, 0);
+    }
+
+    std::vector<bool> bits;
+    for (int flag = 0; flag <= maxFlag; ++flag) {
+        bits.push_back(flags.getHasProperty((TestProperty)flag));
+    }
+    return referenceEncode(bits, maxFlag / (BITS_IN_BYTE - 1) + 1);
+}
+
+static TestPropertyFlags randomFlags(std::mt19937& generator) {
+    TestPropertyFlags flags;
+    int maxFlag = 1 + generator() % TEST_PROP_AFTER_LAST;
+    int numFlags = generator() % 20;
+    for (int i = 0; i < numFlags; ++i) {
+        // some flags get cleared again, which can lower the last flag
+        flags.setHasProperty((TestProperty)(generator() % maxFlag), generator() % 4 != 0);
+    }
+    return flags;
+}
+
+void PropertyFlagsTests::byteCountCodingWireFormat() {
+    // as written by the bit at a time codec
+    QCOMPARE(ByteCountCoded<quint64>(0).encode(), QByteArray("\x00", 1));
+    QCOMPARE(ByteCountCoded<quint64>(1).encode(), QByteArray("\x40", 1));
+    QCOMPARE(ByteCountCoded<quint64>(127).encode(), QByteArray("\xbf\x80", 2));
+    QCOMPARE(ByteCountCoded<quint64>(128).encode(), QByteArray("\x80\x40", 2));
+    QCOMPARE(ByteCountCoded<quint64>(259).encode(), QByteArray("\xb0\x20", 2));
+    QCOMPARE(ByteCountCoded<quint64>(1000000).encode(), QByteArray("\xc0\x48\x5e", 3));
+    QCOMPARE(ByteCountCoded<quint32>(4294967295U).encode(), QByteArray("\xf7\xff\xff\xff\xf8", 5));
+    QCOMPARE(ByteCountCoded<quint64>(1ULL << 63).encode(), QByteArray("\xff\x80\x00\x00\x00\x00\x00\x00\x00\x40", 10));
+    QCOMPARE(ByteCountCoded<quint64>(~0ULL).encode(), QByteArray("\xff\xbf\xff\xff\xff\xff\xff\xff\xff\xc0", 10));
+}
+
+void PropertyFlagsTests::byteCountCodingRoundTrip() {
+    std::mt19937_64 generator { 1 };
+
+    for (int i = 0; i < 10000; ++i) {
+        quint64 value = generator() >> (generator() % 64);
+        ByteCountCoded<quint64> coder { value };
+
+        auto encoded = coder.encode();
+        QCOMPARE(encoded, referenceEncode(value));
+        QCOMPARE(encoded.size(), coder.encodedSize());
+
+        // encoding straight into a buffer gives the same bytes
+        uint8_t buffer[16];
+        QCOMPARE(coder.encode(buffer, encoded.size()), encoded.size());
+        QCOMPARE(QByteArray(reinterpret_cast<const char*>(buffer), encoded.size()), encoded);
+        QCOMPARE(coder.encode(buffer, encoded.size() - 1), 0);
+
+        // what follows the coding is left alone
+        QByteArray packet = encoded + QByteArray(4, (char)generator());
+        ByteCountCoded<quint64> decoded;
+        QCOMPARE(decoded.decode(packet), (size_t)encoded.size());
+        QCOMPARE(decoded.data, value);
+
+        quint32 value32 = (quint32)value;
+        ByteCountCoded<quint32> decoded32 { ByteCountCoded<quint32>(value32).encode() };
+        QCOMPARE(decoded32.data, value32);
+        QCOMPARE(ByteCountCoded<quint32>(value32).encode(), referenceEncode(value32));
+    }
+}
+
+void PropertyFlagsTests::byteCountCodingTruncated() {
+    auto encoded = ByteCountCoded<quint64>(1000000).encode();
+
+    // a buffer too short for the value is consumed without decoding anything
+    ByteCountCoded<quint64> decoded { 42 };
+    QCOMPARE(decoded.decode(encoded.constData(), encoded.size() - 1), (size_t)(encoded.size() - 1));
+    QCOMPARE(decoded.data, (quint64)0);
+
+    QCOMPARE(decoded.decode(QByteArray("\xff\xff", 2)), (size_t)2);
+    QCOMPARE(decoded.data, (quint64)0);
+
+    QCOMPARE(decoded.decode(QByteArray()), (size_t)0);
+}
+
+void PropertyFlagsTests::propertyFlagsWireFormat() {
+    TestPropertyFlags flags;
+    QCOMPARE(flags.encode(), QByteArray("\x00", 1));
+
+    flags.setHasProperty((TestProperty)0);
+    QCOMPARE(flags.encode(), QByteArray("\x40", 1));
+
+    flags.clear();
+    flags.setHasProperty((TestProperty)2);
+    flags.setHasProperty((TestProperty)5);
+    QCOMPARE(flags.encode(), QByteArray("\x12", 1));
+
+    flags.clear();
+    flags.setHasProperty((TestProperty)1);
+    flags.setHasProperty((TestProperty)6);
+    flags.setHasProperty((TestProperty)7);
+    QCOMPARE(flags.encode(), QByteArray("\x90\xc0", 2));
+
+    flags.clear();
+    flags.setHasProperty((TestProperty)63);
+    flags.setHasProperty((TestProperty)64);
+    QCOMPARE(flags.encode(), QByteArray("\xff\x80\x00\x00\x00\x00\x00\x00\x00\x60", 10));
+
+    flags.clear();
+    flags.setHasProperty((TestProperty)130);
+    QCOMPARE(flags.encode(),
+        QByteArray("\xff\xff\xc0\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x04", 19));
+}
+
+void PropertyFlagsTests::propertyFlagsRoundTrip() {
+    std::mt19937 generator { 1 };
+
+    for (int i = 0; i < 10000; ++i) {
+        auto flags = randomFlags(generator);
+
+        auto encoded = flags.encode();
+        QCOMPARE(encoded, referenceEncode(flags));
+        QCOMPARE(encoded.size(), flags.getEncodedSize());
+
+        uint8_t buffer[64];
+        QCOMPARE(flags.encode(buffer, sizeof(buffer)), encoded.size());
+        QCOMPARE(QByteArray(reinterpret_cast<const char*>(buffer), encoded.size()), encoded);
+
+        QByteArray packet = encoded + QByteArray(4, (char)generator());
+        TestPropertyFlags decoded;
+        QCOMPARE(decoded.decode(packet), (size_t)encoded.size());
+        QCOMPARE(decoded.getEncodedLength(), encoded.size());
+        QVERIFY(decoded == flags);
+        for (int flag = 0; flag < TEST_PROP_AFTER_LAST; ++flag) {
+            QCOMPARE(decoded.getHasProperty((TestProperty)flag), flags.getHasProperty((TestProperty)flag));
+        }
+
+        // decoding sets the bounds to the flags that are set
+        if (!flags) {
+            QVERIFY(!decoded);
+        } else {
+            QCOMPARE(decoded.lastFlag(), flags.lastFlag());
+        }
+    }
+}
+
+void PropertyFlagsTests::propertyFlagsOperators() {
+    std::mt19937 generator { 2 };
+
+    for (int i = 0; i < 1000; ++i) {
+        auto a = randomFlags(generator);
+        auto b = randomFlags(generator);
+
+        auto sum = a + b;
+        auto difference = a - b;
+        auto intersection = a & b;
+        auto exclusion = a ^ b;
+        auto complement = ~a;
+        for (int flag = 0; flag < TEST_PROP_AFTER_LAST; ++flag) {
+            bool inA = a.getHasProperty((TestProperty)flag);
+            bool inB = b.getHasProperty((TestProperty)flag);
+            QCOMPARE(sum.getHasProperty((TestProperty)flag), inA || inB);
+            QCOMPARE(difference.getHasProperty((TestProperty)flag), inA && !inB);
+            QCOMPARE(intersection.getHasProperty((TestProperty)flag), inA && inB);
+            // ^ and ~ only apply to the flags up to the last one of the left side
+            QCOMPARE(exclusion.getHasProperty((TestProperty)flag), flag <= a.lastFlag() ? inA != inB : false);
+            QCOMPARE(complement.getHasProperty((TestProperty)flag), !inA);
+        }
+
+        int count = 0;
+        int lastFlag = -1;
+        sum.forEachFlag([&](TestProperty flag) {
+            QVERIFY((int)flag > lastFlag);
+            QVERIFY(sum.getHasProperty(flag));
+            lastFlag = flag;
+            ++count;
+        });
+        QCOMPARE(count, sum.count());
+        QCOMPARE(lastFlag, !sum ? -1 : (int)sum.lastFlag());
+    }
+}
+
+void PropertyFlagsTests::benchmarkByteCountEncode() {
+    std::mt19937_64 generator { 3 };
+    std::vector<ByteCountCoded<quint64>> values;
+    for (int i = 0; i < 10000; ++i) {
+        // mostly small deltas, as in the entity data
+        values.push_back(generator() >> (32 + generator() % 32));
+    }
+
+    uint8_t buffer[16];
+    int totalBytes = 0;
+    QBENCHMARK {
+        for (const auto& value : values) {
+            totalBytes += value.encode(buffer, sizeof(buffer));
+        }
+    }
+    QVERIFY(totalBytes > 0);
+}
+
+void PropertyFlagsTests::benchmarkByteCountDecode() {
+    std::mt19937_64 generator { 3 };
+    QByteArray packet;
+    for (int i = 0; i < 10000; ++i) {
+        packet += ByteCountCoded<quint64>(generator() >> (32 + generator() % 32)).encode();
+    }
+
+    QBENCHMARK {
+        ByteCountCoded<quint64> decoded;
+        for (int offset = 0; offset < packet.size(); ) {
+            offset += (int)decoded.decode(packet.constData() + offset, packet.size() - offset);
+        }
+    }
+}
+
+void PropertyFlagsTests::benchmarkPropertyFlagsEncode() {
+    std::mt19937 generator { 4 };
+    std::vector<TestPropertyFlags> flags;
+    for (int i = 0; i < 10000; ++i) {
+        flags.push_back(randomFlags(generator));
+    }
+
+    uint8_t buffer[64];
+    int totalBytes = 0;
+    QBENCHMARK {
+        for (auto& value : flags) {
+            totalBytes += value.encode(buffer, sizeof(buffer));
+        }
+    }
+    QVERIFY(totalBytes > 0);
+}
+
+void PropertyFlagsTests::benchmarkPropertyFlagsDecode() {
+    std::mt19937 generator { 4 };
+    QByteArray packet;
+    for (int i = 0; i < 10000; ++i) {
+        packet += randomFlags(generator).encode();
+    }
+
+    auto data = reinterpret_cast<const uint8_t*>(packet.constData());
+    QBENCHMARK {
+        TestPropertyFlags decoded;
+        for (int offset = 0; offset < packet.size(); ) {
+            offset += (int)decoded.decode(data + offset, packet.size() - offset);
+        }
+    }
+}
@@ -0,0 +1,31 @@
+//
+//  PropertyFlagsTests.h
+//  tests/shared/src
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_PropertyFlagsTests_h
+#define hifi_PropertyFlagsTests_h
+
+#include <QtTest/QtTest>
+
+class PropertyFlagsTests : public QObject {
+    Q_OBJECT
+private slots:
+    void byteCountCodingWireFormat();
+    void byteCountCodingRoundTrip();
+    void byteCountCodingTruncated();
+    void propertyFlagsWireFormat();
+    void propertyFlagsRoundTrip();
+    void propertyFlagsOperators();
+    void benchmarkByteCountEncode();
+    void benchmarkByteCountDecode();
+    void benchmarkPropertyFlagsEncode();
+    void benchmarkPropertyFlagsDecode();
+};
+
+#endif // hifi_PropertyFlagsTests_h
@@ -0,0 +1,136 @@
+//
+//  FBXLoaderApp.cpp
+//  tools/fbx-loader/src
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "FBXLoaderApp.h"
+
+#include <memory>
+
+#include <QCommandLineParser>
+#include <QDebug>
+#include <QFile>
+
+#include <FBXReader.h>
+#include <SharedUtil.h>
+
+// Loads FBX models the way the model cache does and reports how long each stage took, to measure
+// changes to the FBX reader against real content.
+
+static const int USECS_PER_MSEC = 1000;
+
+static float toMsecs(quint64 usecs) {
+    return (float)usecs / USECS_PER_MSEC;
+}
+
+FBXLoaderApp::FBXLoaderApp(int argc, char* argv[]) : QCoreApplication(argc, argv) {
+
+    // parse command-line
+    QCommandLineParser parser;
+    parser.setApplicationDescription("High Fidelity FBX Loader");
+    const QCommandLineOption helpOption = parser.addHelpOption();
+
+    const QCommandLineOption verboseOutput("v", "verbose output");
+    parser.addOption(verboseOutput);
+
+    const QCommandLineOption repeatOption("r", "number of times to load each model", "count", "1");
+    parser.addOption(repeatOption);
+
+    parser.addPositionalArgument("files", "FBX files to load", "filename.fbx...");
+
+    if (!parser.parse(QCoreApplication::arguments())) {
+        qCritical() << parser.errorText() << endl;
+        parser.showHelp();
+        _returnCode = 1;
+        return;
+    }
+
+    if (parser.isSet(helpOption)) {
+        parser.showHelp();
+        return;
+    }
+
+    auto filenames = parser.positionalArguments();
+    if (filenames.isEmpty()) {
+        qCritical() << "No input files";
+        parser.showHelp();
+        _returnCode = 1;
+        return;
+    }
+
+    bool verbose = parser.isSet(verboseOutput);
+
+    bool ok = false;
+    int repeat = parser.value(repeatOption).toInt(&ok);
+    if (!ok || repeat < 1) {
+        qCritical() << "Invalid repeat count" << parser.value(repeatOption);
+        _returnCode = 1;
+        return;
+    }
+
+    for (const auto& filename : filenames) {
+        for (int i = 0; i < repeat; ++i) {
+            if (!loadModel(filename, verbose)) {
+                _returnCode = 2;
+                break;
+            }
+        }
+    }
+}
+
+FBXLoaderApp::~FBXLoaderApp() {
+}
+
+bool FBXLoaderApp::loadModel(const QString& filename, bool verbose) {
+    quint64 start = usecTimestampNow();
+
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qCritical() << "Failed to open file " << filename;
+        return false;
+    }
+
+    FBXReader reader;
+    std::unique_ptr<FBXGeometry> geometry;
+
+    quint64 parseStart = usecTimestampNow();
+    quint64 extractStart = parseStart;
+    try {
+        // parsing from the file device maps it rather than reading it in
+        reader._fbxNode = FBXReader::parseFBX(&file, true);
+        extractStart = usecTimestampNow();
+        geometry.reset(reader.extractFBXGeometry(QVariantHash(), filename));
+    } catch (const QString& error) {
+        qCritical() << "Failed to load" << filename << "-" << error;
+        return false;
+    }
+    quint64 end = usecTimestampNow();
+
+    int numVertices = 0;
+    for (const auto& mesh : geometry->meshes) {
+        numVertices += mesh.vertices.size();
+    }
+
+    const auto& times = reader._extractionTimes;
+    qDebug().noquote() << filename << "loaded in" << toMsecs(end - start) << "ms:"
+        << "open" << toMsecs(parseStart - start) << "ms,"
+        << "parse" << toMsecs(extractStart - parseStart) << "ms,"
+        << "extract" << toMsecs(end - extractStart) << "ms";
+
+    if (verbose) {
+        qDebug() << "    objects " << toMsecs(times.objects) << "ms";
+        qDebug() << "    meshes  " << toMsecs(times.meshes) << "ms";
+        qDebug() << "    joints  " << toMsecs(times.joints) << "ms";
+        qDebug() << "    skinning" << toMsecs(times.skinning) << "ms";
+        qDebug() << "    shapes  " << toMsecs(times.shapes) << "ms";
+        qDebug() << "   " << geometry->meshes.size() << "meshes," << numVertices << "vertices,"
+            << geometry->joints.size() << "joints";
+    }
+
+    return true;
+}
@@ -0,0 +1,30 @@
+//
+//  FBXLoaderApp.h
+//  tools/fbx-loader/src
+//
+//  Copyright 2017 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_FBXLoaderApp_h
+#define hifi_FBXLoaderApp_h
+
+#include <QCoreApplication>
+
+class FBXLoaderApp : public QCoreApplication {
+    Q_OBJECT
+public:
+    FBXLoaderApp(int argc, char* argv[]);
+    ~FBXLoaderApp();
+
+    int getReturnCode() const { return _returnCode; }
+
+private:
+    bool loadModel(const QString& filename, bool verbose);
+
+    int _returnCode { 0 };
+};
+
+#endif //hifi_FBXLoaderApp_h